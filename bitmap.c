@@ -0,0 +1,643 @@
+/*
+ * Bitmap
+ * Roaring-style compressed bitmap with array and bitmap containers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bitmap.h"
+
+#define CONTAINER_WORDS 1024  // 65536 bits
+#define TYPE_ARRAY 0
+#define TYPE_BITS 1
+
+typedef struct {
+    unsigned int key;           // High 16 bits of every position in the container
+    int type;                   // TYPE_ARRAY or TYPE_BITS
+    int cardinality;
+    int capacity;               // Allocated length of values (array containers)
+    unsigned short* values;     // Sorted low halves (array containers)
+    unsigned long long* words;  // CONTAINER_WORDS words (bitmap containers)
+} Container;
+
+struct Bitmap {
+    Container* containers;  // Sorted by key
+    int count;
+    int capacity;
+};
+
+typedef enum { OP_AND, OP_OR, OP_ANDNOT } BitmapOp;
+
+static int popcount64(unsigned long long x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static int lowerBound(const unsigned short* values, int count, unsigned short value) {
+    int low = 0;
+    int high = count;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (values[middle] < value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/*
+ * Container helpers
+ */
+
+static void freeContainer(Container* container) {
+    free(container->values);
+    free(container->words);
+    container->values = NULL;
+    container->words = NULL;
+}
+
+static int arrayToBits(Container* container) {
+    unsigned long long* words = (unsigned long long*)calloc(CONTAINER_WORDS, sizeof(unsigned long long));
+    if (words == NULL) {
+        printf("Error: Memory allocation for bitmap failed\n");
+        return -1;
+    }
+
+    for (int i = 0; i < container->cardinality; i++) {
+        words[container->values[i] >> 6] |= 1ULL << (container->values[i] & 63);
+    }
+
+    free(container->values);
+    container->values = NULL;
+    container->capacity = 0;
+    container->words = words;
+    container->type = TYPE_BITS;
+    return 0;
+}
+
+static int bitsToArray(Container* container) {
+    int capacity = container->cardinality > 0 ? container->cardinality : 1;
+    unsigned short* values = (unsigned short*)malloc(capacity * sizeof(unsigned short));
+    if (values == NULL) {
+        printf("Error: Memory allocation for bitmap failed\n");
+        return -1;
+    }
+
+    int count = 0;
+    for (int w = 0; w < CONTAINER_WORDS; w++) {
+        unsigned long long word = container->words[w];
+        while (word != 0) {
+            int bit = 0;
+            while (!(word & (1ULL << bit))) {
+                bit++;
+            }
+            values[count++] = (unsigned short)(w * 64 + bit);
+            word &= word - 1;
+        }
+    }
+
+    free(container->words);
+    container->words = NULL;
+    container->values = values;
+    container->capacity = capacity;
+    container->type = TYPE_ARRAY;
+    return 0;
+}
+
+static int containerContains(const Container* container, unsigned short low) {
+    if (container->type == TYPE_BITS) {
+        return (container->words[low >> 6] >> (low & 63)) & 1;
+    }
+    int i = lowerBound(container->values, container->cardinality, low);
+    return i < container->cardinality && container->values[i] == low;
+}
+
+static int containerAdd(Container* container, unsigned short low) {
+    if (container->type == TYPE_ARRAY) {
+        int i = lowerBound(container->values, container->cardinality, low);
+        if (i < container->cardinality && container->values[i] == low) {
+            return 0;
+        }
+
+        if (container->cardinality == BITMAP_ARRAY_LIMIT) {
+            if (arrayToBits(container) != 0) {
+                return -1;
+            }
+        } else {
+            if (container->cardinality == container->capacity) {
+                int capacity = container->capacity == 0 ? 4 : container->capacity * 2;
+                if (capacity > BITMAP_ARRAY_LIMIT) {
+                    capacity = BITMAP_ARRAY_LIMIT;
+                }
+                unsigned short* values = (unsigned short*)realloc(container->values,
+                                                                  capacity * sizeof(unsigned short));
+                if (values == NULL) {
+                    printf("Error: Memory allocation for bitmap failed\n");
+                    return -1;
+                }
+                container->values = values;
+                container->capacity = capacity;
+            }
+
+            memmove(container->values + i + 1, container->values + i,
+                    (container->cardinality - i) * sizeof(unsigned short));
+            container->values[i] = low;
+            container->cardinality++;
+            return 1;
+        }
+    }
+
+    unsigned long long bit = 1ULL << (low & 63);
+    if (container->words[low >> 6] & bit) {
+        return 0;
+    }
+    container->words[low >> 6] |= bit;
+    container->cardinality++;
+    return 1;
+}
+
+static int containerRemove(Container* container, unsigned short low) {
+    if (container->type == TYPE_ARRAY) {
+        int i = lowerBound(container->values, container->cardinality, low);
+        if (i == container->cardinality || container->values[i] != low) {
+            return 0;
+        }
+        memmove(container->values + i, container->values + i + 1,
+                (container->cardinality - i - 1) * sizeof(unsigned short));
+        container->cardinality--;
+        return 1;
+    }
+
+    unsigned long long bit = 1ULL << (low & 63);
+    if (!(container->words[low >> 6] & bit)) {
+        return 0;
+    }
+    container->words[low >> 6] &= ~bit;
+    container->cardinality--;
+
+    if (container->cardinality <= BITMAP_ARRAY_LIMIT && bitsToArray(container) != 0) {
+        return -1;
+    }
+    return 1;
+}
+
+static void containerToWords(const Container* container, unsigned long long* words) {
+    if (container->type == TYPE_BITS) {
+        memcpy(words, container->words, CONTAINER_WORDS * sizeof(unsigned long long));
+        return;
+    }
+
+    memset(words, 0, CONTAINER_WORDS * sizeof(unsigned long long));
+    for (int i = 0; i < container->cardinality; i++) {
+        words[container->values[i] >> 6] |= 1ULL << (container->values[i] & 63);
+    }
+}
+
+// Values above low move down by one. low itself must not be set.
+static void containerShiftDown(Container* container, unsigned short low) {
+    if (container->type == TYPE_ARRAY) {
+        for (int i = 0; i < container->cardinality; i++) {
+            if (container->values[i] > low) {
+                container->values[i]--;
+            }
+        }
+        return;
+    }
+
+    unsigned long long* words = container->words;
+    int first = low >> 6;
+    unsigned long long keep = (1ULL << (low & 63)) - 1;  // Bits below low stay where they are
+
+    unsigned long long next = first + 1 < CONTAINER_WORDS ? words[first + 1] : 0;
+    words[first] = (words[first] & keep) | ((words[first] >> 1) & ~keep) | (next << 63);
+    for (int w = first + 1; w < CONTAINER_WORDS; w++) {
+        next = w + 1 < CONTAINER_WORDS ? words[w + 1] : 0;
+        words[w] = (words[w] >> 1) | (next << 63);
+    }
+}
+
+// Values at or above low move up by one. 0xFFFF must not be set.
+static void containerShiftUp(Container* container, unsigned short low) {
+    if (container->type == TYPE_ARRAY) {
+        for (int i = 0; i < container->cardinality; i++) {
+            if (container->values[i] >= low) {
+                container->values[i]++;
+            }
+        }
+        return;
+    }
+
+    unsigned long long* words = container->words;
+    int first = low >> 6;
+    unsigned long long keep = (1ULL << (low & 63)) - 1;
+
+    for (int w = CONTAINER_WORDS - 1; w > first; w--) {
+        words[w] = (words[w] << 1) | (words[w - 1] >> 63);
+    }
+    words[first] = (words[first] & keep) | ((words[first] << 1) & ~(keep | (1ULL << (low & 63))));
+}
+
+/*
+ * Container list helpers
+ */
+
+// Index of the container with key, or -(insertion point) - 1
+static int findContainer(const Bitmap* bitmap, unsigned int key) {
+    int low = 0;
+    int high = bitmap->count - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (bitmap->containers[middle].key < key) {
+            low = middle + 1;
+        } else if (bitmap->containers[middle].key > key) {
+            high = middle - 1;
+        } else {
+            return middle;
+        }
+    }
+    return -(low + 1);
+}
+
+static Container* insertContainer(Bitmap* bitmap, int at, unsigned int key) {
+    if (bitmap->count == bitmap->capacity) {
+        int capacity = bitmap->capacity == 0 ? 4 : bitmap->capacity * 2;
+        Container* containers = (Container*)realloc(bitmap->containers, capacity * sizeof(Container));
+        if (containers == NULL) {
+            printf("Error: Memory allocation for bitmap failed\n");
+            return NULL;
+        }
+        bitmap->containers = containers;
+        bitmap->capacity = capacity;
+    }
+
+    memmove(bitmap->containers + at + 1, bitmap->containers + at, (bitmap->count - at) * sizeof(Container));
+    bitmap->count++;
+
+    Container* container = &bitmap->containers[at];
+    memset(container, 0, sizeof(Container));
+    container->key = key;
+    container->type = TYPE_ARRAY;
+    return container;
+}
+
+static void removeContainerAt(Bitmap* bitmap, int at) {
+    freeContainer(&bitmap->containers[at]);
+    memmove(bitmap->containers + at, bitmap->containers + at + 1, (bitmap->count - at - 1) * sizeof(Container));
+    bitmap->count--;
+}
+
+// Appends a container built from words (keys must arrive in increasing order)
+static int appendWords(Bitmap* bitmap, unsigned int key, const unsigned long long* words) {
+    int cardinality = 0;
+    for (int w = 0; w < CONTAINER_WORDS; w++) {
+        cardinality += popcount64(words[w]);
+    }
+    if (cardinality == 0) {
+        return 0;
+    }
+
+    Container* container = insertContainer(bitmap, bitmap->count, key);
+    if (container == NULL) {
+        return -1;
+    }
+
+    container->words = (unsigned long long*)malloc(CONTAINER_WORDS * sizeof(unsigned long long));
+    if (container->words == NULL) {
+        printf("Error: Memory allocation for bitmap failed\n");
+        return -1;
+    }
+    memcpy(container->words, words, CONTAINER_WORDS * sizeof(unsigned long long));
+    container->type = TYPE_BITS;
+    container->cardinality = cardinality;
+
+    if (cardinality <= BITMAP_ARRAY_LIMIT) {
+        return bitsToArray(container);
+    }
+    return 0;
+}
+
+static int appendCopy(Bitmap* bitmap, const Container* source) {
+    Container* container = insertContainer(bitmap, bitmap->count, source->key);
+    if (container == NULL) {
+        return -1;
+    }
+
+    *container = *source;
+    container->values = NULL;
+    container->words = NULL;
+
+    if (source->type == TYPE_ARRAY) {
+        container->capacity = source->cardinality;
+        container->values = (unsigned short*)malloc((source->cardinality + 1) * sizeof(unsigned short));
+        if (container->values != NULL) {
+            memcpy(container->values, source->values, source->cardinality * sizeof(unsigned short));
+        }
+    } else {
+        container->words = (unsigned long long*)malloc(CONTAINER_WORDS * sizeof(unsigned long long));
+        if (container->words != NULL) {
+            memcpy(container->words, source->words, CONTAINER_WORDS * sizeof(unsigned long long));
+        }
+    }
+
+    if (container->values == NULL && container->words == NULL) {
+        printf("Error: Memory allocation for bitmap failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Combines two containers with the same key and appends the result
+static int appendCombined(Bitmap* bitmap, const Container* a, const Container* b, BitmapOp op) {
+    unsigned long long left[CONTAINER_WORDS];
+    unsigned long long right[CONTAINER_WORDS];
+
+    if (a->type == TYPE_ARRAY && b->type == TYPE_ARRAY && op != OP_OR) {
+        // Small case: merge the two sorted arrays directly
+        Container* container = insertContainer(bitmap, bitmap->count, a->key);
+        if (container == NULL) {
+            return -1;
+        }
+        container->values = (unsigned short*)malloc((a->cardinality + 1) * sizeof(unsigned short));
+        if (container->values == NULL) {
+            printf("Error: Memory allocation for bitmap failed\n");
+            return -1;
+        }
+        container->capacity = a->cardinality + 1;
+
+        int i = 0;
+        int j = 0;
+        while (i < a->cardinality) {
+            while (j < b->cardinality && b->values[j] < a->values[i]) {
+                j++;
+            }
+            int inB = j < b->cardinality && b->values[j] == a->values[i];
+            if ((op == OP_AND) == inB) {
+                container->values[container->cardinality++] = a->values[i];
+            }
+            i++;
+        }
+
+        if (container->cardinality == 0) {
+            removeContainerAt(bitmap, bitmap->count - 1);
+        }
+        return 0;
+    }
+
+    containerToWords(a, left);
+    containerToWords(b, right);
+    for (int w = 0; w < CONTAINER_WORDS; w++) {
+        switch (op) {
+            case OP_AND:    left[w] &= right[w]; break;
+            case OP_OR:     left[w] |= right[w]; break;
+            case OP_ANDNOT: left[w] &= ~right[w]; break;
+        }
+    }
+    return appendWords(bitmap, a->key, left);
+}
+
+static Bitmap* combine(const Bitmap* a, const Bitmap* b, BitmapOp op) {
+    if (a == NULL || b == NULL) {
+        return NULL;
+    }
+
+    Bitmap* result = createBitmap();
+    if (result == NULL) {
+        return NULL;
+    }
+
+    int i = 0;
+    int j = 0;
+    int status = 0;
+    while (status == 0 && (i < a->count || j < b->count)) {
+        if (j == b->count || (i < a->count && a->containers[i].key < b->containers[j].key)) {
+            // Key only in a
+            if (op != OP_AND) {
+                status = appendCopy(result, &a->containers[i]);
+            }
+            i++;
+        } else if (i == a->count || b->containers[j].key < a->containers[i].key) {
+            // Key only in b
+            if (op == OP_OR) {
+                status = appendCopy(result, &b->containers[j]);
+            }
+            j++;
+        } else {
+            status = appendCombined(result, &a->containers[i], &b->containers[j], op);
+            i++;
+            j++;
+        }
+    }
+
+    if (status != 0) {
+        freeBitmap(result);
+        return NULL;
+    }
+    return result;
+}
+
+/*
+ * Public functions
+ */
+
+Bitmap* createBitmap() {
+    Bitmap* bitmap = (Bitmap*)calloc(1, sizeof(Bitmap));
+    if (bitmap == NULL) {
+        printf("Error: Memory allocation for bitmap failed\n");
+    }
+    return bitmap;
+}
+
+void freeBitmap(Bitmap* bitmap) {
+    if (bitmap == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < bitmap->count; i++) {
+        freeContainer(&bitmap->containers[i]);
+    }
+    free(bitmap->containers);
+    free(bitmap);
+}
+
+int bitmapAdd(Bitmap* bitmap, unsigned int position) {
+    unsigned int key = position >> 16;
+    int at = findContainer(bitmap, key);
+
+    if (at < 0) {
+        if (insertContainer(bitmap, -at - 1, key) == NULL) {
+            return -1;
+        }
+        at = -at - 1;
+    }
+    return containerAdd(&bitmap->containers[at], (unsigned short)(position & 0xFFFF));
+}
+
+int bitmapRemove(Bitmap* bitmap, unsigned int position) {
+    int at = findContainer(bitmap, position >> 16);
+    if (at < 0) {
+        return 0;
+    }
+
+    int result = containerRemove(&bitmap->containers[at], (unsigned short)(position & 0xFFFF));
+    if (bitmap->containers[at].cardinality == 0) {
+        removeContainerAt(bitmap, at);
+    }
+    return result;
+}
+
+int bitmapContains(const Bitmap* bitmap, unsigned int position) {
+    int at = findContainer(bitmap, position >> 16);
+    return at >= 0 && containerContains(&bitmap->containers[at], (unsigned short)(position & 0xFFFF));
+}
+
+long bitmapCardinality(const Bitmap* bitmap) {
+    long total = 0;
+    if (bitmap != NULL) {
+        for (int i = 0; i < bitmap->count; i++) {
+            total += bitmap->containers[i].cardinality;
+        }
+    }
+    return total;
+}
+
+Bitmap* bitmapAnd(const Bitmap* a, const Bitmap* b) {
+    return combine(a, b, OP_AND);
+}
+
+Bitmap* bitmapOr(const Bitmap* a, const Bitmap* b) {
+    return combine(a, b, OP_OR);
+}
+
+Bitmap* bitmapAndNot(const Bitmap* a, const Bitmap* b) {
+    return combine(a, b, OP_ANDNOT);
+}
+
+int bitmapOrInPlace(Bitmap* target, const Bitmap* source) {
+    Bitmap* merged = combine(target, source, OP_OR);
+    if (merged == NULL) {
+        return -1;
+    }
+
+    // Swap the merged containers into target and free the old ones
+    Bitmap old = *target;
+    *target = *merged;
+    *merged = old;
+    freeBitmap(merged);
+    return 0;
+}
+
+long bitmapToArray(const Bitmap* bitmap, unsigned int* positions) {
+    long count = 0;
+
+    for (int i = 0; i < bitmap->count; i++) {
+        const Container* container = &bitmap->containers[i];
+        unsigned int high = container->key << 16;
+
+        if (container->type == TYPE_ARRAY) {
+            for (int j = 0; j < container->cardinality; j++) {
+                positions[count++] = high | container->values[j];
+            }
+        } else {
+            for (int w = 0; w < CONTAINER_WORDS; w++) {
+                unsigned long long word = container->words[w];
+                while (word != 0) {
+                    int bit = 0;
+                    while (!(word & (1ULL << bit))) {
+                        bit++;
+                    }
+                    positions[count++] = high | (unsigned int)(w * 64 + bit);
+                    word &= word - 1;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+int bitmapRemoveShift(Bitmap* bitmap, unsigned int position) {
+    unsigned int key = position >> 16;
+
+    if (bitmapRemove(bitmap, position) < 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < bitmap->count; i++) {
+        if (bitmap->containers[i].key < key) {
+            continue;
+        }
+        if (bitmap->containers[i].key == key) {
+            containerShiftDown(&bitmap->containers[i], (unsigned short)(position & 0xFFFF));
+            continue;
+        }
+
+        // Position 0 of this container becomes 0xFFFF of the previous key
+        unsigned int currentKey = bitmap->containers[i].key;
+        int carry = containerContains(&bitmap->containers[i], 0);
+        if (carry && containerRemove(&bitmap->containers[i], 0) < 0) {
+            return -1;
+        }
+        containerShiftDown(&bitmap->containers[i], 0);
+
+        if (carry) {
+            if (i > 0 && bitmap->containers[i - 1].key == currentKey - 1) {
+                if (containerAdd(&bitmap->containers[i - 1], 0xFFFF) < 0) {
+                    return -1;
+                }
+            } else {
+                Container* previous = insertContainer(bitmap, i, currentKey - 1);
+                if (previous == NULL || containerAdd(previous, 0xFFFF) < 0) {
+                    return -1;
+                }
+                i++;
+            }
+        }
+
+        if (bitmap->containers[i].cardinality == 0) {
+            removeContainerAt(bitmap, i);
+            i--;
+        }
+    }
+    return 0;
+}
+
+int bitmapInsertShift(Bitmap* bitmap, unsigned int position) {
+    unsigned int key = position >> 16;
+
+    for (int i = bitmap->count - 1; i >= 0 && bitmap->containers[i].key >= key; i--) {
+        unsigned int currentKey = bitmap->containers[i].key;
+
+        // Position 0xFFFF of this container becomes 0 of the next key
+        int carry = containerContains(&bitmap->containers[i], 0xFFFF);
+        if (carry && containerRemove(&bitmap->containers[i], 0xFFFF) < 0) {
+            return -1;
+        }
+        containerShiftUp(&bitmap->containers[i], currentKey == key ? (unsigned short)(position & 0xFFFF) : 0);
+
+        if (carry) {
+            if (i + 1 < bitmap->count && bitmap->containers[i + 1].key == currentKey + 1) {
+                if (containerAdd(&bitmap->containers[i + 1], 0) < 0) {
+                    return -1;
+                }
+            } else {
+                Container* next = insertContainer(bitmap, i + 1, currentKey + 1);
+                if (next == NULL || containerAdd(next, 0) < 0) {
+                    return -1;
+                }
+            }
+        }
+
+        if (bitmap->containers[i].cardinality == 0) {
+            removeContainerAt(bitmap, i);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * Bitmap Header File
+ * Compressed bitmap of 32-bit positions, in the style of roaring bitmaps.
+ *
+ * Positions are split into a 16-bit key (high half) and a 16-bit low half. Each key owns
+ * one container: a sorted array of low halves while it holds at most
+ * BITMAP_ARRAY_LIMIT positions, otherwise a plain 65536-bit bitmap.
+ */
+
+#ifndef BITMAP_H
+#define BITMAP_H
+
+#define BITMAP_ARRAY_LIMIT 4096  // Largest container stored as a sorted array
+
+typedef struct Bitmap Bitmap;
+
+/*
+ * Functions: createBitmap, freeBitmap
+ * Purpose: Create an empty bitmap / free a bitmap and its containers.
+ */
+Bitmap* createBitmap();
+void freeBitmap(Bitmap*);
+
+/*
+ * Functions: bitmapAdd, bitmapRemove, bitmapContains
+ * Purpose: Set, clear and test a single position.
+ * Returns: bitmapAdd / bitmapRemove - 1 if the bitmap changed, 0 if not, -1 if allocation failed
+ */
+int bitmapAdd(Bitmap*, unsigned int);
+int bitmapRemove(Bitmap*, unsigned int);
+int bitmapContains(const Bitmap*, unsigned int);
+
+/*
+ * Function: bitmapCardinality
+ * Purpose: Number of positions set. O(number of containers).
+ */
+long bitmapCardinality(const Bitmap*);
+
+/*
+ * Functions: bitmapAnd, bitmapOr, bitmapAndNot
+ * Purpose: Combine two bitmaps into a new one (a & b, a | b, a & ~b).
+ * Returns: the new bitmap, or NULL if allocation failed
+ */
+Bitmap* bitmapAnd(const Bitmap*, const Bitmap*);
+Bitmap* bitmapOr(const Bitmap*, const Bitmap*);
+Bitmap* bitmapAndNot(const Bitmap*, const Bitmap*);
+
+/*
+ * Function: bitmapOrInPlace
+ * Purpose: target |= source, used to union many bitmaps without temporaries.
+ * Returns: 0 on success, -1 if allocation failed
+ */
+int bitmapOrInPlace(Bitmap*, const Bitmap*);
+
+/*
+ * Function: bitmapToArray
+ * Purpose: Writes the positions in increasing order.
+ * Parameters: const Bitmap* - the bitmap
+ *             unsigned int* - output, room for bitmapCardinality positions
+ * Returns: number of positions written
+ */
+long bitmapToArray(const Bitmap*, unsigned int*);
+
+/*
+ * Functions: bitmapInsertShift, bitmapRemoveShift
+ * Purpose: Keep positions in step with a garage that gained or lost an element.
+ *          bitmapInsertShift moves every position >= p up by one (p itself ends up clear).
+ *          bitmapRemoveShift clears p and moves every position > p down by one.
+ * Returns: 0 on success, -1 if allocation failed
+ */
+int bitmapInsertShift(Bitmap*, unsigned int);
+int bitmapRemoveShift(Bitmap*, unsigned int);
+
+#endif /* BITMAP_H */
@@ -0,0 +1,85 @@
+/*
+ * Byte IO
+ * Little endian fields and full reads and writes.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "byte_io.h"
+
+#ifndef _WIN32
+    #include <errno.h>
+    #include <unistd.h>
+#endif
+
+void putU16(unsigned char* bytes, unsigned int value) {
+    bytes[0] = (unsigned char)value;
+    bytes[1] = (unsigned char)(value >> 8);
+}
+
+void putU32(unsigned char* bytes, unsigned int value) {
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+void putU64(unsigned char* bytes, unsigned long long value) {
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+unsigned int getU16(const unsigned char* bytes) {
+    return bytes[0] | (unsigned int)bytes[1] << 8;
+}
+
+unsigned int getU32(const unsigned char* bytes) {
+    return bytes[0] | (unsigned int)bytes[1] << 8 | (unsigned int)bytes[2] << 16 | (unsigned int)bytes[3] << 24;
+}
+
+unsigned long long getU64(const unsigned char* bytes) {
+    return getU32(bytes) | (unsigned long long)getU32(bytes + 4) << 32;
+}
+
+size_t alignUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+#ifndef _WIN32
+
+int writeAll(int fd, const void* data, size_t length) {
+    const char* bytes = (const char*)data;
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return -1;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+int readAll(int fd, void* data, size_t length, off_t offset) {
+    char* bytes = (char*)data;
+    while (length > 0) {
+        ssize_t got = pread(fd, bytes, length, offset);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return -1;
+        }
+        bytes += got;
+        length -= (size_t)got;
+        offset += got;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*
+ * Byte IO Header File
+ * Little endian field encoding and whole-buffer file IO shared by the file and wire formats.
+ */
+
+#ifndef BYTE_IO_H
+#define BYTE_IO_H
+
+#include <stddef.h>
+
+#ifndef _WIN32
+    #include <sys/types.h>
+#endif
+
+/*
+ * Function: putU16 / putU32 / putU64
+ * Purpose: Stores a value little endian at any alignment.
+ * Parameters: unsigned char* - destination, 2, 4 or 8 bytes
+ *             value - the value to store
+ */
+void putU16(unsigned char*, unsigned int);
+void putU32(unsigned char*, unsigned int);
+void putU64(unsigned char*, unsigned long long);
+
+/*
+ * Function: getU16 / getU32 / getU64
+ * Purpose: Reads a value stored by putU16, putU32 or putU64.
+ * Parameters: const unsigned char* - source, 2, 4 or 8 bytes
+ * Returns: the value
+ */
+unsigned int getU16(const unsigned char*);
+unsigned int getU32(const unsigned char*);
+unsigned long long getU64(const unsigned char*);
+
+/*
+ * Function: alignUp
+ * Purpose: Rounds a size up to a multiple of an alignment.
+ * Parameters: size_t - size
+ *             size_t - alignment, greater than 0
+ * Returns: the rounded size
+ */
+size_t alignUp(size_t, size_t);
+
+#ifndef _WIN32
+
+/*
+ * Function: writeAll
+ * Purpose: Writes a whole buffer at the file position, continuing short and interrupted writes.
+ * Parameters: int - file descriptor
+ *             const void* - data
+ *             size_t - number of bytes
+ * Returns: 0, or -1 if a write failed (errno is set)
+ */
+int writeAll(int, const void*, size_t);
+
+/*
+ * Function: readAll
+ * Purpose: Reads a whole buffer from an offset with pread, continuing short and interrupted reads.
+ * Parameters: int - file descriptor
+ *             void* - destination
+ *             size_t - number of bytes
+ *             off_t - offset in the file
+ * Returns: 0, or -1 if a read failed or the file ended first
+ */
+int readAll(int, void*, size_t, off_t);
+
+#endif
+
+#endif /* BYTE_IO_H */
@@ -0,0 +1,631 @@
+/*
+ * Garage Archive
+ * Sorted, block-compressed garage files with a block index for random access.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vehicle.h"
+#include "byte_io.h"
+#include "hash.h"
+#include "lz.h"
+#include "parallel.h"
+#include "garage_archive.h"
+
+#ifndef _WIN32
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <stdatomic.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+#endif
+
+#define ARCHIVE_HEADER_SIZE 32
+#define ARCHIVE_INDEX_ENTRY_SIZE 48
+#define ARCHIVE_TRAILER_SIZE 24
+#define ARCHIVE_WRITE_ROUND 256                    // Blocks compressed together before they are written
+#define ARCHIVE_MAX_RAW_BLOCK (1u << 30)           // Largest uncompressed block accepted when reading
+#define ARCHIVE_CHECKSUM_SEED 0x4741524348495645ull
+
+#define ARCHIVE_CODEC_STORED 0  // Block kept as is, compression did not help
+#define ARCHIVE_CODEC_LZ 1
+
+/*
+ * File layout, little endian:
+ *   header:  "GARC", version, valueBits, yearBase, blockSize, numVehicles, numBlocks, reserved
+ *   blocks:  back to back from offset ARCHIVE_HEADER_SIZE
+ *   index:   per block u64 offset, storedSize, rawSize, firstPosition, count, firstHeader,
+ *            lastHeader, codec, reserved, u64 checksum of the stored bytes
+ *   trailer: u64 index offset, u64 index checksum, numBlocks, "GEND"
+ * A decompressed block is its records in format v1, back to back.
+ */
+
+typedef struct {
+    unsigned long long offset;
+    unsigned int storedSize;
+    unsigned int rawSize;
+    unsigned int firstPosition;
+    unsigned int count;
+    unsigned int firstHeader;
+    unsigned int lastHeader;
+    unsigned int codec;
+    unsigned long long checksum;
+} ArchiveBlock;
+
+#ifndef _WIN32
+
+struct GarageArchive {
+    int fd;
+    char* path;
+    ArchiveBlock* blocks;
+    int numBlocks;
+    int numVehicles;
+    atomic_llong blocksRead;
+};
+
+// Header of a v1 record; read byte by byte because records in a block are not aligned
+static unsigned int recordHeader(const char* record) {
+    const unsigned char* bytes = (const unsigned char*)record;
+    return (unsigned int)bytes[0] << 24 | (unsigned int)bytes[1] << 16 | (unsigned int)bytes[2] << 8 | bytes[3];
+}
+
+typedef struct {
+    unsigned int header;
+    int position;
+} ArchiveKey;
+
+static int compareKeys(const void* a, const void* b) {
+    const ArchiveKey* left = (const ArchiveKey*)a;
+    const ArchiveKey* right = (const ArchiveKey*)b;
+    if (left->header != right->header) {
+        return left->header < right->header ? -1 : 1;
+    }
+    return (left->position > right->position) - (left->position < right->position);
+}
+
+typedef struct {
+    char** garage;
+    const ArchiveKey* keys;  // Vehicles in header order
+    ArchiveBlock* blocks;
+    char** stored;           // Stored bytes of each block in the current round
+    int first;               // First block of the current round
+} ArchiveWriteJob;
+
+// Builds one block's records and compresses them
+static void compressBlockTask(void* context, int begin, int end, int worker) {
+    ArchiveWriteJob* job = (ArchiveWriteJob*)context;
+    (void)worker;
+
+    for (int i = begin; i < end; i++) {
+        ArchiveBlock* block = &job->blocks[job->first + i];
+        char* raw = (char*)malloc(block->rawSize);
+        char* compressed = (char*)malloc(lzCompressBound(block->rawSize));
+        if (raw == NULL || compressed == NULL) {
+            free(raw);
+            free(compressed);
+            job->stored[i] = NULL;
+            continue;
+        }
+
+        size_t offset = 0;
+        for (unsigned int k = 0; k < block->count; k++) {
+            const ArchiveKey* key = &job->keys[block->firstPosition + k];
+            const char* vehicle = job->garage[key->position];
+            offset += encodeVehicleRecord(raw + offset, key->header, vehicleDescription(vehicle),
+                                          vehicleDescriptionLength(vehicle));
+        }
+
+        size_t size = lzCompress(raw, block->rawSize, compressed, lzCompressBound(block->rawSize));
+        if (size > 0 && size < block->rawSize) {
+            free(raw);
+            block->codec = ARCHIVE_CODEC_LZ;
+            block->storedSize = (unsigned int)size;
+            job->stored[i] = compressed;
+        } else {
+            free(compressed);
+            block->codec = ARCHIVE_CODEC_STORED;
+            block->storedSize = block->rawSize;
+            job->stored[i] = raw;
+        }
+        block->checksum = hashBytes(job->stored[i], block->storedSize, ARCHIVE_CHECKSUM_SEED);
+    }
+}
+
+// Cuts the sorted vehicles into blocks. Returns the number of blocks, or -1 if allocation failed.
+static int planBlocks(char** garage, const ArchiveKey* keys, int count, ArchiveBlock** blocks) {
+    int capacity = 64;
+    int numBlocks = 0;
+    ArchiveBlock* planned = (ArchiveBlock*)malloc(capacity * sizeof(ArchiveBlock));
+
+    for (int i = 0; planned != NULL && i < count; i++) {
+        size_t recordSize = 4 + (size_t)vehicleDescriptionLength(garage[keys[i].position]) + 1;
+        ArchiveBlock* block = numBlocks > 0 ? &planned[numBlocks - 1] : NULL;
+        if (block == NULL || block->rawSize + recordSize > ARCHIVE_BLOCK_SIZE) {
+            if (numBlocks == capacity) {
+                capacity *= 2;
+                ArchiveBlock* grown = (ArchiveBlock*)realloc(planned, capacity * sizeof(ArchiveBlock));
+                if (grown == NULL) {
+                    free(planned);
+                    planned = NULL;
+                    break;
+                }
+                planned = grown;
+            }
+            block = &planned[numBlocks++];
+            memset(block, 0, sizeof(ArchiveBlock));
+            block->firstPosition = (unsigned int)i;
+            block->firstHeader = keys[i].header;
+        }
+        block->rawSize += (unsigned int)recordSize;
+        block->count++;
+        block->lastHeader = keys[i].header;
+    }
+    *blocks = planned;
+    return planned != NULL ? numBlocks : -1;
+}
+
+int writeGarageArchive(const char* path, char** garage, int numVehicles, int numThreads) {
+    if (path == NULL || path[0] == '\0') {
+        printf("Error: Archive path is empty\n");
+        return -1;
+    }
+    if (numVehicles < 0 || (garage == NULL && numVehicles > 0)) {
+        printf("Error: Garage pointer is NULL\n");
+        return -1;
+    }
+
+    // Header order; equal headers keep garage order
+    ArchiveKey* keys = (ArchiveKey*)malloc((numVehicles > 0 ? numVehicles : 1) * sizeof(ArchiveKey));
+    if (keys == NULL) {
+        printf("Error: Memory allocation for archive writer failed\n");
+        return -1;
+    }
+    int count = 0;
+    for (int i = 0; i < numVehicles; i++) {
+        if (garage[i] != NULL) {
+            if (vehicleDescriptionLength(garage[i]) > ARCHIVE_MAX_RAW_BLOCK - 5) {
+                printf("Error: Vehicle %d has a description too long to archive\n", i);
+                free(keys);
+                return -1;
+            }
+            keys[count].header = vehicleHeader(garage[i]);
+            keys[count].position = i;
+            count++;
+        }
+    }
+    qsort(keys, count, sizeof(ArchiveKey), compareKeys);
+
+    ArchiveBlock* blocks;
+    int numBlocks = planBlocks(garage, keys, count, &blocks);
+    size_t pathLength = strlen(path);
+    char* temporary = (char*)malloc(pathLength + 5);
+    char** stored = (char**)calloc(ARCHIVE_WRITE_ROUND, sizeof(char*));
+    unsigned char* index = numBlocks >= 0 ? (unsigned char*)malloc((size_t)numBlocks * ARCHIVE_INDEX_ENTRY_SIZE + 1) : NULL;
+    if (numBlocks < 0 || temporary == NULL || stored == NULL || index == NULL) {
+        printf("Error: Memory allocation for archive writer failed\n");
+        free(keys); free(blocks); free(temporary); free(stored); free(index);
+        return -1;
+    }
+    memcpy(temporary, path, pathLength);
+    memcpy(temporary + pathLength, ".tmp", 5);
+
+    int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    unsigned char header[ARCHIVE_HEADER_SIZE] = {0};
+    memcpy(header, "GARC", 4);
+    putU32(header + 4, ARCHIVE_FILE_VERSION);
+    putU32(header + 8, VEHICLE_VALUE_BITS);
+    putU32(header + 12, VEHICLE_YEAR_BASE);
+    putU32(header + 16, ARCHIVE_BLOCK_SIZE);
+    putU32(header + 20, (unsigned int)count);
+    putU32(header + 24, (unsigned int)numBlocks);
+    int failed = fd < 0 || writeAll(fd, header, ARCHIVE_HEADER_SIZE) != 0;
+
+    // Compress a round of blocks in parallel, then append them in order
+    unsigned long long offset = ARCHIVE_HEADER_SIZE;
+    ArchiveWriteJob job = {garage, keys, blocks, stored, 0};
+    for (int first = 0; !failed && first < numBlocks; first += ARCHIVE_WRITE_ROUND) {
+        int round = numBlocks - first < ARCHIVE_WRITE_ROUND ? numBlocks - first : ARCHIVE_WRITE_ROUND;
+        job.first = first;
+        parallelFor(round, numThreads, compressBlockTask, &job);
+        for (int i = 0; i < round; i++) {
+            ArchiveBlock* block = &blocks[first + i];
+            if (stored[i] == NULL || (!failed && writeAll(fd, stored[i], block->storedSize) != 0)) {
+                failed = 1;
+            }
+            block->offset = offset;
+            offset += block->storedSize;
+            free(stored[i]);
+            stored[i] = NULL;
+        }
+    }
+
+    for (int i = 0; i < numBlocks; i++) {
+        unsigned char* entry = index + (size_t)i * ARCHIVE_INDEX_ENTRY_SIZE;
+        putU64(entry, blocks[i].offset);
+        putU32(entry + 8, blocks[i].storedSize);
+        putU32(entry + 12, blocks[i].rawSize);
+        putU32(entry + 16, blocks[i].firstPosition);
+        putU32(entry + 20, blocks[i].count);
+        putU32(entry + 24, blocks[i].firstHeader);
+        putU32(entry + 28, blocks[i].lastHeader);
+        putU32(entry + 32, blocks[i].codec);
+        putU32(entry + 36, 0);
+        putU64(entry + 40, blocks[i].checksum);
+    }
+    size_t indexSize = (size_t)numBlocks * ARCHIVE_INDEX_ENTRY_SIZE;
+    unsigned char trailer[ARCHIVE_TRAILER_SIZE];
+    putU64(trailer, offset);
+    putU64(trailer + 8, hashBytes(index, indexSize, ARCHIVE_CHECKSUM_SEED));
+    putU32(trailer + 16, (unsigned int)numBlocks);
+    memcpy(trailer + 20, "GEND", 4);
+    failed = failed || writeAll(fd, index, indexSize) != 0 || writeAll(fd, trailer, ARCHIVE_TRAILER_SIZE) != 0 ||
+             fsync(fd) != 0;
+    if (fd >= 0 && close(fd) != 0) {
+        failed = 1;
+    }
+    if (!failed && rename(temporary, path) != 0) {
+        failed = 1;
+    }
+    if (failed) {
+        printf("Error: Cannot write garage archive %s\n", path);
+        unlink(temporary);
+    }
+
+    free(keys);
+    free(blocks);
+    free(temporary);
+    free(stored);
+    free(index);
+    return failed ? -1 : numBlocks;
+}
+
+// Checks the block index read from a file
+static int indexIsValid(const ArchiveBlock* blocks, int numBlocks, unsigned int numVehicles, unsigned long long indexOffset) {
+    unsigned long long offset = ARCHIVE_HEADER_SIZE;
+    unsigned long long position = 0;
+
+    for (int i = 0; i < numBlocks; i++) {
+        const ArchiveBlock* block = &blocks[i];
+        int valid = block->offset == offset && block->firstPosition == position && block->count > 0 &&
+                    block->rawSize <= ARCHIVE_MAX_RAW_BLOCK && block->rawSize >= 5ull * block->count &&
+                    block->firstHeader <= block->lastHeader &&
+                    (i == 0 || blocks[i - 1].lastHeader <= block->firstHeader) &&
+                    (block->codec == ARCHIVE_CODEC_LZ ||
+                     (block->codec == ARCHIVE_CODEC_STORED && block->storedSize == block->rawSize));
+        if (!valid) {
+            return 0;
+        }
+        offset += block->storedSize;
+        position += block->count;
+    }
+    return offset == indexOffset && position == numVehicles;
+}
+
+GarageArchive* openGarageArchive(const char* path) {
+    unsigned char header[ARCHIVE_HEADER_SIZE];
+    unsigned char trailer[ARCHIVE_TRAILER_SIZE];
+    struct stat status;
+
+    if (path == NULL) {
+        printf("Error: Archive path is NULL\n");
+        return NULL;
+    }
+    GarageArchive* archive = (GarageArchive*)calloc(1, sizeof(GarageArchive));
+    if (archive == NULL) {
+        printf("Error: Memory allocation for garage archive failed\n");
+        return NULL;
+    }
+    atomic_init(&archive->blocksRead, 0);
+    archive->path = (char*)malloc(strlen(path) + 1);
+    archive->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (archive->path == NULL || archive->fd < 0 || fstat(archive->fd, &status) != 0) {
+        printf("Error: Cannot open garage archive %s\n", path);
+        closeGarageArchive(archive);
+        return NULL;
+    }
+    strcpy(archive->path, path);
+
+    unsigned long long size = (unsigned long long)status.st_size;
+    int valid = size >= ARCHIVE_HEADER_SIZE + ARCHIVE_TRAILER_SIZE &&
+                readAll(archive->fd, header, ARCHIVE_HEADER_SIZE, 0) == 0 &&
+                readAll(archive->fd, trailer, ARCHIVE_TRAILER_SIZE, (off_t)(size - ARCHIVE_TRAILER_SIZE)) == 0 &&
+                memcmp(header, "GARC", 4) == 0 && memcmp(trailer + 20, "GEND", 4) == 0 &&
+                getU32(header + 4) == ARCHIVE_FILE_VERSION && getU32(header + 8) == VEHICLE_VALUE_BITS &&
+                getU32(header + 12) == VEHICLE_YEAR_BASE && getU32(header + 20) <= 0x7FFFFFFFu &&
+                getU32(header + 24) == getU32(trailer + 16) &&
+                getU64(trailer) + (unsigned long long)getU32(trailer + 16) * ARCHIVE_INDEX_ENTRY_SIZE +
+                    ARCHIVE_TRAILER_SIZE == size;
+
+    unsigned char* index = NULL;
+    if (valid) {
+        archive->numVehicles = (int)getU32(header + 20);
+        archive->numBlocks = (int)getU32(trailer + 16);
+        size_t indexSize = (size_t)archive->numBlocks * ARCHIVE_INDEX_ENTRY_SIZE;
+        index = (unsigned char*)malloc(indexSize + 1);
+        archive->blocks = (ArchiveBlock*)malloc(((size_t)archive->numBlocks + 1) * sizeof(ArchiveBlock));
+        valid = index != NULL && archive->blocks != NULL && archive->numBlocks >= 0 &&
+                readAll(archive->fd, index, indexSize, (off_t)getU64(trailer)) == 0 &&
+                hashBytes(index, indexSize, ARCHIVE_CHECKSUM_SEED) == getU64(trailer + 8);
+    }
+    for (int i = 0; valid && i < archive->numBlocks; i++) {
+        const unsigned char* entry = index + (size_t)i * ARCHIVE_INDEX_ENTRY_SIZE;
+        ArchiveBlock* block = &archive->blocks[i];
+        block->offset = getU64(entry);
+        block->storedSize = getU32(entry + 8);
+        block->rawSize = getU32(entry + 12);
+        block->firstPosition = getU32(entry + 16);
+        block->count = getU32(entry + 20);
+        block->firstHeader = getU32(entry + 24);
+        block->lastHeader = getU32(entry + 28);
+        block->codec = getU32(entry + 32);
+        block->checksum = getU64(entry + 40);
+    }
+    free(index);
+    if (!valid || !indexIsValid(archive->blocks, archive->numBlocks, (unsigned int)archive->numVehicles, getU64(trailer))) {
+        printf("Error: %s is not a usable garage archive\n", path);
+        closeGarageArchive(archive);
+        return NULL;
+    }
+    return archive;
+}
+
+int garageArchiveCount(const GarageArchive* archive) {
+    return archive != NULL ? archive->numVehicles : 0;
+}
+
+int garageArchiveBlocks(const GarageArchive* archive) {
+    return archive != NULL ? archive->numBlocks : 0;
+}
+
+long long garageArchiveBlocksRead(const GarageArchive* archive) {
+    return archive != NULL ? atomic_load(&((GarageArchive*)archive)->blocksRead) : 0;
+}
+
+// Reads, checks and decompresses one block and finds where its records start.
+// Returns the records (free with free()), or NULL after reporting the error.
+static char* readBlock(GarageArchive* archive, int index, const char** records) {
+    const ArchiveBlock* block = &archive->blocks[index];
+    char* stored = (char*)malloc(block->storedSize > 0 ? block->storedSize : 1);
+    char* raw = NULL;
+
+    atomic_fetch_add(&archive->blocksRead, 1);
+    int valid = stored != NULL && readAll(archive->fd, stored, block->storedSize, (off_t)block->offset) == 0 &&
+                hashBytes(stored, block->storedSize, ARCHIVE_CHECKSUM_SEED) == block->checksum;
+    if (valid && block->codec == ARCHIVE_CODEC_LZ) {
+        raw = (char*)malloc(block->rawSize);
+        valid = raw != NULL && lzDecompress(stored, block->storedSize, raw, block->rawSize) == (long)block->rawSize;
+        free(stored);
+    } else {
+        raw = stored;
+    }
+
+    // Records must fill the block exactly, in header order, between the index's first and last header
+    size_t offset = 0;
+    unsigned int previous = block->firstHeader;
+    for (unsigned int i = 0; valid && i < block->count; i++) {
+        const char* record = raw + offset;
+        const char* end = block->rawSize - offset >= 5 ? (const char*)memchr(record + 4, '\0', block->rawSize - offset - 4) : NULL;
+        unsigned int header = end != NULL ? recordHeader(record) : 0;
+        valid = end != NULL && !isReservedVehicleRecord(record) && header >= previous && (i > 0 || header == block->firstHeader);
+        records[i] = record;
+        previous = header;
+        offset = end != NULL ? (size_t)(end - raw) + 1 : offset;
+    }
+    if (!valid || offset != block->rawSize || previous != block->lastHeader) {
+        printf("Error: Block %d of garage archive %s is damaged\n", index, archive->path);
+        free(raw);
+        return NULL;
+    }
+    return raw;
+}
+
+static char* copyRecord(const char* record) {
+    const char* description = record + 4;
+    return buildVehicleRecord(recordHeader(record), description, (int)strlen(description));
+}
+
+// Reads one block and copies one of its records
+static char* blockVehicle(GarageArchive* archive, int index, unsigned int slot) {
+    const char** records = (const char**)malloc(archive->blocks[index].count * sizeof(char*));
+    char* raw = records != NULL ? readBlock(archive, index, records) : NULL;
+    char* vehicle = raw != NULL ? copyRecord(records[slot]) : NULL;
+    free(raw);
+    free(records);
+    return vehicle;
+}
+
+char* archiveFindVehicle(GarageArchive* archive, unsigned int header) {
+    if (archive == NULL) {
+        printf("Error: Garage archive is NULL\n");
+        return NULL;
+    }
+
+    // The first match lies in the first block whose last header is not below the key
+    int low = 0;
+    int high = archive->numBlocks;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (archive->blocks[middle].lastHeader < header) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == archive->numBlocks || archive->blocks[low].firstHeader > header) {
+        return NULL;  // Ruled out by the index alone
+    }
+
+    const ArchiveBlock* block = &archive->blocks[low];
+    const char** records = (const char**)malloc(block->count * sizeof(char*));
+    char* raw = records != NULL ? readBlock(archive, low, records) : NULL;
+    char* vehicle = NULL;
+    for (unsigned int i = 0; raw != NULL && i < block->count; i++) {
+        unsigned int found = recordHeader(records[i]);
+        if (found >= header) {
+            vehicle = found == header ? copyRecord(records[i]) : NULL;
+            break;
+        }
+    }
+    free(raw);
+    free(records);
+    return vehicle;
+}
+
+char* archiveVehicleAt(GarageArchive* archive, int position) {
+    if (archive == NULL) {
+        printf("Error: Garage archive is NULL\n");
+        return NULL;
+    }
+    if (position < 0 || position >= archive->numVehicles) {
+        printf("Error: Position %d is out of range\n", position);
+        return NULL;
+    }
+
+    int low = 0;
+    int high = archive->numBlocks - 1;
+    while (low < high) {
+        int middle = low + (high - low + 1) / 2;
+        if (archive->blocks[middle].firstPosition <= (unsigned int)position) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return blockVehicle(archive, low, (unsigned int)position - archive->blocks[low].firstPosition);
+}
+
+typedef struct {
+    GarageArchive* archive;
+    char** garage;
+    int* results;  // 0 or -1 for each block
+} ArchiveLoadJob;
+
+static void loadBlockTask(void* context, int begin, int end, int worker) {
+    ArchiveLoadJob* job = (ArchiveLoadJob*)context;
+    (void)worker;
+
+    for (int i = begin; i < end; i++) {
+        const ArchiveBlock* block = &job->archive->blocks[i];
+        const char** records = (const char**)malloc(block->count * sizeof(char*));
+        char* raw = records != NULL ? readBlock(job->archive, i, records) : NULL;
+        job->results[i] = raw != NULL ? 0 : -1;
+        for (unsigned int k = 0; raw != NULL && k < block->count; k++) {
+            char* vehicle = copyRecord(records[k]);
+            job->garage[block->firstPosition + k] = vehicle;
+            if (vehicle == NULL) {
+                job->results[i] = -1;
+            }
+        }
+        free(raw);
+        free(records);
+    }
+}
+
+char** loadGarageArchive(GarageArchive* archive, int numThreads, int* numVehicles) {
+    if (archive == NULL || numVehicles == NULL) {
+        printf("Error: Garage archive is NULL\n");
+        return NULL;
+    }
+
+    char** garage = (char**)calloc(archive->numVehicles > 0 ? archive->numVehicles : 1, sizeof(char*));
+    int* results = (int*)calloc(archive->numBlocks > 0 ? archive->numBlocks : 1, sizeof(int));
+    if (garage == NULL || results == NULL) {
+        printf("Error: Memory allocation for garage failed\n");
+        free(garage);
+        free(results);
+        return NULL;
+    }
+
+    ArchiveLoadJob job = {archive, garage, results};
+    if (archive->numBlocks > 0) {
+        parallelFor(archive->numBlocks, numThreads, loadBlockTask, &job);
+    }
+    int failed = 0;
+    for (int i = 0; i < archive->numBlocks; i++) {
+        failed |= results[i] != 0;
+    }
+    free(results);
+    if (failed) {
+        // Never part of a live garage, so nothing is reported to the listeners
+        for (int i = 0; i < archive->numVehicles; i++) {
+            freeVehicle(garage[i]);
+        }
+        free(garage);
+        return NULL;
+    }
+    *numVehicles = archive->numVehicles;
+    return garage;
+}
+
+void closeGarageArchive(GarageArchive* archive) {
+    if (archive == NULL) {
+        return;
+    }
+    if (archive->fd >= 0) {
+        close(archive->fd);
+    }
+    free(archive->path);
+    free(archive->blocks);
+    free(archive);
+}
+
+#else
+
+// Garage archives need POSIX file calls; every call reports that
+
+struct GarageArchive {
+    int unused;
+};
+
+int writeGarageArchive(const char* path, char** garage, int numVehicles, int numThreads) {
+    (void)path; (void)garage; (void)numVehicles; (void)numThreads;
+    printf("Error: Garage archives are not supported on this platform\n");
+    return -1;
+}
+
+GarageArchive* openGarageArchive(const char* path) {
+    (void)path;
+    printf("Error: Garage archives are not supported on this platform\n");
+    return NULL;
+}
+
+int garageArchiveCount(const GarageArchive* archive) {
+    (void)archive;
+    return 0;
+}
+
+int garageArchiveBlocks(const GarageArchive* archive) {
+    (void)archive;
+    return 0;
+}
+
+long long garageArchiveBlocksRead(const GarageArchive* archive) {
+    (void)archive;
+    return 0;
+}
+
+char* archiveFindVehicle(GarageArchive* archive, unsigned int header) {
+    (void)archive; (void)header;
+    return NULL;
+}
+
+char* archiveVehicleAt(GarageArchive* archive, int position) {
+    (void)archive; (void)position;
+    return NULL;
+}
+
+char** loadGarageArchive(GarageArchive* archive, int numThreads, int* numVehicles) {
+    (void)archive; (void)numThreads; (void)numVehicles;
+    return NULL;
+}
+
+void closeGarageArchive(GarageArchive* archive) {
+    (void)archive;
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Garage Archive Header File
+ * Block-compressed garage files for large, rarely read garages.
+ *
+ * Vehicles are sorted by packed header and their records (format v1) are grouped into
+ * blocks of about ARCHIVE_BLOCK_SIZE uncompressed bytes. Each block is compressed on its own
+ * with the built-in LZ codec (or stored as is when that does not help). A block index at the
+ * end of the file gives the offset, first and last header, first position and checksum of
+ * every block, so a point lookup reads and decompresses a single block, and a full load
+ * decompresses the blocks in parallel.
+ */
+
+#ifndef GARAGE_ARCHIVE_H
+#define GARAGE_ARCHIVE_H
+
+#define ARCHIVE_FILE_VERSION 1     // Bumped when the archive format changes
+#define ARCHIVE_BLOCK_SIZE 32768   // Uncompressed record bytes per block (a block holds at least one record)
+
+typedef struct GarageArchive GarageArchive;
+
+/*
+ * Function: writeGarageArchive
+ * Purpose: Writes a garage as an archive, compressing the blocks in parallel. NULL slots are
+ *          skipped and vehicles with equal headers keep their garage order. The file is
+ *          written under a temporary name and renamed into place.
+ * Parameters: const char* - path of the archive
+ *             char** - pointer to the garage (may be NULL for an empty garage)
+ *             int - number of vehicles in the garage
+ *             int - number of compressing threads (0 or less means defaultThreadCount)
+ * Returns: number of blocks written, or -1 on error
+ */
+int writeGarageArchive(const char*, char**, int, int);
+
+/*
+ * Function: openGarageArchive
+ * Purpose: Opens an archive and reads its block index. No block is read yet.
+ * Returns: the archive, or NULL if the file is missing, damaged or uses another header layout
+ */
+GarageArchive* openGarageArchive(const char*);
+
+/*
+ * Functions: garageArchiveCount, garageArchiveBlocks, garageArchiveBlocksRead
+ * Purpose: Number of vehicles / number of blocks in an archive / number of blocks read and
+ *          decompressed since it was opened.
+ */
+int garageArchiveCount(const GarageArchive*);
+int garageArchiveBlocks(const GarageArchive*);
+long long garageArchiveBlocksRead(const GarageArchive*);
+
+/*
+ * Function: archiveFindVehicle
+ * Purpose: Finds the first vehicle with a packed header, decompressing at most one block.
+ * Returns: a new vehicle the caller frees, or NULL if there is none or the block is damaged
+ */
+char* archiveFindVehicle(GarageArchive*, unsigned int);
+
+/*
+ * Function: archiveVehicleAt
+ * Purpose: Vehicle at a position in header order, decompressing one block.
+ * Returns: a new vehicle the caller frees, or NULL if the position is out of range or the block is damaged
+ */
+char* archiveVehicleAt(GarageArchive*, int);
+
+/*
+ * Function: loadGarageArchive
+ * Purpose: Decompresses every block in parallel into an ordinary garage in header order.
+ * Parameters: GarageArchive* - the archive
+ *             int - number of threads (0 or less means defaultThreadCount)
+ *             int* - receives the number of vehicles
+ * Returns: a dynamically allocated garage (free it with freeGarage), or NULL on error
+ */
+char** loadGarageArchive(GarageArchive*, int, int*);
+
+/*
+ * Function: closeGarageArchive
+ * Purpose: Closes the file and frees the block index.
+ */
+void closeGarageArchive(GarageArchive*);
+
+#endif /* GARAGE_ARCHIVE_H */
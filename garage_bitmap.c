@@ -0,0 +1,240 @@
+/*
+ * Garage Bitmap Index
+ * Per-year and per-value-bucket bitmaps of garage positions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "vehicle.h"
+#include "garage_bitmap.h"
+#include "garage_scan.h"
+
+struct GarageBitmapIndex {
+    Bitmap* years[MAX_MODEL_YEAR + 1];     // NULL until a vehicle of that year is seen
+    Bitmap* buckets[NUM_VALUE_BUCKETS];    // NULL until a vehicle in that bucket is seen
+    Bitmap* empty;                         // Returned for years/buckets with no vehicles
+    int numVehicles;                       // Positions currently tracked
+};
+
+static Bitmap** bitmapSlot(Bitmap** slot) {
+    if (*slot == NULL) {
+        *slot = createBitmap();
+    }
+    return *slot == NULL ? NULL : slot;
+}
+
+// Applies a position shift to every bitmap in the index
+static int shiftAll(GarageBitmapIndex* index, int position, int inserted) {
+    for (unsigned int i = 0; i <= MAX_MODEL_YEAR; i++) {
+        if (index->years[i] != NULL) {
+            int status = inserted ? bitmapInsertShift(index->years[i], position)
+                                  : bitmapRemoveShift(index->years[i], position);
+            if (status != 0) {
+                return -1;
+            }
+        }
+    }
+    for (unsigned int i = 0; i < NUM_VALUE_BUCKETS; i++) {
+        if (index->buckets[i] != NULL) {
+            int status = inserted ? bitmapInsertShift(index->buckets[i], position)
+                                  : bitmapRemoveShift(index->buckets[i], position);
+            if (status != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int bitmapIndexInsert(GarageBitmapIndex* index, const char* vehicle, int position) {
+    if (index == NULL || vehicle == NULL || position < 0) {
+        return -1;
+    }
+
+    // Appending is the common case and needs no shifting
+    if (position < index->numVehicles && shiftAll(index, position, 1) != 0) {
+        return -1;
+    }
+    index->numVehicles++;
+
+    unsigned int packedData = vehicleHeader(vehicle);
+    Bitmap** year = bitmapSlot(&index->years[headerYear(packedData)]);
+    Bitmap** bucket = bitmapSlot(&index->buckets[headerValue(packedData) >> VALUE_BUCKET_BITS]);
+
+    if (year == NULL || bucket == NULL || bitmapAdd(*year, position) < 0 || bitmapAdd(*bucket, position) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int bitmapIndexRemove(GarageBitmapIndex* index, const char* vehicle, int position) {
+    if (index == NULL || vehicle == NULL || position < 0 || position >= index->numVehicles) {
+        return -1;
+    }
+
+    // Removing from the end needs no shifting, only the two bits of this vehicle
+    if (position == index->numVehicles - 1) {
+        unsigned int packedData = vehicleHeader(vehicle);
+        Bitmap* year = index->years[headerYear(packedData)];
+        Bitmap* bucket = index->buckets[headerValue(packedData) >> VALUE_BUCKET_BITS];
+        if (year != NULL) {
+            bitmapRemove(year, position);
+        }
+        if (bucket != NULL) {
+            bitmapRemove(bucket, position);
+        }
+    } else if (shiftAll(index, position, 0) != 0) {
+        return -1;
+    }
+
+    index->numVehicles--;
+    return 0;
+}
+
+// Moves a position between year and bucket bitmaps after its header changed
+static int bitmapIndexUpdate(GarageBitmapIndex* index, const char* vehicle, int position, unsigned int previousHeader) {
+    if (position < 0 || position >= index->numVehicles) {
+        return -1;
+    }
+
+    unsigned int packedData = vehicleHeader(vehicle);
+    Bitmap* oldYear = index->years[headerYear(previousHeader)];
+    Bitmap* oldBucket = index->buckets[headerValue(previousHeader) >> VALUE_BUCKET_BITS];
+    if (oldYear != NULL) {
+        bitmapRemove(oldYear, position);
+    }
+    if (oldBucket != NULL) {
+        bitmapRemove(oldBucket, position);
+    }
+
+    Bitmap** year = bitmapSlot(&index->years[headerYear(packedData)]);
+    Bitmap** bucket = bitmapSlot(&index->buckets[headerValue(packedData) >> VALUE_BUCKET_BITS]);
+    if (year == NULL || bucket == NULL || bitmapAdd(*year, position) < 0 || bitmapAdd(*bucket, position) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static int indexSlot(void* context, char* vehicle, int position) {
+    GarageBitmapIndex* index = (GarageBitmapIndex*)context;
+
+    if (vehicle == NULL) {
+        // Keep positions aligned with the garage even for empty slots
+        index->numVehicles++;
+        return 0;
+    }
+    return bitmapIndexInsert(index, vehicle, position) != 0;
+}
+
+GarageBitmapIndex* buildGarageBitmapIndex(char** garage, int numVehicles) {
+    GarageBitmapIndex* index = (GarageBitmapIndex*)calloc(1, sizeof(GarageBitmapIndex));
+    if (index == NULL || (index->empty = createBitmap()) == NULL) {
+        printf("Error: Memory allocation for bitmap index failed\n");
+        free(index);
+        return NULL;
+    }
+
+    if (garage == NULL) {
+        return index;
+    }
+
+    if (forEachVehicle(garage, numVehicles, indexSlot, index) != 0) {
+        freeGarageBitmapIndex(index);
+        return NULL;
+    }
+    return index;
+}
+
+const Bitmap* yearBitmap(const GarageBitmapIndex* index, unsigned int year) {
+    if (year > MAX_MODEL_YEAR || index->years[year] == NULL) {
+        return index->empty;
+    }
+    return index->years[year];
+}
+
+const Bitmap* valueBucketBitmap(const GarageBitmapIndex* index, unsigned int bucket) {
+    if (bucket >= NUM_VALUE_BUCKETS || index->buckets[bucket] == NULL) {
+        return index->empty;
+    }
+    return index->buckets[bucket];
+}
+
+static Bitmap* unionOf(Bitmap* const* bitmaps, unsigned int first, unsigned int last) {
+    Bitmap* result = createBitmap();
+
+    for (unsigned int i = first; result != NULL && i <= last; i++) {
+        if (bitmaps[i] != NULL && bitmapOrInPlace(result, bitmaps[i]) != 0) {
+            freeBitmap(result);
+            result = NULL;
+        }
+    }
+    return result;
+}
+
+Bitmap* yearRangeBitmap(const GarageBitmapIndex* index, unsigned int minYear, unsigned int maxYear) {
+    if (maxYear > MAX_MODEL_YEAR) {
+        maxYear = MAX_MODEL_YEAR;
+    }
+    if (minYear > maxYear) {
+        return createBitmap();
+    }
+    return unionOf(index->years, minYear, maxYear);
+}
+
+Bitmap* valueRangeBitmap(const GarageBitmapIndex* index, unsigned int minValue, unsigned int maxValue) {
+    if (maxValue > MAX_VEHICLE_VALUE) {
+        maxValue = MAX_VEHICLE_VALUE;
+    }
+    if (minValue > maxValue) {
+        return createBitmap();
+    }
+    return unionOf(index->buckets, minValue >> VALUE_BUCKET_BITS, maxValue >> VALUE_BUCKET_BITS);
+}
+
+long countYearValueRange(const GarageBitmapIndex* index, unsigned int minYear, unsigned int maxYear,
+                         unsigned int minValue, unsigned int maxValue) {
+    Bitmap* years = yearRangeBitmap(index, minYear, maxYear);
+    Bitmap* values = valueRangeBitmap(index, minValue, maxValue);
+    Bitmap* both = bitmapAnd(years, values);
+    long count = both == NULL ? -1 : bitmapCardinality(both);
+
+    freeBitmap(years);
+    freeBitmap(values);
+    freeBitmap(both);
+    return count;
+}
+
+static void onGarageEvent(void* context, const GarageEvent* event) {
+    GarageBitmapIndex* index = (GarageBitmapIndex*)context;
+
+    if (event->type == GARAGE_EVENT_INSERT) {
+        bitmapIndexInsert(index, event->vehicle, event->position);
+    } else if (event->type == GARAGE_EVENT_REMOVE) {
+        bitmapIndexRemove(index, event->vehicle, event->position);
+    } else if (event->type == GARAGE_EVENT_UPDATE) {
+        bitmapIndexUpdate(index, event->vehicle, event->position, event->previousHeader);
+    }
+}
+
+int attachGarageBitmapIndex(GarageBitmapIndex* index, GarageListeners* listeners) {
+    return addGarageListener(listeners, onGarageEvent, index);
+}
+
+void detachGarageBitmapIndex(GarageBitmapIndex* index, GarageListeners* listeners) {
+    removeGarageListener(listeners, onGarageEvent, index);
+}
+
+void freeGarageBitmapIndex(GarageBitmapIndex* index) {
+    if (index == NULL) {
+        return;
+    }
+
+    for (unsigned int i = 0; i <= MAX_MODEL_YEAR; i++) {
+        freeBitmap(index->years[i]);
+    }
+    for (unsigned int i = 0; i < NUM_VALUE_BUCKETS; i++) {
+        freeBitmap(index->buckets[i]);
+    }
+    freeBitmap(index->empty);
+    free(index);
+}
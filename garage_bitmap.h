@@ -0,0 +1,74 @@
+/*
+ * Garage Bitmap Index Header File
+ * Bitmap indexes of garage positions by model year and by value bucket.
+ *
+ * There is one bitmap per model year (0 .. MAX_MODEL_YEAR) and one per value bucket of
+ * VALUE_BUCKET_WIDTH dollars across the 21-bit value range. Bitmaps are created on first
+ * use. Multi-predicate counts are answered by combining bitmaps, without reading vehicles.
+ */
+
+#ifndef GARAGE_BITMAP_H
+#define GARAGE_BITMAP_H
+
+#include "vehicle.h"
+#include "bitmap.h"
+
+#define VALUE_BUCKET_BITS 13                            // $8,192 per bucket
+#define VALUE_BUCKET_WIDTH (1u << VALUE_BUCKET_BITS)
+#define NUM_VALUE_BUCKETS ((MAX_VEHICLE_VALUE >> VALUE_BUCKET_BITS) + 1)
+
+typedef struct GarageBitmapIndex GarageBitmapIndex;
+
+/*
+ * Function: buildGarageBitmapIndex
+ * Purpose: Indexes every vehicle of a garage by year and value bucket.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ * Returns: the index, or NULL if allocation failed
+ */
+GarageBitmapIndex* buildGarageBitmapIndex(char**, int);
+
+/*
+ * Functions: bitmapIndexInsert, bitmapIndexRemove
+ * Purpose: Record that a vehicle was inserted at / removed from a position. Later positions
+ *          shift by one, the same way they do in the garage.
+ * Returns: 0 on success, -1 if allocation failed
+ */
+int bitmapIndexInsert(GarageBitmapIndex*, const char*, int);
+int bitmapIndexRemove(GarageBitmapIndex*, const char*, int);
+
+/*
+ * Functions: yearBitmap, valueBucketBitmap
+ * Purpose: The bitmap of one model year / one value bucket (read only, never NULL).
+ */
+const Bitmap* yearBitmap(const GarageBitmapIndex*, unsigned int);
+const Bitmap* valueBucketBitmap(const GarageBitmapIndex*, unsigned int);
+
+/*
+ * Functions: yearRangeBitmap, valueRangeBitmap
+ * Purpose: Union of the year bitmaps in [min, max], or of the value buckets that overlap
+ *          [min, max]. Value ranges are therefore rounded out to whole buckets.
+ * Returns: a new bitmap the caller frees with freeBitmap, or NULL if allocation failed
+ */
+Bitmap* yearRangeBitmap(const GarageBitmapIndex*, unsigned int, unsigned int);
+Bitmap* valueRangeBitmap(const GarageBitmapIndex*, unsigned int, unsigned int);
+
+/*
+ * Function: countYearValueRange
+ * Purpose: Number of vehicles with year in [minYear, maxYear] and value in the buckets
+ *          overlapping [minValue, maxValue].
+ * Returns: the count, or -1 if allocation failed
+ */
+long countYearValueRange(const GarageBitmapIndex*, unsigned int, unsigned int, unsigned int, unsigned int);
+
+/*
+ * Functions: attachGarageBitmapIndex, detachGarageBitmapIndex
+ * Purpose: Keep the index in sync with garage events of one listener list (see addGarageListener).
+ *          Pass the same list to both: the garage's own list, or NULL for plain garages.
+ */
+int attachGarageBitmapIndex(GarageBitmapIndex*, GarageListeners*);
+void detachGarageBitmapIndex(GarageBitmapIndex*, GarageListeners*);
+
+void freeGarageBitmapIndex(GarageBitmapIndex*);
+
+#endif /* GARAGE_BITMAP_H */
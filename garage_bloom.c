@@ -0,0 +1,232 @@
+/*
+ * Garage Bloom
+ * Cache-line blocked Bloom filter over vehicle descriptions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "vehicle.h"
+#include "hash.h"
+#include "garage_scan.h"
+#include "garage_bloom.h"
+
+#define BLOCK_WORDS (FILTER_BLOCK_BYTES / 8)
+#define BLOCK_BITS (FILTER_BLOCK_BYTES * 8)
+
+typedef struct {
+    unsigned long long words[BLOCK_WORDS];
+} FilterBlock;
+
+struct DescriptionFilter {
+    FilterBlock* blocks;  // Aligned to FILTER_BLOCK_BYTES inside memory
+    void* memory;
+    unsigned long long numBlocks;
+    long expected;        // Descriptions the filter was sized for
+    long added;           // Vehicles added since the last (re)build
+    long removed;         // Vehicles removed since the last (re)build
+};
+
+// Allocates zeroed, cache-line aligned blocks for the expected number of descriptions
+static int allocateBlocks(DescriptionFilter* filter, int expectedDescriptions) {
+    long expected = expectedDescriptions > 16 ? expectedDescriptions : 16;
+    unsigned long long numBlocks = ((unsigned long long)expected * FILTER_BITS_PER_DESCRIPTION + BLOCK_BITS - 1) / BLOCK_BITS;
+    void* memory = calloc(1, numBlocks * sizeof(FilterBlock) + FILTER_BLOCK_BYTES - 1);
+
+    if (memory == NULL) {
+        printf("Error: Memory allocation for description filter failed\n");
+        return -1;
+    }
+
+    free(filter->memory);
+    filter->memory = memory;
+    filter->blocks = (FilterBlock*)(((uintptr_t)memory + FILTER_BLOCK_BYTES - 1) & ~(uintptr_t)(FILTER_BLOCK_BYTES - 1));
+    filter->numBlocks = numBlocks;
+    filter->expected = expected;
+    filter->added = 0;
+    filter->removed = 0;
+    return 0;
+}
+
+// The upper half of the hash picks the block; a remixed copy supplies the bits inside it
+static FilterBlock* blockOf(const DescriptionFilter* filter, unsigned long long hash) {
+    return &filter->blocks[((hash >> 32) * filter->numBlocks) >> 32];
+}
+
+static unsigned long long bitSource(unsigned long long hash) {
+    return hash * 0x9E3779B97F4A7C15ull;
+}
+
+static void addHash(DescriptionFilter* filter, unsigned long long hash) {
+    FilterBlock* block = blockOf(filter, hash);
+    unsigned long long bits = bitSource(hash);
+
+    for (int i = 0; i < FILTER_PROBES; i++) {
+        unsigned int bit = (unsigned int)(bits >> (64 - 9 * (i + 1))) & (BLOCK_BITS - 1);
+        block->words[bit / 64] |= 1ull << (bit % 64);
+    }
+}
+
+static int containsHash(const DescriptionFilter* filter, unsigned long long hash) {
+    const FilterBlock* block = blockOf(filter, hash);
+    unsigned long long bits = bitSource(hash);
+
+    for (int i = 0; i < FILTER_PROBES; i++) {
+        unsigned int bit = (unsigned int)(bits >> (64 - 9 * (i + 1))) & (BLOCK_BITS - 1);
+        if (!(block->words[bit / 64] & (1ull << (bit % 64)))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+DescriptionFilter* createDescriptionFilter(int expectedDescriptions) {
+    DescriptionFilter* filter = (DescriptionFilter*)calloc(1, sizeof(DescriptionFilter));
+    if (filter == NULL) {
+        printf("Error: Memory allocation for description filter failed\n");
+        return NULL;
+    }
+
+    if (allocateBlocks(filter, expectedDescriptions) != 0) {
+        free(filter);
+        return NULL;
+    }
+    return filter;
+}
+
+static int filterSlot(void* context, char* vehicle, int position) {
+    (void)position;
+    if (vehicle != NULL) {
+        descriptionFilterAdd((DescriptionFilter*)context, vehicle);
+    }
+    return 0;
+}
+
+DescriptionFilter* buildDescriptionFilter(char** garage, int numVehicles) {
+    if (garage == NULL) {
+        printf("Error: Garage pointer is NULL\n");
+        return NULL;
+    }
+
+    DescriptionFilter* filter = createDescriptionFilter(numVehicles);
+    if (filter != NULL) {
+        forEachVehicle(garage, numVehicles, filterSlot, filter);
+    }
+    return filter;
+}
+
+void descriptionFilterAdd(DescriptionFilter* filter, const char* vehicle) {
+    if (filter == NULL || vehicle == NULL) {
+        return;
+    }
+
+    addHash(filter, hashDescriptionBytes(vehicleDescription(vehicle), vehicleDescriptionLength(vehicle)));
+    filter->added++;
+}
+
+void descriptionFilterRemove(DescriptionFilter* filter, const char* vehicle) {
+    if (filter != NULL && vehicle != NULL) {
+        filter->removed++;
+    }
+}
+
+int descriptionFilterMayContain(const DescriptionFilter* filter, const char* description) {
+    if (filter == NULL) {
+        return 1;
+    }
+    if (description == NULL) {
+        return 0;
+    }
+    return containsHash(filter, hashDescriptionBytes(description, strlen(description)));
+}
+
+int descriptionFilterStale(const DescriptionFilter* filter) {
+    if (filter == NULL) {
+        return 0;
+    }
+    return filter->removed * 100 > filter->added * FILTER_STALE_PERCENT ||
+           filter->added - filter->removed > 2 * filter->expected;
+}
+
+int refreshDescriptionFilter(DescriptionFilter* filter, char** garage, int numVehicles) {
+    if (filter == NULL || garage == NULL) {
+        printf("Error: Filter or garage pointer is NULL\n");
+        return -1;
+    }
+    if (!descriptionFilterStale(filter)) {
+        return 0;
+    }
+
+    if (allocateBlocks(filter, numVehicles) != 0) {
+        return -1;
+    }
+    forEachVehicle(garage, numVehicles, filterSlot, filter);
+    return 1;
+}
+
+char* const* filteredIndexLookup(const DescriptionFilter* filter, const VehicleIndex* index, const char* description, int* count) {
+    if (!descriptionFilterMayContain(filter, description)) {
+        if (count != NULL) {
+            *count = 0;
+        }
+        return NULL;
+    }
+    return vehicleIndexLookup(index, description, count);
+}
+
+typedef struct {
+    const char* description;
+    size_t length;
+} DescriptionMatch;
+
+// Stops the scan at the first match, returning its position + 1 so position 0 also stops it
+static int matchSlot(void* context, char* vehicle, int position) {
+    const DescriptionMatch* match = (const DescriptionMatch*)context;
+
+    if (vehicle != NULL && vehicleDescriptionLength(vehicle) == match->length &&
+        memcmp(vehicleDescription(vehicle), match->description, match->length) == 0) {
+        return position + 1;
+    }
+    return 0;
+}
+
+int findDescription(const DescriptionFilter* filter, char** garage, int numVehicles, const char* description) {
+    if (garage == NULL || description == NULL) {
+        printf("Error: Garage or description pointer is NULL\n");
+        return -1;
+    }
+    if (!descriptionFilterMayContain(filter, description)) {
+        return -1;
+    }
+
+    DescriptionMatch match = {description, strlen(description)};
+    return forEachVehicle(garage, numVehicles, matchSlot, &match) - 1;
+}
+
+static void onGarageEvent(void* context, const GarageEvent* event) {
+    DescriptionFilter* filter = (DescriptionFilter*)context;
+
+    if (event->type == GARAGE_EVENT_INSERT) {
+        descriptionFilterAdd(filter, event->vehicle);
+    } else if (event->type == GARAGE_EVENT_REMOVE) {
+        descriptionFilterRemove(filter, event->vehicle);
+    }
+}
+
+int attachDescriptionFilter(DescriptionFilter* filter, GarageListeners* listeners) {
+    return addGarageListener(listeners, onGarageEvent, filter);
+}
+
+void detachDescriptionFilter(DescriptionFilter* filter, GarageListeners* listeners) {
+    removeGarageListener(listeners, onGarageEvent, filter);
+}
+
+void freeDescriptionFilter(DescriptionFilter* filter) {
+    if (filter == NULL) {
+        return;
+    }
+
+    free(filter->memory);
+    free(filter);
+}
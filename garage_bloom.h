@@ -0,0 +1,97 @@
+/*
+ * Garage Bloom Header File
+ * Blocked Bloom filter over vehicle descriptions, used to answer "no such description"
+ * without walking the garage or probing the hash index.
+ *
+ * The filter is an array of 64-byte blocks (one cache line each). A description's hash picks
+ * one block and FILTER_PROBES bits inside it, so a query touches a single cache line. With
+ * FILTER_BITS_PER_DESCRIPTION bits per expected description about 1% of absent descriptions
+ * pass the filter; a description that was added always passes.
+ *
+ * Bits cannot be cleared, so removals only make the filter stale: it keeps passing the
+ * descriptions that left. The filter counts additions and removals and reports itself stale
+ * once FILTER_STALE_PERCENT of what was added has been removed, or it holds more than twice
+ * the descriptions it was sized for; refreshDescriptionFilter then rebuilds it from the garage.
+ */
+
+#ifndef GARAGE_BLOOM_H
+#define GARAGE_BLOOM_H
+
+#include "garage_index.h"
+
+#define FILTER_BLOCK_BYTES 64
+#define FILTER_BITS_PER_DESCRIPTION 12
+#define FILTER_PROBES 6
+#define FILTER_STALE_PERCENT 50
+
+typedef struct DescriptionFilter DescriptionFilter;
+
+/*
+ * Function: createDescriptionFilter
+ * Purpose: Creates an empty filter sized for the expected number of descriptions.
+ * Returns: the filter, or NULL if allocation failed
+ */
+DescriptionFilter* createDescriptionFilter(int);
+
+/*
+ * Function: buildDescriptionFilter
+ * Purpose: Creates a filter containing the description of every vehicle in a garage.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ * Returns: the filter, or NULL if allocation failed
+ */
+DescriptionFilter* buildDescriptionFilter(char**, int);
+
+/*
+ * Functions: descriptionFilterAdd, descriptionFilterRemove
+ * Purpose: Account for a vehicle entering or leaving the garage. Removing only counts
+ *          towards staleness.
+ */
+void descriptionFilterAdd(DescriptionFilter*, const char*);
+void descriptionFilterRemove(DescriptionFilter*, const char*);
+
+/*
+ * Function: descriptionFilterMayContain
+ * Purpose: Tests a null terminated description.
+ * Returns: 0 if no vehicle in the filter has the description, 1 if one may have it
+ */
+int descriptionFilterMayContain(const DescriptionFilter*, const char*);
+
+/*
+ * Functions: descriptionFilterStale, refreshDescriptionFilter
+ * Purpose: Whether removals or overfilling call for a rebuild / rebuild the filter from the
+ *          garage (sized for its current vehicle count) if it is stale.
+ * Returns: refreshDescriptionFilter - 1 if rebuilt, 0 if not needed, -1 if allocation failed
+ */
+int descriptionFilterStale(const DescriptionFilter*);
+int refreshDescriptionFilter(DescriptionFilter*, char**, int);
+
+/*
+ * Function: filteredIndexLookup
+ * Purpose: vehicleIndexLookup behind the filter: negative answers skip the index.
+ */
+char* const* filteredIndexLookup(const DescriptionFilter*, const VehicleIndex*, const char*, int*);
+
+/*
+ * Function: findDescription
+ * Purpose: Position of the first vehicle with a description; the garage is only walked when
+ *          the filter passes the description.
+ * Returns: the position, or -1 if no vehicle has the description
+ */
+int findDescription(const DescriptionFilter*, char**, int, const char*);
+
+/*
+ * Functions: attachDescriptionFilter, detachDescriptionFilter
+ * Purpose: Keep the filter in sync with garage events of one listener list (see addGarageListener).
+ *          Pass the same list to both: the garage's own list, or NULL for plain garages.
+ */
+int attachDescriptionFilter(DescriptionFilter*, GarageListeners*);
+void detachDescriptionFilter(DescriptionFilter*, GarageListeners*);
+
+/*
+ * Function: freeDescriptionFilter
+ * Purpose: Frees the filter.
+ */
+void freeDescriptionFilter(DescriptionFilter*);
+
+#endif /* GARAGE_BLOOM_H */
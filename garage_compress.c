@@ -0,0 +1,434 @@
+/*
+ * Compressed Garage
+ * Sorted, delta/bit-packed headers with dictionary coded descriptions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vehicle.h"
+#include "garage_compress.h"
+#include "garage_scan.h"
+
+typedef struct {
+    unsigned int firstHeader;  // Header of the first vehicle in the block
+    unsigned char deltaBits;   // Width of each packed header delta
+    unsigned char codeBits;    // Width of each packed dictionary code
+    size_t bitOffset;          // Start of the block inside the bit stream
+} CompressedBlock;
+
+struct CompressedGarage {
+    int numVehicles;
+    int numBlocks;
+    CompressedBlock* blocks;
+    unsigned long long* bits;  // Packed deltas followed by packed codes, block after block
+    size_t numWords;
+    int numDescriptions;
+    unsigned int* descriptionOffsets;  // Offset of each dictionary entry inside descriptionData
+    char* descriptionData;             // All distinct descriptions, null terminated, sorted
+    size_t descriptionBytes;
+};
+
+typedef struct {
+    unsigned int header;
+    const char* description;
+} CompressEntry;
+
+static int compareEntries(const void* a, const void* b) {
+    const CompressEntry* left = (const CompressEntry*)a;
+    const CompressEntry* right = (const CompressEntry*)b;
+
+    if (left->header != right->header) {
+        return left->header < right->header ? -1 : 1;
+    }
+    return strcmp(left->description, right->description);
+}
+
+typedef struct {
+    CompressEntry* entries;
+    char** dictionary;
+    int count;
+} CollectScan;
+
+static int collectSlot(void* context, char* vehicle, int position) {
+    CollectScan* collect = (CollectScan*)context;
+    (void)position;
+
+    if (vehicle != NULL) {
+        CompressEntry* entry = &collect->entries[collect->count];
+        entry->header = vehicleHeader(vehicle);
+        entry->description = vehicleDescription(vehicle);
+        collect->dictionary[collect->count++] = (char*)entry->description;
+    }
+    return 0;
+}
+
+static int compareStrings(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+// Number of bits needed to store values up to maxValue
+static int bitsNeeded(unsigned int maxValue) {
+    int bits = 0;
+    while (maxValue != 0) {
+        bits++;
+        maxValue >>= 1;
+    }
+    return bits;
+}
+
+static void writeBits(unsigned long long* words, size_t position, unsigned int value, int width) {
+    if (width == 0) {
+        return;
+    }
+
+    size_t word = position >> 6;
+    int shift = (int)(position & 63);
+
+    words[word] |= (unsigned long long)value << shift;
+    if (shift + width > 64) {
+        words[word + 1] |= (unsigned long long)value >> (64 - shift);
+    }
+}
+
+static unsigned int readBits(const unsigned long long* words, size_t position, int width) {
+    if (width == 0) {
+        return 0;
+    }
+
+    size_t word = position >> 6;
+    int shift = (int)(position & 63);
+    unsigned long long bits = words[word] >> shift;
+
+    if (shift + width > 64) {
+        bits |= words[word + 1] << (64 - shift);
+    }
+    return (unsigned int)(bits & ((1ULL << width) - 1));
+}
+
+static int blockCount(const CompressedGarage* compressed, int block) {
+    int remaining = compressed->numVehicles - block * COMPRESSED_BLOCK_SIZE;
+    return remaining < COMPRESSED_BLOCK_SIZE ? remaining : COMPRESSED_BLOCK_SIZE;
+}
+
+static const char* dictionaryEntry(const CompressedGarage* compressed, unsigned int code) {
+    return compressed->descriptionData + compressed->descriptionOffsets[code];
+}
+
+// Binary search for the dictionary code of a description known to be in the dictionary
+static unsigned int findCode(char** dictionary, int numDescriptions, const char* description) {
+    int low = 0;
+    int high = numDescriptions - 1;
+
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (strcmp(dictionary[middle], description) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return (unsigned int)low;
+}
+
+CompressedGarage* compressGarage(char** garage, int numVehicles) {
+    if (garage == NULL || numVehicles < 0) {
+        printf("Error: Garage pointer is NULL\n");
+        return NULL;
+    }
+
+    CompressedGarage* compressed = (CompressedGarage*)calloc(1, sizeof(CompressedGarage));
+    CompressEntry* entries = (CompressEntry*)malloc((numVehicles + 1) * sizeof(CompressEntry));
+    char** dictionary = (char**)malloc((numVehicles + 1) * sizeof(char*));
+    unsigned int* codes = (unsigned int*)malloc((numVehicles + 1) * sizeof(unsigned int));
+
+    if (compressed == NULL || entries == NULL || dictionary == NULL || codes == NULL) {
+        printf("Error: Memory allocation for compressed garage failed\n");
+        free(compressed);
+        free(entries);
+        free(dictionary);
+        free(codes);
+        return NULL;
+    }
+
+    // Collect and sort the vehicles by header, then by description
+    CollectScan collect = {entries, dictionary, 0};
+    forEachVehicle(garage, numVehicles, collectSlot, &collect);
+    int count = collect.count;
+    qsort(entries, count, sizeof(CompressEntry), compareEntries);
+
+    // Build a sorted dictionary of distinct descriptions
+    qsort(dictionary, count, sizeof(char*), compareStrings);
+    int numDescriptions = 0;
+    size_t descriptionBytes = 0;
+    for (int i = 0; i < count; i++) {
+        if (numDescriptions == 0 || strcmp(dictionary[numDescriptions - 1], dictionary[i]) != 0) {
+            dictionary[numDescriptions++] = dictionary[i];
+            descriptionBytes += strlen(dictionary[i]) + 1;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        codes[i] = findCode(dictionary, numDescriptions, entries[i].description);
+    }
+
+    compressed->numVehicles = count;
+    compressed->numBlocks = (count + COMPRESSED_BLOCK_SIZE - 1) / COMPRESSED_BLOCK_SIZE;
+    compressed->numDescriptions = numDescriptions;
+    compressed->descriptionBytes = descriptionBytes;
+    compressed->blocks = (CompressedBlock*)malloc((compressed->numBlocks + 1) * sizeof(CompressedBlock));
+    compressed->descriptionOffsets = (unsigned int*)malloc((numDescriptions + 1) * sizeof(unsigned int));
+    compressed->descriptionData = (char*)malloc(descriptionBytes + 1);
+
+    if (compressed->blocks == NULL || compressed->descriptionOffsets == NULL ||
+        compressed->descriptionData == NULL) {
+        printf("Error: Memory allocation for compressed garage failed\n");
+        free(entries);
+        free(dictionary);
+        free(codes);
+        freeCompressedGarage(compressed);
+        return NULL;
+    }
+
+    size_t offset = 0;
+    for (int i = 0; i < numDescriptions; i++) {
+        size_t length = strlen(dictionary[i]) + 1;
+        compressed->descriptionOffsets[i] = (unsigned int)offset;
+        memcpy(compressed->descriptionData + offset, dictionary[i], length);
+        offset += length;
+    }
+
+    // First pass: choose the bit widths for each block and size the bit stream
+    size_t totalBits = 0;
+    for (int block = 0; block < compressed->numBlocks; block++) {
+        int start = block * COMPRESSED_BLOCK_SIZE;
+        int blockSize = blockCount(compressed, block);
+        unsigned int maxDelta = 0;
+        unsigned int maxCode = 0;
+
+        for (int i = 0; i < blockSize; i++) {
+            if (i > 0 && entries[start + i].header - entries[start + i - 1].header > maxDelta) {
+                maxDelta = entries[start + i].header - entries[start + i - 1].header;
+            }
+            if (codes[start + i] > maxCode) {
+                maxCode = codes[start + i];
+            }
+        }
+
+        CompressedBlock* current = &compressed->blocks[block];
+        current->firstHeader = entries[start].header;
+        current->deltaBits = (unsigned char)bitsNeeded(maxDelta);
+        current->codeBits = (unsigned char)bitsNeeded(maxCode);
+        current->bitOffset = totalBits;
+        totalBits += (size_t)(blockSize - 1) * current->deltaBits + (size_t)blockSize * current->codeBits;
+    }
+
+    // One spare word so that reads straddling the last word stay in bounds
+    compressed->numWords = (totalBits + 63) / 64 + 1;
+    compressed->bits = (unsigned long long*)calloc(compressed->numWords, sizeof(unsigned long long));
+    if (compressed->bits == NULL) {
+        printf("Error: Memory allocation for compressed garage failed\n");
+        free(entries);
+        free(dictionary);
+        free(codes);
+        freeCompressedGarage(compressed);
+        return NULL;
+    }
+
+    // Second pass: write the deltas and the codes
+    for (int block = 0; block < compressed->numBlocks; block++) {
+        const CompressedBlock* current = &compressed->blocks[block];
+        int start = block * COMPRESSED_BLOCK_SIZE;
+        int blockSize = blockCount(compressed, block);
+        size_t position = current->bitOffset;
+
+        for (int i = 1; i < blockSize; i++) {
+            writeBits(compressed->bits, position, entries[start + i].header - entries[start + i - 1].header,
+                      current->deltaBits);
+            position += current->deltaBits;
+        }
+        for (int i = 0; i < blockSize; i++) {
+            writeBits(compressed->bits, position, codes[start + i], current->codeBits);
+            position += current->codeBits;
+        }
+    }
+
+    free(entries);
+    free(dictionary);
+    free(codes);
+
+    return compressed;
+}
+
+int compressedGarageGet(const CompressedGarage* compressed, int index, unsigned int* header,
+                        const char** description) {
+    if (compressed == NULL || index < 0 || index >= compressed->numVehicles) {
+        return 0;
+    }
+
+    int block = index / COMPRESSED_BLOCK_SIZE;
+    int offset = index % COMPRESSED_BLOCK_SIZE;
+    const CompressedBlock* current = &compressed->blocks[block];
+    size_t position = current->bitOffset;
+
+    // Headers are deltas from the previous one, so add up the prefix of the block
+    unsigned int value = current->firstHeader;
+    for (int i = 0; i < offset; i++) {
+        value += readBits(compressed->bits, position, current->deltaBits);
+        position += current->deltaBits;
+    }
+
+    size_t codePosition = current->bitOffset +
+                          (size_t)(blockCount(compressed, block) - 1) * current->deltaBits +
+                          (size_t)offset * current->codeBits;
+
+    if (header != NULL) {
+        *header = value;
+    }
+    if (description != NULL) {
+        *description = dictionaryEntry(compressed, readBits(compressed->bits, codePosition, current->codeBits));
+    }
+    return 1;
+}
+
+int compressedGarageFind(const CompressedGarage* compressed, unsigned int header) {
+    if (compressed == NULL || compressed->numBlocks == 0) {
+        return -1;
+    }
+
+    // Find the first block whose first header is not smaller than the one we want.
+    // Matches may also sit at the end of the block before it.
+    int low = 0;
+    int high = compressed->numBlocks;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (compressed->blocks[middle].firstHeader < header) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (int block = low > 0 ? low - 1 : 0; block < compressed->numBlocks; block++) {
+        const CompressedBlock* current = &compressed->blocks[block];
+        int blockSize = blockCount(compressed, block);
+        size_t position = current->bitOffset;
+        unsigned int value = current->firstHeader;
+
+        for (int i = 0; i < blockSize; i++) {
+            if (i > 0) {
+                value += readBits(compressed->bits, position, current->deltaBits);
+                position += current->deltaBits;
+            }
+            if (value == header) {
+                return block * COMPRESSED_BLOCK_SIZE + i;
+            }
+            if (value > header) {
+                return -1;
+            }
+        }
+    }
+    return -1;
+}
+
+void compressedGarageScan(const CompressedGarage* compressed, CompressedVisitor visit, void* context) {
+    if (compressed == NULL || visit == NULL) {
+        return;
+    }
+
+    for (int block = 0; block < compressed->numBlocks; block++) {
+        const CompressedBlock* current = &compressed->blocks[block];
+        int blockSize = blockCount(compressed, block);
+        size_t deltaPosition = current->bitOffset;
+        size_t codePosition = current->bitOffset + (size_t)(blockSize - 1) * current->deltaBits;
+        unsigned int value = current->firstHeader;
+
+        for (int i = 0; i < blockSize; i++) {
+            if (i > 0) {
+                value += readBits(compressed->bits, deltaPosition, current->deltaBits);
+                deltaPosition += current->deltaBits;
+            }
+            unsigned int code = readBits(compressed->bits, codePosition, current->codeBits);
+            codePosition += current->codeBits;
+
+            if (visit(context, value, dictionaryEntry(compressed, code))) {
+                return;
+            }
+        }
+    }
+}
+
+typedef struct {
+    char** garage;
+    int count;     // Vehicles built so far
+} DecompressJob;
+
+static int buildDecompressed(void* context, unsigned int header, const char* description) {
+    DecompressJob* job = (DecompressJob*)context;
+    char* vehicle = buildVehicleRecord(header, description, (int)strlen(description));
+
+    if (vehicle == NULL) {
+        return 1;
+    }
+    job->garage[job->count++] = vehicle;
+    return 0;
+}
+
+char** decompressGarage(const CompressedGarage* compressed, int* numVehicles) {
+    if (numVehicles != NULL) {
+        *numVehicles = 0;
+    }
+    if (compressed == NULL || compressed->numVehicles == 0) {
+        return NULL;
+    }
+
+    char** garage = (char**)malloc(compressed->numVehicles * sizeof(char*));
+    if (garage == NULL) {
+        printf("Error: Memory allocation for garage failed\n");
+        return NULL;
+    }
+
+    // One pass over the blocks; compressedGarageGet would re-add each block's deltas per vehicle
+    DecompressJob job = {garage, 0};
+    compressedGarageScan(compressed, buildDecompressed, &job);
+    if (job.count < compressed->numVehicles) {
+        while (job.count-- > 0) {
+            freeVehicle(garage[job.count]);
+        }
+        free(garage);
+        return NULL;
+    }
+
+    if (numVehicles != NULL) {
+        *numVehicles = compressed->numVehicles;
+    }
+    return garage;
+}
+
+int compressedGarageCount(const CompressedGarage* compressed) {
+    return compressed == NULL ? 0 : compressed->numVehicles;
+}
+
+size_t compressedGarageBytes(const CompressedGarage* compressed) {
+    if (compressed == NULL) {
+        return 0;
+    }
+
+    return sizeof(CompressedGarage) +
+           compressed->numBlocks * sizeof(CompressedBlock) +
+           compressed->numWords * sizeof(unsigned long long) +
+           compressed->numDescriptions * sizeof(unsigned int) +
+           compressed->descriptionBytes;
+}
+
+void freeCompressedGarage(CompressedGarage* compressed) {
+    if (compressed == NULL) {
+        return;
+    }
+
+    free(compressed->blocks);
+    free(compressed->bits);
+    free(compressed->descriptionOffsets);
+    free(compressed->descriptionData);
+    free(compressed);
+}
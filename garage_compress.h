@@ -0,0 +1,83 @@
+/*
+ * Compressed Garage Header File
+ * Read-optimized, compressed representation for large garages that are rarely modified.
+ *
+ * Vehicles are sorted by packed header. Every block of COMPRESSED_BLOCK_SIZE vehicles stores
+ * the first header in a small block index and the remaining headers as bit-packed deltas.
+ * Descriptions are replaced by bit-packed codes into a sorted dictionary of distinct descriptions.
+ */
+
+#ifndef GARAGE_COMPRESS_H
+#define GARAGE_COMPRESS_H
+
+#include <stddef.h>
+
+#define COMPRESSED_BLOCK_SIZE 128  // Vehicles per block (unit of random access)
+
+typedef struct CompressedGarage CompressedGarage;
+
+/*
+ * Callback used by compressedGarageScan. Return nonzero to stop the scan early.
+ */
+typedef int (*CompressedVisitor)(void* context, unsigned int header, const char* description);
+
+/*
+ * Function: compressGarage
+ * Purpose: Builds a compressed copy of a garage. NULL slots are skipped.
+ *          The original garage is left untouched.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ * Returns: the compressed garage, or NULL if allocation failed
+ */
+CompressedGarage* compressGarage(char**, int);
+
+/*
+ * Function: decompressGarage
+ * Purpose: Rebuilds a normal garage from a compressed one. Vehicles come back sorted by header.
+ * Parameters: const CompressedGarage* - the compressed garage
+ *             int* - receives the number of vehicles in the new garage
+ * Returns: a dynamically allocated garage, or NULL if it is empty or allocation failed
+ */
+char** decompressGarage(const CompressedGarage*, int*);
+
+/*
+ * Function: compressedGarageGet
+ * Purpose: Point lookup by position in sorted order. Decodes at most one block.
+ * Parameters: const CompressedGarage* - the compressed garage
+ *             int - position (0 based)
+ *             unsigned int* - receives the packed header
+ *             const char** - receives the description (owned by the compressed garage)
+ * Returns: 1 on success, 0 if the position is out of bounds
+ */
+int compressedGarageGet(const CompressedGarage*, int, unsigned int*, const char**);
+
+/*
+ * Function: compressedGarageFind
+ * Purpose: Finds the first vehicle with the given packed header using the block index.
+ * Parameters: const CompressedGarage* - the compressed garage
+ *             unsigned int - packed header to look for
+ * Returns: position of the first match, or -1 if there is none
+ */
+int compressedGarageFind(const CompressedGarage*, unsigned int);
+
+/*
+ * Function: compressedGarageScan
+ * Purpose: Decodes every vehicle in sorted order and passes it to a visitor.
+ *          Nothing is allocated while scanning.
+ */
+void compressedGarageScan(const CompressedGarage*, CompressedVisitor, void*);
+
+/*
+ * Functions: compressedGarageCount, compressedGarageBytes
+ * Purpose: Number of vehicles stored, and total memory used by the compressed garage.
+ */
+int compressedGarageCount(const CompressedGarage*);
+size_t compressedGarageBytes(const CompressedGarage*);
+
+/*
+ * Function: freeCompressedGarage
+ * Purpose: Frees a compressed garage and everything it owns.
+ */
+void freeCompressedGarage(CompressedGarage*);
+
+#endif /* GARAGE_COMPRESS_H */
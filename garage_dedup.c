@@ -0,0 +1,361 @@
+/*
+ * Garage Dedup
+ * Parallel duplicate detection by hash partitioning.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vehicle.h"
+#include "hash.h"
+#include "parallel.h"
+#include "garage_scan.h"
+#include "garage_dedup.h"
+
+typedef struct {
+    unsigned long long hash;
+    int position;  // -1 once the entry has been placed in a group
+} DedupEntry;
+
+typedef struct {
+    DuplicateGroup* groups;
+    int numGroups;
+    int groupCapacity;
+    int* duplicates;
+    int numDuplicates;
+    int duplicateCapacity;
+    int error;
+} DedupResult;
+
+typedef struct {
+    char** garage;
+    size_t* counts;          // [worker * DEDUP_PARTITIONS + partition] entries per worker
+    size_t* cursors;         // Same layout, next write position in entries for this pass
+    size_t* partitionStart;  // Where each partition of this pass begins in entries
+    int firstPartition;      // Partitions [firstPartition, endPartition) form the pass
+    int endPartition;
+    DedupEntry* entries;
+    DedupResult* results;    // One per worker
+} DedupJob;
+
+typedef struct {
+    DedupJob* job;
+    size_t* counts;  // This worker's row of counts or cursors
+    int base;        // Position of the first vehicle of the worker's range
+} DedupScan;
+
+// Hash of header and description; the header seeds the hash of the description
+static unsigned long long vehicleKey(const char* vehicle) {
+    return hashBytes(vehicleDescription(vehicle), vehicleDescriptionLength(vehicle), vehicleHeader(vehicle));
+}
+
+static int partitionOf(unsigned long long hash) {
+    return (int)(hash >> (64 - DEDUP_PARTITION_BITS));
+}
+
+static int sameVehicle(const char* first, const char* second) {
+    size_t length = vehicleDescriptionLength(first);
+    return vehicleHeader(first) == vehicleHeader(second) && vehicleDescriptionLength(second) == length &&
+           memcmp(vehicleDescription(first), vehicleDescription(second), length) == 0;
+}
+
+static int compareEntries(const void* a, const void* b) {
+    const DedupEntry* first = (const DedupEntry*)a;
+    const DedupEntry* second = (const DedupEntry*)b;
+
+    if (first->hash != second->hash) {
+        return first->hash < second->hash ? -1 : 1;
+    }
+    return (first->position > second->position) - (first->position < second->position);
+}
+
+static int comparePositions(const void* a, const void* b) {
+    return (*(const int*)a > *(const int*)b) - (*(const int*)a < *(const int*)b);
+}
+
+static int compareGroups(const void* a, const void* b) {
+    return comparePositions(&((const DuplicateGroup*)a)->first, &((const DuplicateGroup*)b)->first);
+}
+
+// Doubles a list's capacity (starting at 64 items)
+static int growList(void** items, int* capacity, size_t itemSize) {
+    int newCapacity = *capacity > 0 ? *capacity * 2 : 64;
+    void* grown = realloc(*items, newCapacity * itemSize);
+
+    if (grown == NULL) {
+        return -1;
+    }
+    *items = grown;
+    *capacity = newCapacity;
+    return 0;
+}
+
+static int countSlot(void* context, char* vehicle, int position) {
+    (void)position;
+    if (vehicle != NULL) {
+        ((size_t*)context)[partitionOf(vehicleKey(vehicle))]++;
+    }
+    return 0;
+}
+
+static void countTask(void* context, int begin, int end, int worker) {
+    DedupJob* job = (DedupJob*)context;
+    forEachVehicle(job->garage + begin, end - begin, countSlot, job->counts + (size_t)worker * DEDUP_PARTITIONS);
+}
+
+static int scatterSlot(void* context, char* vehicle, int position) {
+    DedupScan* scan = (DedupScan*)context;
+
+    if (vehicle != NULL) {
+        unsigned long long hash = vehicleKey(vehicle);
+        int partition = partitionOf(hash);
+
+        if (partition >= scan->job->firstPartition && partition < scan->job->endPartition) {
+            DedupEntry* entry = &scan->job->entries[scan->counts[partition]++];
+            entry->hash = hash;
+            entry->position = scan->base + position;
+        }
+    }
+    return 0;
+}
+
+static void scatterTask(void* context, int begin, int end, int worker) {
+    DedupJob* job = (DedupJob*)context;
+    DedupScan scan = {job, job->cursors + (size_t)worker * DEDUP_PARTITIONS, begin};
+    forEachVehicle(job->garage + begin, end - begin, scatterSlot, &scan);
+}
+
+// Groups the identical vehicles of one partition; the entries are sorted by hash, then position
+static void groupPartition(DedupJob* job, DedupEntry* entries, size_t count, DedupResult* result) {
+    qsort(entries, count, sizeof(DedupEntry), compareEntries);
+
+    for (size_t runStart = 0; runStart < count && !result->error;) {
+        size_t runEnd = runStart + 1;
+        while (runEnd < count && entries[runEnd].hash == entries[runStart].hash) {
+            runEnd++;
+        }
+
+        // Equal hashes are almost always equal vehicles; collisions split into several groups
+        for (size_t i = runStart; runEnd - runStart > 1 && i < runEnd; i++) {
+            if (entries[i].position < 0) {
+                continue;
+            }
+
+            DuplicateGroup group = {entries[i].position, 1};
+            const char* kept = job->garage[group.first];
+
+            for (size_t j = i + 1; j < runEnd; j++) {
+                if (entries[j].position < 0 || !sameVehicle(kept, job->garage[entries[j].position])) {
+                    continue;
+                }
+                if (result->numDuplicates == result->duplicateCapacity &&
+                    growList((void**)&result->duplicates, &result->duplicateCapacity, sizeof(int)) != 0) {
+                    result->error = 1;
+                    return;
+                }
+                result->duplicates[result->numDuplicates++] = entries[j].position;
+                entries[j].position = -1;
+                group.count++;
+            }
+
+            if (group.count > 1) {
+                if (result->numGroups == result->groupCapacity &&
+                    growList((void**)&result->groups, &result->groupCapacity, sizeof(DuplicateGroup)) != 0) {
+                    result->error = 1;
+                    return;
+                }
+                result->groups[result->numGroups++] = group;
+            }
+        }
+        runStart = runEnd;
+    }
+}
+
+static void groupTask(void* context, int begin, int end, int worker) {
+    DedupJob* job = (DedupJob*)context;
+
+    for (int partition = job->firstPartition + begin; partition < job->firstPartition + end; partition++) {
+        size_t start = job->partitionStart[partition];
+        groupPartition(job, job->entries + start, job->partitionStart[partition + 1] - start, &job->results[worker]);
+    }
+}
+
+// Concatenates the per-worker lists into the report, sorted
+static int collectResults(DedupResult* results, int numThreads, DedupReport* report) {
+    int numGroups = 0;
+    int numDuplicates = 0;
+    for (int i = 0; i < numThreads; i++) {
+        numGroups += results[i].numGroups;
+        numDuplicates += results[i].numDuplicates;
+    }
+
+    report->groups = (DuplicateGroup*)malloc((numGroups > 0 ? numGroups : 1) * sizeof(DuplicateGroup));
+    report->duplicates = (int*)malloc((numDuplicates > 0 ? numDuplicates : 1) * sizeof(int));
+    report->numGroups = 0;
+    report->numDuplicates = 0;
+    if (report->groups == NULL || report->duplicates == NULL) {
+        freeDedupReport(report);
+        return -1;
+    }
+
+    for (int i = 0; i < numThreads; i++) {
+        if (results[i].numGroups > 0) {
+            memcpy(report->groups + report->numGroups, results[i].groups, results[i].numGroups * sizeof(DuplicateGroup));
+            report->numGroups += results[i].numGroups;
+        }
+        if (results[i].numDuplicates > 0) {
+            memcpy(report->duplicates + report->numDuplicates, results[i].duplicates, results[i].numDuplicates * sizeof(int));
+            report->numDuplicates += results[i].numDuplicates;
+        }
+    }
+
+    qsort(report->groups, report->numGroups, sizeof(DuplicateGroup), compareGroups);
+    qsort(report->duplicates, report->numDuplicates, sizeof(int), comparePositions);
+    return 0;
+}
+
+// A pass is whole partitions, at most DEDUP_PASS_ENTRIES entries unless one partition is bigger
+static int passEnd(const size_t* totals, int first, size_t* entries) {
+    int end = first + 1;
+
+    *entries = totals[first];
+    while (end < DEDUP_PARTITIONS && *entries + totals[end] <= DEDUP_PASS_ENTRIES) {
+        *entries += totals[end++];
+    }
+    return end;
+}
+
+// Finds the duplicates; on success the report holds them
+static int findDuplicates(char** garage, int numVehicles, int numThreads, DedupReport* report) {
+    DedupJob job = {0};
+    size_t totals[DEDUP_PARTITIONS] = {0};
+    size_t starts[DEDUP_PARTITIONS + 1];
+    int failed = 0;
+
+    job.counts = (size_t*)calloc((size_t)numThreads * DEDUP_PARTITIONS, sizeof(size_t));
+    job.cursors = (size_t*)malloc((size_t)numThreads * DEDUP_PARTITIONS * sizeof(size_t));
+    job.results = (DedupResult*)calloc(numThreads, sizeof(DedupResult));
+    job.garage = garage;
+    job.partitionStart = starts;
+
+    if (job.counts == NULL || job.cursors == NULL || job.results == NULL) {
+        failed = 1;
+    } else {
+        parallelFor(numVehicles, numThreads, countTask, &job);
+    }
+
+    // Size the buffer for the largest pass
+    size_t largestPass = 0;
+    for (int p = 0; p < DEDUP_PARTITIONS && !failed; p++) {
+        for (int w = 0; w < numThreads; w++) {
+            totals[p] += job.counts[(size_t)w * DEDUP_PARTITIONS + p];
+        }
+    }
+    for (int first = 0; first < DEDUP_PARTITIONS && !failed;) {
+        size_t entries = 0;
+        first = passEnd(totals, first, &entries);
+        largestPass = entries > largestPass ? entries : largestPass;
+    }
+
+    if (!failed) {
+        job.entries = (DedupEntry*)malloc((largestPass > 0 ? largestPass : 1) * sizeof(DedupEntry));
+        failed = job.entries == NULL;
+    }
+
+    for (int first = 0; first < DEDUP_PARTITIONS && !failed;) {
+        size_t entries = 0;
+        int end = passEnd(totals, first, &entries);
+
+        // Each worker writes its entries of a partition after those of the workers before it
+        size_t next = 0;
+        for (int p = first; p < end; p++) {
+            starts[p] = next;
+            for (int w = 0; w < numThreads; w++) {
+                job.cursors[(size_t)w * DEDUP_PARTITIONS + p] = next;
+                next += job.counts[(size_t)w * DEDUP_PARTITIONS + p];
+            }
+        }
+        starts[end] = next;
+
+        job.firstPartition = first;
+        job.endPartition = end;
+        if (entries > 0) {
+            parallelFor(numVehicles, numThreads, scatterTask, &job);
+            parallelFor(end - first, numThreads, groupTask, &job);
+        }
+
+        for (int w = 0; w < numThreads; w++) {
+            failed |= job.results[w].error;
+        }
+        first = end;
+    }
+
+    if (!failed) {
+        failed = collectResults(job.results, numThreads, report) != 0;
+    }
+
+    for (int w = 0; job.results != NULL && w < numThreads; w++) {
+        free(job.results[w].groups);
+        free(job.results[w].duplicates);
+    }
+    free(job.results);
+    free(job.entries);
+    free(job.cursors);
+    free(job.counts);
+    return failed ? -1 : 0;
+}
+
+int dedupGarage(char** garage, int numVehicles, int compact, int numThreads, DedupReport* report) {
+    DedupReport found = {NULL, 0, NULL, 0};
+
+    if (report != NULL) {
+        *report = found;
+    }
+    if (garage == NULL) {
+        printf("Error: Garage pointer is NULL\n");
+        return -1;
+    }
+    if (numThreads <= 0) {
+        numThreads = defaultThreadCount();
+    }
+
+    if (findDuplicates(garage, numVehicles, numThreads, &found) != 0) {
+        printf("Error: Memory allocation for duplicate detection failed\n");
+        return -1;
+    }
+
+    int remaining = numVehicles;
+    if (compact) {
+        // Positions are ascending, so each duplicate's current position is the write index
+        remaining = 0;
+        for (int i = 0, next = 0; i < numVehicles; i++) {
+            if (next < found.numDuplicates && found.duplicates[next] == i) {
+                notifyGarageListeners(NULL, GARAGE_EVENT_REMOVE, garage[i], remaining);
+                freeVehicle(garage[i]);
+                next++;
+            } else {
+                garage[remaining++] = garage[i];
+            }
+        }
+    }
+
+    if (report != NULL) {
+        *report = found;
+    } else {
+        freeDedupReport(&found);
+    }
+    return remaining;
+}
+
+void freeDedupReport(DedupReport* report) {
+    if (report == NULL) {
+        return;
+    }
+
+    free(report->groups);
+    free(report->duplicates);
+    report->groups = NULL;
+    report->duplicates = NULL;
+    report->numGroups = 0;
+    report->numDuplicates = 0;
+}
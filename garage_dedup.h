@@ -0,0 +1,55 @@
+/*
+ * Garage Dedup Header File
+ * Finds vehicles that are exact duplicates (same packed header and same description) and
+ * optionally removes them.
+ *
+ * Every vehicle is hashed over its header and description. The hashes are partitioned by
+ * their top bits so that identical vehicles always meet in the same partition, and the
+ * partitions are sorted and grouped on worker threads independently. Memory is bounded:
+ * partitions are processed in passes of at most DEDUP_PASS_ENTRIES vehicles (16 bytes each),
+ * hashing the garage again for each pass, so very large garages trade time for memory.
+ * Vehicles whose hashes collide are compared byte for byte before being called duplicates.
+ */
+
+#ifndef GARAGE_DEDUP_H
+#define GARAGE_DEDUP_H
+
+#define DEDUP_PARTITION_BITS 10
+#define DEDUP_PARTITIONS (1 << DEDUP_PARTITION_BITS)
+#ifndef DEDUP_PASS_ENTRIES
+#define DEDUP_PASS_ENTRIES (1 << 22)  // Entries held at once; override to trade memory for passes
+#endif
+
+typedef struct {
+    int first;  // Position of the vehicle that is kept (the lowest position)
+    int count;  // Identical vehicles in the group, the first included
+} DuplicateGroup;
+
+typedef struct {
+    DuplicateGroup* groups;  // Groups of two or more identical vehicles, sorted by first
+    int numGroups;
+    int* duplicates;         // Positions of the vehicles that repeat an earlier one, ascending
+    int numDuplicates;
+} DedupReport;
+
+/*
+ * Function: dedupGarage
+ * Purpose: Finds duplicate vehicles and, if asked, compacts the garage in place: every
+ *          duplicate is reported to the garage listeners, freed, and the vehicles after it
+ *          move down. The garage array keeps its allocation.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ *             int - nonzero to remove the duplicates
+ *             int - number of threads (0 = one per processor)
+ *             DedupReport* - receives the groups, positions before compaction (may be NULL)
+ * Returns: the number of vehicles left in the garage, or -1 on error (garage unchanged)
+ */
+int dedupGarage(char**, int, int, int, DedupReport*);
+
+/*
+ * Function: freeDedupReport
+ * Purpose: Frees the lists held by a report.
+ */
+void freeDedupReport(DedupReport*);
+
+#endif /* GARAGE_DEDUP_H */
@@ -0,0 +1,334 @@
+/*
+ * Garage Export
+ * CSV / JSON / NDJSON writers that format into fixed size chunks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vehicle.h"
+#include "garage_export.h"
+#include "parallel.h"
+#include "garage_scan.h"
+
+#ifdef _MSC_VER
+    #include <io.h>
+    #define write _write
+#else
+    #include <unistd.h>
+#endif
+
+typedef struct {
+    char* chunk;       // Where formatted bytes go
+    size_t capacity;   // Size of chunk
+    size_t used;       // Bytes currently in chunk
+    size_t total;      // Bytes produced so far
+    int fd;            // Destination descriptor, or -1 when writing into a caller buffer
+    int error;         // Set once a write failed or the caller buffer overflowed
+    OutputBuffer* output;  // When set, full chunks are appended here instead (parallel export)
+} ExportWriter;
+
+static void flushWriter(ExportWriter* writer) {
+    if (writer->output != NULL) {
+        if (outputAppend(writer->output, writer->chunk, writer->used) != 0) {
+            writer->error = 1;
+            return;
+        }
+        writer->used = 0;
+        return;
+    }
+
+    if (writer->fd < 0) {
+        // A caller buffer cannot be emptied, so running out of room is an error
+        writer->error = 1;
+        return;
+    }
+
+    size_t offset = 0;
+    while (offset < writer->used) {
+        long written = (long)write(writer->fd, writer->chunk + offset, (unsigned int)(writer->used - offset));
+        if (written <= 0) {
+            writer->error = 1;
+            return;
+        }
+        offset += (size_t)written;
+    }
+    writer->used = 0;
+}
+
+static void putBytes(ExportWriter* writer, const char* bytes, size_t length) {
+    while (length > 0 && !writer->error) {
+        if (writer->used == writer->capacity) {
+            flushWriter(writer);
+            continue;
+        }
+
+        size_t room = writer->capacity - writer->used;
+        size_t piece = length < room ? length : room;
+
+        memcpy(writer->chunk + writer->used, bytes, piece);
+        writer->used += piece;
+        writer->total += piece;
+        bytes += piece;
+        length -= piece;
+    }
+}
+
+static void putChar(ExportWriter* writer, char c) {
+    if (writer->used == writer->capacity) {
+        flushWriter(writer);
+    }
+    if (!writer->error) {
+        writer->chunk[writer->used++] = c;
+        writer->total++;
+    }
+}
+
+// Formats an unsigned integer without going through printf
+static void putUnsigned(ExportWriter* writer, unsigned int number) {
+    char digits[10];
+    int count = 0;
+
+    do {
+        digits[count++] = (char)('0' + number % 10);
+        number /= 10;
+    } while (number != 0);
+
+    char text[10];
+    for (int i = 0; i < count; i++) {
+        text[i] = digits[count - 1 - i];
+    }
+    putBytes(writer, text, count);
+}
+
+// RFC 4180: a field with a comma, quote or line break is quoted and quotes are doubled
+static void putCsvField(ExportWriter* writer, const char* text, size_t length) {
+    if (strpbrk(text, ",\"\r\n") == NULL) {
+        putBytes(writer, text, length);
+        return;
+    }
+
+    putChar(writer, '"');
+    for (const char* c = text; c < text + length; c++) {
+        if (*c == '"') {
+            putChar(writer, '"');
+        }
+        putChar(writer, *c);
+    }
+    putChar(writer, '"');
+}
+
+static void putJsonString(ExportWriter* writer, const char* text, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    const char* run = text;
+    const char* end = text + length;
+
+    putChar(writer, '"');
+    for (const char* c = text; c < end; c++) {
+        unsigned char byte = (unsigned char)*c;
+        if (byte >= 0x20 && byte != '"' && byte != '\\') {
+            continue;
+        }
+
+        // Copy the plain run before the character that needs escaping
+        putBytes(writer, run, (size_t)(c - run));
+        run = c + 1;
+
+        putChar(writer, '\\');
+        switch (byte) {
+            case '"':  putChar(writer, '"'); break;
+            case '\\': putChar(writer, '\\'); break;
+            case '\n': putChar(writer, 'n'); break;
+            case '\r': putChar(writer, 'r'); break;
+            case '\t': putChar(writer, 't'); break;
+            case '\b': putChar(writer, 'b'); break;
+            case '\f': putChar(writer, 'f'); break;
+            default: {
+                char escape[5] = {'u', '0', '0', hex[byte >> 4], hex[byte & 0xF]};
+                putBytes(writer, escape, 5);
+            }
+        }
+    }
+    putBytes(writer, run, (size_t)(end - run));
+    putChar(writer, '"');
+}
+
+static void putJsonObject(ExportWriter* writer, const char* vehicle) {
+    unsigned int packedData = vehicleHeader(vehicle);
+
+    putBytes(writer, "{\"value\":", 9);
+    putUnsigned(writer, headerValue(packedData));
+    putBytes(writer, ",\"year\":", 8);
+    putUnsigned(writer, headerYear(packedData));
+    putBytes(writer, ",\"description\":", 15);
+    putJsonString(writer, vehicleDescription(vehicle), vehicleDescriptionLength(vehicle));
+    putChar(writer, '}');
+}
+
+static void putRecord(ExportWriter* writer, const char* vehicle, ExportFormat format, int first) {
+    switch (format) {
+        case EXPORT_CSV: {
+            unsigned int packedData = vehicleHeader(vehicle);
+            putUnsigned(writer, headerValue(packedData));
+            putChar(writer, ',');
+            putUnsigned(writer, headerYear(packedData));
+            putChar(writer, ',');
+            putCsvField(writer, vehicleDescription(vehicle), vehicleDescriptionLength(vehicle));
+            putChar(writer, '\n');
+            break;
+        }
+        case EXPORT_JSON:
+            putBytes(writer, first ? "\n" : ",\n", first ? 1 : 2);
+            putJsonObject(writer, vehicle);
+            break;
+        case EXPORT_NDJSON:
+            putJsonObject(writer, vehicle);
+            putChar(writer, '\n');
+            break;
+    }
+}
+
+static void putPrefix(ExportWriter* writer, ExportFormat format) {
+    if (format == EXPORT_CSV) {
+        putBytes(writer, "value,year,description\n", 23);
+    } else if (format == EXPORT_JSON) {
+        putChar(writer, '[');
+    }
+}
+
+static void putSuffix(ExportWriter* writer, ExportFormat format) {
+    if (format == EXPORT_JSON) {
+        putBytes(writer, "\n]\n", 3);
+    }
+}
+
+typedef struct {
+    ExportWriter* writer;
+    ExportFormat format;
+    int firstVehicle;  // Position of the first non-NULL vehicle, -1 until one is seen, -2 if it came earlier
+} ExportScan;
+
+static int exportSlot(void* context, char* vehicle, int position) {
+    ExportScan* scan = (ExportScan*)context;
+
+    if (vehicle != NULL) {
+        if (scan->firstVehicle == -1) {
+            scan->firstVehicle = position;
+        }
+        putRecord(scan->writer, vehicle, scan->format, position == scan->firstVehicle);
+    }
+    return scan->writer->error;
+}
+
+static void exportGarage(ExportWriter* writer, char** garage, int numVehicles, ExportFormat format) {
+    ExportScan scan = {writer, format, -1};
+
+    putPrefix(writer, format);
+    forEachVehicle(garage, numVehicles, exportSlot, &scan);
+    putSuffix(writer, format);
+}
+
+typedef struct {
+    char** garage;
+    ExportFormat format;
+    int firstVehicle;      // Index of the first non-NULL vehicle, the only one without a JSON comma
+    ExportWriter* writer;  // Final destination, only touched on the calling thread
+} ExportJob;
+
+// Formats vehicles [begin, end) on a worker thread
+static void formatExportChunk(void* context, int begin, int end, OutputBuffer* out) {
+    ExportJob* job = (ExportJob*)context;
+    char chunk[4096];
+    ExportWriter writer = {chunk, sizeof(chunk), 0, 0, -1, 0, out};
+
+    // Positions are relative to begin, so the first vehicle is too
+    ExportScan scan = {&writer, job->format, job->firstVehicle >= begin ? job->firstVehicle - begin : -2};
+    forEachVehicle(job->garage + begin, end - begin, exportSlot, &scan);
+    if (!writer.error) {
+        flushWriter(&writer);
+    }
+}
+
+static int writeExportChunk(void* context, const char* data, size_t length) {
+    ExportWriter* writer = ((ExportJob*)context)->writer;
+    putBytes(writer, data, length);
+    return writer->error ? -1 : 0;
+}
+
+static void exportGarageParallel(ExportWriter* writer, char** garage, int numVehicles, ExportFormat format,
+                                 int numThreads) {
+    ExportJob job = {garage, format, -1, writer};
+
+    for (int i = 0; i < numVehicles; i++) {
+        if (garage[i] != NULL) {
+            job.firstVehicle = i;
+            break;
+        }
+    }
+
+    putPrefix(writer, format);
+    if (!writer->error &&
+        parallelOrderedOutput(numVehicles, numThreads, formatExportChunk, writeExportChunk, &job) != 0) {
+        writer->error = 1;
+    }
+    putSuffix(writer, format);
+}
+
+long exportGarageToBuffer(char** garage, int numVehicles, ExportFormat format, char* buffer, size_t capacity) {
+    int numThreads = numVehicles >= PARALLEL_OUTPUT_THRESHOLD ? 0 : 1;
+    return exportGarageToBufferParallel(garage, numVehicles, format, buffer, capacity, numThreads);
+}
+
+long exportGarageToBufferParallel(char** garage, int numVehicles, ExportFormat format, char* buffer,
+                                  size_t capacity, int numThreads) {
+    if (garage == NULL || buffer == NULL) {
+        printf("Error: Garage pointer is NULL\n");
+        return -1;
+    }
+
+    ExportWriter writer = {buffer, capacity, 0, 0, -1, 0, NULL};
+    if (numThreads == 1) {
+        exportGarage(&writer, garage, numVehicles, format);
+    } else {
+        exportGarageParallel(&writer, garage, numVehicles, format, numThreads);
+    }
+
+    if (writer.error) {
+        return -1;
+    }
+    if (writer.used < capacity) {
+        buffer[writer.used] = '\0';
+    }
+    return (long)writer.used;
+}
+
+int exportGarageToFd(char** garage, int numVehicles, ExportFormat format, int fd) {
+    int numThreads = numVehicles >= PARALLEL_OUTPUT_THRESHOLD ? 0 : 1;
+    return exportGarageToFdParallel(garage, numVehicles, format, fd, numThreads);
+}
+
+int exportGarageToFdParallel(char** garage, int numVehicles, ExportFormat format, int fd, int numThreads) {
+    if (garage == NULL) {
+        printf("Error: Garage pointer is NULL\n");
+        return -1;
+    }
+
+    char* chunk = (char*)malloc(EXPORT_CHUNK_SIZE);
+    if (chunk == NULL) {
+        printf("Error: Memory allocation for export buffer failed\n");
+        return -1;
+    }
+
+    ExportWriter writer = {chunk, EXPORT_CHUNK_SIZE, 0, 0, fd, 0, NULL};
+    if (numThreads == 1) {
+        exportGarage(&writer, garage, numVehicles, format);
+    } else {
+        exportGarageParallel(&writer, garage, numVehicles, format, numThreads);
+    }
+    if (!writer.error) {
+        flushWriter(&writer);
+    }
+
+    free(chunk);
+    return writer.error ? -1 : 0;
+}
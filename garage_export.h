@@ -0,0 +1,62 @@
+/*
+ * Garage Export Header File
+ * Streaming exporters that write a garage as CSV, a JSON array or NDJSON.
+ *
+ * Output is formatted into a fixed size chunk and written out whenever the chunk fills up,
+ * so memory use does not depend on the number of vehicles. NULL slots are skipped.
+ * Garages of PARALLEL_OUTPUT_THRESHOLD or more vehicles are formatted on worker threads in
+ * chunks that are written in order; the output is identical to the serial path.
+ */
+
+#ifndef GARAGE_EXPORT_H
+#define GARAGE_EXPORT_H
+
+#include <stddef.h>
+
+#define EXPORT_CHUNK_SIZE 65536  // Bytes formatted before each write to a file descriptor
+
+typedef enum {
+    EXPORT_CSV,     // value,year,description with a header row
+    EXPORT_JSON,    // one JSON array of objects
+    EXPORT_NDJSON   // one JSON object per line
+} ExportFormat;
+
+/*
+ * Function: exportGarageToBuffer
+ * Purpose: Writes the whole garage into a caller supplied buffer.
+ *          The output is null terminated when there is room for it.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ *             ExportFormat - output format
+ *             char* - destination buffer
+ *             size_t - capacity of the destination buffer
+ * Returns: number of bytes written (without the terminator), or -1 if the buffer is too small
+ */
+long exportGarageToBuffer(char**, int, ExportFormat, char*, size_t);
+
+/*
+ * Function: exportGarageToBufferParallel
+ * Purpose: exportGarageToBuffer with a chosen number of formatting threads
+ *          (1 formats on the calling thread, 0 or less means one per processor).
+ */
+long exportGarageToBufferParallel(char**, int, ExportFormat, char*, size_t, int);
+
+/*
+ * Function: exportGarageToFd
+ * Purpose: Streams the garage to an open file descriptor in EXPORT_CHUNK_SIZE pieces.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ *             ExportFormat - output format
+ *             int - file descriptor to write to
+ * Returns: 0 on success, -1 if a write failed
+ */
+int exportGarageToFd(char**, int, ExportFormat, int);
+
+/*
+ * Function: exportGarageToFdParallel
+ * Purpose: exportGarageToFd with a chosen number of formatting threads
+ *          (1 formats on the calling thread, 0 or less means one per processor).
+ */
+int exportGarageToFdParallel(char**, int, ExportFormat, int, int);
+
+#endif /* GARAGE_EXPORT_H */
@@ -0,0 +1,152 @@
+/*
+ * Garage HyperLogLog
+ * Distinct description counting in fixed memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vehicle.h"
+#include "hash.h"
+#include "parallel.h"
+#include "garage_scan.h"
+#include "garage_hll.h"
+
+struct HyperLogLog {
+    unsigned char registers[HLL_REGISTERS];
+};
+
+// Number of leading zero bits of a nonzero 64-bit value
+static int leadingZeros(unsigned long long value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(value);
+#else
+    int zeros = 0;
+    while (!(value & (1ull << 63))) {
+        value <<= 1;
+        zeros++;
+    }
+    return zeros;
+#endif
+}
+
+HyperLogLog* createHyperLogLog() {
+    HyperLogLog* sketch = (HyperLogLog*)calloc(1, sizeof(HyperLogLog));
+    if (sketch == NULL) {
+        printf("Error: Memory allocation for HyperLogLog failed\n");
+    }
+    return sketch;
+}
+
+void freeHyperLogLog(HyperLogLog* sketch) {
+    free(sketch);
+}
+
+void hyperLogLogAdd(HyperLogLog* sketch, unsigned long long hash) {
+    unsigned int index = (unsigned int)(hash >> (64 - HLL_PRECISION));
+
+    // A sentinel bit caps the run at 64 - HLL_PRECISION zeros
+    unsigned long long rest = (hash << HLL_PRECISION) | (1ull << (HLL_PRECISION - 1));
+    unsigned char rank = (unsigned char)(leadingZeros(rest) + 1);
+
+    if (rank > sketch->registers[index]) {
+        sketch->registers[index] = rank;
+    }
+}
+
+void hyperLogLogAddVehicle(HyperLogLog* sketch, const char* vehicle) {
+    hyperLogLogAdd(sketch, hashDescriptionBytes(vehicleDescription(vehicle), vehicleDescriptionLength(vehicle)));
+}
+
+void mergeHyperLogLog(HyperLogLog* target, const HyperLogLog* source) {
+    if (target == NULL || source == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < HLL_REGISTERS; i++) {
+        if (source->registers[i] > target->registers[i]) {
+            target->registers[i] = source->registers[i];
+        }
+    }
+}
+
+double hyperLogLogEstimate(const HyperLogLog* sketch) {
+    if (sketch == NULL) {
+        return 0.0;
+    }
+
+    double m = HLL_REGISTERS;
+    double sum = 0.0;
+    int zeros = 0;
+
+    for (int i = 0; i < HLL_REGISTERS; i++) {
+        sum += ldexp(1.0, -sketch->registers[i]);
+        zeros += sketch->registers[i] == 0;
+    }
+
+    double estimate = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+
+    // Small cardinalities: counting the empty registers is more accurate
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * log(m / zeros);
+    }
+    return estimate;
+}
+
+void hyperLogLogSave(const HyperLogLog* sketch, unsigned char* bytes) {
+    memcpy(bytes, sketch->registers, HLL_REGISTERS);
+}
+
+HyperLogLog* hyperLogLogLoad(const unsigned char* bytes) {
+    HyperLogLog* sketch = createHyperLogLog();
+    if (sketch != NULL) {
+        memcpy(sketch->registers, bytes, HLL_REGISTERS);
+    }
+    return sketch;
+}
+
+static int sketchSlot(void* context, char* vehicle, int position) {
+    (void)position;
+    if (vehicle != NULL) {
+        hyperLogLogAddVehicle((HyperLogLog*)context, vehicle);
+    }
+    return 0;
+}
+
+typedef struct {
+    char** garage;
+    HyperLogLog* sketches;  // One per worker
+} DistinctJob;
+
+static void distinctTask(void* context, int begin, int end, int worker) {
+    DistinctJob* job = (DistinctJob*)context;
+    forEachVehicle(job->garage + begin, end - begin, sketchSlot, &job->sketches[worker]);
+}
+
+HyperLogLog* buildDistinctModels(char** garage, int numVehicles, int numThreads) {
+    if (garage == NULL) {
+        printf("Error: Garage pointer is NULL\n");
+        return NULL;
+    }
+    if (numThreads <= 0) {
+        numThreads = defaultThreadCount();
+    }
+
+    DistinctJob job = {garage, (HyperLogLog*)calloc(numThreads, sizeof(HyperLogLog))};
+    HyperLogLog* sketch = createHyperLogLog();
+    if (job.sketches == NULL || sketch == NULL) {
+        printf("Error: Memory allocation for HyperLogLog failed\n");
+        free(job.sketches);
+        freeHyperLogLog(sketch);
+        return NULL;
+    }
+
+    int workers = parallelFor(numVehicles, numThreads, distinctTask, &job);
+    for (int i = 0; i < workers; i++) {
+        mergeHyperLogLog(sketch, &job.sketches[i]);
+    }
+
+    free(job.sketches);
+    return sketch;
+}
@@ -0,0 +1,65 @@
+/*
+ * Garage HyperLogLog Header File
+ * Approximate number of distinct descriptions (models) in one or many garages.
+ *
+ * Each description is hashed once (hashDescriptionBytes); the top HLL_PRECISION bits pick a
+ * register and the register keeps the longest run of leading zeros seen in the rest. The
+ * sketch is HLL_REGISTERS bytes (16 KiB) whatever the garage size, the standard error is
+ * 1.04 / sqrt(HLL_REGISTERS) (about 0.8%), and two sketches merge by taking the register
+ * maximum, so garages, shards and files can be sketched separately and combined.
+ */
+
+#ifndef GARAGE_HLL_H
+#define GARAGE_HLL_H
+
+#define HLL_PRECISION 14
+#define HLL_REGISTERS (1 << HLL_PRECISION)
+
+typedef struct HyperLogLog HyperLogLog;
+
+/*
+ * Functions: createHyperLogLog, freeHyperLogLog
+ * Purpose: Create an empty sketch / free a sketch.
+ */
+HyperLogLog* createHyperLogLog();
+void freeHyperLogLog(HyperLogLog*);
+
+/*
+ * Functions: hyperLogLogAdd, hyperLogLogAddVehicle
+ * Purpose: Add a 64-bit hash / the description of a vehicle.
+ */
+void hyperLogLogAdd(HyperLogLog*, unsigned long long);
+void hyperLogLogAddVehicle(HyperLogLog*, const char*);
+
+/*
+ * Function: buildDistinctModels
+ * Purpose: Sketch of the descriptions in a garage. Threads each sketch part of the garage
+ *          and the partial sketches are merged.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ *             int - number of threads (0 = one per processor)
+ * Returns: the sketch, or NULL if allocation failed
+ */
+HyperLogLog* buildDistinctModels(char**, int, int);
+
+/*
+ * Function: mergeHyperLogLog
+ * Purpose: target becomes the sketch of the union of both inputs.
+ */
+void mergeHyperLogLog(HyperLogLog*, const HyperLogLog*);
+
+/*
+ * Function: hyperLogLogEstimate
+ * Purpose: Estimated number of distinct values added (linear counting for small counts).
+ */
+double hyperLogLogEstimate(const HyperLogLog*);
+
+/*
+ * Functions: hyperLogLogSave, hyperLogLogLoad
+ * Purpose: Copy the HLL_REGISTERS register bytes out / create a sketch from saved bytes,
+ *          e.g. to store a sketch next to a garage file and merge it later.
+ */
+void hyperLogLogSave(const HyperLogLog*, unsigned char*);
+HyperLogLog* hyperLogLogLoad(const unsigned char*);
+
+#endif /* GARAGE_HLL_H */
@@ -0,0 +1,263 @@
+/*
+ * Garage Index
+ * Open addressing hash index over vehicle descriptions.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vehicle.h"
+#include "hash.h"
+#include "garage_index.h"
+#include "garage_scan.h"
+
+#define INITIAL_GROUP_CAPACITY 2
+
+typedef struct {
+    unsigned long long hash;  // Hash of the description, computed once
+    char** vehicles;          // Vehicles with this description; NULL marks an empty slot
+    int count;
+    int capacity;
+} IndexSlot;
+
+struct VehicleIndex {
+    IndexSlot* slots;
+    size_t capacity;          // Always a power of two
+    size_t used;              // Number of occupied slots (distinct descriptions)
+};
+
+static size_t roundUpPowerOfTwo(size_t value) {
+    size_t result = 16;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// Returns the slot holding description, or the empty slot where it would go
+static size_t findSlot(const VehicleIndex* index, unsigned long long hash, const char* description, size_t length) {
+    size_t mask = index->capacity - 1;
+    size_t slot = (size_t)hash & mask;
+
+    while (index->slots[slot].vehicles != NULL) {
+        const IndexSlot* current = &index->slots[slot];
+        if (current->hash == hash && vehicleDescriptionLength(current->vehicles[0]) == length &&
+            memcmp(vehicleDescription(current->vehicles[0]), description, length) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int growIndex(VehicleIndex* index) {
+    size_t newCapacity = index->capacity * 2;
+    IndexSlot* newSlots = (IndexSlot*)calloc(newCapacity, sizeof(IndexSlot));
+
+    if (newSlots == NULL) {
+        printf("Error: Memory allocation for vehicle index failed\n");
+        return -1;
+    }
+
+    // Reinsert using the stored hashes; descriptions are not hashed again
+    for (size_t i = 0; i < index->capacity; i++) {
+        if (index->slots[i].vehicles != NULL) {
+            size_t slot = (size_t)index->slots[i].hash & (newCapacity - 1);
+            while (newSlots[slot].vehicles != NULL) {
+                slot = (slot + 1) & (newCapacity - 1);
+            }
+            newSlots[slot] = index->slots[i];
+        }
+    }
+
+    free(index->slots);
+    index->slots = newSlots;
+    index->capacity = newCapacity;
+    return 0;
+}
+
+VehicleIndex* createVehicleIndex(int expectedDescriptions) {
+    VehicleIndex* index = (VehicleIndex*)malloc(sizeof(VehicleIndex));
+    if (index == NULL) {
+        printf("Error: Memory allocation for vehicle index failed\n");
+        return NULL;
+    }
+
+    // Keep the load factor under 0.7
+    index->capacity = roundUpPowerOfTwo(expectedDescriptions > 0 ? (size_t)expectedDescriptions * 10 / 7 + 1 : 16);
+    index->used = 0;
+    index->slots = (IndexSlot*)calloc(index->capacity, sizeof(IndexSlot));
+
+    if (index->slots == NULL) {
+        printf("Error: Memory allocation for vehicle index failed\n");
+        free(index);
+        return NULL;
+    }
+    return index;
+}
+
+static int indexSlot(void* context, char* vehicle, int position) {
+    (void)position;
+    return vehicle != NULL && vehicleIndexAdd((VehicleIndex*)context, vehicle) != 0;
+}
+
+VehicleIndex* buildVehicleIndex(char** garage, int numVehicles) {
+    if (garage == NULL) {
+        printf("Error: Garage pointer is NULL\n");
+        return NULL;
+    }
+
+    VehicleIndex* index = createVehicleIndex(numVehicles);
+    if (index == NULL) {
+        return NULL;
+    }
+
+    if (forEachVehicle(garage, numVehicles, indexSlot, index) != 0) {
+        freeVehicleIndex(index);
+        return NULL;
+    }
+    return index;
+}
+
+int vehicleIndexAdd(VehicleIndex* index, char* vehicle) {
+    if (index == NULL || vehicle == NULL) {
+        return -1;
+    }
+
+    if ((index->used + 1) * 10 > index->capacity * 7 && growIndex(index) != 0) {
+        return -1;
+    }
+
+    const char* description = vehicleDescription(vehicle);
+    size_t length = vehicleDescriptionLength(vehicle);
+    unsigned long long hash = vehicleDescriptionHash(vehicle);  // Stored in v2 records
+    IndexSlot* slot = &index->slots[findSlot(index, hash, description, length)];
+
+    if (slot->vehicles == NULL) {
+        slot->vehicles = (char**)malloc(INITIAL_GROUP_CAPACITY * sizeof(char*));
+        if (slot->vehicles == NULL) {
+            printf("Error: Memory allocation for vehicle index failed\n");
+            return -1;
+        }
+        slot->hash = hash;
+        slot->count = 0;
+        slot->capacity = INITIAL_GROUP_CAPACITY;
+        index->used++;
+    } else if (slot->count == slot->capacity) {
+        char** grown = (char**)realloc(slot->vehicles, slot->capacity * 2 * sizeof(char*));
+        if (grown == NULL) {
+            printf("Error: Memory allocation for vehicle index failed\n");
+            return -1;
+        }
+        slot->vehicles = grown;
+        slot->capacity *= 2;
+    }
+
+    slot->vehicles[slot->count++] = vehicle;
+    return 0;
+}
+
+int vehicleIndexRemove(VehicleIndex* index, const char* vehicle) {
+    if (index == NULL || vehicle == NULL) {
+        return 0;
+    }
+
+    // Descriptions never change, so this is the hash the vehicle was added with
+    size_t mask = index->capacity - 1;
+    size_t hole = findSlot(index, vehicleDescriptionHash(vehicle), vehicleDescription(vehicle),
+                           vehicleDescriptionLength(vehicle));
+    IndexSlot* slot = &index->slots[hole];
+
+    if (slot->vehicles == NULL) {
+        return 0;
+    }
+
+    int found = -1;
+    for (int i = 0; i < slot->count; i++) {
+        if (slot->vehicles[i] == vehicle) {
+            found = i;
+            break;
+        }
+    }
+    if (found < 0) {
+        return 0;
+    }
+
+    slot->vehicles[found] = slot->vehicles[--slot->count];
+    if (slot->count > 0) {
+        return 1;
+    }
+
+    // Last vehicle with this description: empty the slot and shift later
+    // entries of the probe chain back so lookups never stop early
+    free(slot->vehicles);
+    slot->vehicles = NULL;
+    index->used--;
+
+    size_t next = (hole + 1) & mask;
+    while (index->slots[next].vehicles != NULL) {
+        size_t home = (size_t)index->slots[next].hash & mask;
+        // Move the entry if the hole lies between its home slot and where it is now
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            index->slots[hole] = index->slots[next];
+            index->slots[next].vehicles = NULL;
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    return 1;
+}
+
+char* const* vehicleIndexLookup(const VehicleIndex* index, const char* description, int* count) {
+    if (count != NULL) {
+        *count = 0;
+    }
+    if (index == NULL || description == NULL) {
+        return NULL;
+    }
+
+    size_t length = strlen(description);
+    const IndexSlot* slot = &index->slots[findSlot(index, hashDescriptionBytes(description, length), description, length)];
+    if (slot->vehicles == NULL) {
+        return NULL;
+    }
+
+    if (count != NULL) {
+        *count = slot->count;
+    }
+    return slot->vehicles;
+}
+
+int vehicleIndexDescriptions(const VehicleIndex* index) {
+    return index == NULL ? 0 : (int)index->used;
+}
+
+static void onGarageEvent(void* context, const GarageEvent* event) {
+    VehicleIndex* index = (VehicleIndex*)context;
+
+    if (event->type == GARAGE_EVENT_INSERT) {
+        vehicleIndexAdd(index, (char*)event->vehicle);
+    } else if (event->type == GARAGE_EVENT_REMOVE) {
+        vehicleIndexRemove(index, event->vehicle);
+    }
+}
+
+int attachVehicleIndex(VehicleIndex* index, GarageListeners* listeners) {
+    return addGarageListener(listeners, onGarageEvent, index);
+}
+
+void detachVehicleIndex(VehicleIndex* index, GarageListeners* listeners) {
+    removeGarageListener(listeners, onGarageEvent, index);
+}
+
+void freeVehicleIndex(VehicleIndex* index) {
+    if (index == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < index->capacity; i++) {
+        free(index->slots[i].vehicles);
+    }
+    free(index->slots);
+    free(index);
+}
@@ -0,0 +1,74 @@
+/*
+ * Garage Index Header File
+ * Hash index from a vehicle description to every vehicle with exactly that description.
+ *
+ * Open addressing with linear probing. Each slot holds one distinct description, its hash
+ * and the list of vehicles sharing it. Vehicles are stored by pointer, so positions shifting
+ * after removeVehicle do not invalidate the index. Adding and removing a vehicle use the
+ * hash stored in v2 records when they are created (see vehicleDescriptionHash); v1 records
+ * have no room for it and are hashed on the spot. Resizing reuses the slot hashes.
+ */
+
+#ifndef GARAGE_INDEX_H
+#define GARAGE_INDEX_H
+
+#include "vehicle.h"
+
+typedef struct VehicleIndex VehicleIndex;
+
+/*
+ * Function: createVehicleIndex
+ * Purpose: Creates an empty index sized for the expected number of distinct descriptions.
+ * Returns: the index, or NULL if allocation failed
+ */
+VehicleIndex* createVehicleIndex(int);
+
+/*
+ * Function: buildVehicleIndex
+ * Purpose: Creates an index containing every vehicle already in a garage.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ * Returns: the index, or NULL if allocation failed
+ */
+VehicleIndex* buildVehicleIndex(char**, int);
+
+/*
+ * Functions: vehicleIndexAdd, vehicleIndexRemove
+ * Purpose: Add a vehicle to, or remove a vehicle from, the index.
+ * Returns: vehicleIndexAdd - 0 on success, -1 if allocation failed
+ *          vehicleIndexRemove - 1 if the vehicle was indexed, 0 otherwise
+ */
+int vehicleIndexAdd(VehicleIndex*, char*);
+int vehicleIndexRemove(VehicleIndex*, const char*);
+
+/*
+ * Function: vehicleIndexLookup
+ * Purpose: Exact match lookup of a description. O(1) expected, independent of garage size.
+ * Parameters: const VehicleIndex* - the index
+ *             const char* - description to look for
+ *             int* - receives the number of matching vehicles
+ * Returns: the matching vehicles (owned by the index, valid until the index changes), or NULL
+ */
+char* const* vehicleIndexLookup(const VehicleIndex*, const char*, int*);
+
+/*
+ * Function: vehicleIndexDescriptions
+ * Purpose: Number of distinct descriptions currently indexed.
+ */
+int vehicleIndexDescriptions(const VehicleIndex*);
+
+/*
+ * Functions: attachVehicleIndex, detachVehicleIndex
+ * Purpose: Keep the index in sync with garage events of one listener list (see addGarageListener).
+ *          Pass the same list to both: the garage's own list, or NULL for plain garages.
+ */
+int attachVehicleIndex(VehicleIndex*, GarageListeners*);
+void detachVehicleIndex(VehicleIndex*, GarageListeners*);
+
+/*
+ * Function: freeVehicleIndex
+ * Purpose: Frees the index. The vehicles themselves are not freed.
+ */
+void freeVehicleIndex(VehicleIndex*);
+
+#endif /* GARAGE_INDEX_H */
@@ -0,0 +1,545 @@
+/*
+ * Garage Join
+ * Hash join of a garage against a price list.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "vehicle.h"
+#include "hash.h"
+#include "parallel.h"
+#include "garage_scan.h"
+#include "garage_join.h"
+
+#define EMPTY_SLOT -1
+
+typedef struct {
+    size_t offset;             // Description inside the list's text
+    unsigned int length;
+    unsigned long value;
+    unsigned long long hash;   // hashDescriptionBytes of the description
+} PriceRow;
+
+struct PriceList {
+    PriceRow* rows;
+    int count;
+    int capacity;
+    char* text;                // Null terminated descriptions, back to back
+    size_t textUsed;
+    size_t textCapacity;
+};
+
+typedef struct {
+    char** garage;
+    int numVehicles;
+    const PriceList* prices;
+    int numThreads;
+    unsigned char* priced;         // Per vehicle: given a price
+    unsigned int* previous;        // Per vehicle header before the join (NULL without listeners)
+    unsigned char* rowMatched;     // Per row: some vehicle has its description
+    int* clamped;                  // Per worker count of clamped prices
+
+    // Built on the price list: open addressing table of row numbers
+    int* table;
+    size_t tableMask;
+    int* slotOf;                   // Table slot of every row
+    atomic_uchar* slotMatched;
+
+    // Built on the garage: chained table of positions
+    int* heads;
+    int* next;
+    unsigned long long* hashes;
+    int* partRows;                 // Row numbers grouped by part, last row first
+    int* partStart;                // Part p owns partRows[partStart[p]..partStart[p + 1])
+} JoinJob;
+
+typedef struct {
+    JoinJob* job;
+    int worker;
+    int base;
+} JoinScan;
+
+PriceList* createPriceList() {
+    PriceList* list = (PriceList*)calloc(1, sizeof(PriceList));
+    if (list == NULL) {
+        printf("Error: Memory allocation for price list failed\n");
+    }
+    return list;
+}
+
+void freePriceList(PriceList* list) {
+    if (list == NULL) {
+        return;
+    }
+
+    free(list->rows);
+    free(list->text);
+    free(list);
+}
+
+static int addPriceBytes(PriceList* list, const char* description, size_t length, unsigned long value) {
+    if (list->count == list->capacity) {
+        int newCapacity = list->capacity > 0 ? list->capacity * 2 : 64;
+        PriceRow* rows = (PriceRow*)realloc(list->rows, newCapacity * sizeof(PriceRow));
+        if (rows == NULL) {
+            printf("Error: Memory allocation for price list failed\n");
+            return -1;
+        }
+        list->rows = rows;
+        list->capacity = newCapacity;
+    }
+
+    if (list->textUsed + length + 1 > list->textCapacity) {
+        size_t newCapacity = list->textCapacity > 0 ? list->textCapacity * 2 : 4096;
+        while (newCapacity < list->textUsed + length + 1) {
+            newCapacity *= 2;
+        }
+        char* text = (char*)realloc(list->text, newCapacity);
+        if (text == NULL) {
+            printf("Error: Memory allocation for price list failed\n");
+            return -1;
+        }
+        list->text = text;
+        list->textCapacity = newCapacity;
+    }
+
+    PriceRow* row = &list->rows[list->count++];
+    row->offset = list->textUsed;
+    row->length = (unsigned int)length;
+    row->value = value;
+    row->hash = hashDescriptionBytes(description, length);
+
+    memcpy(list->text + list->textUsed, description, length);
+    list->text[list->textUsed + length] = '\0';
+    list->textUsed += length + 1;
+    return 0;
+}
+
+int addPrice(PriceList* list, const char* description, unsigned long value) {
+    if (list == NULL || description == NULL) {
+        printf("Error: Price list or description pointer is NULL\n");
+        return -1;
+    }
+    return addPriceBytes(list, description, strlen(description), value);
+}
+
+// Parses one line: a plain or quoted description, a comma and a decimal value
+static int parseRow(PriceList* list, const char* line, const char* end, char** scratch, size_t* scratchSize) {
+    const char* c = line;
+    size_t length = 0;
+
+    if ((size_t)(end - line) + 1 > *scratchSize) {
+        char* grown = (char*)realloc(*scratch, (size_t)(end - line) + 1);
+        if (grown == NULL) {
+            return -1;
+        }
+        *scratch = grown;
+        *scratchSize = (size_t)(end - line) + 1;
+    }
+
+    if (c < end && *c == '"') {
+        // Quoted: "" stands for one quote
+        for (c++; c < end; c++) {
+            if (*c == '"') {
+                if (c + 1 < end && c[1] == '"') {
+                    c++;
+                } else {
+                    break;
+                }
+            }
+            (*scratch)[length++] = *c;
+        }
+        if (c == end) {
+            return -1;
+        }
+        c++;
+    } else {
+        while (c < end && *c != ',') {
+            (*scratch)[length++] = *c++;
+        }
+    }
+
+    if (c == end || *c != ',' || c + 1 == end) {
+        return -1;
+    }
+
+    unsigned long value = 0;
+    for (c++; c < end; c++) {
+        if (*c < '0' || *c > '9' || value > (unsigned long)-1 / 10) {
+            return -1;
+        }
+        value = value * 10 + (unsigned long)(*c - '0');
+    }
+
+    return addPriceBytes(list, *scratch, length, value);
+}
+
+PriceList* parsePriceList(const char* text, size_t size) {
+    if (text == NULL) {
+        printf("Error: Price list text is NULL\n");
+        return NULL;
+    }
+
+    PriceList* list = createPriceList();
+    char* scratch = NULL;
+    size_t scratchSize = 0;
+    int lineNumber = 0;
+
+    for (const char* line = text; list != NULL && line < text + size; ) {
+        const char* newline = (const char*)memchr(line, '\n', (size_t)(text + size - line));
+        const char* end = newline != NULL ? newline : text + size;
+        const char* next = newline != NULL ? newline + 1 : text + size;
+
+        if (end > line && end[-1] == '\r') {
+            end--;
+        }
+        lineNumber++;
+
+        int isHeader = lineNumber == 1 && (size_t)(end - line) == strlen("description,value") &&
+                       memcmp(line, "description,value", (size_t)(end - line)) == 0;
+        if (end > line && !isHeader && parseRow(list, line, end, &scratch, &scratchSize) != 0) {
+            printf("Error: Price list line %d is malformed\n", lineNumber);
+            freePriceList(list);
+            list = NULL;
+        }
+        line = next;
+    }
+
+    free(scratch);
+    return list;
+}
+
+PriceList* loadPriceList(const char* path) {
+    FILE* file = path == NULL ? NULL : fopen(path, "rb");
+    if (file == NULL) {
+        printf("Error: Cannot open price list %s\n", path == NULL ? "(null)" : path);
+        return NULL;
+    }
+
+    char* text = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+    size_t got;
+
+    do {
+        if (size == capacity) {
+            capacity = capacity > 0 ? capacity * 2 : 65536;
+            char* grown = (char*)realloc(text, capacity);
+            if (grown == NULL) {
+                printf("Error: Memory allocation for price list failed\n");
+                free(text);
+                fclose(file);
+                return NULL;
+            }
+            text = grown;
+        }
+        got = fread(text + size, 1, capacity - size, file);
+        size += got;
+    } while (got > 0);
+
+    int failed = ferror(file);
+    fclose(file);
+    if (failed) {
+        printf("Error: Cannot read price list %s\n", path);
+        free(text);
+        return NULL;
+    }
+
+    PriceList* list = parsePriceList(text, size);
+    free(text);
+    return list;
+}
+
+int priceListSize(const PriceList* list) {
+    return list == NULL ? 0 : list->count;
+}
+
+const char* priceListDescription(const PriceList* list, int row) {
+    return list->text + list->rows[row].offset;
+}
+
+unsigned long priceListValue(const PriceList* list, int row) {
+    return list->rows[row].value;
+}
+
+static int sameDescription(const PriceList* list, const PriceRow* row, const char* vehicle) {
+    return vehicleDescriptionLength(vehicle) == row->length &&
+           memcmp(vehicleDescription(vehicle), list->text + row->offset, row->length) == 0;
+}
+
+static size_t tableSize(int entries) {
+    size_t size = 16;
+    while (size < (size_t)entries * 2) {
+        size <<= 1;
+    }
+    return size;
+}
+
+// Writes a row's value (clamped) into a vehicle, keeping the year
+static void applyPrice(JoinJob* job, int position, const PriceRow* row, int worker) {
+    char* vehicle = job->garage[position];
+    unsigned int packedData = vehicleHeader(vehicle);
+    unsigned int value = row->value > MAX_VEHICLE_VALUE ? MAX_VEHICLE_VALUE : (unsigned int)row->value;
+
+    if (job->previous != NULL) {
+        job->previous[position] = packedData;
+    }
+    job->clamped[worker] += row->value > MAX_VEHICLE_VALUE;
+    job->priced[position] = 1;
+    setVehicleHeader(vehicle, packHeader(value, headerYear(packedData)));
+}
+
+// Price side table: the last row of a description owns its slot
+static void buildPriceTable(JoinJob* job) {
+    const PriceList* prices = job->prices;
+
+    for (int r = 0; r < prices->count; r++) {
+        const PriceRow* row = &prices->rows[r];
+        size_t slot = (size_t)row->hash & job->tableMask;
+
+        while (job->table[slot] != EMPTY_SLOT) {
+            const PriceRow* other = &prices->rows[job->table[slot]];
+            if (other->hash == row->hash && other->length == row->length &&
+                memcmp(prices->text + other->offset, prices->text + row->offset, row->length) == 0) {
+                break;
+            }
+            slot = (slot + 1) & job->tableMask;
+        }
+        job->table[slot] = r;
+        job->slotOf[r] = (int)slot;
+    }
+}
+
+static int probeSlot(void* context, char* vehicle, int position) {
+    JoinScan* scan = (JoinScan*)context;
+    JoinJob* job = scan->job;
+
+    if (vehicle == NULL) {
+        return 0;
+    }
+
+    unsigned long long hash = hashDescriptionBytes(vehicleDescription(vehicle), vehicleDescriptionLength(vehicle));
+    for (size_t slot = (size_t)hash & job->tableMask; job->table[slot] != EMPTY_SLOT; slot = (slot + 1) & job->tableMask) {
+        const PriceRow* row = &job->prices->rows[job->table[slot]];
+        if (row->hash == hash && sameDescription(job->prices, row, vehicle)) {
+            applyPrice(job, scan->base + position, row, scan->worker);
+            atomic_store_explicit(&job->slotMatched[slot], 1, memory_order_relaxed);
+            break;
+        }
+    }
+    return 0;
+}
+
+static void probeGarageTask(void* context, int begin, int end, int worker) {
+    JoinJob* job = (JoinJob*)context;
+    JoinScan scan = {job, worker, begin};
+    forEachVehicle(job->garage + begin, end - begin, probeSlot, &scan);
+}
+
+// Garage side table: chains of positions per hash bucket
+static int chainSlot(void* context, char* vehicle, int position) {
+    JoinJob* job = (JoinJob*)context;
+
+    if (vehicle != NULL) {
+        unsigned long long hash = hashDescriptionBytes(vehicleDescription(vehicle), vehicleDescriptionLength(vehicle));
+        size_t bucket = (size_t)hash & job->tableMask;
+        job->hashes[position] = hash;
+        job->next[position] = job->heads[bucket];
+        job->heads[bucket] = position;
+    }
+    return 0;
+}
+
+// Rows are split by hash so that every row of a description goes to the same part
+static int rowPart(const JoinJob* job, const PriceRow* row) {
+    return (int)(row->hash % (unsigned long long)job->numThreads);
+}
+
+// Groups the row numbers by part, last to first inside every part
+static void splitRows(JoinJob* job) {
+    const PriceList* prices = job->prices;
+
+    for (int r = 0; r < prices->count; r++) {
+        job->partStart[rowPart(job, &prices->rows[r]) + 1]++;
+    }
+    for (int part = 0; part < job->numThreads; part++) {
+        job->partStart[part + 1] += job->partStart[part];
+    }
+    for (int r = prices->count - 1; r >= 0; r--) {
+        int part = rowPart(job, &prices->rows[r]);
+        job->partRows[job->partStart[part]++] = r;
+    }
+    // The fill moved every start to the next part's start
+    for (int part = job->numThreads; part > 0; part--) {
+        job->partStart[part] = job->partStart[part - 1];
+    }
+    job->partStart[0] = 0;
+}
+
+// Every worker walks its own parts' rows last to first: the last row prices a vehicle and
+// earlier rows leave it alone
+static void probeRowsTask(void* context, int begin, int end, int worker) {
+    JoinJob* job = (JoinJob*)context;
+    const PriceList* prices = job->prices;
+
+    for (int i = job->partStart[begin]; i < job->partStart[end]; i++) {
+        int r = job->partRows[i];
+        const PriceRow* row = &prices->rows[r];
+
+        for (int position = job->heads[(size_t)row->hash & job->tableMask]; position != EMPTY_SLOT;
+             position = job->next[position]) {
+            if (job->hashes[position] != row->hash || !sameDescription(prices, row, job->garage[position])) {
+                continue;
+            }
+            job->rowMatched[r] = 1;
+            if (!job->priced[position]) {
+                applyPrice(job, position, row, worker);
+            }
+        }
+    }
+}
+
+static void freeJoinJob(JoinJob* job) {
+    free(job->priced);
+    free(job->previous);
+    free(job->rowMatched);
+    free(job->clamped);
+    free(job->table);
+    free(job->slotOf);
+    free((void*)job->slotMatched);
+    free(job->heads);
+    free(job->next);
+    free(job->hashes);
+    free(job->partRows);
+    free(job->partStart);
+}
+
+int revalueGarage(char** garage, int numVehicles, const PriceList* prices, JoinBuildSide side, int numThreads,
+                  RevalueReport* report) {
+    JoinJob job = {0};
+
+    if (report != NULL) {
+        memset(report, 0, sizeof(RevalueReport));
+    }
+    if (garage == NULL || prices == NULL) {
+        printf("Error: Garage or price list pointer is NULL\n");
+        return -1;
+    }
+    if (numThreads <= 0) {
+        numThreads = defaultThreadCount();
+    }
+    if (side == JOIN_BUILD_AUTO) {
+        side = prices->count <= numVehicles ? JOIN_BUILD_PRICES : JOIN_BUILD_GARAGE;
+    }
+
+    // Everything is allocated before the first header is rewritten
+    int failed = 0;
+    job.garage = garage;
+    job.numVehicles = numVehicles;
+    job.prices = prices;
+    job.numThreads = numThreads;
+    job.priced = (unsigned char*)calloc(numVehicles > 0 ? numVehicles : 1, 1);
+    job.rowMatched = (unsigned char*)calloc(prices->count > 0 ? prices->count : 1, 1);
+    job.clamped = (int*)calloc(numThreads, sizeof(int));
+    failed |= job.priced == NULL || job.rowMatched == NULL || job.clamped == NULL;
+
+    if (hasGarageListeners(NULL)) {
+        job.previous = (unsigned int*)malloc((numVehicles > 0 ? numVehicles : 1) * sizeof(unsigned int));
+        failed |= job.previous == NULL;
+    }
+
+    if (side == JOIN_BUILD_PRICES) {
+        size_t size = tableSize(prices->count);
+        job.tableMask = size - 1;
+        job.table = (int*)malloc(size * sizeof(int));
+        job.slotMatched = (atomic_uchar*)calloc(size, sizeof(atomic_uchar));
+        job.slotOf = (int*)malloc((prices->count > 0 ? prices->count : 1) * sizeof(int));
+        failed |= job.table == NULL || job.slotMatched == NULL || job.slotOf == NULL;
+    } else {
+        size_t size = tableSize(numVehicles);
+        job.tableMask = size - 1;
+        job.heads = (int*)malloc(size * sizeof(int));
+        job.next = (int*)malloc((numVehicles > 0 ? numVehicles : 1) * sizeof(int));
+        job.hashes = (unsigned long long*)malloc((numVehicles > 0 ? numVehicles : 1) * sizeof(unsigned long long));
+        job.partRows = (int*)malloc((prices->count > 0 ? prices->count : 1) * sizeof(int));
+        job.partStart = (int*)calloc(numThreads + 1, sizeof(int));
+        failed |= job.heads == NULL || job.next == NULL || job.hashes == NULL;
+        failed |= job.partRows == NULL || job.partStart == NULL;
+    }
+
+    if (failed) {
+        printf("Error: Memory allocation for price join failed\n");
+        freeJoinJob(&job);
+        return -1;
+    }
+
+    if (side == JOIN_BUILD_PRICES) {
+        memset(job.table, 0xff, (job.tableMask + 1) * sizeof(int));
+        buildPriceTable(&job);
+        parallelFor(numVehicles, numThreads, probeGarageTask, &job);
+        for (int r = 0; r < prices->count; r++) {
+            job.rowMatched[r] = atomic_load_explicit(&job.slotMatched[job.slotOf[r]], memory_order_relaxed);
+        }
+    } else {
+        memset(job.heads, 0xff, (job.tableMask + 1) * sizeof(int));
+        // Built back to front so every chain lists positions in ascending order
+        scanGarage(garage, numVehicles, GARAGE_SCAN_REVERSE, GARAGE_PREFETCH_DISTANCE, chainSlot, &job);
+        splitRows(&job);
+        parallelFor(numThreads, numThreads, probeRowsTask, &job);
+    }
+
+    // Listeners hear about the changes in position order, on this thread
+    int matched = 0;
+    int unmatched = 0;
+    for (int i = 0; i < numVehicles; i++) {
+        if (garage[i] == NULL) {
+            continue;
+        }
+        if (!job.priced[i]) {
+            unmatched++;
+            continue;
+        }
+        matched++;
+        if (job.previous != NULL && job.previous[i] != vehicleHeader(garage[i])) {
+            notifyVehicleUpdated(NULL, garage[i], i, job.previous[i]);
+        }
+    }
+
+    if (report != NULL) {
+        report->buildSide = side;
+        report->matchedVehicles = matched;
+        report->unmatchedVehicles = unmatched;
+        for (int w = 0; w < numThreads; w++) {
+            report->clampedVehicles += job.clamped[w];
+        }
+
+        for (int r = 0; r < prices->count; r++) {
+            report->numUnmatchedRows += !job.rowMatched[r];
+        }
+        report->unmatchedRows = (int*)malloc((report->numUnmatchedRows > 0 ? report->numUnmatchedRows : 1) * sizeof(int));
+        if (report->unmatchedRows == NULL) {
+            printf("Error: Memory allocation for price join report failed\n");
+            report->numUnmatchedRows = 0;
+        }
+        for (int r = 0, count = 0; report->unmatchedRows != NULL && r < prices->count; r++) {
+            if (!job.rowMatched[r]) {
+                report->unmatchedRows[count++] = r;
+            }
+        }
+    }
+
+    freeJoinJob(&job);
+    return 0;
+}
+
+void freeRevalueReport(RevalueReport* report) {
+    if (report == NULL) {
+        return;
+    }
+
+    free(report->unmatchedRows);
+    report->unmatchedRows = NULL;
+    report->numUnmatchedRows = 0;
+}
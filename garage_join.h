@@ -0,0 +1,87 @@
+/*
+ * Garage Join Header File
+ * Bulk revaluation of a garage from a price list keyed by description (a hash join).
+ *
+ * A price list is a CSV file of description,value rows (an optional description,value
+ * header row; descriptions containing commas or quotes are quoted as garage_export writes
+ * them). The join builds a hash table on the smaller side, the price rows or the garage's
+ * descriptions, and probes it with the other side on worker threads, so it is O(n + m)
+ * instead of a search of the list per vehicle. Matching vehicles get the row's value written
+ * into their packed header in place; the year is kept and values above MAX_VEHICLE_VALUE are
+ * clamped. If a description has several rows the last one wins.
+ */
+
+#ifndef GARAGE_JOIN_H
+#define GARAGE_JOIN_H
+
+#include <stddef.h>
+
+typedef struct PriceList PriceList;
+
+typedef enum {
+    JOIN_BUILD_AUTO,     // Build on whichever side has fewer rows
+    JOIN_BUILD_PRICES,   // Hash the price list, probe with the garage
+    JOIN_BUILD_GARAGE    // Hash the garage descriptions, probe with the price list
+} JoinBuildSide;
+
+typedef struct {
+    JoinBuildSide buildSide;  // Side the table was built on
+    int matchedVehicles;      // Vehicles that were given a price
+    int clampedVehicles;      // Of those, vehicles whose price exceeded MAX_VEHICLE_VALUE
+    int unmatchedVehicles;    // Vehicles with no row in the price list
+    int* unmatchedRows;       // Price rows (0 based, header excluded) matching no vehicle, ascending
+    int numUnmatchedRows;
+} RevalueReport;
+
+/*
+ * Functions: createPriceList, freePriceList
+ * Purpose: Create an empty price list / free a price list.
+ */
+PriceList* createPriceList();
+void freePriceList(PriceList*);
+
+/*
+ * Function: addPrice
+ * Purpose: Appends a row to a price list.
+ * Returns: 0 on success, -1 if allocation failed
+ */
+int addPrice(PriceList*, const char*, unsigned long);
+
+/*
+ * Functions: parsePriceList, loadPriceList
+ * Purpose: Reads a price list from CSV text / from a CSV file.
+ * Returns: the price list, or NULL if a line is malformed or the file cannot be read
+ */
+PriceList* parsePriceList(const char*, size_t);
+PriceList* loadPriceList(const char*);
+
+/*
+ * Functions: priceListSize, priceListDescription, priceListValue
+ * Purpose: Number of rows / the description and value of a row.
+ */
+int priceListSize(const PriceList*);
+const char* priceListDescription(const PriceList*, int);
+unsigned long priceListValue(const PriceList*, int);
+
+/*
+ * Function: revalueGarage
+ * Purpose: Joins a garage against a price list and rewrites the value of every match.
+ *          Changed vehicles are reported to the garage listeners as GARAGE_EVENT_UPDATE
+ *          once the join has finished.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ *             const PriceList* - the prices
+ *             JoinBuildSide - side to build the hash table on
+ *             int - number of threads (0 = one per processor)
+ *             RevalueReport* - receives the counts and unmatched rows (may be NULL)
+ * Returns: 0 on success, -1 on error (garage unchanged)
+ */
+int revalueGarage(char**, int, const PriceList*, JoinBuildSide, int, RevalueReport*);
+
+/*
+ * Function: freeRevalueReport
+ * Purpose: Frees the list held by a report.
+ */
+void freeRevalueReport(RevalueReport*);
+
+#endif /* GARAGE_JOIN_H */
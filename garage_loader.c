@@ -0,0 +1,701 @@
+/*
+ * Garage Loader
+ * io_uring reads into registered buffers with worker threads finishing the files, and a
+ * pread thread pool for everything else.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parallel.h"
+#include "garage_loader.h"
+
+#ifndef _WIN32
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <pthread.h>
+    #include <stdatomic.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+    #include <sys/syscall.h>
+    #ifdef __NR_io_uring_setup
+        #include <linux/io_uring.h>
+        #include <sys/mman.h>
+        #include <sys/uio.h>
+        #define LOADER_HAS_IO_URING
+    #endif
+#endif
+
+const char* loaderBackendName(LoaderBackend backend) {
+    switch (backend) {
+        case LOADER_AUTO:
+            return "auto";
+        case LOADER_IO_URING:
+            return "io_uring";
+        case LOADER_PREAD:
+            return "pread";
+    }
+    return "unknown";
+}
+
+#ifndef _WIN32
+
+typedef struct {
+    const char* path;
+    int fd;
+    char* data;             // Whole file; NULL once handed to the handler
+    size_t size;
+    size_t submitted;       // Bytes covered by reads so far (submitting thread only)
+    atomic_int remaining;   // Chunks not yet copied into data
+    atomic_int failed;
+    long long reads;
+    int result;             // 0 once the handler accepted the file
+    int retry;              // An io_uring read failed: read it again with pread
+} LoaderFile;
+
+#ifdef LOADER_HAS_IO_URING
+
+// The rings shared with the kernel
+typedef struct {
+    int fd;
+    unsigned int* sqTail;
+    unsigned int sqMask;
+    unsigned int* sqArray;
+    unsigned int* cqHead;
+    unsigned int* cqTail;
+    unsigned int cqMask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing;           // Same as sqRing when the kernel maps both at once
+    size_t cqRingSize;
+    size_t sqesSize;
+} LoaderRing;
+
+// One registered buffer and the read it holds
+typedef struct {
+    int file;
+    size_t offset;          // In the file
+    size_t length;
+    size_t done;            // Bytes read so far; short reads are continued
+    int error;
+} LoaderSlot;
+
+#endif
+
+typedef struct {
+    LoaderFile* files;
+    int numFiles;
+    LoadedFileHandler handler;
+    void* context;
+    int* preadFiles;                         // Files for the pread pool
+    int numPreadFiles;
+    int fallback;                            // Failed reads are retried rather than reported
+#ifdef LOADER_HAS_IO_URING
+    int numWorkers;
+    LoaderRing ring;
+    char* buffers;                           // LOADER_QUEUE_DEPTH registered chunks
+    LoaderSlot slots[LOADER_QUEUE_DEPTH];
+    pthread_mutex_t lock;                    // Guards the free slots, the chunk queue and finished
+    pthread_cond_t chunkReady;               // A chunk was queued, or submitting ended
+    pthread_cond_t slotFreed;
+    int freeSlots[LOADER_QUEUE_DEPTH];
+    int numFree;
+    int queue[LOADER_QUEUE_DEPTH];           // Completed chunks waiting to be copied
+    int queueHead;
+    int queueCount;
+    int finished;                            // No more chunks will be queued
+    int nextFile;                            // Submitting thread only from here on
+    int currentFile;
+    long long readsIssued;
+#endif
+} GarageLoad;
+
+// Opens a file and allocates room for all of it. Returns 0, or -1 after reporting the error.
+static int openLoaderFile(LoaderFile* file) {
+    struct stat status;
+
+    file->fd = open(file->path, O_RDONLY | O_CLOEXEC);
+    if (file->fd < 0 || fstat(file->fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+        printf("Error: Cannot open garage file %s\n", file->path);
+        if (file->fd >= 0) {
+            close(file->fd);
+            file->fd = -1;
+        }
+        return -1;
+    }
+    file->size = (size_t)status.st_size;
+    file->data = (char*)malloc(file->size > 0 ? file->size : 1);
+    if (file->data == NULL) {
+        printf("Error: Memory allocation for garage file %s failed\n", file->path);
+        close(file->fd);
+        file->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+// Closes a file whose reads are all done and gives it to the handler
+static void finishFile(GarageLoad* load, int index) {
+    LoaderFile* file = &load->files[index];
+
+    close(file->fd);
+    file->fd = -1;
+    if (atomic_load(&file->failed)) {
+        if (load->fallback) {
+            file->retry = 1;
+        } else {
+            printf("Error: Cannot read garage file %s\n", file->path);
+        }
+        free(file->data);
+        file->result = -1;
+    } else {
+        file->result = load->handler(load->context, index, file->data, file->size) == 0 ? 0 : -1;
+    }
+    file->data = NULL;
+}
+
+static void preadTask(void* context, int begin, int end, int worker) {
+    GarageLoad* load = (GarageLoad*)context;
+    (void)worker;
+
+    for (int i = begin; i < end; i++) {
+        LoaderFile* file = &load->files[load->preadFiles[i]];
+        if (openLoaderFile(file) != 0) {
+            continue;
+        }
+        size_t offset = 0;
+        while (offset < file->size) {
+            size_t length = file->size - offset < LOADER_CHUNK_SIZE ? file->size - offset : LOADER_CHUNK_SIZE;
+            ssize_t got = pread(file->fd, file->data + offset, length, (off_t)offset);
+            file->reads++;
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                atomic_store(&file->failed, 1);
+                break;
+            }
+            offset += (size_t)got;
+        }
+        finishFile(load, load->preadFiles[i]);
+    }
+}
+
+#ifdef LOADER_HAS_IO_URING
+
+static void closeRing(LoaderRing* ring) {
+    if (ring->sqes != NULL) {
+        munmap(ring->sqes, ring->sqesSize);
+    }
+    if (ring->cqRing != NULL && ring->cqRing != ring->sqRing) {
+        munmap(ring->cqRing, ring->cqRingSize);
+    }
+    if (ring->sqRing != NULL) {
+        munmap(ring->sqRing, ring->sqRingSize);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);  // Also drops the registered buffers
+    }
+    memset(ring, 0, sizeof(LoaderRing));
+    ring->fd = -1;
+}
+
+// Creates a ring and maps its queues. Returns 0, or -1 if the kernel refuses.
+static int setupRing(LoaderRing* ring, unsigned int entries) {
+    struct io_uring_params params;
+
+    memset(ring, 0, sizeof(LoaderRing));
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        return -1;
+    }
+
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->sqRingSize = ring->sqRingSize > ring->cqRingSize ? ring->sqRingSize : ring->cqRingSize;
+    }
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    void* sq = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->sqRing = sq != MAP_FAILED ? sq : NULL;
+    if (ring->sqRing != NULL && (params.features & IORING_FEAT_SINGLE_MMAP)) {
+        ring->cqRing = ring->sqRing;
+    } else if (ring->sqRing != NULL) {
+        void* cq = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        ring->cqRing = cq != MAP_FAILED ? cq : NULL;
+    }
+    void* sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    ring->sqes = sqes != MAP_FAILED ? (struct io_uring_sqe*)sqes : NULL;
+    if (ring->sqRing == NULL || ring->cqRing == NULL || ring->sqes == NULL) {
+        closeRing(ring);
+        return -1;
+    }
+
+    char* sqBase = (char*)ring->sqRing;
+    char* cqBase = (char*)ring->cqRing;
+    ring->sqTail = (unsigned int*)(sqBase + params.sq_off.tail);
+    ring->sqMask = *(unsigned int*)(sqBase + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned int*)(sqBase + params.sq_off.array);
+    ring->cqHead = (unsigned int*)(cqBase + params.cq_off.head);
+    ring->cqTail = (unsigned int*)(cqBase + params.cq_off.tail);
+    ring->cqMask = *(unsigned int*)(cqBase + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cqBase + params.cq_off.cqes);
+    return 0;
+}
+
+// Queues the rest of a slot's read; the kernel sees it at the next enter
+static void prepareSlot(GarageLoad* load, int slot) {
+    LoaderRing* ring = &load->ring;
+    LoaderSlot* read = &load->slots[slot];
+    unsigned int tail = *ring->sqTail;
+    unsigned int index = tail & ring->sqMask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->fd = load->files[read->file].fd;
+    sqe->off = read->offset + read->done;
+    sqe->addr = (unsigned long long)(size_t)(load->buffers + (size_t)slot * LOADER_CHUNK_SIZE + read->done);
+    sqe->len = (unsigned int)(read->length - read->done);
+    sqe->buf_index = (unsigned short)slot;
+    sqe->user_data = (unsigned long long)slot;
+    ring->sqArray[index] = index;
+    atomic_store_explicit((atomic_uint*)ring->sqTail, tail + 1, memory_order_release);
+    load->readsIssued++;
+    load->files[read->file].reads++;
+}
+
+// Puts the next chunk of the current file (opening files as needed) in a slot.
+// Returns 1 if a read was prepared, 0 if every file is covered.
+static int nextRead(GarageLoad* load, int slot) {
+    for (;;) {
+        if (load->currentFile >= 0) {
+            LoaderFile* file = &load->files[load->currentFile];
+            if (file->submitted < file->size) {
+                LoaderSlot* read = &load->slots[slot];
+                read->file = load->currentFile;
+                read->offset = file->submitted;
+                read->length = file->size - file->submitted < LOADER_CHUNK_SIZE ? file->size - file->submitted : LOADER_CHUNK_SIZE;
+                read->done = 0;
+                read->error = 0;
+                file->submitted += read->length;
+                prepareSlot(load, slot);
+                return 1;
+            }
+            load->currentFile = -1;
+        }
+        if (load->nextFile >= load->numFiles) {
+            return 0;
+        }
+
+        int index = load->nextFile++;
+        LoaderFile* file = &load->files[index];
+        if (openLoaderFile(file) != 0) {
+            continue;
+        }
+        if (file->size == 0) {
+            finishFile(load, index);
+            continue;
+        }
+        atomic_store(&file->remaining, (int)((file->size + LOADER_CHUNK_SIZE - 1) / LOADER_CHUNK_SIZE));
+        load->currentFile = index;
+    }
+}
+
+static void queueChunk(GarageLoad* load, int slot) {
+    pthread_mutex_lock(&load->lock);
+    load->queue[(load->queueHead + load->queueCount) % LOADER_QUEUE_DEPTH] = slot;
+    load->queueCount++;
+    pthread_cond_signal(&load->chunkReady);
+    pthread_mutex_unlock(&load->lock);
+}
+
+// Called with the lock held and a chunk queued
+static int popChunk(GarageLoad* load) {
+    int slot = load->queue[load->queueHead];
+    load->queueHead = (load->queueHead + 1) % LOADER_QUEUE_DEPTH;
+    load->queueCount--;
+    return slot;
+}
+
+// Copies a completed chunk into its file, frees the buffer and finishes the file after its last chunk
+static void processChunk(GarageLoad* load, int slot) {
+    LoaderSlot* read = &load->slots[slot];
+    int index = read->file;
+    LoaderFile* file = &load->files[index];
+
+    if (read->error) {
+        atomic_store(&file->failed, 1);
+    } else {
+        memcpy(file->data + read->offset, load->buffers + (size_t)slot * LOADER_CHUNK_SIZE, read->length);
+    }
+
+    pthread_mutex_lock(&load->lock);
+    load->freeSlots[load->numFree++] = slot;
+    pthread_cond_signal(&load->slotFreed);
+    pthread_mutex_unlock(&load->lock);
+
+    if (atomic_fetch_sub(&file->remaining, 1) == 1) {
+        finishFile(load, index);
+    }
+}
+
+static void processChunks(GarageLoad* load) {
+    for (;;) {
+        pthread_mutex_lock(&load->lock);
+        while (load->queueCount == 0 && !load->finished) {
+            pthread_cond_wait(&load->chunkReady, &load->lock);
+        }
+        if (load->queueCount == 0) {
+            pthread_mutex_unlock(&load->lock);
+            return;
+        }
+        int slot = popChunk(load);
+        pthread_mutex_unlock(&load->lock);
+        processChunk(load, slot);
+    }
+}
+
+// Every buffer is queued or being copied: copy one here, or wait for a worker to free one
+static void helpWithChunks(GarageLoad* load) {
+    int slot = -1;
+
+    pthread_mutex_lock(&load->lock);
+    if (load->queueCount > 0) {
+        slot = popChunk(load);
+    } else if (load->numFree == 0) {
+        pthread_cond_wait(&load->slotFreed, &load->lock);
+    }
+    pthread_mutex_unlock(&load->lock);
+    if (slot >= 0) {
+        processChunk(load, slot);
+    }
+}
+
+// Copies every queued chunk on the submitting thread when no other thread would
+static void processQueuedChunks(GarageLoad* load) {
+    for (;;) {
+        int slot = -1;
+
+        pthread_mutex_lock(&load->lock);
+        if (load->queueCount > 0) {
+            slot = popChunk(load);
+        }
+        pthread_mutex_unlock(&load->lock);
+        if (slot < 0) {
+            return;
+        }
+        processChunk(load, slot);
+    }
+}
+
+static int takeFreeSlot(GarageLoad* load) {
+    pthread_mutex_lock(&load->lock);
+    int slot = load->numFree > 0 ? load->freeSlots[--load->numFree] : -1;
+    pthread_mutex_unlock(&load->lock);
+    return slot;
+}
+
+// Collects the completed reads: a short read is continued, anything else is queued for copying.
+// With abandon set every completed chunk is queued as failed.
+static void reapCompletions(GarageLoad* load, unsigned int* pending, int* inFlight, int abandon) {
+    LoaderRing* ring = &load->ring;
+    unsigned int head = *ring->cqHead;
+    unsigned int tail = atomic_load_explicit((atomic_uint*)ring->cqTail, memory_order_acquire);
+
+    for (; head != tail; head++) {
+        struct io_uring_cqe* cqe = &ring->cqes[head & ring->cqMask];
+        int slot = (int)cqe->user_data;
+        int result = cqe->res;
+        LoaderSlot* read = &load->slots[slot];
+
+        (*inFlight)--;
+        if (abandon) {
+            read->error = 1;
+        } else if (result == -EINTR || result == -EAGAIN) {
+            result = 0;
+        } else if (result <= 0) {
+            read->error = 1;  // An error, or the file ended early
+        }
+        read->done += result > 0 ? (size_t)result : 0;
+        if (!read->error && read->done < read->length) {
+            prepareSlot(load, slot);
+            (*pending)++;
+            (*inFlight)++;
+        } else {
+            queueChunk(load, slot);
+        }
+    }
+    atomic_store_explicit((atomic_uint*)ring->cqHead, head, memory_order_release);
+}
+
+// After a failed submission: waits out the reads the kernel already has, so that the buffers
+// can be unregistered and freed. Returns 0, or -1 if the ring cannot be waited on.
+static int waitForReads(GarageLoad* load, unsigned int pending, int inFlight) {
+    while (inFlight > (int)pending) {
+        if (syscall(__NR_io_uring_enter, load->ring.fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        reapCompletions(load, &pending, &inFlight, 1);
+    }
+    return 0;
+}
+
+// The submitting thread: keeps every free buffer reading and queues completed chunks
+static void submitReads(GarageLoad* load) {
+    LoaderRing* ring = &load->ring;
+    unsigned int pending = 0;  // Prepared but not yet passed to the kernel
+    int inFlight = 0;
+    int covered = 0;           // Every byte of every file has a read
+
+    for (;;) {
+        while (!covered) {
+            int slot = takeFreeSlot(load);
+            if (slot < 0) {
+                break;
+            }
+            if (!nextRead(load, slot)) {
+                pthread_mutex_lock(&load->lock);
+                load->freeSlots[load->numFree++] = slot;
+                pthread_mutex_unlock(&load->lock);
+                covered = 1;
+                break;
+            }
+            pending++;
+            inFlight++;
+        }
+        if (inFlight == 0) {
+            if (covered) {
+                break;
+            }
+            helpWithChunks(load);
+            continue;
+        }
+
+        int submitted = (int)syscall(__NR_io_uring_enter, ring->fd, pending, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (submitted < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                continue;
+            }
+            printf("Error: io_uring submission failed (%s)\n", strerror(errno));
+            if (waitForReads(load, pending, inFlight) != 0) {
+                // Reads may still land in the buffers, so they are never freed
+                load->buffers = NULL;
+            }
+            break;
+        }
+        pending -= (unsigned int)submitted;
+
+        reapCompletions(load, &pending, &inFlight, 0);
+        if (load->numWorkers == 1) {
+            // Copied while the reads just submitted are still in flight
+            processQueuedChunks(load);
+        }
+    }
+
+    pthread_mutex_lock(&load->lock);
+    load->finished = 1;
+    pthread_cond_broadcast(&load->chunkReady);
+    pthread_mutex_unlock(&load->lock);
+}
+
+static void uringTask(void* context, int begin, int end, int worker) {
+    GarageLoad* load = (GarageLoad*)context;
+    (void)begin;
+    (void)end;
+
+    if (worker == 0) {
+        submitReads(load);
+    }
+    processChunks(load);
+}
+
+// Sets up the ring and registers the buffers. Returns 0, or -1 if io_uring cannot be used.
+static int startUring(GarageLoad* load) {
+    struct iovec buffers[LOADER_QUEUE_DEPTH];
+    void* memory = NULL;
+
+    if (setupRing(&load->ring, LOADER_QUEUE_DEPTH) != 0) {
+        return -1;
+    }
+    if (posix_memalign(&memory, 4096, (size_t)LOADER_QUEUE_DEPTH * LOADER_CHUNK_SIZE) != 0) {
+        closeRing(&load->ring);
+        return -1;
+    }
+    load->buffers = (char*)memory;
+    for (int i = 0; i < LOADER_QUEUE_DEPTH; i++) {
+        buffers[i].iov_base = load->buffers + (size_t)i * LOADER_CHUNK_SIZE;
+        buffers[i].iov_len = LOADER_CHUNK_SIZE;
+        load->freeSlots[i] = LOADER_QUEUE_DEPTH - 1 - i;
+    }
+    // Older kernels charge registered buffers to RLIMIT_MEMLOCK, which may be too small
+    if (syscall(__NR_io_uring_register, load->ring.fd, IORING_REGISTER_BUFFERS, buffers, LOADER_QUEUE_DEPTH) != 0) {
+        closeRing(&load->ring);
+        free(load->buffers);
+        load->buffers = NULL;
+        return -1;
+    }
+    load->numFree = LOADER_QUEUE_DEPTH;
+    load->currentFile = -1;
+    pthread_mutex_init(&load->lock, NULL);
+    pthread_cond_init(&load->chunkReady, NULL);
+    pthread_cond_init(&load->slotFreed, NULL);
+    return 0;
+}
+
+static void stopUring(GarageLoad* load) {
+    if (load->buffers != NULL) {
+        syscall(__NR_io_uring_register, load->ring.fd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+    }
+    closeRing(&load->ring);
+    free(load->buffers);
+    pthread_mutex_destroy(&load->lock);
+    pthread_cond_destroy(&load->chunkReady);
+    pthread_cond_destroy(&load->slotFreed);
+}
+
+#endif
+
+int loadGarageFiles(const char* const* paths, int numFiles, LoaderBackend backend, int numThreads,
+                    LoadedFileHandler handler, void* context, LoaderReport* report) {
+    if (numFiles < 0 || (paths == NULL && numFiles > 0)) {
+        printf("Error: File list is NULL\n");
+        return -1;
+    }
+    if (handler == NULL) {
+        printf("Error: Loaded file handler is NULL\n");
+        return -1;
+    }
+    if (backend != LOADER_AUTO && backend != LOADER_IO_URING && backend != LOADER_PREAD) {
+        printf("Error: Unknown loader backend %d\n", (int)backend);
+        return -1;
+    }
+
+    GarageLoad* load = (GarageLoad*)calloc(1, sizeof(GarageLoad));
+    LoaderFile* files = (LoaderFile*)calloc(numFiles > 0 ? numFiles : 1, sizeof(LoaderFile));
+    int* preadFiles = (int*)malloc((numFiles > 0 ? numFiles : 1) * sizeof(int));
+    if (load == NULL || files == NULL || preadFiles == NULL) {
+        printf("Error: Memory allocation for file loader failed\n");
+        free(load);
+        free(files);
+        free(preadFiles);
+        return -1;
+    }
+    for (int i = 0; i < numFiles; i++) {
+        files[i].path = paths[i];
+        files[i].fd = -1;
+        files[i].result = -1;
+        atomic_init(&files[i].remaining, 0);
+        atomic_init(&files[i].failed, 0);
+    }
+    load->files = files;
+    load->numFiles = numFiles;
+    load->handler = handler;
+    load->context = context;
+    load->preadFiles = preadFiles;
+    load->fallback = backend == LOADER_AUTO;
+    if (numThreads <= 0) {
+        numThreads = defaultThreadCount();
+    }
+
+    LoaderBackend used = LOADER_PREAD;
+    if (backend != LOADER_PREAD) {
+#ifdef LOADER_HAS_IO_URING
+        if (startUring(load) == 0) {
+            used = LOADER_IO_URING;
+        }
+#endif
+        if (used != LOADER_IO_URING && backend == LOADER_IO_URING) {
+            printf("Error: io_uring with registered buffers is not available\n");
+            free(files);
+            free(preadFiles);
+            free(load);
+            return -1;
+        }
+    }
+
+    if (used == LOADER_PREAD) {
+        for (int i = 0; i < numFiles; i++) {
+            preadFiles[load->numPreadFiles++] = i;
+        }
+    }
+#ifdef LOADER_HAS_IO_URING
+    if (used == LOADER_IO_URING) {
+        load->numWorkers = numThreads;
+        parallelFor(numThreads, numThreads, uringTask, load);
+        stopUring(load);
+
+        // Under LOADER_AUTO files whose reads failed or were never submitted go to pread
+        for (int i = 0; load->fallback && i < numFiles; i++) {
+            LoaderFile* file = &files[i];
+            if (!file->retry && file->data == NULL && i < load->nextFile) {
+                continue;
+            }
+            if (file->data != NULL) {
+                free(file->data);
+                close(file->fd);
+                file->data = NULL;
+                file->fd = -1;
+            }
+            file->submitted = 0;
+            file->retry = 0;
+            atomic_store(&file->failed, 0);
+            preadFiles[load->numPreadFiles++] = i;
+        }
+    }
+#endif
+    load->fallback = 0;
+    if (load->numPreadFiles > 0) {
+        parallelFor(load->numPreadFiles, numThreads, preadTask, load);
+    }
+
+    // Files cut short by a failed submission never reached the handler
+    int failed = 0;
+    LoaderReport totals = {used, 0, 0, 0};
+    for (int i = 0; i < numFiles; i++) {
+        if (files[i].data != NULL) {
+            free(files[i].data);
+            close(files[i].fd);
+        }
+        if (files[i].result == 0) {
+            totals.filesLoaded++;
+            totals.bytesRead += (long long)files[i].size;
+        } else {
+            failed = 1;
+        }
+        totals.readsIssued += files[i].reads;
+    }
+    if (report != NULL) {
+        *report = totals;
+    }
+
+    free(files);
+    free(preadFiles);
+    free(load);
+    return failed ? -1 : 0;
+}
+
+#else
+
+int loadGarageFiles(const char* const* paths, int numFiles, LoaderBackend backend, int numThreads,
+                    LoadedFileHandler handler, void* context, LoaderReport* report) {
+    (void)paths; (void)numFiles; (void)backend; (void)numThreads; (void)handler; (void)context; (void)report;
+    printf("Error: The garage file loader is not supported on this platform\n");
+    return -1;
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Garage Loader Header File
+ * Reads many garage files into memory at once, keeping the disk queue deep.
+ *
+ * On Linux the reads go through io_uring: files are read in LOADER_CHUNK_SIZE pieces into a
+ * pool of LOADER_QUEUE_DEPTH registered buffers, with up to LOADER_QUEUE_DEPTH reads in
+ * flight. One thread submits reads and collects completions while the other threads copy
+ * finished chunks into place and hand each complete file to the caller's handler, so
+ * parsing overlaps the reads still in flight. Where io_uring is missing, disabled, or the
+ * buffers cannot be registered, a pool of threads reads with pread instead; under LOADER_AUTO
+ * files whose io_uring reads fail are read again with pread.
+ */
+
+#ifndef GARAGE_LOADER_H
+#define GARAGE_LOADER_H
+
+#include <stddef.h>
+
+#define LOADER_CHUNK_SIZE (128 * 1024)  // Bytes per read
+#define LOADER_QUEUE_DEPTH 32           // Reads in flight, one registered buffer each
+
+typedef enum {
+    LOADER_AUTO,      // io_uring where the kernel allows it, otherwise LOADER_PREAD
+    LOADER_IO_URING,  // io_uring only; fails if it is not available
+    LOADER_PREAD      // Threads reading with pread
+} LoaderBackend;
+
+typedef struct {
+    LoaderBackend backend;  // The backend that ran, never LOADER_AUTO
+    int filesLoaded;        // Files read completely and accepted by the handler
+    long long bytesRead;
+    long long readsIssued;
+} LoaderReport;
+
+/*
+ * Receives one complete file on a worker thread. The handler owns the data and frees it
+ * with free(). Returns 0, or -1 to count the file as failed.
+ */
+typedef int (*LoadedFileHandler)(void* context, int file, char* data, size_t size);
+
+/*
+ * Function: loaderBackendName
+ * Purpose: Printable name of a backend.
+ */
+const char* loaderBackendName(LoaderBackend);
+
+/*
+ * Function: loadGarageFiles
+ * Purpose: Reads every file completely and passes each one to the handler once, in no
+ *          particular order. Files that cannot be opened or read are reported and skipped;
+ *          the others are still loaded.
+ * Parameters: const char* const* - paths of the files
+ *             int - number of files
+ *             LoaderBackend - how to read
+ *             int - number of threads (0 or less means defaultThreadCount); with io_uring one
+ *                   of them submits reads and the rest handle completed chunks
+ *             LoadedFileHandler - called for every complete file
+ *             void* - context passed to the handler
+ *             LoaderReport* - receives what was read (may be NULL)
+ * Returns: 0 if every file was loaded and accepted, -1 otherwise
+ */
+int loadGarageFiles(const char* const*, int, LoaderBackend, int, LoadedFileHandler, void*, LoaderReport*);
+
+#endif /* GARAGE_LOADER_H */
@@ -0,0 +1,318 @@
+/*
+ * Garage Memory
+ * mmap / madvise / mbind backed storage and thread pinning. Linux only; other systems get
+ * plain malloc memory and pinning does nothing.
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE  // sched_setaffinity and the CPU_* macros
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "vehicle.h"
+#include "garage_memory.h"
+
+#ifdef __linux__
+    #include <sched.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <linux/mempolicy.h>
+#endif
+
+#define MAX_NUMA_NODES 64  // Nodes a policy can name; fits one node mask word
+
+typedef struct ArenaRegion {
+    struct ArenaRegion* next;
+    size_t bytes;          // Size of the mapping, this header included
+} ArenaRegion;
+
+struct GarageArena {
+    GarageMemoryPolicy policy;
+    pthread_mutex_t lock;
+    ArenaRegion* regions;  // Most recent first
+    char* next;            // Bump pointer inside the current region
+    char* end;
+    GaragePageMode pagesUsed;
+    VehicleAllocator allocator;  // This arena, for the ...With vehicle functions
+};
+
+static const GarageMemoryPolicy defaultPolicy = {GARAGE_PAGES_DEFAULT, GARAGE_NUMA_DEFAULT, 0};
+
+static size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+#ifdef __linux__
+// Parses a sysfs list such as "0-3,8-11" and calls mark for every number in it
+static int readSysfsList(const char* path, void (*mark)(void*, int), void* context) {
+    char text[1024];
+    FILE* file = fopen(path, "r");
+
+    if (file == NULL) {
+        return -1;
+    }
+    if (fgets(text, sizeof(text), file) == NULL) {
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+
+    // strtok_r: pinning threads parse their lists at the same time
+    char* save = NULL;
+    for (char* range = strtok_r(text, ",\n", &save); range != NULL; range = strtok_r(NULL, ",\n", &save)) {
+        int first;
+        int last;
+        int fields = sscanf(range, "%d-%d", &first, &last);
+        if (fields < 1) {
+            continue;
+        }
+        if (fields == 1) {
+            last = first;
+        }
+        for (int i = first; i <= last; i++) {
+            mark(context, i);
+        }
+    }
+    return 0;
+}
+
+static void trackHighest(void* context, int number) {
+    int* highest = (int*)context;
+    if (number > *highest) {
+        *highest = number;
+    }
+}
+
+static void addCpu(void* context, int cpu) {
+    if (cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, (cpu_set_t*)context);
+    }
+}
+
+// Applies the NUMA part of a policy to a fresh mapping; failure just leaves first touch placement
+static void applyNumaPolicy(void* memory, size_t bytes, const GarageMemoryPolicy* policy) {
+    unsigned long nodeMask = 0;
+    int mode;
+
+    if (policy->numa == GARAGE_NUMA_BIND) {
+        if (policy->node < 0 || policy->node >= MAX_NUMA_NODES) {
+            return;
+        }
+        nodeMask = 1ul << policy->node;
+        mode = MPOL_BIND;
+    } else if (policy->numa == GARAGE_NUMA_INTERLEAVE) {
+        int nodes = numaNodeCount();
+        for (int i = 0; i < nodes && i < MAX_NUMA_NODES; i++) {
+            nodeMask |= 1ul << i;
+        }
+        mode = MPOL_INTERLEAVE;
+    } else {
+        return;
+    }
+
+    // Raw system call so there is no libnuma dependency
+    syscall(SYS_mbind, memory, bytes, mode, &nodeMask, (unsigned long)MAX_NUMA_NODES + 1, 0u);
+}
+#endif
+
+int numaNodeCount() {
+#ifdef __linux__
+    int highest = 0;
+    if (readSysfsList("/sys/devices/system/node/online", trackHighest, &highest) == 0) {
+        return highest + 1;
+    }
+#endif
+    return 1;
+}
+
+void* allocateGarageMemory(size_t bytes, const GarageMemoryPolicy* policy, GaragePageMode* pagesUsed) {
+    if (policy == NULL) {
+        policy = &defaultPolicy;
+    }
+    if (pagesUsed != NULL) {
+        *pagesUsed = GARAGE_PAGES_DEFAULT;
+    }
+
+#ifdef __linux__
+    void* memory = MAP_FAILED;
+    GaragePageMode obtained = GARAGE_PAGES_DEFAULT;
+
+    // Whole huge pages whatever the mode, so freeGarageMemory can always unmap the same length
+    bytes = roundUp(bytes, GARAGE_HUGE_PAGE_SIZE);
+
+    if (policy->pages == GARAGE_PAGES_EXPLICIT) {
+        // Only succeeds when huge pages have been reserved (vm.nr_hugepages)
+        memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        obtained = GARAGE_PAGES_EXPLICIT;
+    }
+    if (memory == MAP_FAILED) {
+        memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        obtained = GARAGE_PAGES_DEFAULT;
+        if (memory == MAP_FAILED) {
+            printf("Error: Mapping %zu bytes of garage memory failed\n", bytes);
+            return NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        if (policy->pages != GARAGE_PAGES_DEFAULT && madvise(memory, bytes, MADV_HUGEPAGE) == 0) {
+            obtained = GARAGE_PAGES_TRANSPARENT;
+        }
+#endif
+    }
+
+    // Placement is decided at first touch, so the policy goes on before anything is written
+    applyNumaPolicy(memory, bytes, policy);
+
+    if (pagesUsed != NULL) {
+        *pagesUsed = obtained;
+    }
+    return memory;
+#else
+    void* memory = malloc(bytes);
+    if (memory == NULL) {
+        printf("Error: Memory allocation for garage memory failed\n");
+    }
+    return memory;
+#endif
+}
+
+void freeGarageMemory(void* memory, size_t bytes) {
+    if (memory == NULL) {
+        return;
+    }
+#ifdef __linux__
+    munmap(memory, roundUp(bytes, GARAGE_HUGE_PAGE_SIZE));
+#else
+    (void)bytes;
+    free(memory);
+#endif
+}
+
+char** createGarageArray(int capacity, const GarageMemoryPolicy* policy) {
+    if (capacity <= 0) {
+        printf("Error: Number of vehicles must be positive\n");
+        return NULL;
+    }
+    return (char**)allocateGarageMemory((size_t)capacity * sizeof(char*), policy, NULL);
+}
+
+void freeGarageArray(char** garage, int capacity) {
+    freeGarageMemory(garage, (size_t)capacity * sizeof(char*));
+}
+
+static char* allocateFromArena(void* context, size_t size) {
+    return garageArenaAllocate((GarageArena*)context, size);
+}
+
+static void releaseToArena(void* context, char* vehicle, size_t size) {
+    // Records go back all at once when the arena is destroyed
+    (void)context;
+    (void)vehicle;
+    (void)size;
+}
+
+GarageArena* createGarageArena(const GarageMemoryPolicy* policy) {
+    GarageArena* arena = (GarageArena*)calloc(1, sizeof(GarageArena));
+    if (arena == NULL) {
+        printf("Error: Memory allocation for garage arena failed\n");
+        return NULL;
+    }
+
+    arena->policy = policy != NULL ? *policy : defaultPolicy;
+    arena->allocator.allocate = allocateFromArena;
+    arena->allocator.release = releaseToArena;
+    arena->allocator.context = arena;
+    pthread_mutex_init(&arena->lock, NULL);
+    return arena;
+}
+
+void destroyGarageArena(GarageArena* arena) {
+    if (arena == NULL) {
+        return;
+    }
+
+    ArenaRegion* region = arena->regions;
+    while (region != NULL) {
+        ArenaRegion* next = region->next;
+        freeGarageMemory(region, region->bytes);
+        region = next;
+    }
+    pthread_mutex_destroy(&arena->lock);
+    free(arena);
+}
+
+char* garageArenaAllocate(GarageArena* arena, size_t size) {
+    size = roundUp(size, 8);
+
+    pthread_mutex_lock(&arena->lock);
+    if (arena->next == NULL || (size_t)(arena->end - arena->next) < size) {
+        size_t bytes = roundUp(sizeof(ArenaRegion), 8) + size;
+        bytes = bytes < GARAGE_ARENA_REGION_SIZE ? GARAGE_ARENA_REGION_SIZE : bytes;
+
+        ArenaRegion* region = (ArenaRegion*)allocateGarageMemory(bytes, &arena->policy, &arena->pagesUsed);
+        if (region == NULL) {
+            pthread_mutex_unlock(&arena->lock);
+            return NULL;
+        }
+        region->next = arena->regions;
+        region->bytes = bytes;
+        arena->regions = region;
+        arena->next = (char*)region + roundUp(sizeof(ArenaRegion), 8);
+        arena->end = (char*)region + bytes;
+    }
+
+    char* record = arena->next;
+    arena->next += size;
+    pthread_mutex_unlock(&arena->lock);
+    return record;
+}
+
+const VehicleAllocator* garageArenaAllocator(GarageArena* arena) {
+    return arena != NULL ? &arena->allocator : NULL;
+}
+
+GaragePageMode garageMemoryPagesUsed(const GarageArena* arena) {
+    return arena->pagesUsed;
+}
+
+#ifdef __linux__
+static _Thread_local cpu_set_t savedAffinity;
+static _Thread_local int pinned = 0;
+#endif
+
+int pinThreadToNode(int node) {
+#ifdef __linux__
+    char path[64];
+    cpu_set_t cpus;
+
+    CPU_ZERO(&cpus);
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    if (readSysfsList(path, addCpu, &cpus) != 0 || CPU_COUNT(&cpus) == 0) {
+        return -1;
+    }
+
+    if (!pinned && sched_getaffinity(0, sizeof(cpu_set_t), &savedAffinity) != 0) {
+        return -1;
+    }
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &cpus) != 0) {
+        return -1;
+    }
+    pinned = 1;
+    return 0;
+#else
+    (void)node;
+    return -1;
+#endif
+}
+
+void unpinThread() {
+#ifdef __linux__
+    if (pinned) {
+        sched_setaffinity(0, sizeof(cpu_set_t), &savedAffinity);
+        pinned = 0;
+    }
+#endif
+}
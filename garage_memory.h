@@ -0,0 +1,105 @@
+/*
+ * Garage Memory Header File
+ * Huge page and NUMA aware backing for very large garages.
+ *
+ * A GarageMemoryPolicy says how memory is mapped: which page size to ask for and on which
+ * NUMA node(s) to place it. The policy is applied to the garage's pointer array
+ * (createGarageArray) and to record storage (a GarageArena passed as the vehicle
+ * allocator). On systems without huge pages or NUMA the calls fall back to ordinary
+ * memory, and garageMemoryPagesUsed reports what was actually obtained.
+ */
+
+#ifndef GARAGE_MEMORY_H
+#define GARAGE_MEMORY_H
+
+#include <stddef.h>
+#include "vehicle.h"
+
+#define GARAGE_HUGE_PAGE_SIZE (2u * 1024 * 1024)        // x86-64 / arm64 default huge page
+#define GARAGE_ARENA_REGION_SIZE (64u * 1024 * 1024)    // Bytes an arena maps at a time
+
+typedef enum {
+    GARAGE_PAGES_DEFAULT,      // Normal pages
+    GARAGE_PAGES_TRANSPARENT,  // Ask the kernel to back the mapping with transparent huge pages
+    GARAGE_PAGES_EXPLICIT      // Reserved huge pages (MAP_HUGETLB); falls back to transparent
+} GaragePageMode;
+
+typedef enum {
+    GARAGE_NUMA_DEFAULT,       // Wherever the kernel decides (first touch)
+    GARAGE_NUMA_BIND,          // All pages on one node
+    GARAGE_NUMA_INTERLEAVE     // Pages spread round robin over every node
+} GarageNumaMode;
+
+typedef struct {
+    GaragePageMode pages;
+    GarageNumaMode numa;
+    int node;                  // Node for GARAGE_NUMA_BIND
+} GarageMemoryPolicy;
+
+typedef struct GarageArena GarageArena;
+
+/*
+ * Function: numaNodeCount
+ * Purpose: Number of NUMA nodes online (1 when NUMA is not available).
+ */
+int numaNodeCount();
+
+/*
+ * Functions: allocateGarageMemory, freeGarageMemory
+ * Purpose: Map / unmap a block of memory following a policy. Mappings are rounded up to
+ *          whole huge pages, so this is meant for large blocks.
+ * Parameters: size_t - number of bytes
+ *             const GarageMemoryPolicy* - policy, NULL for the default
+ *             GaragePageMode* - receives the page mode actually obtained (may be NULL)
+ * Returns: the memory, or NULL if it could not be mapped
+ */
+void* allocateGarageMemory(size_t, const GarageMemoryPolicy*, GaragePageMode*);
+void freeGarageMemory(void*, size_t);
+
+/*
+ * Functions: createGarageArray, freeGarageArray
+ * Purpose: Pointer array for a garage of fixed capacity, mapped following a policy.
+ *          The array cannot be resized, so it must not be passed to addVehicle, removeVehicle
+ *          or freeGarage; free the vehicles and then call freeGarageArray.
+ */
+char** createGarageArray(int, const GarageMemoryPolicy*);
+void freeGarageArray(char**, int);
+
+/*
+ * Functions: createGarageArena, destroyGarageArena
+ * Purpose: Record storage that carves vehicles out of policy mapped regions.
+ *          Destroying the arena releases every record it handed out.
+ */
+GarageArena* createGarageArena(const GarageMemoryPolicy*);
+void destroyGarageArena(GarageArena*);
+
+/*
+ * Function: garageArenaAllocate
+ * Purpose: Bump allocation of size bytes, 8-byte aligned. Thread safe.
+ * Returns: the memory, or NULL if a new region could not be mapped
+ */
+char* garageArenaAllocate(GarageArena*, size_t);
+
+/*
+ * Function: garageArenaAllocator
+ * Purpose: The arena as a vehicle allocator, for buildVehicleWith and the other ...With
+ *          functions. Freeing its records does nothing; the space returns with the arena.
+ * Returns: the allocator, valid until the arena is destroyed (NULL for a NULL arena)
+ */
+const VehicleAllocator* garageArenaAllocator(GarageArena*);
+
+/*
+ * Function: garageMemoryPagesUsed
+ * Purpose: Page mode the arena actually obtained for its most recent region.
+ */
+GaragePageMode garageMemoryPagesUsed(const GarageArena*);
+
+/*
+ * Functions: pinThreadToNode, unpinThread
+ * Purpose: Restrict the calling thread to the CPUs of one NUMA node, and undo it.
+ * Returns: pinThreadToNode - 0 on success, -1 if the node has no CPUs or pinning failed
+ */
+int pinThreadToNode(int);
+void unpinThread();
+
+#endif /* GARAGE_MEMORY_H */
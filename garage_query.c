@@ -0,0 +1,174 @@
+/*
+ * Garage Query
+ * Header-first evaluation of composite vehicle filters.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "vehicle.h"
+#include "garage_query.h"
+#include "garage_scan.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define QUERY_USE_SSE2 1
+#endif
+
+// A query translated to compares on the raw header word
+typedef struct {
+    unsigned int lowHeader;   // Smallest header with a value in range
+    unsigned int highHeader;  // Largest header with a value in range
+    unsigned int minYear;
+    unsigned int yearSpan;    // maxYear - minYear; (year - minYear) <= yearSpan covers both bounds
+    int empty;                // The ranges cannot match anything
+} HeaderFilter;
+
+void initVehicleQuery(VehicleQuery* query) {
+    query->minYear = MIN_MODEL_YEAR;
+    query->maxYear = MAX_MODEL_YEAR;
+    query->minValue = 0;
+    query->maxValue = MAX_VEHICLE_VALUE;
+    query->descriptionPrefix = NULL;
+}
+
+static HeaderFilter makeFilter(const VehicleQuery* query) {
+    HeaderFilter filter;
+    unsigned int maxValue = query->maxValue > MAX_VEHICLE_VALUE ? MAX_VEHICLE_VALUE : query->maxValue;
+    unsigned int minYear = query->minYear;
+#if VEHICLE_YEAR_BASE > 0
+    if (minYear < MIN_MODEL_YEAR) {
+        minYear = MIN_MODEL_YEAR;
+    }
+#endif
+    unsigned int maxYear = query->maxYear > MAX_MODEL_YEAR ? MAX_MODEL_YEAR : query->maxYear;
+
+    filter.empty = query->minValue > maxValue || minYear > maxYear;
+    filter.lowHeader = packHeader(query->minValue, MIN_MODEL_YEAR);
+    filter.highHeader = packHeader(maxValue, MAX_MODEL_YEAR);
+    // Compared against the raw year bits, which are stored relative to MIN_MODEL_YEAR
+    filter.minYear = minYear - MIN_MODEL_YEAR;
+    filter.yearSpan = maxYear - minYear;
+    return filter;
+}
+
+/*
+ * Filters count headers and appends base + i for each match to selection.
+ * Returns the number of matches appended.
+ */
+static int filterHeaders(const unsigned int* headers, int count, int base, const HeaderFilter* filter,
+                         int* selection) {
+    int matches = 0;
+    int i = 0;
+
+#ifdef QUERY_USE_SSE2
+    // SSE2 only has signed compares, so flip the sign bit to compare unsigned values
+    const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+    const __m128i low = _mm_set1_epi32((int)(filter->lowHeader ^ 0x80000000u));
+    const __m128i high = _mm_set1_epi32((int)(filter->highHeader ^ 0x80000000u));
+    const __m128i yearMask = _mm_set1_epi32(YEAR_MASK);
+    const __m128i minYear = _mm_set1_epi32((int)filter->minYear);
+    const __m128i yearSpan = _mm_set1_epi32((int)(filter->yearSpan ^ 0x80000000u));
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i header = _mm_loadu_si128((const __m128i*)(headers + i));
+        __m128i flipped = _mm_xor_si128(header, sign);
+        __m128i yearOffset = _mm_xor_si128(_mm_sub_epi32(_mm_and_si128(header, yearMask), minYear), sign);
+
+        __m128i rejected = _mm_or_si128(_mm_cmpgt_epi32(low, flipped), _mm_cmpgt_epi32(flipped, high));
+        rejected = _mm_or_si128(rejected, _mm_cmpgt_epi32(yearOffset, yearSpan));
+
+        int accepted = ~_mm_movemask_ps(_mm_castsi128_ps(rejected)) & 0xF;
+        while (accepted != 0) {
+            int lane = 0;
+            while (!(accepted & (1 << lane))) {
+                lane++;
+            }
+            selection[matches++] = base + i + lane;
+            accepted &= accepted - 1;
+        }
+    }
+#endif
+
+    // Branch-free scalar loop for the remainder (or everything without SSE2)
+    for (; i < count; i++) {
+        unsigned int header = headers[i];
+        int accepted = (header >= filter->lowHeader) & (header <= filter->highHeader) &
+                       (((header & YEAR_MASK) - filter->minYear) <= filter->yearSpan);
+        selection[matches] = base + i;
+        matches += accepted;
+    }
+
+    return matches;
+}
+
+int queryHeaders(const unsigned int* headers, int numHeaders, const VehicleQuery* query, int* selection) {
+    if (headers == NULL || query == NULL || selection == NULL) {
+        printf("Error: Invalid arguments for query\n");
+        return -1;
+    }
+
+    HeaderFilter filter = makeFilter(query);
+    if (filter.empty) {
+        return 0;
+    }
+
+    return filterHeaders(headers, numHeaders, 0, &filter, selection);
+}
+
+typedef struct {
+    unsigned int* headers;
+    int* positions;
+    int count;
+    int base;  // Garage position of the first slot of the batch
+} HeaderGather;
+
+static int gatherSlot(void* context, char* vehicle, int position) {
+    HeaderGather* gather = (HeaderGather*)context;
+
+    if (vehicle != NULL) {
+        gather->headers[gather->count] = vehicleHeader(vehicle);
+        gather->positions[gather->count] = gather->base + position;
+        gather->count++;
+    }
+    return 0;
+}
+
+int queryGarage(char** garage, int numVehicles, const VehicleQuery* query, int* selection) {
+    if (garage == NULL || query == NULL || selection == NULL) {
+        printf("Error: Invalid arguments for query\n");
+        return -1;
+    }
+
+    HeaderFilter filter = makeFilter(query);
+    if (filter.empty) {
+        return 0;
+    }
+
+    const char* prefix = query->descriptionPrefix;
+    size_t prefixLength = prefix == NULL ? 0 : strlen(prefix);
+    unsigned int headers[QUERY_BATCH_SIZE];
+    int positions[QUERY_BATCH_SIZE];
+    int candidates[QUERY_BATCH_SIZE];
+    int total = 0;
+
+    for (int start = 0; start < numVehicles; start += QUERY_BATCH_SIZE) {
+        int end = start + QUERY_BATCH_SIZE < numVehicles ? start + QUERY_BATCH_SIZE : numVehicles;
+        // Gather the headers of this batch into a dense column
+        HeaderGather gather = {headers, positions, 0, start};
+        forEachVehicle(garage + start, end - start, gatherSlot, &gather);
+        int batch = gather.count;
+
+        int survivors = filterHeaders(headers, batch, 0, &filter, candidates);
+
+        // Only the survivors have their description read
+        for (int j = 0; j < survivors; j++) {
+            int position = positions[candidates[j]];
+            if (prefixLength == 0 ||
+                strncmp(vehicleDescription(garage[position]), prefix, prefixLength) == 0) {
+                selection[total++] = position;
+            }
+        }
+    }
+
+    return total;
+}
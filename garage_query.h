@@ -0,0 +1,54 @@
+/*
+ * Garage Query Header File
+ * Composite filters over year range, value range and description prefix.
+ *
+ * Numeric predicates are evaluated first, directly on the packed headers and without
+ * unpacking: a value range is a range of header words because the value sits in the
+ * upper bits, and a year range is one masked compare. Headers are processed in batches
+ * (4 at a time with SSE2 when available). Descriptions are read only for survivors.
+ */
+
+#ifndef GARAGE_QUERY_H
+#define GARAGE_QUERY_H
+
+#define QUERY_BATCH_SIZE 256  // Headers decoded and filtered together
+
+typedef struct {
+    unsigned int minYear;           // Inclusive
+    unsigned int maxYear;           // Inclusive
+    unsigned int minValue;          // Inclusive
+    unsigned int maxValue;          // Inclusive
+    const char* descriptionPrefix;  // NULL or "" matches every description
+} VehicleQuery;
+
+/*
+ * Function: initVehicleQuery
+ * Purpose: Sets a query to match every vehicle. Callers then narrow the fields they need.
+ */
+void initVehicleQuery(VehicleQuery*);
+
+/*
+ * Function: queryGarage
+ * Purpose: Evaluates a query over a garage. NULL slots never match.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ *             const VehicleQuery* - the filter
+ *             int* - selection vector, receives matching positions in increasing order
+ *                    (must have room for every vehicle in the garage)
+ * Returns: number of matching vehicles, or -1 on error
+ */
+int queryGarage(char**, int, const VehicleQuery*, int*);
+
+/*
+ * Function: queryHeaders
+ * Purpose: Evaluates the numeric part of a query over a dense column of packed headers.
+ *          The description prefix is ignored.
+ * Parameters: const unsigned int* - packed headers
+ *             int - number of headers
+ *             const VehicleQuery* - the filter
+ *             int* - selection vector, receives matching positions in increasing order
+ * Returns: number of matching headers, or -1 on error
+ */
+int queryHeaders(const unsigned int*, int, const VehicleQuery*, int*);
+
+#endif /* GARAGE_QUERY_H */
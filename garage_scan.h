@@ -0,0 +1,90 @@
+/*
+ * Garage Scan Header File
+ * Prefetching iteration over a char** garage.
+ *
+ * Every slot of a garage points to a separately allocated record, so a plain loop waits on
+ * one cache miss per vehicle. scanGarage prefetches the record prefetchDistance slots ahead
+ * and visits the slots in batches of GARAGE_SCAN_BATCH, keeping several misses in flight
+ * while the visitor works. It is inline so a visitor defined next to the call can be
+ * inlined into the loop as well.
+ */
+
+#ifndef GARAGE_SCAN_H
+#define GARAGE_SCAN_H
+
+#define GARAGE_PREFETCH_DISTANCE 16  // Default number of slots prefetched ahead
+#define GARAGE_SCAN_BATCH 8          // Slots prefetched together and then visited together
+
+#define GARAGE_SCAN_FORWARD 0        // Slot 0 first
+#define GARAGE_SCAN_REVERSE 1        // Last slot first, used when visitors remove vehicles
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define PREFETCH_VEHICLE(vehicle) __builtin_prefetch((vehicle), 0, 3)
+#elif defined(_MSC_VER)
+    #include <xmmintrin.h>
+    #define PREFETCH_VEHICLE(vehicle) _mm_prefetch((const char*)(vehicle), _MM_HINT_T0)
+#else
+    #define PREFETCH_VEHICLE(vehicle) ((void)(vehicle))
+#endif
+
+/*
+ * Called once per slot, NULL slots included.
+ * Returns 0 to continue, anything else stops the scan and is returned by scanGarage.
+ */
+typedef int (*VehicleVisitor)(void* context, char* vehicle, int position);
+
+/*
+ * Function: scanGarage
+ * Purpose: Visits every slot of the garage with software prefetching.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ *             int - GARAGE_SCAN_FORWARD or GARAGE_SCAN_REVERSE
+ *             int - prefetch distance in slots (0 turns prefetching off)
+ *             VehicleVisitor - called for each slot
+ *             void* - context passed to the visitor
+ * Returns: 0 if every slot was visited, otherwise the value that stopped the scan
+ */
+static inline int scanGarage(char** garage, int numVehicles, int direction, int prefetchDistance,
+                             VehicleVisitor visitor, void* context) {
+    int last = numVehicles - 1;
+
+    if (prefetchDistance < 0) {
+        prefetchDistance = 0;
+    }
+
+    // Slots [0, prefetchDistance) are requested before the first visit
+    for (int j = 0; j < prefetchDistance && j < numVehicles; j++) {
+        PREFETCH_VEHICLE(garage[direction == GARAGE_SCAN_REVERSE ? last - j : j]);
+    }
+
+    for (int done = 0; done < numVehicles; done += GARAGE_SCAN_BATCH) {
+        int batchEnd = done + GARAGE_SCAN_BATCH < numVehicles ? done + GARAGE_SCAN_BATCH : numVehicles;
+
+        // Request the batch that is prefetchDistance slots ahead. Prefetching NULL is harmless.
+        if (prefetchDistance > 0) {
+            int aheadEnd = batchEnd + prefetchDistance < numVehicles ? batchEnd + prefetchDistance : numVehicles;
+            for (int j = done + prefetchDistance; j < aheadEnd; j++) {
+                PREFETCH_VEHICLE(garage[direction == GARAGE_SCAN_REVERSE ? last - j : j]);
+            }
+        }
+
+        for (int j = done; j < batchEnd; j++) {
+            int slot = direction == GARAGE_SCAN_REVERSE ? last - j : j;
+            int result = visitor(context, garage[slot], slot);
+            if (result != 0) {
+                return result;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Function: forEachVehicle
+ * Purpose: scanGarage front to back with the default prefetch distance.
+ */
+static inline int forEachVehicle(char** garage, int numVehicles, VehicleVisitor visitor, void* context) {
+    return scanGarage(garage, numVehicles, GARAGE_SCAN_FORWARD, GARAGE_PREFETCH_DISTANCE, visitor, context);
+}
+
+#endif /* GARAGE_SCAN_H */
@@ -0,0 +1,731 @@
+/*
+ * Garage Segment
+ * Year partitioned segment files: the writer, footer-only catalogs and parallel loading.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vehicle.h"
+#include "byte_io.h"
+#include "hash.h"
+#include "parallel.h"
+#include "garage_loader.h"
+#include "garage_segment.h"
+
+#ifndef _WIN32
+    #include <dirent.h>
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#define SEGMENT_CHECKSUM_SEED 0x5345474D454E54ull  // Seed of the checksum over the segment body
+#define SEGMENT_NAME_LENGTH 48                      // "garage-<first>-<last>.gseg" and a temporary suffix
+
+/*
+ * Footer layout, little endian:
+ *   0 "GSEG"          4 version         8 valueBits      12 yearBase
+ *  16 numVehicles    20 firstYear      24 lastYear       28 minYear
+ *  32 maxYear        36 minValue       40 maxValue       44 reserved (0)
+ *  48 u64 recordsBytes                 56 u64 offsetsOffset
+ *  64 u64 checksum of bytes [0, footer) 72 footer size    76 "GEND"
+ * The records start at offset 0; the u32 record offsets follow them.
+ */
+
+struct SegmentCatalog {
+    SegmentInfo* segments;
+    int numSegments;
+};
+
+typedef struct {
+    char* base;   // Whole file, read or mapped
+    size_t size;
+    int mapped;
+} LoadedSegment;
+
+struct SegmentGarage {
+    LoadedSegment* segments;
+    int numSegments;
+    char** vehicles;
+    int numVehicles;
+};
+
+#ifndef _WIN32
+
+static int isSegmentName(const char* name) {
+    size_t length = strlen(name);
+    size_t suffix = strlen(SEGMENT_FILE_SUFFIX);
+    return length > suffix && strcmp(name + length - suffix, SEGMENT_FILE_SUFFIX) == 0;
+}
+
+// "<directory>/<name>" in a new string
+static char* joinPath(const char* directory, const char* name) {
+    size_t length = strlen(directory) + strlen(name) + 2;
+    char* path = (char*)malloc(length);
+    if (path == NULL) {
+        printf("Error: Memory allocation for segment path failed\n");
+        return NULL;
+    }
+    snprintf(path, length, "%s/%s", directory, name);
+    return path;
+}
+
+// Decodes and checks a footer against the size of its file. Returns 0, or -1 if it is not usable.
+static int decodeFooter(const unsigned char* footer, long long fileSize, SegmentInfo* info,
+                        unsigned long long* recordsBytes, unsigned long long* checksum) {
+    if (memcmp(footer, "GSEG", 4) != 0 || memcmp(footer + 76, "GEND", 4) != 0 ||
+        getU32(footer + 4) != SEGMENT_FILE_VERSION || getU32(footer + 8) != VEHICLE_VALUE_BITS ||
+        getU32(footer + 12) != VEHICLE_YEAR_BASE || getU32(footer + 72) != SEGMENT_FOOTER_SIZE) {
+        return -1;
+    }
+
+    unsigned int count = getU32(footer + 16);
+    info->numVehicles = (int)count;
+    info->firstYear = getU32(footer + 20);
+    info->lastYear = getU32(footer + 24);
+    info->minYear = getU32(footer + 28);
+    info->maxYear = getU32(footer + 32);
+    info->minValue = getU32(footer + 36);
+    info->maxValue = getU32(footer + 40);
+    info->fileSize = fileSize;
+    *recordsBytes = getU64(footer + 48);
+    *checksum = getU64(footer + 64);
+
+    unsigned long long offsetsOffset = getU64(footer + 56);
+    int valid = count <= 0x7FFFFFFFu && info->firstYear <= info->lastYear &&
+                *recordsBytes % 4 == 0 && offsetsOffset == *recordsBytes &&
+                offsetsOffset + 4ull * count + SEGMENT_FOOTER_SIZE == (unsigned long long)fileSize;
+    if (valid && count > 0) {
+        valid = info->firstYear <= info->minYear && info->minYear <= info->maxYear &&
+                info->maxYear <= info->lastYear && info->minValue <= info->maxValue &&
+                info->maxValue <= MAX_VEHICLE_VALUE && *recordsBytes >= 8ull * count;  // 8 bytes per record at least
+    }
+    return valid ? 0 : -1;
+}
+
+typedef struct {
+    const char* directory;
+    char** garage;
+    const int* order;          // Garage positions grouped by partition
+    const int* partitionStart; // First entry of each written partition in order
+    const int* partitions;     // Partition number of each written segment
+    int yearsPerSegment;
+    int* results;              // 0 or -1 for each segment
+} SegmentWriteJob;
+
+static void segmentName(char* name, unsigned int firstYear, unsigned int lastYear, const char* extra) {
+    snprintf(name, SEGMENT_NAME_LENGTH, "garage-%u-%u%s%s", firstYear, lastYear, SEGMENT_FILE_SUFFIX, extra);
+}
+
+static void partitionYears(int partition, int yearsPerSegment, unsigned int* firstYear, unsigned int* lastYear) {
+    unsigned int first = MIN_MODEL_YEAR + (unsigned int)partition * (unsigned int)yearsPerSegment;
+    unsigned int last = first + (unsigned int)yearsPerSegment - 1;
+    *firstYear = first;
+    *lastYear = last > MAX_MODEL_YEAR ? MAX_MODEL_YEAR : last;
+}
+
+// Builds one segment file in memory and writes it under a temporary name, then renames it
+static int writeSegment(SegmentWriteJob* job, int segment) {
+    char name[SEGMENT_NAME_LENGTH];
+    char temporary[SEGMENT_NAME_LENGTH];
+    unsigned int firstYear;
+    unsigned int lastYear;
+    int begin = job->partitionStart[segment];
+    int count = job->partitionStart[segment + 1] - begin;
+
+    partitionYears(job->partitions[segment], job->yearsPerSegment, &firstYear, &lastYear);
+    segmentName(name, firstYear, lastYear, "");
+    segmentName(temporary, firstYear, lastYear, ".tmp");
+
+    size_t recordsBytes = 0;
+    for (int i = 0; i < count; i++) {
+        recordsBytes += alignUp(4 + vehicleDescriptionLength(job->garage[job->order[begin + i]]) + 1, 4);
+    }
+    if (recordsBytes > 0xFFFFFFFFu) {
+        printf("Error: Segment %s would exceed 4 GB of records\n", name);
+        return -1;
+    }
+    size_t size = recordsBytes + (size_t)count * 4 + SEGMENT_FOOTER_SIZE;
+    char* file = (char*)calloc(size, 1);  // Padding after each description stays zero
+    if (file == NULL) {
+        printf("Error: Memory allocation for segment %s failed\n", name);
+        return -1;
+    }
+
+    // Records in format v1, then their offsets
+    unsigned char* offsets = (unsigned char*)file + recordsBytes;
+    unsigned int minYear = MAX_MODEL_YEAR, maxYear = MIN_MODEL_YEAR;
+    unsigned int minValue = MAX_VEHICLE_VALUE, maxValue = 0;
+    size_t offset = 0;
+    for (int i = 0; i < count; i++) {
+        const char* vehicle = job->garage[job->order[begin + i]];
+        unsigned int header = vehicleHeader(vehicle);
+        unsigned int length = vehicleDescriptionLength(vehicle);
+        putU32(offsets + 4 * (size_t)i, (unsigned int)offset);
+        offset += alignUp(encodeVehicleRecord(file + offset, header, vehicleDescription(vehicle), length), 4);
+
+        unsigned int year = headerYear(header);
+        unsigned int value = headerValue(header);
+        minYear = year < minYear ? year : minYear;
+        maxYear = year > maxYear ? year : maxYear;
+        minValue = value < minValue ? value : minValue;
+        maxValue = value > maxValue ? value : maxValue;
+    }
+
+    unsigned char* footer = (unsigned char*)file + size - SEGMENT_FOOTER_SIZE;
+    memcpy(footer, "GSEG", 4);
+    putU32(footer + 4, SEGMENT_FILE_VERSION);
+    putU32(footer + 8, VEHICLE_VALUE_BITS);
+    putU32(footer + 12, VEHICLE_YEAR_BASE);
+    putU32(footer + 16, (unsigned int)count);
+    putU32(footer + 20, firstYear);
+    putU32(footer + 24, lastYear);
+    putU32(footer + 28, minYear);
+    putU32(footer + 32, maxYear);
+    putU32(footer + 36, minValue);
+    putU32(footer + 40, maxValue);
+    putU64(footer + 48, recordsBytes);
+    putU64(footer + 56, recordsBytes);
+    putU64(footer + 64, hashBytes(file, size - SEGMENT_FOOTER_SIZE, SEGMENT_CHECKSUM_SEED));
+    putU32(footer + 72, SEGMENT_FOOTER_SIZE);
+    memcpy(footer + 76, "GEND", 4);
+
+    char* temporaryPath = joinPath(job->directory, temporary);
+    char* path = joinPath(job->directory, name);
+    int fd = temporaryPath != NULL && path != NULL ? open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+    int result = fd >= 0 && writeAll(fd, file, size) == 0 && fsync(fd) == 0 ? 0 : -1;
+    if (fd >= 0 && close(fd) != 0) {
+        result = -1;
+    }
+    if (result == 0 && rename(temporaryPath, path) != 0) {
+        result = -1;
+    }
+    if (result != 0) {
+        printf("Error: Cannot write segment file %s in %s\n", name, job->directory);
+        if (temporaryPath != NULL) {
+            unlink(temporaryPath);
+        }
+    }
+    free(temporaryPath);
+    free(path);
+    free(file);
+    return result;
+}
+
+static void writeSegmentTask(void* context, int begin, int end, int worker) {
+    SegmentWriteJob* job = (SegmentWriteJob*)context;
+    (void)worker;
+
+    for (int segment = begin; segment < end; segment++) {
+        job->results[segment] = writeSegment(job, segment);
+    }
+}
+
+// Deletes the segment files of a directory that are not in the keep list
+static int removeSegmentsExcept(const char* directory, char (*keep)[SEGMENT_NAME_LENGTH], int numKeep) {
+    DIR* dir = opendir(directory);
+    struct dirent* entry;
+    int removed = 0;
+
+    if (dir == NULL) {
+        printf("Error: Cannot read segment directory %s\n", directory);
+        return -1;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+        int kept = 0;
+        if (!isSegmentName(entry->d_name)) {
+            continue;
+        }
+        for (int i = 0; i < numKeep && !kept; i++) {
+            kept = strcmp(keep[i], entry->d_name) == 0;
+        }
+        char* path = kept ? NULL : joinPath(directory, entry->d_name);
+        if (path != NULL && unlink(path) == 0) {
+            removed++;
+        }
+        free(path);
+    }
+    closedir(dir);
+    return removed;
+}
+
+int writeGarageSegments(const char* directory, char** garage, int numVehicles, int yearsPerSegment, int numThreads) {
+    if (directory == NULL || directory[0] == '\0') {
+        printf("Error: Segment directory is empty\n");
+        return -1;
+    }
+    if (numVehicles < 0 || (garage == NULL && numVehicles > 0)) {
+        printf("Error: Garage pointer is NULL\n");
+        return -1;
+    }
+    if (yearsPerSegment <= 0) {
+        yearsPerSegment = DEFAULT_SEGMENT_YEARS;
+    }
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        printf("Error: Cannot create segment directory %s\n", directory);
+        return -1;
+    }
+
+    // Counting sort of the garage positions by partition, stable so garage order is kept
+    int numPartitions = (int)(YEAR_MASK / (unsigned int)yearsPerSegment) + 1;
+    int* counts = (int*)calloc((size_t)numPartitions + 1, sizeof(int));
+    int* order = (int*)malloc((numVehicles > 0 ? numVehicles : 1) * sizeof(int));
+    int* partitionStart = (int*)malloc(((size_t)numPartitions + 1) * sizeof(int));
+    int* partitions = (int*)malloc((size_t)numPartitions * sizeof(int));
+    int* results = (int*)calloc((size_t)numPartitions, sizeof(int));
+    char (*names)[SEGMENT_NAME_LENGTH] = (char (*)[SEGMENT_NAME_LENGTH])malloc((size_t)numPartitions * SEGMENT_NAME_LENGTH);
+    if (counts == NULL || order == NULL || partitionStart == NULL || partitions == NULL || results == NULL || names == NULL) {
+        printf("Error: Memory allocation for segment writer failed\n");
+        free(counts); free(order); free(partitionStart); free(partitions); free(results); free(names);
+        return -1;
+    }
+
+    for (int i = 0; i < numVehicles; i++) {
+        if (garage[i] != NULL) {
+            counts[(headerYear(vehicleHeader(garage[i])) - MIN_MODEL_YEAR) / (unsigned int)yearsPerSegment + 1]++;
+        }
+    }
+    int numSegments = 0;
+    for (int p = 0; p < numPartitions; p++) {
+        if (counts[p + 1] > 0) {
+            unsigned int firstYear;
+            unsigned int lastYear;
+            partitionYears(p, yearsPerSegment, &firstYear, &lastYear);
+            segmentName(names[numSegments], firstYear, lastYear, "");
+            partitionStart[numSegments] = counts[p];
+            partitions[numSegments++] = p;
+        }
+        counts[p + 1] += counts[p];
+    }
+    partitionStart[numSegments] = counts[numPartitions];
+    for (int i = 0; i < numVehicles; i++) {
+        if (garage[i] != NULL) {
+            order[counts[(headerYear(vehicleHeader(garage[i])) - MIN_MODEL_YEAR) / (unsigned int)yearsPerSegment]++] = i;
+        }
+    }
+
+    SegmentWriteJob job = {directory, garage, order, partitionStart, partitions, yearsPerSegment, results};
+    if (numSegments > 0) {
+        parallelFor(numSegments, numThreads, writeSegmentTask, &job);
+    }
+    int failed = 0;
+    for (int i = 0; i < numSegments; i++) {
+        failed |= results[i] != 0;
+    }
+    // Older segments go only once the new set is complete, so a failed write never loses data
+    if (!failed && removeSegmentsExcept(directory, names, numSegments) < 0) {
+        failed = 1;
+    }
+
+    free(counts);
+    free(order);
+    free(partitionStart);
+    free(partitions);
+    free(results);
+    free(names);
+    return failed ? -1 : numSegments;
+}
+
+int removeGarageSegments(const char* directory) {
+    if (directory == NULL) {
+        printf("Error: Segment directory is NULL\n");
+        return -1;
+    }
+    return removeSegmentsExcept(directory, NULL, 0);
+}
+
+static int compareSegments(const void* a, const void* b) {
+    const SegmentInfo* left = (const SegmentInfo*)a;
+    const SegmentInfo* right = (const SegmentInfo*)b;
+    if (left->firstYear != right->firstYear) {
+        return left->firstYear < right->firstYear ? -1 : 1;
+    }
+    return strcmp(left->path, right->path);
+}
+
+// Reads the footer of one file. Returns 0, or -1 if it is not a usable segment.
+static int readFooter(const char* path, SegmentInfo* info) {
+    unsigned char footer[SEGMENT_FOOTER_SIZE];
+    unsigned long long recordsBytes;
+    unsigned long long checksum;
+    struct stat status;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    int result = fstat(fd, &status) == 0 && status.st_size >= SEGMENT_FOOTER_SIZE &&
+                 readAll(fd, (char*)footer, SEGMENT_FOOTER_SIZE, status.st_size - SEGMENT_FOOTER_SIZE) == 0 &&
+                 decodeFooter(footer, (long long)status.st_size, info, &recordsBytes, &checksum) == 0 ? 0 : -1;
+    close(fd);
+    return result;
+}
+
+SegmentCatalog* openSegmentCatalog(const char* directory) {
+    if (directory == NULL) {
+        printf("Error: Segment directory is NULL\n");
+        return NULL;
+    }
+    DIR* dir = opendir(directory);
+    if (dir == NULL) {
+        printf("Error: Cannot read segment directory %s\n", directory);
+        return NULL;
+    }
+    SegmentCatalog* catalog = (SegmentCatalog*)calloc(1, sizeof(SegmentCatalog));
+    if (catalog == NULL) {
+        printf("Error: Memory allocation for segment catalog failed\n");
+        closedir(dir);
+        return NULL;
+    }
+
+    int capacity = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!isSegmentName(entry->d_name)) {
+            continue;
+        }
+        if (catalog->numSegments == capacity) {
+            int grown = capacity > 0 ? capacity * 2 : 16;
+            SegmentInfo* segments = (SegmentInfo*)realloc(catalog->segments, grown * sizeof(SegmentInfo));
+            if (segments == NULL) {
+                printf("Error: Memory allocation for segment catalog failed\n");
+                closedir(dir);
+                closeSegmentCatalog(catalog);
+                return NULL;
+            }
+            catalog->segments = segments;
+            capacity = grown;
+        }
+
+        SegmentInfo* info = &catalog->segments[catalog->numSegments];
+        info->path = joinPath(directory, entry->d_name);
+        if (info->path == NULL) {
+            closedir(dir);
+            closeSegmentCatalog(catalog);
+            return NULL;
+        }
+        if (readFooter(info->path, info) != 0) {
+            printf("Error: %s is not a usable segment file; it is left out\n", info->path);
+            free(info->path);
+            continue;
+        }
+        catalog->numSegments++;
+    }
+    closedir(dir);
+
+    if (catalog->numSegments > 1) {
+        qsort(catalog->segments, catalog->numSegments, sizeof(SegmentInfo), compareSegments);
+    }
+    return catalog;
+}
+
+int segmentCatalogSize(const SegmentCatalog* catalog) {
+    return catalog != NULL ? catalog->numSegments : 0;
+}
+
+const SegmentInfo* segmentCatalogInfo(const SegmentCatalog* catalog, int segment) {
+    if (catalog == NULL || segment < 0 || segment >= catalog->numSegments) {
+        printf("Error: Segment %d is out of range\n", segment);
+        return NULL;
+    }
+    return &catalog->segments[segment];
+}
+
+int segmentMayMatch(const SegmentInfo* info, const VehicleQuery* query) {
+    if (info == NULL || info->numVehicles == 0) {
+        return 0;
+    }
+    if (query == NULL) {
+        return 1;
+    }
+    return info->minYear <= query->maxYear && query->minYear <= info->maxYear &&
+           info->minValue <= query->maxValue && query->minValue <= info->maxValue;
+}
+
+typedef struct {
+    const SegmentInfo** infos;  // Segments to load
+    LoadedSegment* segments;
+    const int* firstVehicle;    // Garage position of each segment's first vehicle
+    char** vehicles;
+    SegmentLoadMode mode;
+} SegmentLoadJob;
+
+static void releaseSegment(LoadedSegment* segment) {
+    if (segment->base == NULL) {
+        return;
+    }
+    if (segment->mapped) {
+        munmap(segment->base, segment->size);
+    } else {
+        free(segment->base);
+    }
+    segment->base = NULL;
+}
+
+// Checks a loaded segment against the catalog and its checksum, and points the garage at it.
+// On failure the segment is released.
+static int attachSegment(const SegmentInfo* info, LoadedSegment* segment, char** vehicles) {
+    SegmentInfo loaded;
+    unsigned long long recordsBytes;
+    unsigned long long checksum;
+
+    // The footer must still say what the catalog saw, and the body must match its checksum
+    const unsigned char* base = (const unsigned char*)segment->base;
+    size_t bodySize = segment->size - SEGMENT_FOOTER_SIZE;
+    int valid = segment->size == (size_t)info->fileSize &&
+                decodeFooter(base + bodySize, info->fileSize, &loaded, &recordsBytes, &checksum) == 0 &&
+                loaded.numVehicles == info->numVehicles && loaded.firstYear == info->firstYear &&
+                hashBytes(base, bodySize, SEGMENT_CHECKSUM_SEED) == checksum &&
+                (loaded.numVehicles == 0 || base[recordsBytes - 1] == '\0');
+    for (int i = 0; valid && i < loaded.numVehicles; i++) {
+        unsigned int offset = getU32(base + recordsBytes + 4 * (size_t)i);
+        // Room for a header and a terminator after the offset, and not the reserved v2 prefix
+        valid = offset % 4 == 0 && offset < recordsBytes && recordsBytes - offset >= 5 &&
+                !isReservedVehicleRecord(segment->base + offset);
+        vehicles[i] = segment->base + offset;
+    }
+    if (!valid) {
+        printf("Error: Segment file %s is damaged\n", info->path);
+        releaseSegment(segment);
+        return -1;
+    }
+    return 0;
+}
+
+// Reads or maps one segment and attaches it. On failure the segment is left without a base.
+static int loadSegment(const SegmentInfo* info, LoadedSegment* segment, char** vehicles, SegmentLoadMode mode) {
+    struct stat status;
+
+    int fd = open(info->path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &status) != 0 || (long long)status.st_size != info->fileSize) {
+        printf("Error: Segment file %s is missing or changed since it was cataloged\n", info->path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    segment->size = (size_t)status.st_size;
+    if (mode == SEGMENT_LOAD_MMAP) {
+        void* mapping = mmap(NULL, segment->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, segment->size, MADV_WILLNEED);
+            segment->base = (char*)mapping;
+            segment->mapped = 1;
+        }
+    } else {
+        segment->base = (char*)malloc(segment->size);
+        if (segment->base != NULL && readAll(fd, segment->base, segment->size, 0) != 0) {
+            free(segment->base);
+            segment->base = NULL;
+        }
+    }
+    close(fd);
+    if (segment->base == NULL) {
+        printf("Error: Cannot %s segment file %s\n", mode == SEGMENT_LOAD_MMAP ? "map" : "read", info->path);
+        return -1;
+    }
+    return attachSegment(info, segment, vehicles);
+}
+
+// Takes a segment read by the garage loader; runs on a loader thread
+static int attachLoadedSegment(void* context, int file, char* data, size_t size) {
+    SegmentLoadJob* job = (SegmentLoadJob*)context;
+    LoadedSegment* segment = &job->segments[file];
+
+    segment->base = data;
+    segment->size = size;
+    segment->mapped = 0;
+    return attachSegment(job->infos[file], segment, job->vehicles + job->firstVehicle[file]);
+}
+
+static void loadSegmentTask(void* context, int begin, int end, int worker) {
+    SegmentLoadJob* job = (SegmentLoadJob*)context;
+    (void)worker;
+
+    for (int i = begin; i < end; i++) {
+        loadSegment(job->infos[i], &job->segments[i], job->vehicles + job->firstVehicle[i], job->mode);
+    }
+}
+
+SegmentGarage* loadGarageSegments(const SegmentCatalog* catalog, const VehicleQuery* query, SegmentLoadMode mode,
+                                  int numThreads, SegmentLoadReport* report) {
+    if (catalog == NULL) {
+        printf("Error: Segment catalog is NULL\n");
+        return NULL;
+    }
+    if (mode != SEGMENT_LOAD_READ && mode != SEGMENT_LOAD_MMAP && mode != SEGMENT_LOAD_QUEUED) {
+        printf("Error: Unknown segment load mode %d\n", (int)mode);
+        return NULL;
+    }
+
+    // Pruning needs nothing but the footers already in the catalog
+    int numSegments = catalog->numSegments;
+    SegmentGarage* result = (SegmentGarage*)calloc(1, sizeof(SegmentGarage));
+    const SegmentInfo** infos = (const SegmentInfo**)malloc((numSegments > 0 ? numSegments : 1) * sizeof(SegmentInfo*));
+    int* firstVehicle = (int*)malloc(((size_t)numSegments + 1) * sizeof(int));
+    if (result == NULL || infos == NULL || firstVehicle == NULL) {
+        printf("Error: Memory allocation for segment garage failed\n");
+        free(result); free(infos); free(firstVehicle);
+        return NULL;
+    }
+    long long bytes = 0;
+    int matched = 0;
+    firstVehicle[0] = 0;
+    for (int i = 0; i < numSegments; i++) {
+        const SegmentInfo* info = &catalog->segments[i];
+        if (segmentMayMatch(info, query)) {
+            if ((long long)firstVehicle[matched] + info->numVehicles > 0x7FFFFFFF) {
+                printf("Error: Matching segments hold more vehicles than a garage can\n");
+                free(result); free(infos); free(firstVehicle);
+                return NULL;
+            }
+            infos[matched] = info;
+            firstVehicle[matched + 1] = firstVehicle[matched] + info->numVehicles;
+            bytes += info->fileSize;
+            matched++;
+        }
+    }
+
+    result->numVehicles = firstVehicle[matched];
+    result->segments = (LoadedSegment*)calloc(matched > 0 ? matched : 1, sizeof(LoadedSegment));
+    result->vehicles = (char**)malloc((result->numVehicles > 0 ? result->numVehicles : 1) * sizeof(char*));
+    if (result->segments == NULL || result->vehicles == NULL) {
+        printf("Error: Memory allocation for segment garage failed\n");
+        free(infos); free(firstVehicle);
+        freeSegmentGarage(result);
+        return NULL;
+    }
+    result->numSegments = matched;
+
+    SegmentLoadJob job = {infos, result->segments, firstVehicle, result->vehicles, mode};
+    if (matched > 0 && mode == SEGMENT_LOAD_QUEUED) {
+        const char** paths = (const char**)malloc(matched * sizeof(char*));
+        for (int i = 0; paths != NULL && i < matched; i++) {
+            paths[i] = infos[i]->path;
+        }
+        if (paths == NULL) {
+            printf("Error: Memory allocation for segment garage failed\n");
+        } else {
+            loadGarageFiles(paths, matched, LOADER_AUTO, numThreads, attachLoadedSegment, &job, NULL);
+        }
+        free(paths);
+    } else if (matched > 0) {
+        parallelFor(matched, numThreads, loadSegmentTask, &job);
+    }
+    free(infos);
+    free(firstVehicle);
+    // A segment that failed to load is left without a base
+    int failed = 0;
+    for (int i = 0; i < matched; i++) {
+        failed |= result->segments[i].base == NULL;
+    }
+    if (failed) {
+        freeSegmentGarage(result);
+        return NULL;
+    }
+
+    if (report != NULL) {
+        report->segmentsPruned = numSegments - matched;
+        report->segmentsLoaded = matched;
+        report->bytesLoaded = bytes;
+    }
+    return result;
+}
+
+char** segmentGarageVehicles(const SegmentGarage* loaded, int* numVehicles) {
+    if (loaded == NULL) {
+        printf("Error: Segment garage is NULL\n");
+        return NULL;
+    }
+    if (numVehicles != NULL) {
+        *numVehicles = loaded->numVehicles;
+    }
+    return loaded->vehicles;
+}
+
+void freeSegmentGarage(SegmentGarage* loaded) {
+    if (loaded == NULL) {
+        return;
+    }
+    for (int i = 0; loaded->segments != NULL && i < loaded->numSegments; i++) {
+        releaseSegment(&loaded->segments[i]);
+    }
+    free(loaded->segments);
+    free(loaded->vehicles);
+    free(loaded);
+}
+
+void closeSegmentCatalog(SegmentCatalog* catalog) {
+    if (catalog == NULL) {
+        return;
+    }
+    for (int i = 0; i < catalog->numSegments; i++) {
+        free(catalog->segments[i].path);
+    }
+    free(catalog->segments);
+    free(catalog);
+}
+
+#else
+
+// Segment files need POSIX file and mapping calls; every call reports that
+
+int writeGarageSegments(const char* directory, char** garage, int numVehicles, int yearsPerSegment, int numThreads) {
+    (void)directory; (void)garage; (void)numVehicles; (void)yearsPerSegment; (void)numThreads;
+    printf("Error: Segment files are not supported on this platform\n");
+    return -1;
+}
+
+int removeGarageSegments(const char* directory) {
+    (void)directory;
+    return -1;
+}
+
+SegmentCatalog* openSegmentCatalog(const char* directory) {
+    (void)directory;
+    printf("Error: Segment files are not supported on this platform\n");
+    return NULL;
+}
+
+int segmentCatalogSize(const SegmentCatalog* catalog) {
+    (void)catalog;
+    return 0;
+}
+
+const SegmentInfo* segmentCatalogInfo(const SegmentCatalog* catalog, int segment) {
+    (void)catalog; (void)segment;
+    return NULL;
+}
+
+int segmentMayMatch(const SegmentInfo* info, const VehicleQuery* query) {
+    (void)info; (void)query;
+    return 0;
+}
+
+SegmentGarage* loadGarageSegments(const SegmentCatalog* catalog, const VehicleQuery* query, SegmentLoadMode mode,
+                                  int numThreads, SegmentLoadReport* report) {
+    (void)catalog; (void)query; (void)mode; (void)numThreads; (void)report;
+    return NULL;
+}
+
+char** segmentGarageVehicles(const SegmentGarage* loaded, int* numVehicles) {
+    (void)loaded; (void)numVehicles;
+    return NULL;
+}
+
+void freeSegmentGarage(SegmentGarage* loaded) {
+    (void)loaded;
+}
+
+void closeSegmentCatalog(SegmentCatalog* catalog) {
+    (void)catalog;
+}
+
+#endif
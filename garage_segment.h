@@ -0,0 +1,131 @@
+/*
+ * Garage Segment Header File
+ * On-disk garages split into segment files partitioned by model year range.
+ *
+ * Each segment file holds the vehicles of one year range: the records in format v1 (each
+ * starting on a 4-byte boundary), the little endian offset of every record, and a fixed
+ * size footer at the end of the file. The footer carries the year range of the partition,
+ * the minimum and maximum year and value of the vehicles actually in the segment, and a
+ * checksum of everything before it.
+ *
+ * Opening a directory reads only the footers. A query then skips every segment whose
+ * footer rules it out and loads the rest in parallel, either read into memory or mapped
+ * read-only; either way the result is an ordinary garage of pointers into the loaded
+ * segments, so queryGarage and the other garage code run on it unchanged.
+ */
+
+#ifndef GARAGE_SEGMENT_H
+#define GARAGE_SEGMENT_H
+
+#include "garage_query.h"
+
+#define SEGMENT_FILE_VERSION 1         // Bumped when the segment format changes
+#define SEGMENT_FOOTER_SIZE 80         // Bytes at the end of every segment file
+#define SEGMENT_FILE_SUFFIX ".gseg"
+#define DEFAULT_SEGMENT_YEARS 10       // Model years per segment when the caller passes 0
+
+typedef struct {
+    char* path;
+    unsigned int firstYear;  // Year range of the partition, inclusive
+    unsigned int lastYear;
+    unsigned int minYear;    // Ranges of the vehicles in the segment, inclusive
+    unsigned int maxYear;
+    unsigned int minValue;
+    unsigned int maxValue;
+    int numVehicles;
+    long long fileSize;
+} SegmentInfo;
+
+typedef enum {
+    SEGMENT_LOAD_READ,  // Read each segment into memory
+    SEGMENT_LOAD_MMAP,  // Map each segment read-only
+    SEGMENT_LOAD_QUEUED // Read through the garage loader (io_uring, or pread where it is missing)
+} SegmentLoadMode;
+
+typedef struct {
+    int segmentsPruned;    // Skipped on their footer alone
+    int segmentsLoaded;
+    long long bytesLoaded;
+} SegmentLoadReport;
+
+typedef struct SegmentCatalog SegmentCatalog;
+typedef struct SegmentGarage SegmentGarage;
+
+/*
+ * Function: writeGarageSegments
+ * Purpose: Writes a garage as segment files, one per range of model years that holds any
+ *          vehicles. Vehicles keep their garage order within a segment; NULL slots are skipped.
+ *          Each file is written under a temporary name and renamed into place, and segment
+ *          files left in the directory by an earlier write are removed afterwards.
+ * Parameters: const char* - directory for the segment files (created if missing)
+ *             char** - pointer to the garage (may be NULL for an empty garage)
+ *             int - number of vehicles in the garage
+ *             int - model years per segment (0 or less means DEFAULT_SEGMENT_YEARS)
+ *             int - number of writing threads (0 or less means defaultThreadCount)
+ * Returns: number of segment files written, or -1 on error
+ */
+int writeGarageSegments(const char*, char**, int, int, int);
+
+/*
+ * Function: removeGarageSegments
+ * Purpose: Deletes every segment file in a directory. Other files are left alone.
+ * Returns: number of files deleted, or -1 if the directory cannot be read
+ */
+int removeGarageSegments(const char*);
+
+/*
+ * Function: openSegmentCatalog
+ * Purpose: Reads the footer of every segment file in a directory. Files whose footer is
+ *          damaged or written with a different header layout are reported and left out.
+ * Returns: the catalog, segments ordered by year range, or NULL if the directory cannot be read
+ */
+SegmentCatalog* openSegmentCatalog(const char*);
+
+/*
+ * Functions: segmentCatalogSize, segmentCatalogInfo
+ * Purpose: Number of segments in a catalog / the footer of one of them.
+ */
+int segmentCatalogSize(const SegmentCatalog*);
+const SegmentInfo* segmentCatalogInfo(const SegmentCatalog*, int);
+
+/*
+ * Function: segmentMayMatch
+ * Purpose: Checks a segment footer against the numeric part of a query (NULL matches all).
+ * Returns: 1 if the segment may hold a matching vehicle, 0 if it certainly does not
+ */
+int segmentMayMatch(const SegmentInfo*, const VehicleQuery*);
+
+/*
+ * Function: loadGarageSegments
+ * Purpose: Loads every segment that may match a query, in parallel, and checks each one
+ *          against its footer and checksum. The query only selects segments; run queryGarage
+ *          on the result to select vehicles.
+ * Parameters: const SegmentCatalog* - the catalog
+ *             const VehicleQuery* - the filter (NULL loads every segment)
+ *             SegmentLoadMode - read into memory, map read-only, or read through the garage loader
+ *             int - number of loading threads (0 or less means defaultThreadCount)
+ *             SegmentLoadReport* - receives what was pruned and loaded (may be NULL)
+ * Returns: the loaded garage, or NULL on error
+ */
+SegmentGarage* loadGarageSegments(const SegmentCatalog*, const VehicleQuery*, SegmentLoadMode, int, SegmentLoadReport*);
+
+/*
+ * Function: segmentGarageVehicles
+ * Purpose: The loaded garage, segments in year range order, and its size. The vehicles
+ *          belong to the loaded segments: they are read-only and must not be freed.
+ */
+char** segmentGarageVehicles(const SegmentGarage*, int*);
+
+/*
+ * Function: freeSegmentGarage
+ * Purpose: Unmaps or frees the loaded segments and the garage.
+ */
+void freeSegmentGarage(SegmentGarage*);
+
+/*
+ * Function: closeSegmentCatalog
+ * Purpose: Frees a catalog. Garages loaded from it stay valid.
+ */
+void closeSegmentCatalog(SegmentCatalog*);
+
+#endif /* GARAGE_SEGMENT_H */
@@ -0,0 +1,1334 @@
+/*
+ * Garage Server
+ * Unix domain socket daemon: an epoll loop for connections and cheap requests, a worker
+ * pool for range queries, and the matching client.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vehicle.h"
+#include "byte_io.h"
+#include "garage_index.h"
+#include "parallel.h"
+#include "garage_server.h"
+
+#ifdef __linux__
+    #include <errno.h>
+    #include <signal.h>
+    #include <stdatomic.h>
+    #include <pthread.h>
+    #include <unistd.h>
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <sys/signalfd.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+#endif
+
+#define SERVER_FRAME_HEADER 9     // u32 length, u32 id, u8 op or status
+#define SERVER_READ_CHUNK 65536   // Bytes read from a connection per readiness event
+#define SERVER_MAX_EVENTS 64
+#define SERVER_MIN_CAPACITY 16    // Garage slots allocated up front
+
+#ifdef __linux__
+
+static void appendU16(OutputBuffer* out, unsigned int value) {
+    unsigned char bytes[2];
+    putU16(bytes, value);
+    outputAppend(out, (const char*)bytes, sizeof(bytes));
+}
+
+static void appendU32(OutputBuffer* out, unsigned int value) {
+    unsigned char bytes[4];
+    putU32(bytes, value);
+    outputAppend(out, (const char*)bytes, sizeof(bytes));
+}
+
+static void appendU64(OutputBuffer* out, unsigned long long value) {
+    unsigned char bytes[8];
+    putU64(bytes, value);
+    outputAppend(out, (const char*)bytes, sizeof(bytes));
+}
+
+// Starts a response frame; endFrame fills in its length once the payload is appended
+static size_t beginFrame(OutputBuffer* out, unsigned int id, int status) {
+    size_t start = out->used;
+    unsigned char status8 = (unsigned char)status;
+
+    appendU32(out, 0);
+    appendU32(out, id);
+    outputAppend(out, (const char*)&status8, 1);
+    return start;
+}
+
+static void endFrame(OutputBuffer* out, size_t start) {
+    if (!out->error) {
+        putU32((unsigned char*)out->data + start, (unsigned int)(out->used - start - 4));
+    }
+}
+
+static void emptyFrame(OutputBuffer* out, unsigned int id, int status) {
+    endFrame(out, beginFrame(out, id, status));
+}
+
+typedef struct ServerConnection {
+    int fd;
+    unsigned char* input;
+    size_t inputUsed;
+    size_t inputStart;      // First byte not yet handled
+    size_t inputCapacity;
+    OutputBuffer output;
+    size_t outputSent;      // Bytes of output already written to the socket
+    unsigned int events;    // Events registered with epoll
+    int waiting;            // A range query from this connection is with the workers
+    int finished;           // Peer will send nothing more
+    int closed;             // Socket closed; freed once no job refers to it
+    struct ServerConnection* next;
+} ServerConnection;
+
+typedef struct ServerJob {
+    ServerConnection* connection;
+    unsigned int id;
+    VehicleQuery query;
+    char* prefix;
+    unsigned int limit;
+    OutputBuffer result;    // Complete response frame
+    struct ServerJob* next;
+} ServerJob;
+
+struct GarageServer {
+    char* path;
+    int listenFd;
+    int epollFd;
+    int wakeFd;             // eventfd: finished jobs or a stop request
+    int signalFd;           // runGarageServer only
+
+    // Written only by the loop thread, under garageLock; workers read under the shared lock
+    char** garage;
+    int numVehicles;
+    int capacity;
+    VehicleIndex* index;
+    GarageYearStats* stats;
+    pthread_rwlock_t garageLock;
+
+    pthread_mutex_t jobLock;
+    pthread_cond_t jobReady;
+    ServerJob* pending;     // FIFO of range queries
+    ServerJob* pendingTail;
+    ServerJob* done;
+    int stopWorkers;
+    pthread_t* workers;
+    int numWorkers;
+
+    pthread_t loopThread;
+    atomic_int stopRequested;
+    int shutdownRequested;  // SERVER_OP_SHUTDOWN received
+    int haveClosed;         // Some connection waits to be freed
+    ServerConnection* connections;
+};
+
+static void wakeLoop(GarageServer* server) {
+    unsigned long long one = 1;
+    ssize_t written = write(server->wakeFd, &one, sizeof(one));
+    (void)written;  // A full counter already wakes the loop
+}
+
+static void freeJob(ServerJob* job) {
+    free(job->prefix);
+    free(job->result.data);
+    free(job);
+}
+
+// Runs a range query against the garage and formats the complete response
+static void runRangeJob(GarageServer* server, ServerJob* job) {
+    OutputBuffer* out = &job->result;
+
+    pthread_rwlock_rdlock(&server->garageLock);
+    int* positions = (int*)malloc((server->numVehicles > 0 ? server->numVehicles : 1) * sizeof(int));
+    int matches = positions == NULL ? -1 :
+                  server->numVehicles == 0 ? 0 : queryGarage(server->garage, server->numVehicles, &job->query, positions);
+
+    if (matches < 0) {
+        emptyFrame(out, job->id, SERVER_STATUS_ERROR);
+    } else {
+        size_t start = beginFrame(out, job->id, SERVER_STATUS_OK);
+        appendU32(out, (unsigned int)matches);
+        size_t countAt = out->used;
+        appendU32(out, 0);
+
+        // Stop at the limit, or before the frame would be larger than a client accepts
+        unsigned int count = 0;
+        for (int i = 0; i < matches && count < job->limit; i++) {
+            const char* vehicle = server->garage[positions[i]];
+            unsigned int length = vehicleDescriptionLength(vehicle);
+            length = length > 0xFFFF ? 0xFFFF : length;
+
+            if (out->used - start + 10 + length > SERVER_MAX_FRAME) {
+                break;
+            }
+            appendU32(out, (unsigned int)positions[i]);
+            appendU32(out, vehicleHeader(vehicle));
+            appendU16(out, length);
+            outputAppend(out, vehicleDescription(vehicle), length);
+            count++;
+        }
+        if (!out->error) {
+            putU32((unsigned char*)out->data + countAt, count);
+        }
+        endFrame(out, start);
+    }
+    pthread_rwlock_unlock(&server->garageLock);
+    free(positions);
+}
+
+static void* serverWorker(void* argument) {
+    GarageServer* server = (GarageServer*)argument;
+
+    pthread_mutex_lock(&server->jobLock);
+    for (;;) {
+        while (server->pending == NULL && !server->stopWorkers) {
+            pthread_cond_wait(&server->jobReady, &server->jobLock);
+        }
+        if (server->stopWorkers) {
+            break;
+        }
+
+        ServerJob* job = server->pending;
+        server->pending = job->next;
+        if (server->pending == NULL) {
+            server->pendingTail = NULL;
+        }
+        pthread_mutex_unlock(&server->jobLock);
+
+        runRangeJob(server, job);
+
+        pthread_mutex_lock(&server->jobLock);
+        job->next = server->done;
+        server->done = job;
+        wakeLoop(server);
+    }
+    pthread_mutex_unlock(&server->jobLock);
+    return NULL;
+}
+
+static void submitJob(GarageServer* server, ServerJob* job) {
+    pthread_mutex_lock(&server->jobLock);
+    job->next = NULL;
+    if (server->pendingTail != NULL) {
+        server->pendingTail->next = job;
+    } else {
+        server->pending = job;
+    }
+    server->pendingTail = job;
+    pthread_cond_signal(&server->jobReady);
+    pthread_mutex_unlock(&server->jobLock);
+}
+
+// Copies a length-prefixed string out of a request; NULL if it holds a NUL byte or allocation failed
+static char* copyText(const unsigned char* bytes, unsigned int length) {
+    if (memchr(bytes, '\0', length) != NULL) {
+        return NULL;
+    }
+    char* text = (char*)malloc(length + 1);
+    if (text != NULL) {
+        memcpy(text, bytes, length);
+        text[length] = '\0';
+    }
+    return text;
+}
+
+static int serverAdd(GarageServer* server, const unsigned char* payload, unsigned int size, OutputBuffer* out, unsigned int id) {
+    if (size < 10 || size != 10 + getU16(payload + 8)) {
+        return SERVER_STATUS_BAD_REQUEST;
+    }
+    char* description = copyText(payload + 10, size - 10);
+    if (description == NULL) {
+        return SERVER_STATUS_BAD_REQUEST;
+    }
+    char* vehicle = buildVehicle(getU32(payload), getU32(payload + 4), description);
+    free(description);
+    if (vehicle == NULL) {
+        return SERVER_STATUS_ERROR;
+    }
+
+    if (server->numVehicles == server->capacity) {
+        int capacity = server->capacity * 2;
+        pthread_rwlock_wrlock(&server->garageLock);
+        char** garage = (char**)realloc(server->garage, capacity * sizeof(char*));
+        if (garage != NULL) {
+            server->garage = garage;
+            server->capacity = capacity;
+        }
+        pthread_rwlock_unlock(&server->garageLock);
+        if (garage == NULL) {
+            printf("Error: Memory allocation for garage failed\n");
+            freeVehicle(vehicle);
+            return SERVER_STATUS_ERROR;
+        }
+    }
+    if (vehicleIndexAdd(server->index, vehicle) != 0) {
+        freeVehicle(vehicle);
+        return SERVER_STATUS_ERROR;
+    }
+    yearStatsAdd(server->stats, vehicle);
+
+    int position = server->numVehicles;
+    pthread_rwlock_wrlock(&server->garageLock);
+    server->garage[position] = vehicle;
+    server->numVehicles++;
+    pthread_rwlock_unlock(&server->garageLock);
+
+    size_t start = beginFrame(out, id, SERVER_STATUS_OK);
+    appendU32(out, (unsigned int)position);
+    endFrame(out, start);
+    return SERVER_STATUS_OK;
+}
+
+static int serverRemove(GarageServer* server, const unsigned char* payload, unsigned int size, OutputBuffer* out, unsigned int id) {
+    if (size != 4) {
+        return SERVER_STATUS_BAD_REQUEST;
+    }
+    unsigned int position = getU32(payload);
+    if (position >= (unsigned int)server->numVehicles) {
+        return SERVER_STATUS_ERROR;
+    }
+
+    char* vehicle = server->garage[position];
+    if (vehicle != NULL) {
+        vehicleIndexRemove(server->index, vehicle);
+        yearStatsRemove(server->stats, vehicle);
+    }
+
+    pthread_rwlock_wrlock(&server->garageLock);
+    memmove(server->garage + position, server->garage + position + 1,
+            (server->numVehicles - position - 1) * sizeof(char*));
+    server->numVehicles--;
+    pthread_rwlock_unlock(&server->garageLock);
+    if (vehicle != NULL) {
+        freeVehicle(vehicle);
+    }
+
+    emptyFrame(out, id, SERVER_STATUS_OK);
+    return SERVER_STATUS_OK;
+}
+
+static int serverLookup(GarageServer* server, const unsigned char* payload, unsigned int size, OutputBuffer* out, unsigned int id) {
+    if (size < 2 || size != 2 + getU16(payload)) {
+        return SERVER_STATUS_BAD_REQUEST;
+    }
+    char* description = copyText(payload + 2, size - 2);
+    if (description == NULL) {
+        return SERVER_STATUS_BAD_REQUEST;
+    }
+
+    int matches = 0;
+    char* const* vehicles = vehicleIndexLookup(server->index, description, &matches);
+    unsigned int count = (unsigned int)matches;
+    free(description);
+    if (vehicles == NULL) {
+        count = 0;
+    }
+
+    // Keep the frame within SERVER_MAX_FRAME; the match count is still exact
+    unsigned int stored = count < (SERVER_MAX_FRAME - 16) / 4 ? count : (SERVER_MAX_FRAME - 16) / 4;
+    size_t start = beginFrame(out, id, SERVER_STATUS_OK);
+    appendU32(out, count);
+    appendU32(out, stored);
+    for (unsigned int i = 0; i < stored; i++) {
+        appendU32(out, vehicleHeader(vehicles[i]));
+    }
+    endFrame(out, start);
+    return SERVER_STATUS_OK;
+}
+
+static int serverRange(GarageServer* server, ServerConnection* connection, const unsigned char* payload,
+                       unsigned int size, unsigned int id) {
+    if (size < 22 || size != 22 + getU16(payload + 20)) {
+        return SERVER_STATUS_BAD_REQUEST;
+    }
+
+    ServerJob* job = (ServerJob*)calloc(1, sizeof(ServerJob));
+    if (job == NULL) {
+        return SERVER_STATUS_ERROR;
+    }
+    job->prefix = copyText(payload + 22, size - 22);
+    if (job->prefix == NULL) {
+        free(job);
+        return SERVER_STATUS_BAD_REQUEST;
+    }
+
+    job->connection = connection;
+    job->id = id;
+    job->query.minYear = getU32(payload);
+    job->query.maxYear = getU32(payload + 4);
+    job->query.minValue = getU32(payload + 8);
+    job->query.maxValue = getU32(payload + 12);
+    job->query.descriptionPrefix = job->prefix;
+    job->limit = getU32(payload + 16);
+
+    // The connection is not read again until the answer is back, keeping requests in order
+    connection->waiting = 1;
+    submitJob(server, job);
+    return SERVER_STATUS_OK;
+}
+
+static int serverStats(GarageServer* server, const unsigned char* payload, unsigned int size, OutputBuffer* out, unsigned int id) {
+    YearAggregate aggregate;
+
+    if (size != 4) {
+        return SERVER_STATUS_BAD_REQUEST;
+    }
+    if (!readYearAggregate(server->stats, getU32(payload), &aggregate)) {
+        return SERVER_STATUS_ERROR;
+    }
+
+    size_t start = beginFrame(out, id, SERVER_STATUS_OK);
+    appendU64(out, (unsigned long long)aggregate.count);
+    appendU64(out, (unsigned long long)aggregate.sum);
+    appendU32(out, aggregate.minValue);
+    appendU32(out, aggregate.maxValue);
+    endFrame(out, start);
+    return SERVER_STATUS_OK;
+}
+
+// Handles one request frame (id, op, payload); the response is queued on the connection
+static void handleRequest(GarageServer* server, ServerConnection* connection, const unsigned char* frame, unsigned int length) {
+    unsigned int id = getU32(frame);
+    const unsigned char* payload = frame + 5;
+    unsigned int size = length - 5;
+    OutputBuffer* out = &connection->output;
+    int status;
+
+    switch (frame[4]) {
+        case SERVER_OP_ADD:
+            status = serverAdd(server, payload, size, out, id);
+            break;
+        case SERVER_OP_REMOVE:
+            status = serverRemove(server, payload, size, out, id);
+            break;
+        case SERVER_OP_LOOKUP:
+            status = serverLookup(server, payload, size, out, id);
+            break;
+        case SERVER_OP_RANGE:
+            status = serverRange(server, connection, payload, size, id);
+            break;
+        case SERVER_OP_STATS:
+            status = serverStats(server, payload, size, out, id);
+            break;
+        case SERVER_OP_COUNT: {
+            status = size == 0 ? SERVER_STATUS_OK : SERVER_STATUS_BAD_REQUEST;
+            if (status == SERVER_STATUS_OK) {
+                size_t start = beginFrame(out, id, SERVER_STATUS_OK);
+                appendU32(out, (unsigned int)server->numVehicles);
+                endFrame(out, start);
+            }
+            break;
+        }
+        case SERVER_OP_SHUTDOWN:
+            status = size == 0 ? SERVER_STATUS_OK : SERVER_STATUS_BAD_REQUEST;
+            if (status == SERVER_STATUS_OK) {
+                emptyFrame(out, id, SERVER_STATUS_OK);
+                server->shutdownRequested = 1;
+            }
+            break;
+        default:
+            status = SERVER_STATUS_BAD_REQUEST;
+            break;
+    }
+
+    // Successful requests wrote their own response
+    if (status != SERVER_STATUS_OK) {
+        emptyFrame(out, id, status);
+    }
+}
+
+static size_t pendingOutput(const ServerConnection* connection) {
+    return connection->output.used - connection->outputSent;
+}
+
+static int hasCompleteFrame(const ServerConnection* connection) {
+    size_t available = connection->inputUsed - connection->inputStart;
+    return available >= 4 && available >= 4 + (size_t)getU32(connection->input + connection->inputStart);
+}
+
+// Handles complete frames in order. Returns -1 on a malformed frame.
+static int processInput(GarageServer* server, ServerConnection* connection) {
+    while (!connection->waiting && !server->shutdownRequested && pendingOutput(connection) < SERVER_OUTPUT_LIMIT) {
+        size_t available = connection->inputUsed - connection->inputStart;
+        if (available < 4) {
+            break;
+        }
+
+        unsigned int length = getU32(connection->input + connection->inputStart);
+        if (length < 5 || length > SERVER_MAX_FRAME) {
+            return -1;
+        }
+        if (available < 4 + (size_t)length) {
+            break;
+        }
+
+        handleRequest(server, connection, connection->input + connection->inputStart + 4, length);
+        connection->inputStart += 4 + (size_t)length;
+    }
+
+    if (connection->output.error) {
+        return -1;
+    }
+
+    // Move a partial frame to the front of the buffer
+    if (connection->inputStart > 0) {
+        connection->inputUsed -= connection->inputStart;
+        memmove(connection->input, connection->input + connection->inputStart, connection->inputUsed);
+        connection->inputStart = 0;
+    }
+    return 0;
+}
+
+// Reads one chunk. Returns -1 if the connection failed.
+static int readInput(ServerConnection* connection) {
+    if (connection->inputCapacity - connection->inputUsed < SERVER_READ_CHUNK) {
+        size_t capacity = connection->inputUsed + SERVER_READ_CHUNK;
+        unsigned char* input = (unsigned char*)realloc(connection->input, capacity);
+        if (input == NULL) {
+            printf("Error: Memory allocation for connection buffer failed\n");
+            return -1;
+        }
+        connection->input = input;
+        connection->inputCapacity = capacity;
+    }
+
+    ssize_t received = read(connection->fd, connection->input + connection->inputUsed, SERVER_READ_CHUNK);
+    if (received < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+    }
+    if (received == 0) {
+        connection->finished = 1;
+    }
+    connection->inputUsed += (size_t)received;
+    return 0;
+}
+
+// Writes as much queued output as the socket takes. Returns -1 if the connection failed.
+static int flushOutput(ServerConnection* connection) {
+    OutputBuffer* out = &connection->output;
+
+    while (connection->outputSent < out->used) {
+        ssize_t sent = send(connection->fd, out->data + connection->outputSent, out->used - connection->outputSent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return -1;
+        }
+        connection->outputSent += (size_t)sent;
+    }
+
+    if (connection->outputSent == out->used) {
+        out->used = 0;
+        connection->outputSent = 0;
+    } else if (connection->outputSent >= out->used / 2) {
+        out->used -= connection->outputSent;
+        memmove(out->data, out->data + connection->outputSent, out->used);
+        connection->outputSent = 0;
+    }
+    return 0;
+}
+
+static void closeConnection(GarageServer* server, ServerConnection* connection) {
+    epoll_ctl(server->epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    connection->fd = -1;
+    connection->closed = 1;
+    server->haveClosed = 1;
+}
+
+// Reads only while the connection may make progress, so level triggering never spins
+static void updateEvents(GarageServer* server, ServerConnection* connection) {
+    unsigned int events = 0;
+
+    if (!connection->waiting && !connection->finished && pendingOutput(connection) < SERVER_OUTPUT_LIMIT) {
+        events |= EPOLLIN;
+    }
+    if (pendingOutput(connection) > 0) {
+        events |= EPOLLOUT;
+    }
+
+    if (events != connection->events) {
+        struct epoll_event event;
+        event.events = events;
+        event.data.ptr = connection;
+        epoll_ctl(server->epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->events = events;
+    }
+}
+
+// Answers what can be answered, writes, and decides what to wait for next
+static void serviceConnection(GarageServer* server, ServerConnection* connection) {
+    do {
+        if (processInput(server, connection) != 0 || flushOutput(connection) != 0) {
+            closeConnection(server, connection);
+            return;
+        }
+    } while (!connection->waiting && !server->shutdownRequested &&
+             pendingOutput(connection) < SERVER_OUTPUT_LIMIT && hasCompleteFrame(connection));
+
+    if (connection->finished && !connection->waiting && pendingOutput(connection) == 0) {
+        closeConnection(server, connection);
+        return;
+    }
+    updateEvents(server, connection);
+}
+
+static void acceptConnections(GarageServer* server) {
+    for (;;) {
+        int fd = accept4(server->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                printf("Error: Accepting a connection failed\n");
+            }
+            return;
+        }
+
+        ServerConnection* connection = (ServerConnection*)calloc(1, sizeof(ServerConnection));
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        if (connection == NULL || epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            printf("Error: Cannot register connection\n");
+            free(connection);
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        connection->next = server->connections;
+        server->connections = connection;
+    }
+}
+
+// Hands finished range queries back to their connections
+static void finishJobs(GarageServer* server) {
+    pthread_mutex_lock(&server->jobLock);
+    ServerJob* job = server->done;
+    server->done = NULL;
+    pthread_mutex_unlock(&server->jobLock);
+
+    while (job != NULL) {
+        ServerJob* next = job->next;
+        ServerConnection* connection = job->connection;
+
+        connection->waiting = 0;
+        if (connection->closed) {
+            server->haveClosed = 1;  // reapConnections skipped it while the job was out
+        } else {
+            if (job->result.error) {
+                emptyFrame(&connection->output, job->id, SERVER_STATUS_ERROR);
+            } else {
+                outputAppend(&connection->output, job->result.data, job->result.used);
+            }
+            serviceConnection(server, connection);
+        }
+        freeJob(job);
+        job = next;
+    }
+}
+
+static void freeConnection(ServerConnection* connection) {
+    if (connection->fd >= 0) {
+        close(connection->fd);
+    }
+    free(connection->input);
+    free(connection->output.data);
+    free(connection);
+}
+
+// Frees closed connections that no job refers to any more
+static void reapConnections(GarageServer* server) {
+    ServerConnection** link = &server->connections;
+
+    while (*link != NULL) {
+        ServerConnection* connection = *link;
+        if (connection->closed && !connection->waiting) {
+            *link = connection->next;
+            freeConnection(connection);
+        } else {
+            link = &connection->next;
+        }
+    }
+    server->haveClosed = 0;
+}
+
+static void serveLoop(GarageServer* server) {
+    struct epoll_event events[SERVER_MAX_EVENTS];
+
+    while (!server->shutdownRequested && !atomic_load(&server->stopRequested)) {
+        int ready = epoll_wait(server->epollFd, events, SERVER_MAX_EVENTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            printf("Error: Waiting for connections failed\n");
+            break;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            void* source = events[i].data.ptr;
+
+            if (source == &server->listenFd) {
+                acceptConnections(server);
+            } else if (source == &server->wakeFd) {
+                unsigned long long count;
+                ssize_t drained = read(server->wakeFd, &count, sizeof(count));
+                (void)drained;
+                finishJobs(server);
+            } else if (source == &server->signalFd) {
+                struct signalfd_siginfo info;
+                ssize_t drained = read(server->signalFd, &info, sizeof(info));
+                (void)drained;
+                server->shutdownRequested = 1;
+            } else {
+                ServerConnection* connection = (ServerConnection*)source;
+                // Skip events for a connection closed earlier in this batch
+                if (connection->closed) {
+                    continue;
+                }
+                // A hung up peer cannot receive answers any more
+                if ((events[i].events & (EPOLLHUP | EPOLLERR)) ||
+                    ((events[i].events & EPOLLIN) && readInput(connection) != 0)) {
+                    closeConnection(server, connection);
+                    continue;
+                }
+                serviceConnection(server, connection);
+            }
+        }
+
+        if (server->haveClosed) {
+            reapConnections(server);
+        }
+    }
+}
+
+static int watch(GarageServer* server, int fd, void* source) {
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = source;
+    return epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &event);
+}
+
+// Stops the workers and frees everything except the garage
+static void releaseServer(GarageServer* server) {
+    pthread_mutex_lock(&server->jobLock);
+    server->stopWorkers = 1;
+    pthread_cond_broadcast(&server->jobReady);
+    pthread_mutex_unlock(&server->jobLock);
+    for (int i = 0; i < server->numWorkers; i++) {
+        pthread_join(server->workers[i], NULL);
+    }
+    free(server->workers);
+
+    ServerJob* lists[2] = {server->pending, server->done};
+    for (int i = 0; i < 2; i++) {
+        while (lists[i] != NULL) {
+            ServerJob* next = lists[i]->next;
+            freeJob(lists[i]);
+            lists[i] = next;
+        }
+    }
+    while (server->connections != NULL) {
+        ServerConnection* next = server->connections->next;
+        freeConnection(server->connections);
+        server->connections = next;
+    }
+
+    int fds[4] = {server->listenFd, server->epollFd, server->wakeFd, server->signalFd};
+    for (int i = 0; i < 4; i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+    }
+    if (server->listenFd >= 0) {
+        unlink(server->path);
+    }
+
+    if (server->index != NULL) {
+        freeVehicleIndex(server->index);
+    }
+    if (server->stats != NULL) {
+        freeGarageYearStats(server->stats);
+    }
+    pthread_rwlock_destroy(&server->garageLock);
+    pthread_mutex_destroy(&server->jobLock);
+    pthread_cond_destroy(&server->jobReady);
+    free(server->path);
+    free(server);
+}
+
+// Binds the socket, indexes the garage and starts the workers. The caller keeps the garage on failure.
+static GarageServer* openServer(const char* path, char** garage, int numVehicles, int numWorkers) {
+    struct sockaddr_un address;
+    struct stat existing;
+
+    if (path == NULL || strlen(path) >= sizeof(address.sun_path)) {
+        printf("Error: Socket path is missing or too long\n");
+        return NULL;
+    }
+    if (numVehicles < 0 || (garage == NULL && numVehicles > 0)) {
+        printf("Error: Garage pointer is NULL\n");
+        return NULL;
+    }
+
+    GarageServer* server = (GarageServer*)calloc(1, sizeof(GarageServer));
+    if (server == NULL) {
+        printf("Error: Memory allocation for server failed\n");
+        return NULL;
+    }
+    server->listenFd = server->epollFd = server->wakeFd = server->signalFd = -1;
+    pthread_rwlock_init(&server->garageLock, NULL);
+    pthread_mutex_init(&server->jobLock, NULL);
+    pthread_cond_init(&server->jobReady, NULL);
+    atomic_init(&server->stopRequested, 0);
+
+    server->path = (char*)malloc(strlen(path) + 1);
+    if (server->path == NULL) {
+        releaseServer(server);
+        return NULL;
+    }
+    strcpy(server->path, path);
+
+    // A socket file left behind by an earlier server is replaced; any other file is kept
+    if (lstat(path, &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+        unlink(path);
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        printf("Error: Cannot create socket\n");
+        releaseServer(server);
+        return NULL;
+    }
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        printf("Error: Cannot listen on %s\n", path);
+        close(fd);
+        releaseServer(server);
+        return NULL;
+    }
+    server->listenFd = fd;
+
+    server->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    server->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (server->epollFd < 0 || server->wakeFd < 0 ||
+        watch(server, server->listenFd, &server->listenFd) != 0 || watch(server, server->wakeFd, &server->wakeFd) != 0) {
+        printf("Error: Cannot set up the event loop\n");
+        releaseServer(server);
+        return NULL;
+    }
+
+    server->index = numVehicles > 0 ? buildVehicleIndex(garage, numVehicles) : createVehicleIndex(SERVER_MIN_CAPACITY);
+    server->stats = buildGarageYearStats(garage, numVehicles);
+    int wanted = numWorkers > 0 ? numWorkers : defaultThreadCount();
+    server->workers = (pthread_t*)malloc(wanted * sizeof(pthread_t));
+    if (server->index == NULL || server->stats == NULL || server->workers == NULL) {
+        printf("Error: Memory allocation for server failed\n");
+        releaseServer(server);
+        return NULL;
+    }
+
+    while (server->numWorkers < wanted && pthread_create(&server->workers[server->numWorkers], NULL, serverWorker, server) == 0) {
+        server->numWorkers++;
+    }
+    if (server->numWorkers == 0) {
+        printf("Error: Cannot start worker threads\n");
+        releaseServer(server);
+        return NULL;
+    }
+
+    // Last, so the caller's garage is untouched if anything fails: the server grows the
+    // garage itself, doubling instead of one slot per add
+    int capacity = numVehicles > SERVER_MIN_CAPACITY ? numVehicles : SERVER_MIN_CAPACITY;
+    char** grown = (char**)realloc(garage, capacity * sizeof(char*));
+    if (grown == NULL) {
+        printf("Error: Memory allocation for garage failed\n");
+        releaseServer(server);
+        return NULL;
+    }
+    server->garage = grown;
+    server->numVehicles = numVehicles;
+    server->capacity = capacity;
+    return server;
+}
+
+static void* serverThread(void* argument) {
+    serveLoop((GarageServer*)argument);
+    return NULL;
+}
+
+GarageServer* startGarageServer(const char* path, char** garage, int numVehicles, int numWorkers) {
+    GarageServer* server = openServer(path, garage, numVehicles, numWorkers);
+    if (server == NULL) {
+        return NULL;
+    }
+
+    if (pthread_create(&server->loopThread, NULL, serverThread, server) != 0) {
+        printf("Error: Cannot start server thread\n");
+        releaseServer(server);
+        return NULL;
+    }
+    return server;
+}
+
+char** stopGarageServer(GarageServer* server, int* numVehicles) {
+    if (server == NULL) {
+        printf("Error: Server pointer is NULL\n");
+        return NULL;
+    }
+
+    atomic_store(&server->stopRequested, 1);
+    wakeLoop(server);
+    pthread_join(server->loopThread, NULL);
+
+    char** garage = server->garage;
+    if (numVehicles != NULL) {
+        *numVehicles = server->numVehicles;
+    }
+    releaseServer(server);
+    return garage;
+}
+
+char** runGarageServer(const char* path, char** garage, int* numVehicles, int numWorkers) {
+    sigset_t stopSignals;
+    sigset_t previous;
+
+    if (numVehicles == NULL) {
+        printf("Error: Vehicle count pointer is NULL\n");
+        return NULL;
+    }
+
+    // Blocked before the workers start so that they inherit the mask and only signalfd sees them
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &previous);
+
+    GarageServer* server = openServer(path, garage, *numVehicles, numWorkers);
+    if (server == NULL) {
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+        return NULL;
+    }
+
+    server->signalFd = signalfd(-1, &stopSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (server->signalFd < 0 || watch(server, server->signalFd, &server->signalFd) != 0) {
+        printf("Error: Cannot watch for stop signals\n");
+    }
+
+    printf("Serving %d vehicles on %s with %d worker threads\n", server->numVehicles, path, server->numWorkers);
+    fflush(stdout);
+    serveLoop(server);
+
+    garage = server->garage;
+    *numVehicles = server->numVehicles;
+    releaseServer(server);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    printf("Server stopped with %d vehicles\n", *numVehicles);
+    return garage;
+}
+
+/*
+ * Client
+ */
+struct GarageClient {
+    int fd;
+    unsigned char* input;
+    size_t inputUsed;
+    size_t inputCapacity;
+    size_t consumed;        // Bytes of the frame returned last, dropped by the next receive
+    unsigned int nextId;
+};
+
+GarageClient* connectGarageServer(const char* path) {
+    struct sockaddr_un address;
+
+    if (path == NULL || strlen(path) >= sizeof(address.sun_path)) {
+        printf("Error: Socket path is missing or too long\n");
+        return NULL;
+    }
+
+    GarageClient* client = (GarageClient*)calloc(1, sizeof(GarageClient));
+    if (client == NULL) {
+        printf("Error: Memory allocation for client failed\n");
+        return NULL;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    client->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (client->fd < 0 || connect(client->fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        printf("Error: Cannot connect to %s\n", path);
+        if (client->fd >= 0) {
+            close(client->fd);
+        }
+        free(client);
+        return NULL;
+    }
+    return client;
+}
+
+void closeGarageClient(GarageClient* client) {
+    if (client != NULL) {
+        close(client->fd);
+        free(client->input);
+        free(client);
+    }
+}
+
+static int sendAll(int fd, const void* data, size_t length) {
+    const char* bytes = (const char*)data;
+
+    while (length > 0) {
+        ssize_t sent = send(fd, bytes, length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        bytes += sent;
+        length -= (size_t)sent;
+    }
+    return 0;
+}
+
+int sendGarageRequest(GarageClient* client, unsigned int id, int op, const void* payload, unsigned int length) {
+    unsigned char frame[SERVER_FRAME_HEADER + 256];
+
+    if (client == NULL || (payload == NULL && length > 0) || length > SERVER_MAX_FRAME - 5) {
+        printf("Error: Invalid request\n");
+        return -1;
+    }
+
+    putU32(frame, length + 5);
+    putU32(frame + 4, id);
+    frame[8] = (unsigned char)op;
+
+    // Small requests go out in one write
+    if (length <= sizeof(frame) - SERVER_FRAME_HEADER) {
+        if (length > 0) {
+            memcpy(frame + SERVER_FRAME_HEADER, payload, length);
+        }
+        return sendAll(client->fd, frame, SERVER_FRAME_HEADER + length);
+    }
+    if (sendAll(client->fd, frame, SERVER_FRAME_HEADER) != 0) {
+        return -1;
+    }
+    return sendAll(client->fd, payload, length);
+}
+
+int receiveGarageResponse(GarageClient* client, GarageResponse* response) {
+    if (client == NULL || response == NULL) {
+        printf("Error: Client or response pointer is NULL\n");
+        return -1;
+    }
+
+    client->inputUsed -= client->consumed;
+    if (client->inputUsed > 0) {
+        memmove(client->input, client->input + client->consumed, client->inputUsed);
+    }
+    client->consumed = 0;
+
+    for (;;) {
+        if (client->inputUsed >= 4) {
+            unsigned int length = getU32(client->input);
+            if (length < 5 || length > SERVER_MAX_FRAME) {
+                printf("Error: Malformed response from server\n");
+                return -1;
+            }
+            if (client->inputUsed >= 4 + (size_t)length) {
+                response->id = getU32(client->input + 4);
+                response->status = client->input[8];
+                response->payload = client->input + SERVER_FRAME_HEADER;
+                response->length = length - 5;
+                client->consumed = 4 + (size_t)length;
+                return 0;
+            }
+        }
+
+        if (client->inputCapacity - client->inputUsed < SERVER_READ_CHUNK) {
+            size_t capacity = client->inputUsed + SERVER_READ_CHUNK;
+            unsigned char* input = (unsigned char*)realloc(client->input, capacity);
+            if (input == NULL) {
+                printf("Error: Memory allocation for client buffer failed\n");
+                return -1;
+            }
+            client->input = input;
+            client->inputCapacity = capacity;
+        }
+
+        ssize_t received = read(client->fd, client->input + client->inputUsed, client->inputCapacity - client->inputUsed);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            printf("Error: Connection to server lost\n");
+            return -1;
+        }
+        client->inputUsed += (size_t)received;
+    }
+}
+
+// Sends one request and waits for its response; -1 unless the status is SERVER_STATUS_OK
+static int roundTrip(GarageClient* client, int op, const void* payload, unsigned int length, GarageResponse* response) {
+    if (client == NULL) {
+        printf("Error: Client pointer is NULL\n");
+        return -1;
+    }
+
+    unsigned int id = client->nextId++;
+    if (sendGarageRequest(client, id, op, payload, length) != 0 || receiveGarageResponse(client, response) != 0) {
+        return -1;
+    }
+    if (response->id != id) {
+        printf("Error: Response %u does not answer request %u\n", response->id, id);
+        return -1;
+    }
+    if (response->status != SERVER_STATUS_OK) {
+        printf("Error: Server refused request (status %d)\n", response->status);
+        return -1;
+    }
+    return 0;
+}
+
+static unsigned int textLength(const char* text) {
+    size_t length = strlen(text);
+    return length > 0xFFFF ? 0xFFFF : (unsigned int)length;
+}
+
+int garageClientAdd(GarageClient* client, unsigned int value, unsigned int year, const char* description) {
+    GarageResponse response;
+
+    if (description == NULL) {
+        printf("Error: Description pointer is NULL\n");
+        return -1;
+    }
+
+    unsigned int length = textLength(description);
+    unsigned char* payload = (unsigned char*)malloc(10 + length);
+    if (payload == NULL) {
+        printf("Error: Memory allocation for request failed\n");
+        return -1;
+    }
+    putU32(payload, value);
+    putU32(payload + 4, year);
+    putU16(payload + 8, length);
+    memcpy(payload + 10, description, length);
+
+    int result = roundTrip(client, SERVER_OP_ADD, payload, 10 + length, &response);
+    free(payload);
+    return result == 0 && response.length == 4 ? (int)getU32(response.payload) : -1;
+}
+
+int garageClientRemove(GarageClient* client, int position) {
+    GarageResponse response;
+    unsigned char payload[4];
+
+    if (position < 0) {
+        printf("Error: Vehicle index %d is out of bounds\n", position);
+        return -1;
+    }
+    putU32(payload, (unsigned int)position);
+    return roundTrip(client, SERVER_OP_REMOVE, payload, sizeof(payload), &response);
+}
+
+int garageClientLookup(GarageClient* client, const char* description, unsigned int* headers, int max) {
+    GarageResponse response;
+
+    if (description == NULL) {
+        printf("Error: Description pointer is NULL\n");
+        return -1;
+    }
+
+    unsigned int length = textLength(description);
+    unsigned char* payload = (unsigned char*)malloc(2 + length);
+    if (payload == NULL) {
+        printf("Error: Memory allocation for request failed\n");
+        return -1;
+    }
+    putU16(payload, length);
+    memcpy(payload + 2, description, length);
+
+    int result = roundTrip(client, SERVER_OP_LOOKUP, payload, 2 + length, &response);
+    free(payload);
+    if (result != 0 || response.length < 8) {
+        return -1;
+    }
+
+    unsigned int stored = getU32(response.payload + 4);
+    for (unsigned int i = 0; i < stored && (int)i < max && headers != NULL; i++) {
+        headers[i] = getU32(response.payload + 8 + 4 * i);
+    }
+    return (int)getU32(response.payload);
+}
+
+int garageClientRange(GarageClient* client, const VehicleQuery* query, int* positions, unsigned int* headers, int max) {
+    GarageResponse response;
+
+    if (query == NULL) {
+        printf("Error: Query pointer is NULL\n");
+        return -1;
+    }
+
+    const char* prefix = query->descriptionPrefix != NULL ? query->descriptionPrefix : "";
+    unsigned int length = textLength(prefix);
+    unsigned char* payload = (unsigned char*)malloc(22 + length);
+    if (payload == NULL) {
+        printf("Error: Memory allocation for request failed\n");
+        return -1;
+    }
+    putU32(payload, query->minYear);
+    putU32(payload + 4, query->maxYear);
+    putU32(payload + 8, query->minValue);
+    putU32(payload + 12, query->maxValue);
+    putU32(payload + 16, max > 0 ? (unsigned int)max : 0);
+    putU16(payload + 20, length);
+    memcpy(payload + 22, prefix, length);
+
+    int result = roundTrip(client, SERVER_OP_RANGE, payload, 22 + length, &response);
+    free(payload);
+    if (result != 0 || response.length < 8) {
+        return -1;
+    }
+
+    const unsigned char* entry = response.payload + 8;
+    unsigned int count = getU32(response.payload + 4);
+    for (unsigned int i = 0; i < count; i++) {
+        if (positions != NULL) {
+            positions[i] = (int)getU32(entry);
+        }
+        if (headers != NULL) {
+            headers[i] = getU32(entry + 4);
+        }
+        entry += 10 + getU16(entry + 8);
+    }
+    return (int)getU32(response.payload);
+}
+
+int garageClientStats(GarageClient* client, unsigned int year, YearAggregate* aggregate) {
+    GarageResponse response;
+    unsigned char payload[4];
+
+    putU32(payload, year);
+    if (roundTrip(client, SERVER_OP_STATS, payload, sizeof(payload), &response) != 0 || response.length != 24) {
+        return -1;
+    }
+    if (aggregate != NULL) {
+        aggregate->count = (long)getU64(response.payload);
+        aggregate->sum = (long long)getU64(response.payload + 8);
+        aggregate->minValue = getU32(response.payload + 16);
+        aggregate->maxValue = getU32(response.payload + 20);
+    }
+    return 0;
+}
+
+int garageClientCount(GarageClient* client) {
+    GarageResponse response;
+
+    if (roundTrip(client, SERVER_OP_COUNT, NULL, 0, &response) != 0 || response.length != 4) {
+        return -1;
+    }
+    return (int)getU32(response.payload);
+}
+
+int garageClientShutdown(GarageClient* client) {
+    GarageResponse response;
+    return roundTrip(client, SERVER_OP_SHUTDOWN, NULL, 0, &response);
+}
+
+#else
+
+// epoll, eventfd and signalfd are Linux only; elsewhere the server reports that it cannot run
+
+GarageServer* startGarageServer(const char* path, char** garage, int numVehicles, int numWorkers) {
+    (void)path; (void)garage; (void)numVehicles; (void)numWorkers;
+    printf("Error: The garage server needs Linux\n");
+    return NULL;
+}
+
+char** stopGarageServer(GarageServer* server, int* numVehicles) {
+    (void)server; (void)numVehicles;
+    return NULL;
+}
+
+char** runGarageServer(const char* path, char** garage, int* numVehicles, int numWorkers) {
+    (void)path; (void)garage; (void)numVehicles; (void)numWorkers;
+    printf("Error: The garage server needs Linux\n");
+    return NULL;
+}
+
+GarageClient* connectGarageServer(const char* path) {
+    (void)path;
+    printf("Error: The garage server needs Linux\n");
+    return NULL;
+}
+
+void closeGarageClient(GarageClient* client) {
+    (void)client;
+}
+
+int sendGarageRequest(GarageClient* client, unsigned int id, int op, const void* payload, unsigned int length) {
+    (void)client; (void)id; (void)op; (void)payload; (void)length;
+    return -1;
+}
+
+int receiveGarageResponse(GarageClient* client, GarageResponse* response) {
+    (void)client; (void)response;
+    return -1;
+}
+
+int garageClientAdd(GarageClient* client, unsigned int value, unsigned int year, const char* description) {
+    (void)client; (void)value; (void)year; (void)description;
+    return -1;
+}
+
+int garageClientRemove(GarageClient* client, int position) {
+    (void)client; (void)position;
+    return -1;
+}
+
+int garageClientLookup(GarageClient* client, const char* description, unsigned int* headers, int max) {
+    (void)client; (void)description; (void)headers; (void)max;
+    return -1;
+}
+
+int garageClientRange(GarageClient* client, const VehicleQuery* query, int* positions, unsigned int* headers, int max) {
+    (void)client; (void)query; (void)positions; (void)headers; (void)max;
+    return -1;
+}
+
+int garageClientStats(GarageClient* client, unsigned int year, YearAggregate* aggregate) {
+    (void)client; (void)year; (void)aggregate;
+    return -1;
+}
+
+int garageClientCount(GarageClient* client) {
+    (void)client;
+    return -1;
+}
+
+int garageClientShutdown(GarageClient* client) {
+    (void)client;
+    return -1;
+}
+
+#endif
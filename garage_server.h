@@ -0,0 +1,120 @@
+/*
+ * Garage Server Header File
+ * Daemon that holds one garage in memory and serves it to local processes over a Unix
+ * domain socket, plus the client side of the protocol.
+ *
+ * Protocol: every message is a frame, all integers little endian.
+ *   request:  u32 length | u32 id | u8 op     | payload    (length counts id, op and payload)
+ *   response: u32 length | u32 id | u8 status | payload
+ * The id is chosen by the client and echoed back, so a client may pipeline any number of
+ * requests before reading; it must read once unanswered responses near SERVER_OUTPUT_LIMIT,
+ * because the server stops reading a connection whose responses are not collected. Requests
+ * on one connection are executed and answered in the order sent.
+ *
+ *   op                 request payload                               response payload
+ *   SERVER_OP_ADD      u32 value, u32 year, u16 n, n bytes           u32 position
+ *   SERVER_OP_REMOVE   u32 position                                  -
+ *   SERVER_OP_LOOKUP   u16 n, n bytes (description)                  u32 matches, u32 count,
+ *                                                                    count x u32 header
+ *   SERVER_OP_RANGE    u32 minYear, maxYear, minValue, maxValue,     u32 matches, u32 count,
+ *                      u32 limit, u16 n, n bytes (prefix)            count x (u32 position,
+ *                                                                    u32 header, u16 n, n bytes)
+ *   SERVER_OP_STATS    u32 year                                      u64 count, u64 sum, u32 min, u32 max
+ *   SERVER_OP_COUNT    -                                             u32 number of vehicles
+ *   SERVER_OP_SHUTDOWN -                                             - (the server then stops)
+ *
+ * One thread runs an epoll loop over the listening socket and every connection; it applies
+ * adds and removes and answers the cheap requests itself. Range queries go to a pool of
+ * worker threads, which read the garage under a shared lock while the loop keeps serving
+ * other connections.
+ */
+
+#ifndef GARAGE_SERVER_H
+#define GARAGE_SERVER_H
+
+#include "garage_query.h"
+#include "garage_stats.h"
+
+#define SERVER_OP_ADD 1
+#define SERVER_OP_REMOVE 2
+#define SERVER_OP_LOOKUP 3
+#define SERVER_OP_RANGE 4
+#define SERVER_OP_STATS 5
+#define SERVER_OP_COUNT 6
+#define SERVER_OP_SHUTDOWN 7
+
+#define SERVER_STATUS_OK 0
+#define SERVER_STATUS_ERROR 1       // Request understood but could not be carried out
+#define SERVER_STATUS_BAD_REQUEST 2 // Unknown op or malformed payload
+
+#define SERVER_MAX_FRAME (1 << 20)          // Largest frame either side accepts
+#define SERVER_OUTPUT_LIMIT (4 << 20)       // Queued response bytes before a connection stops being read
+
+typedef struct GarageServer GarageServer;
+typedef struct GarageClient GarageClient;
+
+typedef struct {
+    unsigned int id;
+    int status;
+    const unsigned char* payload;  // Owned by the client, valid until its next receive
+    unsigned int length;
+} GarageResponse;
+
+/*
+ * Functions: startGarageServer, stopGarageServer
+ * Purpose: Serve a garage from a background thread / stop it and take the garage back.
+ *          The server owns the garage while it runs and keeps its own index and statistics;
+ *          client changes are not reported to garage listeners, so rebuild anything attached
+ *          to the garage from the one stopGarageServer returns.
+ * Parameters: const char* - socket path (an existing socket file is replaced)
+ *             char** - the garage
+ *             int - number of vehicles in the garage
+ *             int - number of worker threads (0 = one per processor)
+ * Returns: startGarageServer - the server, or NULL if it could not start
+ *          stopGarageServer - the garage as left by the clients; *numVehicles receives its size
+ */
+GarageServer* startGarageServer(const char*, char**, int, int);
+char** stopGarageServer(GarageServer*, int*);
+
+/*
+ * Function: runGarageServer
+ * Purpose: Serves a garage on the calling thread until a SERVER_OP_SHUTDOWN request,
+ *          SIGINT or SIGTERM.
+ * Returns: the garage as left by the clients (*numVehicles receives its size), or NULL if
+ *          the server could not start
+ */
+char** runGarageServer(const char*, char**, int*, int);
+
+/*
+ * Functions: connectGarageServer, closeGarageClient
+ * Purpose: Open / close a client connection.
+ */
+GarageClient* connectGarageServer(const char*);
+void closeGarageClient(GarageClient*);
+
+/*
+ * Functions: sendGarageRequest, receiveGarageResponse
+ * Purpose: Pipelined access: send frames, then read the responses in order.
+ * Returns: 0 on success, -1 if the connection failed
+ */
+int sendGarageRequest(GarageClient*, unsigned int, int, const void*, unsigned int);
+int receiveGarageResponse(GarageClient*, GarageResponse*);
+
+/*
+ * Functions: garageClientAdd, garageClientRemove, garageClientLookup, garageClientRange,
+ *            garageClientStats, garageClientCount, garageClientShutdown
+ * Purpose: One request and its response.
+ * Returns: garageClientAdd - position of the new vehicle; garageClientLookup - number of
+ *          vehicles with the description (up to max headers stored); garageClientRange -
+ *          number of matches (up to max positions and headers stored); garageClientCount -
+ *          number of vehicles; the others 0. All return -1 on error.
+ */
+int garageClientAdd(GarageClient*, unsigned int, unsigned int, const char*);
+int garageClientRemove(GarageClient*, int);
+int garageClientLookup(GarageClient*, const char*, unsigned int*, int);
+int garageClientRange(GarageClient*, const VehicleQuery*, int*, unsigned int*, int);
+int garageClientStats(GarageClient*, unsigned int, YearAggregate*);
+int garageClientCount(GarageClient*);
+int garageClientShutdown(GarageClient*);
+
+#endif /* GARAGE_SERVER_H */
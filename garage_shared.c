@@ -0,0 +1,527 @@
+/*
+ * Garage Shared Memory
+ * Immutable per-generation segments and a sequence-locked control segment.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vehicle.h"
+#include "byte_io.h"
+#include "garage_shared.h"
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sched.h>
+    #include <stdatomic.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+#define SHARED_NAME_LENGTH 64  // Longest name accepted, without the leading '/' and generation
+
+#ifndef _WIN32
+
+// The control segment: which generation is current, published under a sequence lock
+typedef struct {
+    char magic[4];                    // "GSHC"
+    unsigned int version;
+    unsigned int valueBits;
+    unsigned int yearBase;
+    atomic_uint sequence;             // Odd while the writer changes the fields below
+    atomic_ullong generation;         // 0 until the first publish
+    atomic_ullong dataSize;
+    atomic_int numVehicles;
+} SharedControl;
+
+// Start of every generation segment
+typedef struct {
+    char magic[4];                    // "GSHD"
+    unsigned int version;
+    unsigned int valueBits;
+    unsigned int yearBase;
+    unsigned long long generation;
+    long long numVehicles;
+    unsigned long long headersOffset; // unsigned int[numVehicles]
+    unsigned long long offsetsOffset; // unsigned long long[numVehicles], relative to recordsOffset
+    unsigned long long recordsOffset; // v1 records, each starting on a 4-byte boundary
+    unsigned long long size;          // Whole segment
+} SharedData;
+
+struct SharedGarageWriter {
+    char name[SHARED_NAME_LENGTH + 2];
+    int controlFd;
+    SharedControl* control;
+    unsigned long long generation;
+};
+
+struct SharedGarageReader {
+    char name[SHARED_NAME_LENGTH + 2];
+    int controlFd;
+    const SharedControl* control;
+    const SharedData* data;           // The mapped generation
+    size_t dataSize;
+    char** vehicles;                  // Pointers into the mapping
+    int numVehicles;
+};
+
+// "/name" for the control segment; validates the name
+static int controlName(const char* name, char* path) {
+    size_t length = name != NULL ? strlen(name) : 0;
+
+    if (length == 0 || length > SHARED_NAME_LENGTH) {
+        printf("Error: Shared garage name must be 1 to %d characters\n", SHARED_NAME_LENGTH);
+        return -1;
+    }
+    for (size_t i = 0; i < length; i++) {
+        char c = name[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-')) {
+            printf("Error: Shared garage name may only use letters, digits, '_' and '-'\n");
+            return -1;
+        }
+    }
+    path[0] = '/';
+    strcpy(path + 1, name);
+    return 0;
+}
+
+static void generationName(const char* control, unsigned long long generation, char* path) {
+    sprintf(path, "%s.%llu", control, generation);
+}
+
+static int layoutMatches(unsigned int version, unsigned int valueBits, unsigned int yearBase) {
+    return version == SHARED_GARAGE_VERSION && valueBits == VEHICLE_VALUE_BITS && yearBase == VEHICLE_YEAR_BASE;
+}
+
+SharedGarageWriter* createSharedGarageWriter(const char* name) {
+    SharedGarageWriter* writer = (SharedGarageWriter*)calloc(1, sizeof(SharedGarageWriter));
+    struct stat status;
+
+    if (writer == NULL) {
+        printf("Error: Memory allocation for shared garage writer failed\n");
+        return NULL;
+    }
+    if (controlName(name, writer->name) != 0) {
+        free(writer);
+        return NULL;
+    }
+
+    writer->controlFd = shm_open(writer->name, O_RDWR | O_CREAT, 0644);
+    if (writer->controlFd < 0 || fstat(writer->controlFd, &status) != 0) {
+        printf("Error: Cannot create shared memory segment %s\n", writer->name);
+        if (writer->controlFd >= 0) {
+            close(writer->controlFd);
+        }
+        free(writer);
+        return NULL;
+    }
+
+    // A control segment left by an earlier writer is reused, so its readers keep working
+    int reuse = (size_t)status.st_size == sizeof(SharedControl);
+    if (!reuse && ftruncate(writer->controlFd, sizeof(SharedControl)) != 0) {
+        printf("Error: Cannot size shared memory segment %s\n", writer->name);
+        close(writer->controlFd);
+        free(writer);
+        return NULL;
+    }
+
+    void* mapping = mmap(NULL, sizeof(SharedControl), PROT_READ | PROT_WRITE, MAP_SHARED, writer->controlFd, 0);
+    if (mapping == MAP_FAILED) {
+        printf("Error: Cannot map shared memory segment %s\n", writer->name);
+        close(writer->controlFd);
+        free(writer);
+        return NULL;
+    }
+    writer->control = (SharedControl*)mapping;
+
+    SharedControl* control = writer->control;
+    if (reuse && memcmp(control->magic, "GSHC", 4) == 0 &&
+        layoutMatches(control->version, control->valueBits, control->yearBase)) {
+        writer->generation = atomic_load(&control->generation);
+    } else {
+        memset(control, 0, sizeof(SharedControl));
+        control->version = SHARED_GARAGE_VERSION;
+        control->valueBits = VEHICLE_VALUE_BITS;
+        control->yearBase = VEHICLE_YEAR_BASE;
+        atomic_store(&control->sequence, 0);
+        atomic_store(&control->generation, 0);
+        atomic_store(&control->dataSize, 0);
+        atomic_store(&control->numVehicles, 0);
+        atomic_thread_fence(memory_order_release);
+        memcpy(control->magic, "GSHC", 4);
+    }
+    return writer;
+}
+
+long publishSharedGarage(SharedGarageWriter* writer, char** garage, int numVehicles) {
+    char path[SHARED_NAME_LENGTH + 32];
+
+    if (writer == NULL) {
+        printf("Error: Shared garage writer is NULL\n");
+        return -1;
+    }
+    if (numVehicles < 0 || (garage == NULL && numVehicles > 0)) {
+        printf("Error: Garage pointer is NULL\n");
+        return -1;
+    }
+
+    // Size the segment: header, header column, offsets, then the records
+    long long count = 0;
+    size_t recordBytes = 0;
+    for (int i = 0; i < numVehicles; i++) {
+        if (garage[i] != NULL) {
+            recordBytes += alignUp(4 + vehicleDescriptionLength(garage[i]) + 1, 4);
+            count++;
+        }
+    }
+    size_t headersOffset = alignUp(sizeof(SharedData), 64);
+    size_t offsetsOffset = alignUp(headersOffset + count * sizeof(unsigned int), 8);
+    size_t recordsOffset = alignUp(offsetsOffset + count * sizeof(unsigned long long), 64);
+    size_t size = recordsOffset + recordBytes + 1;  // Trailing NUL bounds every description
+
+    unsigned long long generation = writer->generation + 1;
+    generationName(writer->name, generation, path);
+    shm_unlink(path);  // Left over from a writer that stopped halfway
+    int fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        printf("Error: Cannot create shared memory segment %s\n", path);
+        return -1;
+    }
+    void* mapping = ftruncate(fd, (off_t)size) == 0 ?
+                    mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        printf("Error: Cannot map shared memory segment %s (%zu bytes)\n", path, size);
+        shm_unlink(path);
+        return -1;
+    }
+
+    char* base = (char*)mapping;
+    SharedData* data = (SharedData*)base;
+    unsigned int* headers = (unsigned int*)(base + headersOffset);
+    unsigned long long* offsets = (unsigned long long*)(base + offsetsOffset);
+    char* records = base + recordsOffset;
+    size_t offset = 0;
+    long long slot = 0;
+
+    for (int i = 0; i < numVehicles; i++) {
+        const char* vehicle = garage[i];
+        if (vehicle == NULL) {
+            continue;
+        }
+
+        // Always written in format v1: the big endian header followed by the description
+        unsigned int header = vehicleHeader(vehicle);
+        unsigned int length = vehicleDescriptionLength(vehicle);
+        headers[slot] = header;
+        offsets[slot] = offset;
+        offset += alignUp(encodeVehicleRecord(records + offset, header, vehicleDescription(vehicle), length), 4);
+        slot++;
+    }
+
+    memcpy(data->magic, "GSHD", 4);
+    data->version = SHARED_GARAGE_VERSION;
+    data->valueBits = VEHICLE_VALUE_BITS;
+    data->yearBase = VEHICLE_YEAR_BASE;
+    data->generation = generation;
+    data->numVehicles = count;
+    data->headersOffset = headersOffset;
+    data->offsetsOffset = offsetsOffset;
+    data->recordsOffset = recordsOffset;
+    data->size = size;
+    munmap(mapping, size);
+
+    // Swap: readers retry while the sequence is odd or changed under them
+    SharedControl* control = writer->control;
+    unsigned int sequence = atomic_load_explicit(&control->sequence, memory_order_relaxed);
+    atomic_store_explicit(&control->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&control->generation, generation, memory_order_relaxed);
+    atomic_store_explicit(&control->dataSize, size, memory_order_relaxed);
+    atomic_store_explicit(&control->numVehicles, (int)count, memory_order_relaxed);
+    atomic_store_explicit(&control->sequence, sequence + 2, memory_order_release);
+
+    // Readers mapping the old generation keep it; only its name goes away
+    if (writer->generation > 0) {
+        generationName(writer->name, writer->generation, path);
+        shm_unlink(path);
+    }
+    writer->generation = generation;
+    return (long)generation;
+}
+
+void closeSharedGarageWriter(SharedGarageWriter* writer) {
+    char path[SHARED_NAME_LENGTH + 32];
+
+    if (writer == NULL) {
+        return;
+    }
+    if (writer->generation > 0) {
+        generationName(writer->name, writer->generation, path);
+        shm_unlink(path);
+    }
+    munmap(writer->control, sizeof(SharedControl));
+    close(writer->controlFd);
+    shm_unlink(writer->name);
+    free(writer);
+}
+
+// Consistent read of the current generation number (0 if none is published)
+static unsigned long long currentGeneration(const SharedControl* control) {
+    for (;;) {
+        unsigned int before = atomic_load_explicit(&control->sequence, memory_order_acquire);
+        if (before & 1u) {
+            sched_yield();
+            continue;
+        }
+        unsigned long long generation = atomic_load_explicit(&control->generation, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&control->sequence, memory_order_relaxed) == before) {
+            return generation;
+        }
+    }
+}
+
+// Maps one generation and checks it. Returns 0, or -1 if it is gone or not usable.
+static int mapGeneration(SharedGarageReader* reader, unsigned long long generation,
+                         const SharedData** data, size_t* size, char*** vehicles) {
+    char path[SHARED_NAME_LENGTH + 32];
+    struct stat status;
+
+    generationName(reader->name, generation, path);
+    int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0) {
+        return -1;  // Already replaced; the caller looks again
+    }
+    if (fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(SharedData)) {
+        close(fd);
+        return -1;
+    }
+    *size = (size_t)status.st_size;
+    void* mapping = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return -1;
+    }
+
+    const char* base = (const char*)mapping;
+    const SharedData* header = (const SharedData*)base;
+    unsigned long long count = (unsigned long long)header->numVehicles;
+    int valid = memcmp(header->magic, "GSHD", 4) == 0 && header->generation == generation &&
+                layoutMatches(header->version, header->valueBits, header->yearBase) &&
+                header->size == *size && header->numVehicles >= 0 && count <= 0x7FFFFFFFull &&
+                header->headersOffset + count * sizeof(unsigned int) <= header->offsetsOffset &&
+                header->offsetsOffset + count * sizeof(unsigned long long) <= header->recordsOffset &&
+                header->recordsOffset < *size && base[*size - 1] == '\0';
+    if (!valid) {
+        munmap(mapping, *size);
+        return -1;
+    }
+
+    // The garage itself is just pointers into the mapping
+    char** garage = (char**)malloc((count > 0 ? count : 1) * sizeof(char*));
+    const unsigned long long* offsets = (const unsigned long long*)(base + header->offsetsOffset);
+    unsigned long long recordSpace = *size - header->recordsOffset;
+    for (unsigned long long i = 0; garage != NULL && i < count; i++) {
+        // Room for a header and a terminator after the offset, and not the reserved v2 prefix
+        if (offsets[i] >= recordSpace || recordSpace - offsets[i] < 5 ||
+            isReservedVehicleRecord(base + header->recordsOffset + offsets[i])) {
+            free(garage);
+            garage = NULL;
+            break;
+        }
+        garage[i] = (char*)(base + header->recordsOffset + offsets[i]);
+    }
+    if (garage == NULL) {
+        munmap(mapping, *size);
+        return -1;
+    }
+
+    *data = header;
+    *vehicles = garage;
+    return 0;
+}
+
+// Maps the newest generation; loops while the writer replaces generations under us
+static int mapCurrent(SharedGarageReader* reader, const SharedData** data, size_t* size, char*** vehicles) {
+    for (int attempt = 0; attempt < SHARED_GARAGE_OPEN_ATTEMPTS; attempt++) {
+        unsigned long long generation = currentGeneration(reader->control);
+        if (generation == 0) {
+            printf("Error: Nothing has been published to %s yet\n", reader->name);
+            return -1;
+        }
+        if (mapGeneration(reader, generation, data, size, vehicles) == 0) {
+            return 0;
+        }
+        if (currentGeneration(reader->control) == generation) {
+            printf("Error: Shared garage %s generation %llu cannot be read\n", reader->name, generation);
+            return -1;
+        }
+    }
+    printf("Error: Shared garage %s changes too fast to open\n", reader->name);
+    return -1;
+}
+
+SharedGarageReader* openSharedGarage(const char* name) {
+    SharedGarageReader* reader = (SharedGarageReader*)calloc(1, sizeof(SharedGarageReader));
+    struct stat status;
+
+    if (reader == NULL) {
+        printf("Error: Memory allocation for shared garage reader failed\n");
+        return NULL;
+    }
+    if (controlName(name, reader->name) != 0) {
+        free(reader);
+        return NULL;
+    }
+
+    reader->controlFd = shm_open(reader->name, O_RDONLY, 0);
+    if (reader->controlFd < 0 || fstat(reader->controlFd, &status) != 0 ||
+        (size_t)status.st_size != sizeof(SharedControl)) {
+        printf("Error: No shared garage named %s\n", name);
+        if (reader->controlFd >= 0) {
+            close(reader->controlFd);
+        }
+        free(reader);
+        return NULL;
+    }
+
+    void* mapping = mmap(NULL, sizeof(SharedControl), PROT_READ, MAP_SHARED, reader->controlFd, 0);
+    if (mapping == MAP_FAILED) {
+        printf("Error: Cannot map shared memory segment %s\n", reader->name);
+        close(reader->controlFd);
+        free(reader);
+        return NULL;
+    }
+    reader->control = (const SharedControl*)mapping;
+
+    if (memcmp(reader->control->magic, "GSHC", 4) != 0 ||
+        !layoutMatches(reader->control->version, reader->control->valueBits, reader->control->yearBase)) {
+        printf("Error: Shared garage %s uses a different format or header layout\n", name);
+        closeSharedGarage(reader);
+        return NULL;
+    }
+    if (mapCurrent(reader, &reader->data, &reader->dataSize, &reader->vehicles) != 0) {
+        closeSharedGarage(reader);
+        return NULL;
+    }
+    reader->numVehicles = (int)reader->data->numVehicles;
+    return reader;
+}
+
+int refreshSharedGarage(SharedGarageReader* reader) {
+    const SharedData* data;
+    size_t size;
+    char** vehicles;
+
+    if (reader == NULL) {
+        printf("Error: Shared garage reader is NULL\n");
+        return -1;
+    }
+    if (currentGeneration(reader->control) == reader->data->generation) {
+        return 0;
+    }
+    if (mapCurrent(reader, &data, &size, &vehicles) != 0) {
+        return -1;
+    }
+
+    munmap((void*)reader->data, reader->dataSize);
+    free(reader->vehicles);
+    reader->data = data;
+    reader->dataSize = size;
+    reader->vehicles = vehicles;
+    reader->numVehicles = (int)data->numVehicles;
+    return 1;
+}
+
+char** sharedGarageVehicles(const SharedGarageReader* reader, int* numVehicles) {
+    if (reader == NULL) {
+        printf("Error: Shared garage reader is NULL\n");
+        return NULL;
+    }
+    if (numVehicles != NULL) {
+        *numVehicles = reader->numVehicles;
+    }
+    return reader->vehicles;
+}
+
+const unsigned int* sharedGarageHeaders(const SharedGarageReader* reader) {
+    if (reader == NULL) {
+        printf("Error: Shared garage reader is NULL\n");
+        return NULL;
+    }
+    return (const unsigned int*)((const char*)reader->data + reader->data->headersOffset);
+}
+
+long sharedGarageGeneration(const SharedGarageReader* reader) {
+    return reader != NULL ? (long)reader->data->generation : -1;
+}
+
+void closeSharedGarage(SharedGarageReader* reader) {
+    if (reader == NULL) {
+        return;
+    }
+    if (reader->data != NULL) {
+        munmap((void*)reader->data, reader->dataSize);
+    }
+    free(reader->vehicles);
+    munmap((void*)reader->control, sizeof(SharedControl));
+    close(reader->controlFd);
+    free(reader);
+}
+
+#else
+
+// POSIX shared memory is not available; every call reports that
+
+SharedGarageWriter* createSharedGarageWriter(const char* name) {
+    (void)name;
+    printf("Error: Shared garages need POSIX shared memory\n");
+    return NULL;
+}
+
+long publishSharedGarage(SharedGarageWriter* writer, char** garage, int numVehicles) {
+    (void)writer; (void)garage; (void)numVehicles;
+    return -1;
+}
+
+void closeSharedGarageWriter(SharedGarageWriter* writer) {
+    (void)writer;
+}
+
+SharedGarageReader* openSharedGarage(const char* name) {
+    (void)name;
+    printf("Error: Shared garages need POSIX shared memory\n");
+    return NULL;
+}
+
+int refreshSharedGarage(SharedGarageReader* reader) {
+    (void)reader;
+    return -1;
+}
+
+char** sharedGarageVehicles(const SharedGarageReader* reader, int* numVehicles) {
+    (void)reader; (void)numVehicles;
+    return NULL;
+}
+
+const unsigned int* sharedGarageHeaders(const SharedGarageReader* reader) {
+    (void)reader;
+    return NULL;
+}
+
+long sharedGarageGeneration(const SharedGarageReader* reader) {
+    (void)reader;
+    return -1;
+}
+
+void closeSharedGarage(SharedGarageReader* reader) {
+    (void)reader;
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * Garage Shared Memory Header File
+ * Publishes a garage into POSIX shared memory so other processes can read it in place.
+ *
+ * Every publish writes a complete, immutable generation into its own segment
+ * ("/<name>.<generation>"): a versioned header, the dense column of packed headers, the
+ * offset of every record, and the records themselves in format v1. A small control
+ * segment ("/<name>") names the current generation behind a sequence lock. Readers map a
+ * generation read-only and get an ordinary garage of pointers into the mapping, so
+ * displayVehicle, queryGarage and the other garage code run on it without copying.
+ *
+ * Publishing never touches a generation a reader may have mapped: the writer builds the new
+ * segment, swaps the generation number in the control segment, and unlinks the old name.
+ * Readers that still map the old generation keep a valid view until they refresh.
+ */
+
+#ifndef GARAGE_SHARED_H
+#define GARAGE_SHARED_H
+
+#define SHARED_GARAGE_VERSION 1          // Bumped when the segment format changes
+#define SHARED_GARAGE_OPEN_ATTEMPTS 1000 // Tries to catch a generation before the writer replaces it
+
+typedef struct SharedGarageWriter SharedGarageWriter;
+typedef struct SharedGarageReader SharedGarageReader;
+
+/*
+ * Function: createSharedGarageWriter
+ * Purpose: Creates (or takes over) the control segment for a shared garage name.
+ * Parameters: const char* - name of the shared garage (letters, digits, '_' and '-')
+ * Returns: the writer, or NULL on error
+ */
+SharedGarageWriter* createSharedGarageWriter(const char*);
+
+/*
+ * Function: publishSharedGarage
+ * Purpose: Publishes the current contents of a garage as a new generation. NULL slots are
+ *          skipped. Readers see either the old or the new generation, never a mix.
+ * Parameters: SharedGarageWriter* - the writer
+ *             char** - pointer to the garage (may be NULL for an empty garage)
+ *             int - number of vehicles in the garage
+ * Returns: the new generation number, or -1 on error (the previous generation stays current)
+ */
+long publishSharedGarage(SharedGarageWriter*, char**, int);
+
+/*
+ * Function: closeSharedGarageWriter
+ * Purpose: Removes the shared garage names and frees the writer. Readers keep their mappings.
+ */
+void closeSharedGarageWriter(SharedGarageWriter*);
+
+/*
+ * Function: openSharedGarage
+ * Purpose: Maps the current generation of a shared garage read-only.
+ * Returns: the reader, or NULL if nothing is published or the format does not match
+ */
+SharedGarageReader* openSharedGarage(const char*);
+
+/*
+ * Function: refreshSharedGarage
+ * Purpose: Moves a reader to the newest generation. Pointers from the previous generation
+ *          become invalid once this returns 1.
+ * Returns: 1 if the reader moved, 0 if it was already current, -1 on error (view unchanged)
+ */
+int refreshSharedGarage(SharedGarageReader*);
+
+/*
+ * Functions: sharedGarageVehicles, sharedGarageHeaders, sharedGarageGeneration
+ * Purpose: The mapped garage (vehicles are read-only) and its size / its column of packed
+ *          headers, in garage order / the generation being viewed.
+ */
+char** sharedGarageVehicles(const SharedGarageReader*, int*);
+const unsigned int* sharedGarageHeaders(const SharedGarageReader*);
+long sharedGarageGeneration(const SharedGarageReader*);
+
+/*
+ * Function: closeSharedGarage
+ * Purpose: Unmaps the view and frees the reader.
+ */
+void closeSharedGarage(SharedGarageReader*);
+
+#endif /* GARAGE_SHARED_H */
@@ -0,0 +1,189 @@
+/*
+ * Garage Sketch
+ * Log-linear value buckets for approximate percentiles.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "vehicle.h"
+#include "parallel.h"
+#include "garage_scan.h"
+#include "garage_sketch.h"
+
+struct ValueSketch {
+    long total;
+    long counts[SKETCH_NUM_BUCKETS];
+};
+
+// Position of the highest set bit (value > 0)
+static int highestBit(unsigned int value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 31 - __builtin_clz(value);
+#else
+    int bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// Values keep their top SKETCH_SUB_BUCKET_BITS + 1 bits; smaller values map to themselves
+static int bucketOf(unsigned int value) {
+    int shift = value < SKETCH_SUB_BUCKETS ? 0 : highestBit(value) - SKETCH_SUB_BUCKET_BITS;
+    return (shift << SKETCH_SUB_BUCKET_BITS) + (int)(value >> shift);
+}
+
+// Midpoint of the values that share a bucket
+static unsigned int bucketMidpoint(int bucket) {
+    int shift = bucket < 2 * SKETCH_SUB_BUCKETS ? 0 : (bucket >> SKETCH_SUB_BUCKET_BITS) - 1;
+    unsigned int lowest = (unsigned int)(bucket - (shift << SKETCH_SUB_BUCKET_BITS)) << shift;
+    return lowest + ((1u << shift) - 1) / 2;
+}
+
+ValueSketch* createValueSketch() {
+    ValueSketch* sketch = (ValueSketch*)calloc(1, sizeof(ValueSketch));
+    if (sketch == NULL) {
+        printf("Error: Memory allocation for value sketch failed\n");
+    }
+    return sketch;
+}
+
+void freeValueSketch(ValueSketch* sketch) {
+    free(sketch);
+}
+
+int valueSketchAdd(ValueSketch* sketch, const char* vehicle) {
+    if (sketch == NULL || vehicle == NULL) {
+        return -1;
+    }
+
+    sketch->counts[bucketOf(headerValue(vehicleHeader(vehicle)))]++;
+    sketch->total++;
+    return 0;
+}
+
+int valueSketchRemove(ValueSketch* sketch, const char* vehicle) {
+    if (sketch == NULL || vehicle == NULL) {
+        return -1;
+    }
+
+    int bucket = bucketOf(headerValue(vehicleHeader(vehicle)));
+    if (sketch->counts[bucket] == 0) {
+        printf("Error: Vehicle is not in the value sketch\n");
+        return -1;
+    }
+    sketch->counts[bucket]--;
+    sketch->total--;
+    return 0;
+}
+
+void mergeValueSketch(ValueSketch* target, const ValueSketch* source) {
+    if (target == NULL || source == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < SKETCH_NUM_BUCKETS; i++) {
+        target->counts[i] += source->counts[i];
+    }
+    target->total += source->total;
+}
+
+long valueSketchCount(const ValueSketch* sketch) {
+    return sketch == NULL ? 0 : sketch->total;
+}
+
+unsigned int valueSketchQuantile(const ValueSketch* sketch, double quantile) {
+    if (sketch == NULL || sketch->total == 0) {
+        return 0;
+    }
+
+    quantile = quantile < 0.0 ? 0.0 : quantile > 1.0 ? 1.0 : quantile;
+
+    // Rank of the wanted value, 1 based, the same convention as a sorted array's nearest rank
+    long rank = (long)(quantile * (double)sketch->total);
+    if ((double)rank < quantile * (double)sketch->total) {
+        rank++;
+    }
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    long seen = 0;
+    for (int i = 0; i < SKETCH_NUM_BUCKETS; i++) {
+        seen += sketch->counts[i];
+        if (seen >= rank) {
+            return bucketMidpoint(i);
+        }
+    }
+    return bucketMidpoint(SKETCH_NUM_BUCKETS - 1);
+}
+
+static int sketchSlot(void* context, char* vehicle, int position) {
+    (void)position;
+    if (vehicle != NULL) {
+        valueSketchAdd((ValueSketch*)context, vehicle);
+    }
+    return 0;
+}
+
+typedef struct {
+    char** garage;
+    ValueSketch* sketches;  // One per worker
+} SketchJob;
+
+static void sketchTask(void* context, int begin, int end, int worker) {
+    SketchJob* job = (SketchJob*)context;
+    forEachVehicle(job->garage + begin, end - begin, sketchSlot, &job->sketches[worker]);
+}
+
+ValueSketch* buildValueSketch(char** garage, int numVehicles, int numThreads) {
+    if (garage == NULL) {
+        printf("Error: Garage pointer is NULL\n");
+        return NULL;
+    }
+    if (numThreads <= 0) {
+        numThreads = defaultThreadCount();
+    }
+
+    SketchJob job = {garage, (ValueSketch*)calloc(numThreads, sizeof(ValueSketch))};
+    ValueSketch* sketch = createValueSketch();
+    if (job.sketches == NULL || sketch == NULL) {
+        printf("Error: Memory allocation for value sketch failed\n");
+        free(job.sketches);
+        freeValueSketch(sketch);
+        return NULL;
+    }
+
+    int workers = parallelFor(numVehicles, numThreads, sketchTask, &job);
+    for (int i = 0; i < workers; i++) {
+        mergeValueSketch(sketch, &job.sketches[i]);
+    }
+
+    free(job.sketches);
+    return sketch;
+}
+
+static void onGarageEvent(void* context, const GarageEvent* event) {
+    ValueSketch* sketch = (ValueSketch*)context;
+
+    if (event->type == GARAGE_EVENT_INSERT) {
+        valueSketchAdd(sketch, event->vehicle);
+    } else if (event->type == GARAGE_EVENT_REMOVE) {
+        valueSketchRemove(sketch, event->vehicle);
+    } else if (event->type == GARAGE_EVENT_UPDATE) {
+        int before = bucketOf(headerValue(event->previousHeader));
+        if (sketch->counts[before] > 0) {
+            sketch->counts[before]--;
+            sketch->counts[bucketOf(headerValue(vehicleHeader(event->vehicle)))]++;
+        }
+    }
+}
+
+int attachValueSketch(ValueSketch* sketch, GarageListeners* listeners) {
+    return addGarageListener(listeners, onGarageEvent, sketch);
+}
+
+void detachValueSketch(ValueSketch* sketch, GarageListeners* listeners) {
+    removeGarageListener(listeners, onGarageEvent, sketch);
+}
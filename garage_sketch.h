@@ -0,0 +1,78 @@
+/*
+ * Garage Sketch Header File
+ * Mergeable value-distribution sketch for approximate percentiles (p50 / p90 / p99 ...).
+ *
+ * Log-linear buckets in the style of HDR histograms: values below 2^SKETCH_SUB_BUCKET_BITS
+ * get a bucket each, larger values share a bucket with the values that agree on their top
+ * SKETCH_SUB_BUCKET_BITS + 1 bits. A bucket covers at most 1/2^SKETCH_SUB_BUCKET_BITS of its
+ * lowest value and a quantile is reported as the bucket midpoint, so the relative error is
+ * at most 1/2^(SKETCH_SUB_BUCKET_BITS + 1) (0.4% with 7 bits). Memory is a fixed
+ * SKETCH_NUM_BUCKETS counters whatever the garage size. Adding and removing a vehicle are
+ * O(1) and exact, and two sketches merge by adding their counters.
+ */
+
+#ifndef GARAGE_SKETCH_H
+#define GARAGE_SKETCH_H
+
+#include "vehicle.h"
+
+#define SKETCH_SUB_BUCKET_BITS 7
+#define SKETCH_SUB_BUCKETS (1 << SKETCH_SUB_BUCKET_BITS)
+#define SKETCH_NUM_BUCKETS ((VEHICLE_VALUE_BITS - SKETCH_SUB_BUCKET_BITS + 1) * SKETCH_SUB_BUCKETS)
+
+typedef struct ValueSketch ValueSketch;
+
+/*
+ * Functions: createValueSketch, freeValueSketch
+ * Purpose: Create an empty sketch / free a sketch.
+ */
+ValueSketch* createValueSketch();
+void freeValueSketch(ValueSketch*);
+
+/*
+ * Function: buildValueSketch
+ * Purpose: Sketch of the values in a garage. Threads each sketch part of the garage and
+ *          the partial sketches are merged.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ *             int - number of threads (0 = one per processor)
+ * Returns: the sketch, or NULL if allocation failed
+ */
+ValueSketch* buildValueSketch(char**, int, int);
+
+/*
+ * Functions: valueSketchAdd, valueSketchRemove
+ * Purpose: Account for a vehicle entering or leaving the garage.
+ * Returns: 0 on success, -1 on error (removing from an empty bucket is an error)
+ */
+int valueSketchAdd(ValueSketch*, const char*);
+int valueSketchRemove(ValueSketch*, const char*);
+
+/*
+ * Function: mergeValueSketch
+ * Purpose: target += source, e.g. to combine the sketches of garage shards.
+ */
+void mergeValueSketch(ValueSketch*, const ValueSketch*);
+
+/*
+ * Function: valueSketchCount
+ * Purpose: Number of values in the sketch.
+ */
+long valueSketchCount(const ValueSketch*);
+
+/*
+ * Function: valueSketchQuantile
+ * Purpose: Approximate value at quantile q (0.5 = median, 0.99 = p99) within the error above.
+ * Returns: the value, or 0 if the sketch is empty
+ */
+unsigned int valueSketchQuantile(const ValueSketch*, double);
+
+/*
+ * Functions: attachValueSketch, detachValueSketch
+ * Purpose: Keep the sketch in sync with garage events of one listener list (see addGarageListener).
+ *          Pass the same list to both: the garage's own list, or NULL for plain garages.
+ */
+int attachValueSketch(ValueSketch*, GarageListeners*);
+void detachValueSketch(ValueSketch*, GarageListeners*);
+
+#endif /* GARAGE_SKETCH_H */
@@ -0,0 +1,727 @@
+/*
+ * Garage Snapshot
+ * Persistent counted B+ tree of vehicle pointers with reference counted, path copied nodes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "vehicle.h"
+#include "garage_snapshot.h"
+
+#define SNAPSHOT_MERGE_BELOW (SNAPSHOT_NODE_SIZE / 4)  // A node this small merges with a neighbour
+#define SNAPSHOT_MAX_SPARES 64                        // Nodes reserved before a change
+
+typedef struct SnapshotNode {
+    atomic_int references;  // Parents and snapshots (or the garage) holding this node
+    int leaf;
+    int count;              // Entries used
+    int total;              // Vehicles below this node
+    union {
+        struct SnapshotNode* children[SNAPSHOT_NODE_SIZE];
+        char* vehicles[SNAPSHOT_NODE_SIZE];
+    } entries;
+    int totals[SNAPSHOT_NODE_SIZE];  // Inner nodes: vehicles below each child
+} SnapshotNode;
+
+typedef struct {
+    char* vehicle;
+    long version;           // First version without the vehicle
+} RetiredVehicle;
+
+struct GarageSnapshot {
+    VersionedGarage* garage;
+    SnapshotNode* root;
+    long version;
+    struct GarageSnapshot* previous;
+    struct GarageSnapshot* next;
+};
+
+struct VersionedGarage {
+    pthread_mutex_t lock;
+    SnapshotNode* root;     // Never NULL; an empty leaf when the garage is empty
+    long version;           // Number of changes made so far
+    atomic_long nodes;
+    SnapshotNode* spares[SNAPSHOT_MAX_SPARES];
+    int numSpares;
+    RetiredVehicle* retired;  // In increasing version order
+    int numRetired;
+    int retiredCapacity;
+    GarageSnapshot* snapshots;
+    int openSnapshots;
+    GarageListeners* listeners;  // Hear about this garage only
+};
+
+static SnapshotNode* allocateNode() {
+    SnapshotNode* node = (SnapshotNode*)malloc(sizeof(SnapshotNode));
+    if (node == NULL) {
+        printf("Error: Memory allocation for snapshot node failed\n");
+    }
+    return node;
+}
+
+// A node from the reserve, so a change never fails halfway
+static SnapshotNode* takeNode(VersionedGarage* garage, int leaf) {
+    SnapshotNode* node = garage->spares[--garage->numSpares];
+    atomic_init(&node->references, 1);
+    node->leaf = leaf;
+    node->count = 0;
+    node->total = 0;
+    atomic_fetch_add_explicit(&garage->nodes, 1, memory_order_relaxed);
+    return node;
+}
+
+static void releaseNode(VersionedGarage* garage, SnapshotNode* node) {
+    if (atomic_fetch_sub_explicit(&node->references, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+    if (!node->leaf) {
+        for (int i = 0; i < node->count; i++) {
+            releaseNode(garage, node->entries.children[i]);
+        }
+    }
+    free(node);
+    atomic_fetch_sub_explicit(&garage->nodes, 1, memory_order_relaxed);
+}
+
+static int treeHeight(const SnapshotNode* node) {
+    int height = 1;
+    while (!node->leaf) {
+        node = node->entries.children[0];
+        height++;
+    }
+    return height;
+}
+
+// Enough nodes for the copies and splits (or merges) one change can need
+static int reserveNodes(VersionedGarage* garage) {
+    int needed = 2 * treeHeight(garage->root) + 2;
+
+    if (needed > SNAPSHOT_MAX_SPARES) {
+        printf("Error: Versioned garage is too deep\n");
+        return -1;
+    }
+    while (garage->numSpares < needed) {
+        SnapshotNode* node = allocateNode();
+        if (node == NULL) {
+            return -1;
+        }
+        garage->spares[garage->numSpares++] = node;
+    }
+    return 0;
+}
+
+static void addChildReferences(SnapshotNode* node) {
+    for (int i = 0; i < node->count; i++) {
+        atomic_fetch_add_explicit(&node->entries.children[i]->references, 1, memory_order_relaxed);
+    }
+}
+
+// The node itself if only the current version holds it, otherwise a private copy
+static SnapshotNode* writableNode(VersionedGarage* garage, SnapshotNode* node) {
+    if (atomic_load_explicit(&node->references, memory_order_acquire) == 1) {
+        return node;
+    }
+
+    SnapshotNode* copy = takeNode(garage, node->leaf);
+    copy->count = node->count;
+    copy->total = node->total;
+    memcpy(&copy->entries, &node->entries, sizeof(copy->entries));
+    if (!node->leaf) {
+        memcpy(copy->totals, node->totals, node->count * sizeof(int));
+        addChildReferences(copy);
+    }
+    releaseNode(garage, node);
+    return copy;
+}
+
+static void recount(SnapshotNode* node) {
+    if (node->leaf) {
+        node->total = node->count;
+        return;
+    }
+    node->total = 0;
+    for (int i = 0; i < node->count; i++) {
+        node->total += node->totals[i];
+    }
+}
+
+// Child of an inner node that holds a position; *before receives the vehicles left of it
+static int childFor(const SnapshotNode* node, int position, int inserting, int* before) {
+    int skipped = 0;
+    int i = 0;
+
+    // An insert at a boundary goes to the end of the left child
+    while (i < node->count - 1 &&
+           (inserting ? position > skipped + node->totals[i] : position >= skipped + node->totals[i])) {
+        skipped += node->totals[i];
+        i++;
+    }
+    *before = skipped;
+    return i;
+}
+
+static void insertEntry(SnapshotNode* node, int index, void* entry, int total) {
+    if (node->leaf) {
+        memmove(node->entries.vehicles + index + 1, node->entries.vehicles + index, (node->count - index) * sizeof(char*));
+        node->entries.vehicles[index] = (char*)entry;
+    } else {
+        memmove(node->entries.children + index + 1, node->entries.children + index, (node->count - index) * sizeof(SnapshotNode*));
+        memmove(node->totals + index + 1, node->totals + index, (node->count - index) * sizeof(int));
+        node->entries.children[index] = (SnapshotNode*)entry;
+        node->totals[index] = total;
+    }
+    node->count++;
+}
+
+static void removeEntry(SnapshotNode* node, int index) {
+    if (node->leaf) {
+        memmove(node->entries.vehicles + index, node->entries.vehicles + index + 1, (node->count - index - 1) * sizeof(char*));
+    } else {
+        memmove(node->entries.children + index, node->entries.children + index + 1, (node->count - index - 1) * sizeof(SnapshotNode*));
+        memmove(node->totals + index, node->totals + index + 1, (node->count - index - 1) * sizeof(int));
+    }
+    node->count--;
+}
+
+// Inserts an entry into a writable node, splitting it when full. Returns the new right half, or NULL.
+static SnapshotNode* insertOrSplit(VersionedGarage* garage, SnapshotNode* node, int index, void* entry, int total) {
+    if (node->count < SNAPSHOT_NODE_SIZE) {
+        insertEntry(node, index, entry, total);
+        recount(node);
+        return NULL;
+    }
+
+    int half = SNAPSHOT_NODE_SIZE / 2;
+    SnapshotNode* right = takeNode(garage, node->leaf);
+    if (node->leaf) {
+        memcpy(right->entries.vehicles, node->entries.vehicles + half, half * sizeof(char*));
+    } else {
+        memcpy(right->entries.children, node->entries.children + half, half * sizeof(SnapshotNode*));
+        memcpy(right->totals, node->totals + half, half * sizeof(int));
+    }
+    right->count = half;
+    node->count = half;
+
+    if (index <= half) {
+        insertEntry(node, index, entry, total);
+    } else {
+        insertEntry(right, index - half, entry, total);
+    }
+    recount(node);
+    recount(right);
+    return right;
+}
+
+static SnapshotNode* insertAt(VersionedGarage* garage, SnapshotNode* node, int position, char* vehicle) {
+    if (node->leaf) {
+        return insertOrSplit(garage, node, position, vehicle, 1);
+    }
+
+    int before;
+    int i = childFor(node, position, 1, &before);
+    SnapshotNode* child = writableNode(garage, node->entries.children[i]);
+    node->entries.children[i] = child;
+
+    SnapshotNode* split = insertAt(garage, child, position - before, vehicle);
+    node->totals[i] = child->total;
+    if (split == NULL) {
+        node->total++;
+        return NULL;
+    }
+    return insertOrSplit(garage, node, i + 1, split, split->total);
+}
+
+// Joins a small child with a neighbour when both fit in one node
+static void mergeSmallChild(VersionedGarage* garage, SnapshotNode* node, int i) {
+    if (node->count < 2) {
+        return;
+    }
+    int left = i + 1 < node->count ? i : i - 1;
+    SnapshotNode* right = node->entries.children[left + 1];
+    if (node->entries.children[left]->count + right->count > SNAPSHOT_NODE_SIZE) {
+        return;
+    }
+
+    SnapshotNode* merged = writableNode(garage, node->entries.children[left]);
+    if (merged->leaf) {
+        memcpy(merged->entries.vehicles + merged->count, right->entries.vehicles, right->count * sizeof(char*));
+    } else {
+        memcpy(merged->entries.children + merged->count, right->entries.children, right->count * sizeof(SnapshotNode*));
+        memcpy(merged->totals + merged->count, right->totals, right->count * sizeof(int));
+        addChildReferences(right);
+    }
+    merged->count += right->count;
+    recount(merged);
+
+    node->entries.children[left] = merged;
+    node->totals[left] = merged->total;
+    removeEntry(node, left + 1);
+    releaseNode(garage, right);
+}
+
+static char* removeAt(VersionedGarage* garage, SnapshotNode* node, int position) {
+    if (node->leaf) {
+        char* vehicle = node->entries.vehicles[position];
+        removeEntry(node, position);
+        node->total--;
+        return vehicle;
+    }
+
+    int before;
+    int i = childFor(node, position, 0, &before);
+    SnapshotNode* child = writableNode(garage, node->entries.children[i]);
+    node->entries.children[i] = child;
+
+    char* vehicle = removeAt(garage, child, position - before);
+    node->totals[i]--;
+    node->total--;
+
+    if (child->count == 0) {
+        removeEntry(node, i);
+        releaseNode(garage, child);
+    } else if (child->count < SNAPSHOT_MERGE_BELOW) {
+        mergeSmallChild(garage, node, i);
+    }
+    return vehicle;
+}
+
+static char** slotFor(VersionedGarage* garage, SnapshotNode** link, int position) {
+    SnapshotNode* node = writableNode(garage, *link);
+    *link = node;
+
+    while (!node->leaf) {
+        int before;
+        int i = childFor(node, position, 0, &before);
+        SnapshotNode* child = writableNode(garage, node->entries.children[i]);
+        node->entries.children[i] = child;
+        node = child;
+        position -= before;
+    }
+    return &node->entries.vehicles[position];
+}
+
+static char* lookup(const SnapshotNode* node, int position) {
+    while (!node->leaf) {
+        int before;
+        int i = childFor(node, position, 0, &before);
+        node = node->entries.children[i];
+        position -= before;
+    }
+    return node->entries.vehicles[position];
+}
+
+// Frees retired vehicles that no open snapshot can see. Called with the lock held.
+static void reclaimRetired(VersionedGarage* garage) {
+    long oldest = garage->version;
+    for (GarageSnapshot* snapshot = garage->snapshots; snapshot != NULL; snapshot = snapshot->next) {
+        oldest = snapshot->version < oldest ? snapshot->version : oldest;
+    }
+
+    int freed = 0;
+    while (freed < garage->numRetired && garage->retired[freed].version <= oldest) {
+        freeVehicle(garage->retired[freed].vehicle);
+        freed++;
+    }
+    garage->numRetired -= freed;
+    memmove(garage->retired, garage->retired + freed, garage->numRetired * sizeof(RetiredVehicle));
+}
+
+static int reserveRetired(VersionedGarage* garage) {
+    if (garage->numRetired < garage->retiredCapacity) {
+        return 0;
+    }
+    int capacity = garage->retiredCapacity > 0 ? 2 * garage->retiredCapacity : 64;
+    RetiredVehicle* retired = (RetiredVehicle*)realloc(garage->retired, capacity * sizeof(RetiredVehicle));
+    if (retired == NULL) {
+        printf("Error: Memory allocation for retired vehicles failed\n");
+        return -1;
+    }
+    garage->retired = retired;
+    garage->retiredCapacity = capacity;
+    return 0;
+}
+
+static void retire(VersionedGarage* garage, char* vehicle) {
+    garage->retired[garage->numRetired].vehicle = vehicle;
+    garage->retired[garage->numRetired].version = garage->version;
+    garage->numRetired++;
+    reclaimRetired(garage);
+}
+
+VersionedGarage* createVersionedGarage(char** vehicles, int numVehicles) {
+    if (numVehicles < 0 || (vehicles == NULL && numVehicles > 0)) {
+        printf("Error: Garage pointer is NULL\n");
+        return NULL;
+    }
+
+    VersionedGarage* garage = (VersionedGarage*)calloc(1, sizeof(VersionedGarage));
+    if (garage == NULL) {
+        printf("Error: Memory allocation for versioned garage failed\n");
+        return NULL;
+    }
+    pthread_mutex_init(&garage->lock, NULL);
+    atomic_init(&garage->nodes, 0);
+    garage->listeners = createGarageListeners();
+
+    // Bulk load: full leaves, then full levels above them
+    int count = (numVehicles + SNAPSHOT_NODE_SIZE - 1) / SNAPSHOT_NODE_SIZE;
+    count = count > 0 ? count : 1;
+    SnapshotNode** level = (SnapshotNode**)calloc(count, sizeof(SnapshotNode*));
+    int failed = level == NULL || garage->listeners == NULL;
+
+    for (int i = 0; !failed && i < count; i++) {
+        level[i] = allocateNode();
+        if (level[i] == NULL) {
+            failed = 1;
+            break;
+        }
+        garage->spares[garage->numSpares++] = level[i];
+        level[i] = takeNode(garage, 1);
+        int first = i * SNAPSHOT_NODE_SIZE;
+        int n = numVehicles - first < SNAPSHOT_NODE_SIZE ? numVehicles - first : SNAPSHOT_NODE_SIZE;
+        n = n > 0 ? n : 0;
+        memcpy(level[i]->entries.vehicles, vehicles + first, n * sizeof(char*));
+        level[i]->count = n;
+        recount(level[i]);
+    }
+
+    while (!failed && count > 1) {
+        int parents = (count + SNAPSHOT_NODE_SIZE - 1) / SNAPSHOT_NODE_SIZE;
+        for (int p = 0; p < parents; p++) {
+            SnapshotNode* parent = allocateNode();
+            if (parent == NULL) {
+                // Children already grouped are owned by their parents in level[0 .. p - 1]
+                for (int i = p * SNAPSHOT_NODE_SIZE; i < count; i++) {
+                    releaseNode(garage, level[i]);
+                }
+                count = p;
+                failed = 1;
+                break;
+            }
+            garage->spares[garage->numSpares++] = parent;
+            parent = takeNode(garage, 0);
+            int first = p * SNAPSHOT_NODE_SIZE;
+            for (int i = first; i < count && i < first + SNAPSHOT_NODE_SIZE; i++) {
+                parent->entries.children[parent->count] = level[i];
+                parent->totals[parent->count] = level[i]->total;
+                parent->count++;
+            }
+            recount(parent);
+            level[p] = parent;
+        }
+        if (!failed) {
+            count = parents;
+        }
+    }
+
+    if (failed) {
+        for (int i = 0; level != NULL && i < count; i++) {
+            if (level[i] != NULL) {
+                releaseNode(garage, level[i]);
+            }
+        }
+        free(level);
+        freeGarageListeners(garage->listeners);
+        pthread_mutex_destroy(&garage->lock);
+        free(garage);
+        return NULL;
+    }
+
+    garage->root = level[0];
+    free(level);
+    return garage;
+}
+
+int versionedGarageSize(VersionedGarage* garage) {
+    if (garage == NULL) {
+        return 0;
+    }
+    pthread_mutex_lock(&garage->lock);
+    int size = garage->root->total;
+    pthread_mutex_unlock(&garage->lock);
+    return size;
+}
+
+char* versionedGarageVehicle(VersionedGarage* garage, int position) {
+    char* vehicle = NULL;
+
+    if (garage == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&garage->lock);
+    if (position >= 0 && position < garage->root->total) {
+        vehicle = lookup(garage->root, position);
+    }
+    pthread_mutex_unlock(&garage->lock);
+    return vehicle;
+}
+
+// Inserts before a position, or at the end when append is set
+static int insertVehicle(VersionedGarage* garage, int position, int append, char* vehicle) {
+    if (garage == NULL || vehicle == NULL) {
+        printf("Error: Garage or vehicle pointer is NULL\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&garage->lock);
+    position = append ? garage->root->total : position;
+    if (position < 0 || position > garage->root->total) {
+        printf("Error: Vehicle index %d is out of bounds\n", position);
+        pthread_mutex_unlock(&garage->lock);
+        return -1;
+    }
+    if (reserveNodes(garage) != 0) {
+        pthread_mutex_unlock(&garage->lock);
+        return -1;
+    }
+
+    garage->root = writableNode(garage, garage->root);
+    SnapshotNode* split = insertAt(garage, garage->root, position, vehicle);
+    if (split != NULL) {
+        SnapshotNode* root = takeNode(garage, 0);
+        insertEntry(root, 0, garage->root, garage->root->total);
+        insertEntry(root, 1, split, split->total);
+        recount(root);
+        garage->root = root;
+    }
+    garage->version++;
+    notifyGarageListeners(garage->listeners, GARAGE_EVENT_INSERT, vehicle, position);
+    pthread_mutex_unlock(&garage->lock);
+    return 0;
+}
+
+int versionedGarageInsert(VersionedGarage* garage, int position, char* vehicle) {
+    return insertVehicle(garage, position, 0, vehicle);
+}
+
+int versionedGarageAppend(VersionedGarage* garage, char* vehicle) {
+    return insertVehicle(garage, 0, 1, vehicle);
+}
+
+int versionedGarageRemove(VersionedGarage* garage, int position) {
+    if (garage == NULL) {
+        printf("Error: Garage pointer is NULL\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&garage->lock);
+    if (position < 0 || position >= garage->root->total) {
+        printf("Error: Vehicle index %d is out of bounds\n", position);
+        pthread_mutex_unlock(&garage->lock);
+        return -1;
+    }
+    if (reserveNodes(garage) != 0 || reserveRetired(garage) != 0) {
+        pthread_mutex_unlock(&garage->lock);
+        return -1;
+    }
+
+    notifyGarageListeners(garage->listeners, GARAGE_EVENT_REMOVE, lookup(garage->root, position), position);
+    garage->root = writableNode(garage, garage->root);
+    char* vehicle = removeAt(garage, garage->root, position);
+
+    // Drop levels left with a single child, and keep an empty garage as an empty leaf
+    while (!garage->root->leaf && garage->root->count == 1) {
+        SnapshotNode* child = garage->root->entries.children[0];
+        atomic_fetch_add_explicit(&child->references, 1, memory_order_relaxed);
+        releaseNode(garage, garage->root);
+        garage->root = child;
+    }
+    if (!garage->root->leaf && garage->root->count == 0) {
+        releaseNode(garage, garage->root);
+        garage->root = takeNode(garage, 1);
+    }
+
+    garage->version++;
+    retire(garage, vehicle);
+    pthread_mutex_unlock(&garage->lock);
+    return 0;
+}
+
+int versionedGarageReplace(VersionedGarage* garage, int position, char* vehicle) {
+    if (garage == NULL || vehicle == NULL) {
+        printf("Error: Garage or vehicle pointer is NULL\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&garage->lock);
+    if (position < 0 || position >= garage->root->total) {
+        printf("Error: Vehicle index %d is out of bounds\n", position);
+        pthread_mutex_unlock(&garage->lock);
+        return -1;
+    }
+    if (reserveNodes(garage) != 0 || reserveRetired(garage) != 0) {
+        pthread_mutex_unlock(&garage->lock);
+        return -1;
+    }
+
+    char** slot = slotFor(garage, &garage->root, position);
+    char* old = *slot;
+    notifyGarageListeners(garage->listeners, GARAGE_EVENT_REMOVE, old, position);
+    *slot = vehicle;
+    notifyGarageListeners(garage->listeners, GARAGE_EVENT_INSERT, vehicle, position);
+
+    garage->version++;
+    retire(garage, old);
+    pthread_mutex_unlock(&garage->lock);
+    return 0;
+}
+
+GarageSnapshot* takeGarageSnapshot(VersionedGarage* garage) {
+    if (garage == NULL) {
+        printf("Error: Garage pointer is NULL\n");
+        return NULL;
+    }
+
+    GarageSnapshot* snapshot = (GarageSnapshot*)malloc(sizeof(GarageSnapshot));
+    if (snapshot == NULL) {
+        printf("Error: Memory allocation for snapshot failed\n");
+        return NULL;
+    }
+
+    pthread_mutex_lock(&garage->lock);
+    atomic_fetch_add_explicit(&garage->root->references, 1, memory_order_relaxed);
+    snapshot->garage = garage;
+    snapshot->root = garage->root;
+    snapshot->version = garage->version;
+    snapshot->previous = NULL;
+    snapshot->next = garage->snapshots;
+    if (garage->snapshots != NULL) {
+        garage->snapshots->previous = snapshot;
+    }
+    garage->snapshots = snapshot;
+    garage->openSnapshots++;
+    pthread_mutex_unlock(&garage->lock);
+    return snapshot;
+}
+
+int snapshotSize(const GarageSnapshot* snapshot) {
+    return snapshot != NULL ? snapshot->root->total : 0;
+}
+
+char* snapshotVehicle(const GarageSnapshot* snapshot, int position) {
+    if (snapshot == NULL || position < 0 || position >= snapshot->root->total) {
+        return NULL;
+    }
+    return lookup(snapshot->root, position);
+}
+
+static int walkChunks(const SnapshotNode* node, int first, SnapshotChunkVisitor visitor, void* context) {
+    if (node->leaf) {
+        return node->count > 0 ? visitor(context, (char**)node->entries.vehicles, node->count, first) : 0;
+    }
+    for (int i = 0; i < node->count; i++) {
+        int stop = walkChunks(node->entries.children[i], first, visitor, context);
+        if (stop != 0) {
+            return stop;
+        }
+        first += node->totals[i];
+    }
+    return 0;
+}
+
+int forEachSnapshotChunk(const GarageSnapshot* snapshot, SnapshotChunkVisitor visitor, void* context) {
+    if (snapshot == NULL || visitor == NULL) {
+        printf("Error: Snapshot or visitor pointer is NULL\n");
+        return 0;
+    }
+    return walkChunks(snapshot->root, 0, visitor, context);
+}
+
+typedef struct {
+    VehicleVisitor visitor;
+    void* context;
+} SnapshotVehicleWalk;
+
+static int visitChunkVehicles(void* context, char** vehicles, int count, int first) {
+    SnapshotVehicleWalk* walk = (SnapshotVehicleWalk*)context;
+    for (int i = 0; i < count; i++) {
+        int stop = walk->visitor(walk->context, vehicles[i], first + i);
+        if (stop != 0) {
+            return stop;
+        }
+    }
+    return 0;
+}
+
+int forEachSnapshotVehicle(const GarageSnapshot* snapshot, VehicleVisitor visitor, void* context) {
+    SnapshotVehicleWalk walk = {visitor, context};
+
+    if (snapshot == NULL || visitor == NULL) {
+        printf("Error: Snapshot or visitor pointer is NULL\n");
+        return 0;
+    }
+    return walkChunks(snapshot->root, 0, visitChunkVehicles, &walk);
+}
+
+void releaseGarageSnapshot(GarageSnapshot* snapshot) {
+    if (snapshot == NULL) {
+        return;
+    }
+    VersionedGarage* garage = snapshot->garage;
+
+    pthread_mutex_lock(&garage->lock);
+    if (snapshot->previous != NULL) {
+        snapshot->previous->next = snapshot->next;
+    } else {
+        garage->snapshots = snapshot->next;
+    }
+    if (snapshot->next != NULL) {
+        snapshot->next->previous = snapshot->previous;
+    }
+    garage->openSnapshots--;
+    reclaimRetired(garage);
+    pthread_mutex_unlock(&garage->lock);
+
+    // Nodes only this snapshot still held go away with it
+    releaseNode(garage, snapshot->root);
+    free(snapshot);
+}
+
+GarageListeners* versionedGarageListeners(VersionedGarage* garage) {
+    return garage == NULL ? NULL : garage->listeners;
+}
+
+void versionedGarageUsage(VersionedGarage* garage, VersionedGarageUsage* usage) {
+    if (garage == NULL || usage == NULL) {
+        printf("Error: Garage or usage pointer is NULL\n");
+        return;
+    }
+    pthread_mutex_lock(&garage->lock);
+    usage->nodes = atomic_load_explicit(&garage->nodes, memory_order_relaxed);
+    usage->retiredVehicles = garage->numRetired;
+    usage->openSnapshots = garage->openSnapshots;
+    pthread_mutex_unlock(&garage->lock);
+}
+
+static int releaseVehicle(void* context, char* vehicle, int position) {
+    notifyGarageListeners((GarageListeners*)context, GARAGE_EVENT_REMOVE, vehicle, position);
+    freeVehicle(vehicle);
+    return 0;
+}
+
+void freeVersionedGarage(VersionedGarage* garage) {
+    if (garage == NULL) {
+        return;
+    }
+    if (garage->openSnapshots > 0) {
+        printf("Error: %d snapshots of the garage are still open\n", garage->openSnapshots);
+        return;
+    }
+
+    SnapshotVehicleWalk walk = {releaseVehicle, garage->listeners};
+    walkChunks(garage->root, 0, visitChunkVehicles, &walk);
+    releaseNode(garage, garage->root);
+    for (int i = 0; i < garage->numRetired; i++) {
+        freeVehicle(garage->retired[i].vehicle);
+    }
+    for (int i = 0; i < garage->numSpares; i++) {
+        free(garage->spares[i]);
+    }
+    free(garage->retired);
+    freeGarageListeners(garage->listeners);
+    pthread_mutex_destroy(&garage->lock);
+    free(garage);
+}
@@ -0,0 +1,127 @@
+/*
+ * Garage Snapshot Header File
+ * A garage with O(1) copy-on-write snapshots, for reports that must see one consistent
+ * state while other threads keep changing the garage.
+ *
+ * The vehicle pointers live in a persistent counted B+ tree: leaves are chunks of up to
+ * SNAPSHOT_NODE_SIZE pointers and inner nodes count the vehicles below each child, so a
+ * position is found in O(log n). Nodes are reference counted. A snapshot only takes a
+ * reference on the root. A change copies the chunks on its path that a snapshot still
+ * shares and changes the rest in place, so a snapshot costs memory in proportion to the
+ * changes made after it, never to the size of the garage. Removed vehicles are freed once
+ * no open snapshot can still see them.
+ *
+ * Changes and taking snapshots are serialized by an internal lock. A snapshot is read
+ * without any lock, from any thread, and may be released from any thread.
+ */
+
+#ifndef GARAGE_SNAPSHOT_H
+#define GARAGE_SNAPSHOT_H
+
+#include "vehicle.h"
+#include "garage_scan.h"
+
+#define SNAPSHOT_NODE_SIZE 64  // Vehicle pointers per chunk, children per inner node
+
+typedef struct VersionedGarage VersionedGarage;
+typedef struct GarageSnapshot GarageSnapshot;
+
+typedef struct {
+    long nodes;            // Tree nodes held by the garage and every open snapshot
+    long retiredVehicles;  // Removed vehicles kept alive for open snapshots
+    int openSnapshots;
+} VersionedGarageUsage;
+
+/*
+ * Reads one chunk of a snapshot: count consecutive vehicles starting at garage position
+ * first. The chunk is an ordinary garage, so the garage functions work on it directly.
+ * Returns nonzero to stop the walk.
+ */
+typedef int (*SnapshotChunkVisitor)(void* context, char** vehicles, int count, int first);
+
+/*
+ * Function: createVersionedGarage
+ * Purpose: Creates a versioned garage holding the vehicles of an ordinary garage.
+ * Parameters: char** - pointer to the garage (may be NULL when empty); the versioned garage
+ *                      takes the vehicles, the array itself stays with the caller
+ *             int - number of vehicles in the garage
+ * Returns: the versioned garage, or NULL if allocation failed
+ */
+VersionedGarage* createVersionedGarage(char**, int);
+
+/*
+ * Function: versionedGarageSize
+ * Purpose: Number of vehicles in the current version.
+ */
+int versionedGarageSize(VersionedGarage*);
+
+/*
+ * Function: versionedGarageVehicle
+ * Purpose: Vehicle at a position of the current version. Call it from the thread that
+ *          changes the garage; other threads read through a snapshot.
+ * Returns: the vehicle, or NULL if the position is out of range
+ */
+char* versionedGarageVehicle(VersionedGarage*, int);
+
+/*
+ * Functions: versionedGarageInsert, versionedGarageAppend, versionedGarageRemove,
+ *            versionedGarageReplace
+ * Purpose: Insert a vehicle before a position (the size appends), append, remove the vehicle
+ *          at a position, or put a new vehicle in place of the one at a position. The garage
+ *          takes ownership of inserted vehicles. Changes are reported to the garage's own
+ *          listener list (a replacement as a removal followed by an insert).
+ * Returns: 0 on success, -1 on error (garage unchanged)
+ */
+int versionedGarageInsert(VersionedGarage*, int, char*);
+int versionedGarageAppend(VersionedGarage*, char*);
+int versionedGarageRemove(VersionedGarage*, int);
+int versionedGarageReplace(VersionedGarage*, int, char*);
+
+/*
+ * Function: takeGarageSnapshot
+ * Purpose: Freezes the current version in O(1).
+ * Returns: the snapshot, or NULL if allocation failed
+ */
+GarageSnapshot* takeGarageSnapshot(VersionedGarage*);
+
+/*
+ * Functions: snapshotSize, snapshotVehicle
+ * Purpose: Number of vehicles in a snapshot / the vehicle at a position (O(log n)).
+ */
+int snapshotSize(const GarageSnapshot*);
+char* snapshotVehicle(const GarageSnapshot*, int);
+
+/*
+ * Functions: forEachSnapshotChunk, forEachSnapshotVehicle
+ * Purpose: Walk a snapshot in garage order, a chunk or a vehicle at a time.
+ * Returns: the value that stopped the walk, or 0
+ */
+int forEachSnapshotChunk(const GarageSnapshot*, SnapshotChunkVisitor, void*);
+int forEachSnapshotVehicle(const GarageSnapshot*, VehicleVisitor, void*);
+
+/*
+ * Function: releaseGarageSnapshot
+ * Purpose: Closes a snapshot. Its vehicles may be freed once it returns.
+ */
+void releaseGarageSnapshot(GarageSnapshot*);
+
+/*
+ * Function: versionedGarageListeners
+ * Purpose: The garage's own listener list, for attaching indexes and statistics to it.
+ *          Its events are reported on the thread making the change, under the garage lock.
+ */
+GarageListeners* versionedGarageListeners(VersionedGarage*);
+
+/*
+ * Function: versionedGarageUsage
+ * Purpose: Reports how much memory the garage and its snapshots hold.
+ */
+void versionedGarageUsage(VersionedGarage*, VersionedGarageUsage*);
+
+/*
+ * Function: freeVersionedGarage
+ * Purpose: Frees the garage and its vehicles. Every snapshot must be released first.
+ */
+void freeVersionedGarage(VersionedGarage*);
+
+#endif /* GARAGE_SNAPSHOT_H */
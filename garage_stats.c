@@ -0,0 +1,291 @@
+/*
+ * Garage Statistics
+ * Per-year aggregates published through per-year sequence counters.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "vehicle.h"
+#include "garage_stats.h"
+#include "garage_scan.h"
+
+typedef struct {
+    unsigned int* items;
+    int size;
+    int capacity;
+} ValueHeap;
+
+typedef struct {
+    // Published fields, read without locks
+    atomic_uint sequence;  // Odd while the writer is updating this year
+    atomic_long count;
+    atomic_llong sum;
+    atomic_uint minValue;
+    atomic_uint maxValue;
+
+    // Writer-only support structures. Removed values go to the "removed" heaps and are
+    // pruned once they reach the top, so min/max stay correct under deletions.
+    ValueHeap low;         // Min-heap of values added
+    ValueHeap lowRemoved;  // Min-heap of values removed
+    ValueHeap high;        // Max-heap of values added
+    ValueHeap highRemoved; // Max-heap of values removed
+} YearSlot;
+
+struct GarageYearStats {
+    YearSlot years[MAX_MODEL_YEAR + 1];
+};
+
+// Nonzero when a belongs above b (smaller first in a min-heap, larger first in a max-heap)
+static int ranksFirst(unsigned int a, unsigned int b, int maxHeap) {
+    return maxHeap ? a > b : a < b;
+}
+
+static int heapPush(ValueHeap* heap, unsigned int value, int maxHeap) {
+    if (heap->size == heap->capacity) {
+        int capacity = heap->capacity == 0 ? 8 : heap->capacity * 2;
+        unsigned int* items = (unsigned int*)realloc(heap->items, capacity * sizeof(unsigned int));
+        if (items == NULL) {
+            printf("Error: Memory allocation for year statistics failed\n");
+            return -1;
+        }
+        heap->items = items;
+        heap->capacity = capacity;
+    }
+
+    int index = heap->size++;
+    heap->items[index] = value;
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!ranksFirst(heap->items[index], heap->items[parent], maxHeap)) {
+            break;
+        }
+        unsigned int swap = heap->items[index];
+        heap->items[index] = heap->items[parent];
+        heap->items[parent] = swap;
+        index = parent;
+    }
+    return 0;
+}
+
+static void heapPop(ValueHeap* heap, int maxHeap) {
+    heap->items[0] = heap->items[--heap->size];
+
+    int index = 0;
+    for (;;) {
+        int child = 2 * index + 1;
+        if (child >= heap->size) {
+            return;
+        }
+        if (child + 1 < heap->size && ranksFirst(heap->items[child + 1], heap->items[child], maxHeap)) {
+            child++;
+        }
+        if (!ranksFirst(heap->items[child], heap->items[index], maxHeap)) {
+            return;
+        }
+        unsigned int swap = heap->items[index];
+        heap->items[index] = heap->items[child];
+        heap->items[child] = swap;
+        index = child;
+    }
+}
+
+// Drops values from the top of live that are waiting in removed
+static void prune(ValueHeap* live, ValueHeap* removed, int maxHeap) {
+    while (live->size > 0 && removed->size > 0 && live->items[0] == removed->items[0]) {
+        heapPop(live, maxHeap);
+        heapPop(removed, maxHeap);
+    }
+}
+
+static int compareValues(const void* a, const void* b) {
+    unsigned int left = *(const unsigned int*)a;
+    unsigned int right = *(const unsigned int*)b;
+    return left < right ? -1 : left > right;
+}
+
+/*
+ * Removed values that never reach the top would pile up, so once they make up half of a
+ * heap subtract them out. A sorted array is a valid heap (ascending for a min-heap,
+ * descending for a max-heap), so no extra heapify is needed.
+ */
+static void compact(ValueHeap* live, ValueHeap* removed, int maxHeap) {
+    if (removed->size < 64 || removed->size * 2 < live->size) {
+        return;
+    }
+
+    qsort(live->items, live->size, sizeof(unsigned int), compareValues);
+    qsort(removed->items, removed->size, sizeof(unsigned int), compareValues);
+
+    int kept = 0;
+    int j = 0;
+    for (int i = 0; i < live->size; i++) {
+        while (j < removed->size && removed->items[j] < live->items[i]) {
+            j++;
+        }
+        if (j < removed->size && removed->items[j] == live->items[i]) {
+            j++;
+        } else {
+            live->items[kept++] = live->items[i];
+        }
+    }
+    live->size = kept;
+    removed->size = 0;
+
+    if (maxHeap) {
+        for (int i = 0; i < kept / 2; i++) {
+            unsigned int swap = live->items[i];
+            live->items[i] = live->items[kept - 1 - i];
+            live->items[kept - 1 - i] = swap;
+        }
+    }
+}
+
+// Publishes new values for a year between two sequence increments
+static void publish(YearSlot* slot, long count, long long sum) {
+    unsigned int sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&slot->count, count, memory_order_relaxed);
+    atomic_store_explicit(&slot->sum, sum, memory_order_relaxed);
+    atomic_store_explicit(&slot->minValue, count > 0 ? slot->low.items[0] : 0, memory_order_relaxed);
+    atomic_store_explicit(&slot->maxValue, count > 0 ? slot->high.items[0] : 0, memory_order_relaxed);
+
+    atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+}
+
+static int addSlot(void* context, char* vehicle, int position) {
+    (void)position;
+    return vehicle != NULL && yearStatsAdd((GarageYearStats*)context, vehicle) != 0;
+}
+
+GarageYearStats* buildGarageYearStats(char** garage, int numVehicles) {
+    GarageYearStats* stats = (GarageYearStats*)calloc(1, sizeof(GarageYearStats));
+    if (stats == NULL) {
+        printf("Error: Memory allocation for year statistics failed\n");
+        return NULL;
+    }
+
+    if (garage != NULL && forEachVehicle(garage, numVehicles, addSlot, stats) != 0) {
+        freeGarageYearStats(stats);
+        return NULL;
+    }
+    return stats;
+}
+
+static int addHeader(GarageYearStats* stats, unsigned int packedData) {
+    unsigned int value = headerValue(packedData);
+    YearSlot* slot = &stats->years[headerYear(packedData)];
+
+    if (heapPush(&slot->low, value, 0) != 0 || heapPush(&slot->high, value, 1) != 0) {
+        return -1;
+    }
+
+    publish(slot, atomic_load_explicit(&slot->count, memory_order_relaxed) + 1,
+            atomic_load_explicit(&slot->sum, memory_order_relaxed) + value);
+    return 0;
+}
+
+static int removeHeader(GarageYearStats* stats, unsigned int packedData) {
+    unsigned int value = headerValue(packedData);
+    YearSlot* slot = &stats->years[headerYear(packedData)];
+    long count = atomic_load_explicit(&slot->count, memory_order_relaxed);
+
+    if (count == 0) {
+        return -1;
+    }
+
+    if (heapPush(&slot->lowRemoved, value, 0) != 0 || heapPush(&slot->highRemoved, value, 1) != 0) {
+        return -1;
+    }
+    prune(&slot->low, &slot->lowRemoved, 0);
+    prune(&slot->high, &slot->highRemoved, 1);
+    compact(&slot->low, &slot->lowRemoved, 0);
+    compact(&slot->high, &slot->highRemoved, 1);
+
+    publish(slot, count - 1, atomic_load_explicit(&slot->sum, memory_order_relaxed) - value);
+    return 0;
+}
+
+int yearStatsAdd(GarageYearStats* stats, const char* vehicle) {
+    if (stats == NULL || vehicle == NULL) {
+        return -1;
+    }
+    return addHeader(stats, vehicleHeader(vehicle));
+}
+
+int yearStatsRemove(GarageYearStats* stats, const char* vehicle) {
+    if (stats == NULL || vehicle == NULL) {
+        return -1;
+    }
+    return removeHeader(stats, vehicleHeader(vehicle));
+}
+
+int readYearAggregate(const GarageYearStats* stats, unsigned int year, YearAggregate* aggregate) {
+    if (stats == NULL || aggregate == NULL || year > MAX_MODEL_YEAR) {
+        return 0;
+    }
+
+    YearSlot* slot = (YearSlot*)&stats->years[year];
+    unsigned int before;
+    unsigned int after;
+
+    do {
+        before = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+        aggregate->count = atomic_load_explicit(&slot->count, memory_order_relaxed);
+        aggregate->sum = atomic_load_explicit(&slot->sum, memory_order_relaxed);
+        aggregate->minValue = atomic_load_explicit(&slot->minValue, memory_order_relaxed);
+        aggregate->maxValue = atomic_load_explicit(&slot->maxValue, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+
+    return 1;
+}
+
+double yearAverageValue(const GarageYearStats* stats, unsigned int year) {
+    YearAggregate aggregate;
+
+    if (!readYearAggregate(stats, year, &aggregate) || aggregate.count == 0) {
+        return 0.0;
+    }
+    return (double)aggregate.sum / (double)aggregate.count;
+}
+
+static void onGarageEvent(void* context, const GarageEvent* event) {
+    GarageYearStats* stats = (GarageYearStats*)context;
+
+    if (event->type == GARAGE_EVENT_INSERT) {
+        yearStatsAdd(stats, event->vehicle);
+    } else if (event->type == GARAGE_EVENT_REMOVE) {
+        yearStatsRemove(stats, event->vehicle);
+    } else if (event->type == GARAGE_EVENT_UPDATE && removeHeader(stats, event->previousHeader) == 0) {
+        addHeader(stats, vehicleHeader(event->vehicle));
+    }
+}
+
+int attachGarageYearStats(GarageYearStats* stats, GarageListeners* listeners) {
+    return addGarageListener(listeners, onGarageEvent, stats);
+}
+
+void detachGarageYearStats(GarageYearStats* stats, GarageListeners* listeners) {
+    removeGarageListener(listeners, onGarageEvent, stats);
+}
+
+void freeGarageYearStats(GarageYearStats* stats) {
+    if (stats == NULL) {
+        return;
+    }
+
+    for (unsigned int i = 0; i <= MAX_MODEL_YEAR; i++) {
+        free(stats->years[i].low.items);
+        free(stats->years[i].lowRemoved.items);
+        free(stats->years[i].high.items);
+        free(stats->years[i].highRemoved.items);
+    }
+    free(stats);
+}
@@ -0,0 +1,69 @@
+/*
+ * Garage Statistics Header File
+ * Materialized per-model-year aggregates (count, sum, min and max value).
+ *
+ * Updates happen on every insert/remove event: count and sum in O(1), min and max through
+ * lazily pruned heaps in O(log n) amortized, so deleting the current minimum or maximum
+ * still gives the right answer. Readers never take a lock: each year is published through
+ * a sequence counter and readYearAggregate retries only if it raced with a writer.
+ * Writers must be serialized by the caller (garage events already are).
+ */
+
+#ifndef GARAGE_STATS_H
+#define GARAGE_STATS_H
+
+#include "vehicle.h"
+
+typedef struct {
+    long count;
+    long long sum;
+    unsigned int minValue;  // 0 when count is 0
+    unsigned int maxValue;  // 0 when count is 0
+} YearAggregate;
+
+typedef struct GarageYearStats GarageYearStats;
+
+/*
+ * Function: buildGarageYearStats
+ * Purpose: Computes the per-year aggregates of a garage.
+ * Parameters: char** - pointer to the garage (may be NULL for an empty garage)
+ *             int - number of vehicles in the garage
+ * Returns: the statistics, or NULL if allocation failed
+ */
+GarageYearStats* buildGarageYearStats(char**, int);
+
+/*
+ * Functions: yearStatsAdd, yearStatsRemove
+ * Purpose: Account for a vehicle entering or leaving the garage.
+ * Returns: 0 on success, -1 on error
+ */
+int yearStatsAdd(GarageYearStats*, const char*);
+int yearStatsRemove(GarageYearStats*, const char*);
+
+/*
+ * Function: readYearAggregate
+ * Purpose: Lock-free, consistent read of one year's aggregate. Safe from any thread.
+ * Parameters: const GarageYearStats* - the statistics
+ *             unsigned int - model year
+ *             YearAggregate* - receives the aggregate
+ * Returns: 1 on success, 0 if the year is out of range
+ */
+int readYearAggregate(const GarageYearStats*, unsigned int, YearAggregate*);
+
+/*
+ * Function: yearAverageValue
+ * Purpose: Average value of the vehicles from one year, or 0 if there are none.
+ */
+double yearAverageValue(const GarageYearStats*, unsigned int);
+
+/*
+ * Functions: attachGarageYearStats, detachGarageYearStats
+ * Purpose: Keep the statistics in sync with garage events of one listener list (see addGarageListener).
+ *          Pass the same list to both: the garage's own list, or NULL for plain garages.
+ */
+int attachGarageYearStats(GarageYearStats*, GarageListeners*);
+void detachGarageYearStats(GarageYearStats*, GarageListeners*);
+
+void freeGarageYearStats(GarageYearStats*);
+
+#endif /* GARAGE_STATS_H */
@@ -0,0 +1,188 @@
+/*
+ * Garage Top-K
+ * Bounded heaps over decoded vehicle values.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "vehicle.h"
+#include "parallel.h"
+#include "garage_topk.h"
+#include "garage_scan.h"
+
+typedef struct {
+    unsigned int value;
+    int position;
+} TopKEntry;
+
+typedef struct {
+    TopKEntry* entries;
+    int size;
+    int capacity;  // K
+    int most;      // Nonzero when larger values rank higher
+} TopKHeap;
+
+// Nonzero when a ranks strictly higher than b
+static int ranksHigher(const TopKHeap* heap, TopKEntry a, TopKEntry b) {
+    if (a.value != b.value) {
+        return heap->most ? a.value > b.value : a.value < b.value;
+    }
+    return a.position < b.position;
+}
+
+// The root of the heap is the lowest ranked entry kept so far
+static void siftDown(TopKHeap* heap, int index) {
+    for (;;) {
+        int child = 2 * index + 1;
+        if (child >= heap->size) {
+            return;
+        }
+        if (child + 1 < heap->size && ranksHigher(heap, heap->entries[child], heap->entries[child + 1])) {
+            child++;
+        }
+        if (!ranksHigher(heap, heap->entries[index], heap->entries[child])) {
+            return;
+        }
+        TopKEntry swap = heap->entries[index];
+        heap->entries[index] = heap->entries[child];
+        heap->entries[child] = swap;
+        index = child;
+    }
+}
+
+static void siftUp(TopKHeap* heap, int index) {
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!ranksHigher(heap, heap->entries[parent], heap->entries[index])) {
+            return;
+        }
+        TopKEntry swap = heap->entries[index];
+        heap->entries[index] = heap->entries[parent];
+        heap->entries[parent] = swap;
+        index = parent;
+    }
+}
+
+static void offer(TopKHeap* heap, TopKEntry entry) {
+    if (heap->size < heap->capacity) {
+        heap->entries[heap->size++] = entry;
+        siftUp(heap, heap->size - 1);
+    } else if (ranksHigher(heap, entry, heap->entries[0])) {
+        heap->entries[0] = entry;
+        siftDown(heap, 0);
+    }
+}
+
+typedef struct {
+    TopKHeap* heap;
+    int base;  // Garage position of the first slot scanned
+} TopKScan;
+
+static int offerSlot(void* context, char* vehicle, int position) {
+    TopKScan* scan = (TopKScan*)context;
+    TopKHeap* heap = scan->heap;
+
+    if (vehicle == NULL) {
+        return 0;
+    }
+
+    TopKEntry entry = {headerValue(vehicleHeader(vehicle)), scan->base + position};
+
+    // Cheap threshold test before touching the heap
+    if (heap->size < heap->capacity || ranksHigher(heap, entry, heap->entries[0])) {
+        offer(heap, entry);
+    }
+    return 0;
+}
+
+static void scanRange(TopKHeap* heap, char** garage, int begin, int end) {
+    TopKScan scan = {heap, begin};
+    forEachVehicle(garage + begin, end - begin, offerSlot, &scan);
+}
+
+// Pops the heap (worst first) so the result ends up best first
+static int drainHeap(TopKHeap* heap, char** garage, char** result) {
+    int count = heap->size;
+
+    for (int i = count - 1; i >= 0; i--) {
+        result[i] = garage[heap->entries[0].position];
+        heap->entries[0] = heap->entries[--heap->size];
+        siftDown(heap, 0);
+    }
+    return count;
+}
+
+int topKVehicles(char** garage, int numVehicles, int k, int most, char** result) {
+    if (garage == NULL || result == NULL || k < 0) {
+        printf("Error: Invalid arguments for top-K\n");
+        return -1;
+    }
+    if (k == 0) {
+        return 0;
+    }
+
+    TopKHeap heap = {(TopKEntry*)malloc(k * sizeof(TopKEntry)), 0, k, most};
+    if (heap.entries == NULL) {
+        printf("Error: Memory allocation for top-K failed\n");
+        return -1;
+    }
+
+    scanRange(&heap, garage, 0, numVehicles);
+    int count = drainHeap(&heap, garage, result);
+
+    free(heap.entries);
+    return count;
+}
+
+typedef struct {
+    char** garage;
+    TopKHeap* heaps;  // One per worker
+} TopKJob;
+
+static void topKTask(void* context, int begin, int end, int worker) {
+    TopKJob* job = (TopKJob*)context;
+    scanRange(&job->heaps[worker], job->garage, begin, end);
+}
+
+int topKVehiclesParallel(char** garage, int numVehicles, int k, int most, char** result, int numThreads) {
+    if (garage == NULL || result == NULL || k < 0) {
+        printf("Error: Invalid arguments for top-K\n");
+        return -1;
+    }
+    if (k == 0) {
+        return 0;
+    }
+    if (numThreads <= 0) {
+        numThreads = defaultThreadCount();
+    }
+
+    TopKJob job = {garage, (TopKHeap*)calloc(numThreads, sizeof(TopKHeap))};
+    TopKEntry* storage = (TopKEntry*)malloc((size_t)numThreads * k * sizeof(TopKEntry));
+    if (job.heaps == NULL || storage == NULL) {
+        printf("Error: Memory allocation for top-K failed\n");
+        free(job.heaps);
+        free(storage);
+        return -1;
+    }
+
+    for (int i = 0; i < numThreads; i++) {
+        job.heaps[i].entries = storage + (size_t)i * k;
+        job.heaps[i].capacity = k;
+        job.heaps[i].most = most;
+    }
+
+    int workers = parallelFor(numVehicles, numThreads, topKTask, &job);
+
+    // Merge: feed every per-thread survivor into the first heap
+    TopKHeap* merged = &job.heaps[0];
+    for (int i = 1; i < workers; i++) {
+        for (int j = 0; j < job.heaps[i].size; j++) {
+            offer(merged, job.heaps[i].entries[j]);
+        }
+    }
+    int count = drainHeap(merged, garage, result);
+
+    free(storage);
+    free(job.heaps);
+    return count;
+}
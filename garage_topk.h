@@ -0,0 +1,37 @@
+/*
+ * Garage Top-K Header File
+ * Single pass selection of the K most or least valuable vehicles using a bounded heap.
+ *
+ * Results are pointers into the existing garage, best first. Ties on value are broken by
+ * position in the garage (earlier wins), so the serial and parallel versions agree.
+ */
+
+#ifndef GARAGE_TOPK_H
+#define GARAGE_TOPK_H
+
+#define TOPK_MOST_VALUABLE 1
+#define TOPK_LEAST_VALUABLE 0
+
+/*
+ * Function: topKVehicles
+ * Purpose: Finds the K most (or least) valuable vehicles without sorting the garage.
+ *          O(n log K) time, O(K) extra memory. NULL slots are ignored.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ *             int - K
+ *             int - TOPK_MOST_VALUABLE or TOPK_LEAST_VALUABLE
+ *             char** - receives up to K vehicle pointers, best first
+ * Returns: the number of vehicles written to the result (at most K), or -1 on error
+ */
+int topKVehicles(char**, int, int, int, char**);
+
+/*
+ * Function: topKVehiclesParallel
+ * Purpose: Same as topKVehicles, but every thread keeps its own heap over part of the
+ *          garage and the per-thread heaps are merged at the end.
+ * Parameters: same as topKVehicles, plus the number of threads (0 = one per processor)
+ * Returns: the number of vehicles written to the result, or -1 on error
+ */
+int topKVehiclesParallel(char**, int, int, int, char**, int);
+
+#endif /* GARAGE_TOPK_H */
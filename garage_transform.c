@@ -0,0 +1,282 @@
+/*
+ * Garage Transform
+ * SSE2 kernels for saturating bulk value changes on packed headers.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vehicle.h"
+#include "garage_scan.h"
+#include "garage_transform.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define TRANSFORM_USE_SSE2 1
+#endif
+
+// A transform with everything the kernels need worked out once
+typedef struct {
+    TransformKind kind;
+    double factor;                               // TRANSFORM_SCALE
+    const double* ageFactors;                    // TRANSFORM_DEPRECIATE: (1 - rate)^age
+    unsigned int magnitude;                      // TRANSFORM_ADD: |delta|, at most MAX_VEHICLE_VALUE
+    int negative;                                // TRANSFORM_ADD: delta < 0
+    unsigned int currentYear;
+} TransformPlan;
+
+ValueTransform scaleTransform(double factor) {
+    ValueTransform transform = {TRANSFORM_SCALE, factor, 0, 0.0, 0};
+    return transform;
+}
+
+ValueTransform addTransform(int delta) {
+    ValueTransform transform = {TRANSFORM_ADD, 1.0, delta, 0.0, 0};
+    return transform;
+}
+
+ValueTransform depreciationTransform(double rate, unsigned int currentYear) {
+    ValueTransform transform = {TRANSFORM_DEPRECIATE, 1.0, 0, rate, currentYear};
+    return transform;
+}
+
+// Nonzero lanes of a 4-bit movemask
+static int laneCount(int mask) {
+    return (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+}
+
+static unsigned int ageOf(const TransformPlan* plan, unsigned int header) {
+    unsigned int year = headerYear(header);
+    unsigned int age = plan->currentYear > year ? plan->currentYear - year : 0;
+    return age > TRANSFORM_MAX_AGE ? TRANSFORM_MAX_AGE : age;
+}
+
+static double factorOf(const TransformPlan* plan, unsigned int header) {
+    return plan->ageFactors != NULL ? plan->ageFactors[ageOf(plan, header)] : plan->factor;
+}
+
+// value * factor, clamped to the value range and rounded to nearest (ties to even)
+static int multiplyValues(unsigned int* headers, int count, const TransformPlan* plan) {
+    int changed = 0;
+    int i = 0;
+
+#ifdef TRANSFORM_USE_SSE2
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d maxValue = _mm_set1_pd((double)MAX_VEHICLE_VALUE);
+    const __m128i yearMask = _mm_set1_epi32(YEAR_MASK);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i header = _mm_loadu_si128((const __m128i*)(headers + i));
+        __m128i values = _mm_srli_epi32(header, VALUE_SHIFT);
+
+        // Depreciation looks its factors up per vehicle; scaling uses one factor
+        __m128d lowFactor = _mm_set_pd(factorOf(plan, headers[i + 1]), factorOf(plan, headers[i]));
+        __m128d highFactor = _mm_set_pd(factorOf(plan, headers[i + 3]), factorOf(plan, headers[i + 2]));
+
+        __m128d low = _mm_mul_pd(_mm_cvtepi32_pd(values), lowFactor);
+        __m128d high = _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(values, _MM_SHUFFLE(3, 2, 3, 2))), highFactor);
+        low = _mm_min_pd(_mm_max_pd(low, zero), maxValue);
+        high = _mm_min_pd(_mm_max_pd(high, zero), maxValue);
+
+        __m128i result = _mm_unpacklo_epi64(_mm_cvtpd_epi32(low), _mm_cvtpd_epi32(high));
+        __m128i updated = _mm_or_si128(_mm_slli_epi32(result, VALUE_SHIFT), _mm_and_si128(header, yearMask));
+
+        _mm_storeu_si128((__m128i*)(headers + i), updated);
+        changed += 4 - laneCount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(header, updated))));
+    }
+#endif
+
+    for (; i < count; i++) {
+        unsigned int header = headers[i];
+        double product = headerValue(header) * factorOf(plan, header);
+        product = product > 0.0 ? product : 0.0;
+        product = product < (double)MAX_VEHICLE_VALUE ? product : (double)MAX_VEHICLE_VALUE;
+
+        headers[i] = packHeader((unsigned int)lrint(product), headerYear(header));
+        changed += headers[i] != header;
+    }
+    return changed;
+}
+
+// value + delta, saturating at 0 and MAX_VEHICLE_VALUE
+static int addValues(unsigned int* headers, int count, const TransformPlan* plan) {
+    unsigned int magnitude = plan->magnitude;
+    unsigned int limit = MAX_VEHICLE_VALUE - magnitude;  // Largest value that can take +magnitude
+    int changed = 0;
+    int i = 0;
+
+#ifdef TRANSFORM_USE_SSE2
+    // SSE2 only has signed compares, so flip the sign bit to compare unsigned values
+    const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+    const __m128i step = _mm_set1_epi32((int)magnitude);
+    const __m128i flippedStep = _mm_set1_epi32((int)(magnitude ^ 0x80000000u));
+    const __m128i flippedLimit = _mm_set1_epi32((int)(limit ^ 0x80000000u));
+    const __m128i maxValue = _mm_set1_epi32((int)MAX_VEHICLE_VALUE);
+    const __m128i yearMask = _mm_set1_epi32(YEAR_MASK);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i header = _mm_loadu_si128((const __m128i*)(headers + i));
+        __m128i values = _mm_srli_epi32(header, VALUE_SHIFT);
+        __m128i flipped = _mm_xor_si128(values, sign);
+        __m128i result;
+
+        if (plan->negative) {
+            __m128i under = _mm_cmpgt_epi32(flippedStep, flipped);
+            result = _mm_andnot_si128(under, _mm_sub_epi32(values, step));
+        } else {
+            __m128i over = _mm_cmpgt_epi32(flipped, flippedLimit);
+            result = _mm_or_si128(_mm_and_si128(over, maxValue), _mm_andnot_si128(over, _mm_add_epi32(values, step)));
+        }
+
+        __m128i updated = _mm_or_si128(_mm_slli_epi32(result, VALUE_SHIFT), _mm_and_si128(header, yearMask));
+        _mm_storeu_si128((__m128i*)(headers + i), updated);
+        changed += 4 - laneCount(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(header, updated))));
+    }
+#endif
+
+    for (; i < count; i++) {
+        unsigned int header = headers[i];
+        unsigned int value = headerValue(header);
+
+        if (plan->negative) {
+            value = value < magnitude ? 0 : value - magnitude;
+        } else {
+            value = value > limit ? MAX_VEHICLE_VALUE : value + magnitude;
+        }
+        headers[i] = packHeader(value, headerYear(header));
+        changed += headers[i] != header;
+    }
+    return changed;
+}
+
+static int applyPlan(unsigned int* headers, int count, const TransformPlan* plan) {
+    return plan->kind == TRANSFORM_ADD ? addValues(headers, count, plan) : multiplyValues(headers, count, plan);
+}
+
+// Checks a transform and prepares its plan; depreciation needs a factor table (freed by the caller)
+static int makePlan(const ValueTransform* transform, TransformPlan* plan) {
+    memset(plan, 0, sizeof(TransformPlan));
+    if (transform == NULL) {
+        printf("Error: Transform pointer is NULL\n");
+        return -1;
+    }
+    plan->kind = transform->kind;
+
+    switch (transform->kind) {
+        case TRANSFORM_SCALE:
+            if (!isfinite(transform->factor)) {
+                printf("Error: Scale factor must be a finite number\n");
+                return -1;
+            }
+            plan->factor = transform->factor;
+            return 0;
+        case TRANSFORM_ADD: {
+            // Anything beyond the value range saturates the same way as the range itself
+            long long delta = transform->delta;
+            long long magnitude = delta < 0 ? -delta : delta;
+            plan->negative = delta < 0;
+            plan->magnitude = magnitude > MAX_VEHICLE_VALUE ? MAX_VEHICLE_VALUE : (unsigned int)magnitude;
+            return 0;
+        }
+        case TRANSFORM_DEPRECIATE: {
+            if (!(transform->rate >= 0.0 && transform->rate <= 1.0)) {
+                printf("Error: Depreciation rate must be between 0 and 1\n");
+                return -1;
+            }
+
+            double* factors = (double*)malloc((TRANSFORM_MAX_AGE + 1) * sizeof(double));
+            if (factors == NULL) {
+                printf("Error: Memory allocation for depreciation table failed\n");
+                return -1;
+            }
+            factors[0] = 1.0;
+            for (unsigned int age = 1; age <= TRANSFORM_MAX_AGE; age++) {
+                factors[age] = factors[age - 1] * (1.0 - transform->rate);
+            }
+            plan->ageFactors = factors;
+            plan->currentYear = transform->currentYear;
+            return 0;
+        }
+    }
+
+    printf("Error: Unknown transform\n");
+    return -1;
+}
+
+int transformHeaders(unsigned int* headers, int numHeaders, const ValueTransform* transform) {
+    TransformPlan plan;
+
+    if (headers == NULL) {
+        printf("Error: Header column is NULL\n");
+        return -1;
+    }
+    if (makePlan(transform, &plan) != 0) {
+        return -1;
+    }
+
+    int changed = applyPlan(headers, numHeaders, &plan);
+    free((void*)plan.ageFactors);
+    return changed;
+}
+
+typedef struct {
+    unsigned int* headers;
+    int* positions;
+    int count;
+    int base;  // Garage position of the first slot of the batch
+} TransformGather;
+
+static int gatherSlot(void* context, char* vehicle, int position) {
+    TransformGather* gather = (TransformGather*)context;
+
+    if (vehicle != NULL) {
+        gather->headers[gather->count] = vehicleHeader(vehicle);
+        gather->positions[gather->count] = gather->base + position;
+        gather->count++;
+    }
+    return 0;
+}
+
+int transformGarage(char** garage, int numVehicles, const ValueTransform* transform) {
+    TransformPlan plan;
+
+    if (garage == NULL) {
+        printf("Error: Garage pointer is NULL\n");
+        return -1;
+    }
+    if (makePlan(transform, &plan) != 0) {
+        return -1;
+    }
+
+    unsigned int before[TRANSFORM_BATCH_SIZE];
+    unsigned int after[TRANSFORM_BATCH_SIZE];
+    int positions[TRANSFORM_BATCH_SIZE];
+    int notify = hasGarageListeners(NULL);
+    int changed = 0;
+
+    for (int start = 0; start < numVehicles; start += TRANSFORM_BATCH_SIZE) {
+        int end = start + TRANSFORM_BATCH_SIZE < numVehicles ? start + TRANSFORM_BATCH_SIZE : numVehicles;
+        // Gather the headers of this batch into a dense column, transform, write back the changes
+        TransformGather gather = {before, positions, 0, start};
+        forEachVehicle(garage + start, end - start, gatherSlot, &gather);
+
+        memcpy(after, before, gather.count * sizeof(unsigned int));
+        if (applyPlan(after, gather.count, &plan) == 0) {
+            continue;
+        }
+
+        for (int j = 0; j < gather.count; j++) {
+            if (after[j] != before[j]) {
+                setVehicleHeader(garage[positions[j]], after[j]);
+                if (notify) {
+                    notifyVehicleUpdated(NULL, garage[positions[j]], positions[j], before[j]);
+                }
+                changed++;
+            }
+        }
+    }
+
+    free((void*)plan.ageFactors);
+    return changed;
+}
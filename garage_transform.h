@@ -0,0 +1,67 @@
+/*
+ * Garage Transform Header File
+ * Bulk in-place value transforms (scaling, adding a delta, depreciation by age).
+ *
+ * Transforms run directly on packed headers: the value is taken from the upper bits, changed,
+ * saturated to 0 .. MAX_VEHICLE_VALUE and written back next to the untouched year bits.
+ * Headers are processed 4 at a time with SSE2 when available and the scalar remainder uses
+ * the same arithmetic, so results do not depend on alignment or batch boundaries. Scaling
+ * and depreciation compute in double precision and round to the nearest value (ties to
+ * even); adding a delta is exact integer arithmetic.
+ */
+
+#ifndef GARAGE_TRANSFORM_H
+#define GARAGE_TRANSFORM_H
+
+#include "vehicle_layout.h"
+
+#define TRANSFORM_BATCH_SIZE 256  // Headers gathered from a garage and transformed together
+
+// Oldest age depreciation distinguishes; only layouts with more than 12 year bits reach it
+#define TRANSFORM_MAX_AGE (YEAR_MASK < 4095u ? YEAR_MASK : 4095u)
+
+typedef enum {
+    TRANSFORM_SCALE,       // value * factor
+    TRANSFORM_ADD,         // value + delta
+    TRANSFORM_DEPRECIATE   // value * (1 - rate)^age, age = currentYear - model year (0 if newer)
+} TransformKind;
+
+typedef struct {
+    TransformKind kind;
+    double factor;             // TRANSFORM_SCALE
+    int delta;                 // TRANSFORM_ADD
+    double rate;               // TRANSFORM_DEPRECIATE: fraction of value lost per year
+    unsigned int currentYear;  // TRANSFORM_DEPRECIATE
+} ValueTransform;
+
+/*
+ * Functions: scaleTransform, addTransform, depreciationTransform
+ * Purpose: Describe a transform: multiply by a factor (0.9 = 10% down), add a signed delta,
+ *          or depreciate by a yearly rate up to the current year.
+ */
+ValueTransform scaleTransform(double);
+ValueTransform addTransform(int);
+ValueTransform depreciationTransform(double, unsigned int);
+
+/*
+ * Function: transformHeaders
+ * Purpose: Applies a transform to a dense column of packed headers in place.
+ * Parameters: unsigned int* - packed headers
+ *             int - number of headers
+ *             const ValueTransform* - the transform
+ * Returns: number of headers whose value changed, or -1 on error
+ */
+int transformHeaders(unsigned int*, int, const ValueTransform*);
+
+/*
+ * Function: transformGarage
+ * Purpose: Applies a transform to every vehicle of a garage in place (either record format).
+ *          Changed vehicles are reported to the garage listeners as GARAGE_EVENT_UPDATE.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ *             const ValueTransform* - the transform
+ * Returns: number of vehicles whose value changed, or -1 on error
+ */
+int transformGarage(char**, int, const ValueTransform*);
+
+#endif /* GARAGE_TRANSFORM_H */
@@ -0,0 +1,56 @@
+/*
+ * Hash
+ * MurmurHash64A style hashing over 8-byte words.
+ */
+
+#include <string.h>
+#include "hash.h"
+
+#define HASH_MULTIPLIER 0xC6A4A7935BD1E995ULL
+#define HASH_ROTATE 47
+#define DEFAULT_SEED 0x9E3779B97F4A7C15ULL
+
+unsigned long long hashBytes(const void* data, size_t length, unsigned long long seed) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    unsigned long long hash = seed ^ (length * HASH_MULTIPLIER);
+
+    // Mix in 8 bytes at a time; memcpy keeps unaligned loads legal
+    while (length >= 8) {
+        unsigned long long word;
+        memcpy(&word, bytes, 8);
+
+        word *= HASH_MULTIPLIER;
+        word ^= word >> HASH_ROTATE;
+        word *= HASH_MULTIPLIER;
+
+        hash ^= word;
+        hash *= HASH_MULTIPLIER;
+
+        bytes += 8;
+        length -= 8;
+    }
+
+    // Remaining 0-7 bytes
+    if (length > 0) {
+        unsigned long long tail = 0;
+        for (size_t i = 0; i < length; i++) {
+            tail |= (unsigned long long)bytes[i] << (8 * i);
+        }
+        hash ^= tail;
+        hash *= HASH_MULTIPLIER;
+    }
+
+    hash ^= hash >> HASH_ROTATE;
+    hash *= HASH_MULTIPLIER;
+    hash ^= hash >> HASH_ROTATE;
+
+    return hash;
+}
+
+unsigned long long hashDescription(const char* description) {
+    return hashBytes(description, strlen(description), DEFAULT_SEED);
+}
+
+unsigned long long hashDescriptionBytes(const char* description, size_t length) {
+    return hashBytes(description, length, DEFAULT_SEED);
+}
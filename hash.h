@@ -0,0 +1,33 @@
+/*
+ * Hash Header File
+ * Fast non-cryptographic hashing shared by the garage indexes and sketches.
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+
+/*
+ * Function: hashBytes
+ * Purpose: 64-bit hash of a block of memory (MurmurHash64A style, 8 bytes per step).
+ * Parameters: const void* - data to hash
+ *             size_t - number of bytes
+ *             unsigned long long - seed, lets callers derive independent hashes
+ * Returns: the 64-bit hash
+ */
+unsigned long long hashBytes(const void*, size_t, unsigned long long);
+
+/*
+ * Function: hashDescription
+ * Purpose: Hash of a null terminated vehicle description with the default seed.
+ */
+unsigned long long hashDescription(const char*);
+
+/*
+ * Function: hashDescriptionBytes
+ * Purpose: Same hash as hashDescription for a description whose length is already known.
+ */
+unsigned long long hashDescriptionBytes(const char*, size_t);
+
+#endif /* HASH_H */
@@ -0,0 +1,165 @@
+/*
+ * LZ
+ * Greedy LZ77 compression with a single-probe hash table, and a bounds-checked decoder.
+ */
+
+#include <string.h>
+#include "lz.h"
+
+#define LZ_HASH_MULTIPLIER 2654435761u
+
+static unsigned int readWord(const unsigned char* bytes) {
+    unsigned int word;
+    memcpy(&word, bytes, 4);
+    return word;
+}
+
+static unsigned int hashWord(unsigned int word) {
+    return (word * LZ_HASH_MULTIPLIER) >> (32 - LZ_HASH_BITS);
+}
+
+// Writes the extra bytes of a length that did not fit its nibble
+static unsigned char* putLength(unsigned char* out, size_t length) {
+    while (length >= 255) {
+        *out++ = 255;
+        length -= 255;
+    }
+    *out++ = (unsigned char)length;
+    return out;
+}
+
+// Reads the extra bytes of a length. Returns 0, or -1 if the input ends first.
+static int getLength(const unsigned char** in, const unsigned char* end, size_t* length) {
+    unsigned int byte;
+    do {
+        if (*in >= end) {
+            return -1;
+        }
+        byte = *(*in)++;
+        *length += byte;
+    } while (byte == 255);
+    return 0;
+}
+
+// Emits one sequence; a match length of 0 marks the final, literal-only sequence
+static unsigned char* putSequence(unsigned char* out, const unsigned char* outEnd, const unsigned char* literals,
+                                  size_t numLiterals, size_t distance, size_t matchLength) {
+    size_t extra = matchLength > 0 ? matchLength - LZ_MIN_MATCH : 0;
+    size_t needed = 1 + numLiterals / 255 + 1 + numLiterals + 2 + extra / 255 + 1;
+    if ((size_t)(outEnd - out) < needed) {
+        return NULL;
+    }
+
+    unsigned char* token = out++;
+    *token = (unsigned char)((numLiterals < 15 ? numLiterals : 15) << 4);
+    if (numLiterals >= 15) {
+        out = putLength(out, numLiterals - 15);
+    }
+    memcpy(out, literals, numLiterals);
+    out += numLiterals;
+    if (matchLength == 0) {
+        return out;
+    }
+
+    *out++ = (unsigned char)distance;
+    *out++ = (unsigned char)(distance >> 8);
+    *token |= (unsigned char)(extra < 15 ? extra : 15);
+    if (extra >= 15) {
+        out = putLength(out, extra - 15);
+    }
+    return out;
+}
+
+size_t lzCompressBound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+size_t lzCompress(const char* input, size_t size, char* output, size_t capacity) {
+    const unsigned char* start = (const unsigned char*)input;
+    const unsigned char* end = start + size;
+    const unsigned char* position = start;
+    const unsigned char* anchor = start;  // First byte not yet emitted
+    unsigned char* out = (unsigned char*)output;
+    const unsigned char* outEnd = out + capacity;
+    unsigned int table[1u << LZ_HASH_BITS];  // Last position seen for each hash
+
+    memset(table, 0, sizeof(table));
+    while (size >= LZ_MIN_MATCH && position <= end - LZ_MIN_MATCH) {
+        unsigned int word = readWord(position);
+        unsigned int slot = hashWord(word);
+        const unsigned char* candidate = start + table[slot];
+        table[slot] = (unsigned int)(position - start);
+
+        if (candidate >= position || (size_t)(position - candidate) > LZ_MAX_DISTANCE || readWord(candidate) != word) {
+            position++;
+            continue;
+        }
+
+        size_t length = LZ_MIN_MATCH;
+        while (position + length < end && candidate[length] == position[length]) {
+            length++;
+        }
+        out = putSequence(out, outEnd, anchor, (size_t)(position - anchor), (size_t)(position - candidate), length);
+        if (out == NULL) {
+            return 0;
+        }
+        position += length;
+        anchor = position;
+    }
+
+    out = putSequence(out, outEnd, anchor, (size_t)(end - anchor), 0, 0);
+    return out != NULL ? (size_t)(out - (unsigned char*)output) : 0;
+}
+
+long lzDecompress(const char* input, size_t size, char* output, size_t capacity) {
+    const unsigned char* in = (const unsigned char*)input;
+    const unsigned char* inEnd = in + size;
+    unsigned char* out = (unsigned char*)output;
+    unsigned char* outStart = out;
+    unsigned char* outEnd = out + capacity;
+    int complete = 0;
+
+    while (in < inEnd) {
+        unsigned int token = *in++;
+        size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && getLength(&in, inEnd, &numLiterals) != 0) {
+            return -1;
+        }
+        if (numLiterals > (size_t)(inEnd - in) || numLiterals > (size_t)(outEnd - out)) {
+            return -1;
+        }
+        memcpy(out, in, numLiterals);
+        in += numLiterals;
+        out += numLiterals;
+        if (in == inEnd) {
+            complete = 1;  // The final sequence has no match
+            break;
+        }
+
+        if (inEnd - in < 2) {
+            return -1;
+        }
+        size_t distance = in[0] | (size_t)in[1] << 8;
+        in += 2;
+        size_t length = token & 15u;
+        if (length == 15 && getLength(&in, inEnd, &length) != 0) {
+            return -1;
+        }
+        length += LZ_MIN_MATCH;
+        if (distance == 0 || distance > (size_t)(out - outStart) || length > (size_t)(outEnd - out)) {
+            return -1;
+        }
+
+        const unsigned char* match = out - distance;
+        if (distance >= length) {
+            memcpy(out, match, length);
+        } else {
+            // The match overlaps what it produces, so it repeats the last distance bytes
+            for (size_t i = 0; i < length; i++) {
+                out[i] = match[i];
+            }
+        }
+        out += length;
+    }
+    return complete ? (long)(out - outStart) : -1;  // Input cut off after a match
+}
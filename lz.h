@@ -0,0 +1,49 @@
+/*
+ * LZ Header File
+ * Small byte-oriented LZ77 codec in the style of LZ4, used for archived garage blocks.
+ *
+ * A compressed block is a run of sequences. Each sequence starts with a token byte: the high
+ * four bits count the literals that follow, the low four bits count the match length minus
+ * LZ_MIN_MATCH. A nibble of 15 continues in extra bytes of up to 255 each. The literals come
+ * next, then the 2-byte little endian distance back to the match and the extra match length
+ * bytes. The last sequence holds only literals.
+ */
+
+#ifndef LZ_H
+#define LZ_H
+
+#include <stddef.h>
+
+#define LZ_MIN_MATCH 4          // Shortest match worth encoding
+#define LZ_MAX_DISTANCE 65535   // Furthest a match may reach back
+#define LZ_HASH_BITS 12         // Compressor hash table of 2^12 positions
+
+/*
+ * Function: lzCompressBound
+ * Purpose: Largest compressed size of an input of the given size.
+ */
+size_t lzCompressBound(size_t);
+
+/*
+ * Function: lzCompress
+ * Purpose: Compresses a block of bytes.
+ * Parameters: const char* - input
+ *             size_t - input size
+ *             char* - output
+ *             size_t - output capacity (lzCompressBound always suffices)
+ * Returns: compressed size, or 0 if the output does not fit
+ */
+size_t lzCompress(const char*, size_t, char*, size_t);
+
+/*
+ * Function: lzDecompress
+ * Purpose: Decompresses a block, checking every length and distance against the buffers.
+ * Parameters: const char* - compressed input
+ *             size_t - compressed size
+ *             char* - output
+ *             size_t - output capacity
+ * Returns: decompressed size, or -1 if the input is malformed or does not fit
+ */
+long lzDecompress(const char*, size_t, char*, size_t);
+
+#endif /* LZ_H */
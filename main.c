@@ -1,11 +1,56 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
 
 #ifndef _MSC_VER
     #define scanf_s scanf
+    #include <unistd.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <sys/wait.h>
+#else
+    #include <io.h>
+    #define dup _dup
+    #define dup2 _dup2
+    #define fileno _fileno
 #endif
 
 #include "vehicle.h"
+#include "garage_compress.h"
+#include "garage_export.h"
+#include "garage_index.h"
+#include "garage_topk.h"
+#include "garage_query.h"
+#include "garage_bitmap.h"
+#include "garage_stats.h"
+#include "vehicle_pool.h"
+#include "garage_scan.h"
+#include "garage_memory.h"
+#include "garage_sketch.h"
+#include "garage_hll.h"
+#include "garage_bloom.h"
+#include "garage_dedup.h"
+#include "garage_join.h"
+#include "garage_transform.h"
+#include "garage_server.h"
+#include "garage_shared.h"
+#include "garage_snapshot.h"
+#include "garage_segment.h"
+#include "garage_loader.h"
+#include "garage_archive.h"
+#include "lz.h"
+#include "hash.h"
+#include "parallel.h"
+
+// Garage visitor that frees each vehicle
+int freeSlot(void* context, char* vehicle, int position) {
+    (void)context;
+    (void)position;
+    freeVehicle(vehicle);
+    return 0;
+}
 
 void clearInputBuffer() {
     int c;
@@ -29,8 +74,33 @@ int mainMenu() {
     printf("4. Error Handling Test\n");
     printf("5. Multiple Vehicles Test\n");
     printf("6. Run All Tests\n");
+    printf("7. Compressed Garage Test\n");
+    printf("8. Export Test\n");
+    printf("9. Description Index Test\n");
+    printf("10. Top-K Test\n");
+    printf("11. Query Test\n");
+    printf("12. Bitmap Index Test\n");
+    printf("13. Year Statistics Test\n");
+    printf("14. Vehicle Pool Test\n");
+    printf("15. Record Format V2 Test\n");
+    printf("16. Parallel Output Test\n");
+    printf("17. Garage Scan Test\n");
+    printf("18. Huge Page / NUMA Garage Test\n");
+    printf("19. Value Sketch Test\n");
+    printf("20. Distinct Model Count Test\n");
+    printf("21. Description Filter Test\n");
+    printf("22. Duplicate Vehicle Test\n");
+    printf("23. Price List Revaluation Test\n");
+    printf("24. Value Transform Test\n");
+    printf("25. Garage Server Test\n");
+    printf("26. Shared Memory Garage Test\n");
+    printf("27. Garage Snapshot Test\n");
+    printf("28. Garage Segment Test\n");
+    printf("29. Garage File Loader Test\n");
+    printf("30. Garage Archive Test\n");
+    printf("31. Header Layout Test\n");
     printf("0. Exit Program\n");
-    printf("Select an option (0-6): ");
+    printf("Select an option (0-31): ");
     scanf_s("%d", &choice);
 
     // Clear input buffer
@@ -84,9 +154,7 @@ void testGarage()
     }
 
     // Free all remaining vehicles and the garage
-    for (int i = 0; i < numVehicles; i++) {
-        free(garage[i]);
-    }
+    forEachVehicle(garage, numVehicles, freeSlot, NULL);
     free(garage);
 
     printf("\nTest completed. All memory freed.\n");
@@ -106,15 +174,15 @@ void testBitManipulation() {
     unsigned int packedData;
 
     // Put the value and year into one 32-bit integer
-    packedData = (value << 11) | year;
+    packedData = packHeader(value, year);
 
     printf("Original value: $%u\n", value);
     printf("Original year: %u\n", year);
     printf("Packed data (hex): 0x%08X\n", packedData);
 
     // fetch value and year from the packed data
-    unsigned int extractedValue = (packedData & 0xFFFFE000) >> 11;
-    unsigned int extractedYear = packedData & 0x000007FF;
+    unsigned int extractedValue = headerValue(packedData);
+    unsigned int extractedYear = headerYear(packedData);
 
     printf("Extracted value: $%u\n", extractedValue);
     printf("Extracted year: %u\n", extractedYear);
@@ -123,7 +191,7 @@ void testBitManipulation() {
     printf("Bit pattern: ");
     for (int i = 31; i >= 0; i--) {
         printf("%d", (packedData >> i) & 1);
-        if (i == 11) printf(" | "); // Separator between value and year bits
+        if (i == VALUE_SHIFT) printf(" | "); // Separator between value and year bits
     }
     printf("\n");
 
@@ -144,9 +212,9 @@ void testBoundaryValues() {
 
     // Test maximum value
     printf("Testing maximum vehicle value...\n");
-    unsigned int maxValue = 2097151; // 2^21 - 1
+    unsigned int maxValue = MAX_VEHICLE_VALUE; // 2^21 - 1 by default
     unsigned int year = 2000;
-    unsigned int packedData = (maxValue << 11) | year;
+    unsigned int packedData = packHeader(maxValue, year);
 
     // Manually create the vehicle
     char* vehicle = (char*)malloc(4 + 13); // 4 bytes + "Max Value Test" + null
@@ -168,8 +236,8 @@ void testBoundaryValues() {
     // Test maximum year
     printf("\nTesting maximum model year...\n");
     unsigned int value = 50000;
-    unsigned int maxYear = 2047; // 2^11 - 1
-    packedData = (value << 11) | maxYear;
+    unsigned int maxYear = MAX_MODEL_YEAR; // 2^11 - 1 by default
+    packedData = packHeader(value, maxYear);
 
     // Manually create the vehicle
     char* vehicle2 = (char*)malloc(4 + 12); // 4 bytes + "Max Year Test" + null
@@ -228,7 +296,7 @@ void testErrorHandling() {
     // Create a vehicle with hardcoded values to avoid input
     unsigned int value = 10000;
     unsigned int year = 2020;
-    unsigned int packedData = (value << 11) | year;
+    unsigned int packedData = packHeader(value, year);
 
     char* vehicle = (char*)malloc(4 + 13); // 4 bytes + "Test Vehicle" + null
     vehicle[0] = (packedData >> 24) & 0xFF;
@@ -275,7 +343,7 @@ void testMultipleVehicles() {
     // Vehicle 1: Honda Civic, 2015, $12000
     unsigned int value1 = 12000;
     unsigned int year1 = 2015;
-    unsigned int packedData1 = (value1 << 11) | year1;
+    unsigned int packedData1 = packHeader(value1, year1);
 
     garage[0] = (char*)malloc(4 + 12); // 4 bytes + "Honda Civic" + null
     garage[0][0] = (packedData1 >> 24) & 0xFF;
@@ -291,7 +359,7 @@ void testMultipleVehicles() {
     // Vehicle 2: Toyota Camry, 2018, $18000
     unsigned int value2 = 18000;
     unsigned int year2 = 2018;
-    unsigned int packedData2 = (value2 << 11) | year2;
+    unsigned int packedData2 = packHeader(value2, year2);
 
     garage[1] = (char*)malloc(4 + 12); // 4 bytes + "Toyota Camry" + null
     garage[1][0] = (packedData2 >> 24) & 0xFF;
@@ -307,7 +375,7 @@ void testMultipleVehicles() {
     // Vehicle 3: Ford F-150, 2020, $35000
     unsigned int value3 = 35000;
     unsigned int year3 = 2020;
-    unsigned int packedData3 = (value3 << 11) | year3;
+    unsigned int packedData3 = packHeader(value3, year3);
 
     garage[2] = (char*)malloc(4 + 10); // 4 bytes + "Ford F-150" + null
     garage[2][0] = (packedData3 >> 24) & 0xFF;
@@ -349,65 +417,2939 @@ void testMultipleVehicles() {
     }
 
     // Free memory
+    forEachVehicle(garage, numVehicles, freeSlot, NULL);
+    free(garage);
+
+    printf("Multiple vehicles test completed.\n");
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+/*
+ * Function: fillSampleGarage
+ * Purpose: Builds the sample vehicles of slots [begin, end) into an existing garage array.
+ *          Slot i always gets the same vehicle.
+ *          Records come from the allocator (NULL for malloc).
+ */
+void fillSampleGarage(char** garage, int begin, int end, const VehicleAllocator* allocator) {
+    static const char* models[] = {
+        "Honda Civic", "Toyota Camry", "Ford F-150", "Chevrolet Malibu",
+        "Nissan Altima", "Tesla Model 3", "Subaru Outback", "Mazda CX-5"
+    };
+
+    for (int i = begin; i < end; i++) {
+        unsigned int value = (unsigned int)((i * 7919u + 1000u) % 60000u);
+        unsigned int year = 1990 + (unsigned int)(i * 31 % 35);
+        garage[i] = buildVehicleWith(allocator, value, year, models[i % 8]);
+    }
+}
+
+/*
+ * Function: buildSampleGarage
+ * Purpose: Builds a garage of hardcoded vehicles so larger tests do not need user input.
+ *          The same numVehicles always produces the same garage.
+ */
+char** buildSampleGarage(int numVehicles) {
+    char** garage = (char**)malloc(numVehicles * sizeof(char*));
+
+    if (garage == NULL) {
+        printf("Error: Memory allocation for garage failed\n");
+        return NULL;
+    }
+
+    fillSampleGarage(garage, 0, numVehicles, NULL);
+    return garage;
+}
+
+/*
+ * Function: shuffleGarage
+ * Purpose: Reorders the slots (always the same way) so consecutive slots point to records
+ *          far apart in memory, the access pattern of a garage built up over time.
+ */
+void shuffleGarage(char** garage, int numVehicles) {
+    unsigned int seed = 12345;
+
+    for (int i = numVehicles - 1; i > 0; i--) {
+        seed = seed * 1103515245u + 12345u;
+        int j = (int)(seed % (unsigned int)(i + 1));
+        char* swap = garage[i];
+        garage[i] = garage[j];
+        garage[j] = swap;
+    }
+}
+
+static int countCompressedVisit(void* context, unsigned int header, const char* description) {
+    (void)header;
+    (void)description;
+    (*(int*)context)++;
+    return 0;
+}
+
+/*
+ * Function: testCompressedGarage
+ * Purpose: Tests converting a garage to the compressed form and back
+ */
+void testCompressedGarage() {
+    printf("\n--- Compressed Garage Test ---\n");
+
+    int numVehicles = 1000;
+    char** garage = buildSampleGarage(numVehicles);
+    CompressedGarage* compressed = compressGarage(garage, numVehicles);
+
+    size_t originalBytes = numVehicles * sizeof(char*);
+    for (int i = 0; i < numVehicles; i++) {
+        originalBytes += 4 + strlen(garage[i] + 4) + 1;
+    }
+    printf("Original garage: %zu bytes (without malloc overhead)\n", originalBytes);
+    printf("Compressed garage: %zu bytes\n", compressedGarageBytes(compressed));
+
+    // Every original vehicle must be found again by its header
+    int failures = 0;
+    for (int i = 0; i < numVehicles; i++) {
+        unsigned int header = vehicleHeader(garage[i]);
+        int position = compressedGarageFind(compressed, header);
+        unsigned int foundHeader;
+        const char* description;
+
+        if (position < 0 || !compressedGarageGet(compressed, position, &foundHeader, &description) ||
+            foundHeader != header) {
+            failures++;
+        }
+    }
+
+    int scanned = 0;
+    compressedGarageScan(compressed, countCompressedVisit, &scanned);
+
+    int restoredVehicles;
+    char** restored = decompressGarage(compressed, &restoredVehicles);
+    printf("Scanned %d vehicles, restored %d vehicles\n", scanned, restoredVehicles);
+    displayGarage(restored, 3);
+
+    if (failures == 0 && scanned == numVehicles && restoredVehicles == numVehicles) {
+        printf("Compressed garage test passed.\n");
+    } else {
+        printf("Compressed garage test FAILED (%d lookups failed).\n", failures);
+    }
+
+    freeGarage(garage, numVehicles);
+    freeGarage(restored, restoredVehicles);
+    freeCompressedGarage(compressed);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+/*
+ * Function: testExport
+ * Purpose: Tests the CSV, JSON and NDJSON exporters, including descriptions that need escaping
+ */
+void testExport() {
+    printf("\n--- Export Test ---\n");
+
+    int numVehicles = 3;
+    char** garage = (char**)malloc(numVehicles * sizeof(char*));
+    garage[0] = buildVehicle(12000, 2015, "Honda Civic");
+    garage[1] = buildVehicle(18000, 2018, "Toyota \"Camry\", LE");
+    garage[2] = buildVehicle(35000, 2020, "Ford F-150\tcrew\\cab");
+
+    char buffer[1024];
+    const char* names[] = {"CSV", "JSON", "NDJSON"};
+    ExportFormat formats[] = {EXPORT_CSV, EXPORT_JSON, EXPORT_NDJSON};
+
+    for (int i = 0; i < 3; i++) {
+        long length = exportGarageToBuffer(garage, numVehicles, formats[i], buffer, sizeof(buffer));
+        printf("%s (%ld bytes):\n%s", names[i], length, buffer);
+    }
+
+    // A buffer that is too small must be reported instead of silently truncated
+    if (exportGarageToBuffer(garage, numVehicles, EXPORT_JSON, buffer, 16) == -1) {
+        printf("Successfully rejected a buffer that is too small.\n");
+    }
+
+    printf("NDJSON streamed to standard output:\n");
+    fflush(stdout);
+    if (exportGarageToFd(garage, numVehicles, EXPORT_NDJSON, 1) == 0) {
+        printf("Export test completed.\n");
+    }
+
+    freeGarage(garage, numVehicles);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+/*
+ * Function: testVehicleIndex
+ * Purpose: Tests exact description lookups and that the index follows adds and removals
+ */
+void testVehicleIndex() {
+    printf("\n--- Description Index Test ---\n");
+
+    int numVehicles = 1000;
+    char** garage = buildSampleGarage(numVehicles);
+    VehicleIndex* index = buildVehicleIndex(garage, numVehicles);
+    attachVehicleIndex(index, NULL);
+
+    int count;
+    vehicleIndexLookup(index, "Toyota Camry", &count);
+    printf("Distinct descriptions: %d\n", vehicleIndexDescriptions(index));
+    printf("Toyota Camry vehicles: %d (expected 125)\n", count);
+
+    // Vehicle 2 is a Toyota Camry
+    garage = removeVehicle(garage, numVehicles--, 1);
+    vehicleIndexLookup(index, "Toyota Camry", &count);
+    printf("After removing one: %d (expected 124)\n", count);
+
+    garage = addVehicle(garage, numVehicles++, buildVehicle(21000, 2021, "Toyota Camry"));
+    char* const* matches = vehicleIndexLookup(index, "Toyota Camry", &count);
+    printf("After adding one: %d (expected 125)\n", count);
+    displayVehicle(matches[count - 1]);
+
+    // createVehicle makes v2 records, whose description hash is stored when they are built
+    char* stored = buildVehicleV2(22000, 2022, "Toyota Camry");
+    int storedHashOk = vehicleDescriptionHash(stored) == hashDescription("Toyota Camry");
+    garage = addVehicle(garage, numVehicles++, stored);
+    vehicleIndexLookup(index, "Toyota Camry", &count);
+    garage = removeVehicle(garage, numVehicles, numVehicles - 1);
+    numVehicles--;
+    int afterStored;
+    vehicleIndexLookup(index, "Toyota Camry", &afterStored);
+    printf("v2 record with a stored hash added and removed: %s\n",
+           storedHashOk && count == 126 && afterStored == 125 ? "yes" : "no");
+
+    if (vehicleIndexLookup(index, "DeLorean DMC-12", &count) == NULL && count == 0) {
+        printf("Successfully found no match for a missing description.\n");
+    }
+
+    freeGarage(garage, numVehicles);
+    printf("Descriptions left after freeing the garage: %d\n", vehicleIndexDescriptions(index));
+
+    detachVehicleIndex(index, NULL);
+    freeVehicleIndex(index);
+
+    printf("Description index test completed.\n");
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+/*
+ * Function: testTopK
+ * Purpose: Tests the serial and parallel top-K selection against each other
+ */
+void testTopK() {
+    printf("\n--- Top-K Test ---\n");
+
+    int numVehicles = 100000;
+    int k = 5;
+    char** garage = buildSampleGarage(numVehicles);
+    char* serial[5];
+    char* parallel[5];
+
+    int mismatches = 0;
+    int most[] = {TOPK_MOST_VALUABLE, TOPK_LEAST_VALUABLE};
+
+    for (int m = 0; m < 2; m++) {
+        int found = topKVehicles(garage, numVehicles, k, most[m], serial);
+        int foundParallel = topKVehiclesParallel(garage, numVehicles, k, most[m], parallel, 4);
+
+        printf("%s valuable %d vehicles:\n", most[m] ? "Most" : "Least", found);
+        for (int i = 0; i < found; i++) {
+            displayVehicle(serial[i]);
+            if (i >= foundParallel || serial[i] != parallel[i]) {
+                mismatches++;
+            }
+        }
+    }
+
+    if (mismatches == 0) {
+        printf("Top-K test passed (serial and parallel agree).\n");
+    } else {
+        printf("Top-K test FAILED (%d mismatches).\n", mismatches);
+    }
+
+    freeGarage(garage, numVehicles);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+/*
+ * Function: testQuery
+ * Purpose: Tests a composite query against a straightforward check of every vehicle
+ */
+void testQuery() {
+    printf("\n--- Query Test ---\n");
+
+    int numVehicles = 10000;
+    char** garage = buildSampleGarage(numVehicles);
+    int* selection = (int*)malloc(numVehicles * sizeof(int));
+
+    // year in [2010, 2020] AND value in [$5,000, $39,999] AND description starts with "Ford"
+    VehicleQuery query;
+    initVehicleQuery(&query);
+    query.minYear = 2010;
+    query.maxYear = 2020;
+    query.minValue = 5000;
+    query.maxValue = 39999;
+    query.descriptionPrefix = "Ford";
+
+    int found = queryGarage(garage, numVehicles, &query, selection);
+
+    int expected = 0;
+    int mismatches = 0;
+    for (int i = 0; i < numVehicles; i++) {
+        unsigned int packedData = vehicleHeader(garage[i]);
+        unsigned int value = headerValue(packedData);
+        unsigned int year = headerYear(packedData);
+
+        if (year >= 2010 && year <= 2020 && value >= 5000 && value <= 39999 &&
+            strncmp(vehicleDescription(garage[i]), "Ford", 4) == 0) {
+            if (expected >= found || selection[expected] != i) {
+                mismatches++;
+            }
+            expected++;
+        }
+    }
+
+    printf("Matching vehicles: %d (expected %d)\n", found, expected);
+    if (found > 0) {
+        displayVehicle(garage[selection[0]]);
+    }
+
+    if (found == expected && mismatches == 0) {
+        printf("Query test passed.\n");
+    } else {
+        printf("Query test FAILED.\n");
+    }
+
+    free(selection);
+    freeGarage(garage, numVehicles);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+// Counts vehicles with year in [minYear, maxYear] and value bucket in [minBucket, maxBucket]
+static long countByScanning(char** garage, int numVehicles, unsigned int minYear, unsigned int maxYear,
+                            unsigned int minBucket, unsigned int maxBucket) {
+    long count = 0;
+    for (int i = 0; i < numVehicles; i++) {
+        unsigned int packedData = vehicleHeader(garage[i]);
+        unsigned int bucket = headerValue(packedData) >> VALUE_BUCKET_BITS;
+        if (headerYear(packedData) >= minYear && headerYear(packedData) <= maxYear &&
+            bucket >= minBucket && bucket <= maxBucket) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/*
+ * Function: testBitmapIndex
+ * Purpose: Tests bitmap index counts against a scan, before and after removing vehicles
+ */
+void testBitmapIndex() {
+    printf("\n--- Bitmap Index Test ---\n");
+
+    int numVehicles = 5000;
+    char** garage = buildSampleGarage(numVehicles);
+    GarageBitmapIndex* index = buildGarageBitmapIndex(garage, numVehicles);
+    attachGarageBitmapIndex(index, NULL);
+
+    // year in [2000, 2010] AND value in [$0, $16,383] (buckets 0 and 1)
+    long fromIndex = countYearValueRange(index, 2000, 2010, 0, 2 * VALUE_BUCKET_WIDTH - 1);
+    long fromScan = countByScanning(garage, numVehicles, 2000, 2010, 0, 1);
+    printf("Before removal: index %ld, scan %ld\n", fromIndex, fromScan);
+    int passed = fromIndex == fromScan;
+
+    // Remove from the front, the middle and the end so positions shift
+    int removals[] = {0, numVehicles / 2, numVehicles - 3};
+    for (int i = 0; i < 3; i++) {
+        garage = removeVehicle(garage, numVehicles--, removals[i]);
+    }
+
+    fromIndex = countYearValueRange(index, 2000, 2010, 0, 2 * VALUE_BUCKET_WIDTH - 1);
+    fromScan = countByScanning(garage, numVehicles, 2000, 2010, 0, 1);
+    printf("After removal: index %ld, scan %ld\n", fromIndex, fromScan);
+    passed = passed && fromIndex == fromScan;
+
+    // Every position in a year bitmap must hold a vehicle of that year
+    Bitmap* years = yearRangeBitmap(index, 2015, 2015);
+    unsigned int* positions = (unsigned int*)malloc(numVehicles * sizeof(unsigned int));
+    long count = bitmapToArray(years, positions);
+    for (long i = 0; i < count; i++) {
+        if (headerYear(vehicleHeader(garage[positions[i]])) != 2015) {
+            passed = 0;
+        }
+    }
+    printf("Vehicles from 2015: %ld\n", count);
+
+    printf("Bitmap index test %s.\n", passed ? "passed" : "FAILED");
+
+    free(positions);
+    freeBitmap(years);
+    detachGarageBitmapIndex(index, NULL);
+    freeGarageBitmapIndex(index);
+    freeGarage(garage, numVehicles);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+// Compares the materialized aggregate of every year with one computed by scanning
+static int yearStatsMatchGarage(const GarageYearStats* stats, char** garage, int numVehicles) {
+    for (unsigned int year = 1990; year < 2025; year++) {
+        YearAggregate expected = {0, 0, MAX_VEHICLE_VALUE, 0};
+        YearAggregate actual;
+
+        for (int i = 0; i < numVehicles; i++) {
+            unsigned int packedData = vehicleHeader(garage[i]);
+            unsigned int value = headerValue(packedData);
+            if (headerYear(packedData) == year) {
+                expected.count++;
+                expected.sum += value;
+                expected.minValue = value < expected.minValue ? value : expected.minValue;
+                expected.maxValue = value > expected.maxValue ? value : expected.maxValue;
+            }
+        }
+
+        readYearAggregate(stats, year, &actual);
+        if (actual.count != expected.count || actual.sum != expected.sum ||
+            (expected.count > 0 && (actual.minValue != expected.minValue || actual.maxValue != expected.maxValue))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Function: testYearStats
+ * Purpose: Tests that per-year aggregates follow removals, including of the min and max vehicle
+ */
+void testYearStats() {
+    printf("\n--- Year Statistics Test ---\n");
+
+    int numVehicles = 2000;
+    char** garage = buildSampleGarage(numVehicles);
+    GarageYearStats* stats = buildGarageYearStats(garage, numVehicles);
+    attachGarageYearStats(stats, NULL);
+
+    YearAggregate aggregate;
+    readYearAggregate(stats, 2015, &aggregate);
+    printf("2015: %ld vehicles, total $%lld, average $%.2f, min $%u, max $%u\n",
+           aggregate.count, aggregate.sum, yearAverageValue(stats, 2015), aggregate.minValue, aggregate.maxValue);
+    int passed = yearStatsMatchGarage(stats, garage, numVehicles);
+
+    // Remove the most valuable 2015 vehicle so the maximum has to fall back to the next one
+    for (int i = 0; i < numVehicles; i++) {
+        unsigned int packedData = vehicleHeader(garage[i]);
+        if (headerYear(packedData) == 2015 && headerValue(packedData) == aggregate.maxValue) {
+            garage = removeVehicle(garage, numVehicles--, i);
+            break;
+        }
+    }
+    for (int i = 0; i < 500; i++) {
+        int position = (i * 37) % numVehicles;
+        garage = removeVehicle(garage, numVehicles--, position);
+    }
+
+    readYearAggregate(stats, 2015, &aggregate);
+    printf("2015 after removals: %ld vehicles, average $%.2f, max $%u\n",
+           aggregate.count, yearAverageValue(stats, 2015), aggregate.maxValue);
+    passed = passed && yearStatsMatchGarage(stats, garage, numVehicles);
+
+    printf("Year statistics test %s.\n", passed ? "passed" : "FAILED");
+
+    detachGarageYearStats(stats, NULL);
+    freeGarageYearStats(stats);
+    freeGarage(garage, numVehicles);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+// Churns records through the pool on worker 1, a thread that exits afterwards
+void poolThreadTask(void* context, int begin, int end, int worker) {
+    VehiclePool* pool = (VehiclePool*)context;
+    char* records[40];
+    (void)begin;
+    (void)end;
+
+    if (worker != 1) {
+        return;
+    }
+    for (int i = 0; i < 40; i++) {
+        records[i] = vehiclePoolAllocate(pool, 24);
+    }
+    for (int i = 0; i < 40; i++) {
+        vehiclePoolFree(pool, records[i], 24);
+    }
+}
+
+/*
+ * Function: testVehiclePool
+ * Purpose: Tests that churning vehicles through a pool stops reaching the system allocator,
+ *          and that thread caches give their records back on thread exit and pool switches
+ */
+void testVehiclePool() {
+    printf("\n--- Vehicle Pool Test ---\n");
+
+    VehiclePool* pool = createVehiclePool();
+    const VehicleAllocator* allocator = vehiclePoolAllocator(pool);
+    VehiclePoolStats before;
+    VehiclePoolStats after;
+
+    // The garage owns the pool: its records are created and freed through it
+    int numVehicles = 1000;
+    char** garage = (char**)malloc(numVehicles * sizeof(char*));
+    fillSampleGarage(garage, 0, numVehicles, allocator);
+    vehiclePoolGetStats(pool, &before);
+    printf("After building: %ld system allocations, %ld slabs, %ld records in use\n",
+           before.systemAllocations, before.slabs, before.recordsInUse);
+
+    // Replace vehicles over and over, with descriptions of different lengths
+    static const char* models[] = {"Kia Rio", "Toyota Land Cruiser", "Ford Focus", "Volkswagen Golf GTI"};
+    for (int round = 0; round < 100000; round++) {
+        int slot = (round * 7) % numVehicles;
+        freeVehicleWith(allocator, garage[slot]);
+        garage[slot] = buildVehicleWith(allocator, round % 50000, 2000 + round % 25, models[round % 4]);
+    }
+
+    vehiclePoolGetStats(pool, &after);
+    printf("After 100000 replacements: %ld system allocations, %ld slabs, %ld records in use\n",
+           after.systemAllocations, after.slabs, after.recordsInUse);
+
+    // Steady state: only the first few new size classes may have needed a slab
+    if (after.recordsInUse == numVehicles && after.systemAllocations - before.systemAllocations <= 4) {
+        printf("Vehicle pool test passed.\n");
+    } else {
+        printf("Vehicle pool test FAILED.\n");
+    }
+
+    vehiclePoolFreeGarage(pool, garage, numVehicles);
+    vehiclePoolGetStats(pool, &after);
+    printf("After bulk return: %ld records in use\n", after.recordsInUse);
+
+    // removeVehicleWith and freeGarageWith give the records back to the garage's pool
+    garage = (char**)malloc(4 * sizeof(char*));
+    fillSampleGarage(garage, 0, 4, allocator);
+    garage = removeVehicleWith(garage, 4, 1, allocator);
+    vehiclePoolGetStats(pool, &before);
+    freeGarageWith(garage, 3, allocator);
+    vehiclePoolGetStats(pool, &after);
+    printf("Removed and freed vehicles returned to the pool: %s\n",
+           before.recordsInUse == 3 && after.recordsInUse == 0 ? "yes" : "no");
+
+    // A thread that exits returns what it cached; this thread has already carved the class
+    vehiclePoolFree(pool, vehiclePoolAllocate(pool, 24), 24);
+    vehiclePoolGetStats(pool, &before);
+    parallelFor(2, 2, poolThreadTask, pool);
+    vehiclePoolGetStats(pool, &after);
+    int exitOk = after.sharedRecords == before.sharedRecords;
+    printf("Records cached by an exited thread returned to the pool: %s\n", exitOk ? "yes" : "no");
+
+    // Moving to another pool returns this thread's cached records to the first one
+    VehiclePool* other = createVehiclePool();
+    vehiclePoolFree(other, vehiclePoolAllocate(other, 24), 24);
+    vehiclePoolGetStats(pool, &before);
+    int switchOk = before.sharedRecords > after.sharedRecords;
+    printf("Records cached for one pool returned when switching pools: %s\n", switchOk ? "yes" : "no");
+    destroyVehiclePool(other);
+
+    printf("Thread cache test %s.\n", exitOk && switchOk ? "passed" : "FAILED");
+    destroyVehiclePool(pool);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+/*
+ * Function: testRecordFormatV2
+ * Purpose: Tests v2 records next to v1 records: conversion, accessors, display, export and lookup
+ */
+void testRecordFormatV2() {
+    printf("\n--- Record Format V2 Test ---\n");
+
+    int numVehicles = 1000;
+    char** garage = buildSampleGarage(numVehicles);
+    char** mixed = buildSampleGarage(numVehicles);
+    int mismatches = 0;
+
+    // Convert every other vehicle so both formats sit in one garage
+    for (int i = 0; i < numVehicles; i += 2) {
+        char* converted = convertVehicleToV2(mixed[i]);
+        freeVehicle(mixed[i]);
+        mixed[i] = converted;
+    }
+
+    for (int i = 0; i < numVehicles; i++) {
+        if (isVehicleV2(mixed[i]) != (i % 2 == 0) ||
+            vehicleHeader(mixed[i]) != vehicleHeader(garage[i]) ||
+            vehicleDescriptionLength(mixed[i]) != strlen(vehicleDescription(garage[i])) ||
+            strcmp(vehicleDescription(mixed[i]), vehicleDescription(garage[i])) != 0) {
+            mismatches++;
+        }
+    }
+    printf("Header/description mismatches: %d\n", mismatches);
+
+    printf("v1: ");
+    displayVehicle(garage[0]);
+    printf("v2: ");
+    displayVehicle(mixed[0]);
+
+    char* v2 = buildVehicleV2(MAX_VEHICLE_VALUE, MAX_MODEL_YEAR, "");
+    printf("Empty description v2 record: %zu bytes, ", vehicleRecordSize(v2));
+    displayVehicle(v2);
+    freeVehicle(v2);
+
+    // A description that would make a v1 record look like a v2 tag is refused
+    char* refused = buildVehicle(0, 0, "\x01V2");
+    printf("Tag-like v1 description refused: %s\n", refused == NULL ? "yes" : "no");
+    freeVehicle(refused);
+    // The same from a packed header, as the loaders build records, and as a stored record.
+    // A nonzero header is refused too, since revaluing could rewrite it to 0 later.
+    char* refusedRecord = buildVehicleRecord(0, "\x01V2", 3);
+    char* refusedLater = buildVehicleRecord(packHeader(1, MIN_MODEL_YEAR), "\x01V2", 3);
+    char* refusedV2 = buildVehicleRecordV2(packHeader(1, MIN_MODEL_YEAR), "\x01V2", 3);
+    const char storedTag[] = VEHICLE_V2_TAG;
+    const char storedLater[] = "\0\0\x08\0\x01V2";
+    int reservedOk = refusedRecord == NULL && refusedLater == NULL && refusedV2 == NULL &&
+                     isReservedVehicleRecord(storedTag) && isReservedVehicleRecord(storedLater) &&
+                     !isReservedVehicleRecord(garage[0]);
+    printf("Tag-like record refused and detected when stored: %s\n", reservedOk ? "yes" : "no");
+    freeVehicle(refusedRecord);
+    freeVehicle(refusedLater);
+    freeVehicle(refusedV2);
+
+    // Exports must not depend on the record format
+    size_t capacity = 256 * 1024;
+    char* expected = (char*)malloc(capacity);
+    char* actual = (char*)malloc(capacity);
+    long expectedLength = exportGarageToBuffer(garage, numVehicles, EXPORT_JSON, expected, capacity);
+    long actualLength = exportGarageToBuffer(mixed, numVehicles, EXPORT_JSON, actual, capacity);
+    int sameExport = expectedLength > 0 && expectedLength == actualLength && memcmp(expected, actual, expectedLength) == 0;
+    printf("JSON export identical: %s\n", sameExport ? "yes" : "no");
+    free(expected);
+    free(actual);
+
+    VehicleIndex* index = buildVehicleIndex(mixed, numVehicles);
+    int count = 0;
+    vehicleIndexLookup(index, "Honda Civic", &count);
+    printf("Index lookup 'Honda Civic' in mixed garage: %d vehicles\n", count);
+    freeVehicleIndex(index);
+
+    if (mismatches == 0 && refused == NULL && reservedOk && sameExport && count == numVehicles / 8) {
+        printf("Record format v2 test passed.\n");
+    } else {
+        printf("Record format v2 test FAILED.\n");
+    }
+
     for (int i = 0; i < numVehicles; i++) {
-        free(garage[i]);
+        freeVehicle(garage[i]);
+        freeVehicle(mixed[i]);
     }
     free(garage);
+    free(mixed);
 
-    printf("Multiple vehicles test completed.\n");
     printf("Press Enter to continue...");
     getchar();
 }
 
 /*
- * Function: runAllTests
- * Purpose: Runs all test functions
+ * Function: readDisplayOutput
+ * Purpose: Runs displayGarageParallel with standard output redirected to a temporary file
+ *          and returns what it printed (numThreads 1 with a small garage is the serial path).
  */
-void runAllTests() {
-    printf("\n=== Running All Tests ===\n");
+char* readDisplayOutput(char** garage, int numVehicles, int numThreads, long* length) {
+    FILE* capture = tmpfile();
+    if (capture == NULL) {
+        return NULL;
+    }
 
-    testGarage();
-    testBitManipulation();
-    testBoundaryValues();
-    testErrorHandling();
-    testMultipleVehicles();
+    fflush(stdout);
+    int savedStdout = dup(1);
+    dup2(fileno(capture), 1);
+    if (numThreads == 1) {
+        displayGarage(garage, numVehicles);
+    } else {
+        displayGarageParallel(garage, numVehicles, numThreads);
+    }
+    fflush(stdout);
+    dup2(savedStdout, 1);
+    close(savedStdout);
+
+    *length = ftell(capture);
+    char* output = (char*)malloc(*length + 1);
+    rewind(capture);
+    *length = (long)fread(output, 1, *length, capture);
+    fclose(capture);
+    return output;
+}
+
+/*
+ * Function: testParallelOutput
+ * Purpose: Tests that displayGarage and the exporters produce the same bytes on many threads
+ */
+void testParallelOutput() {
+    printf("\n--- Parallel Output Test ---\n");
+
+    int numVehicles = 300000;
+    char** garage = buildSampleGarage(numVehicles);
+    int failures = 0;
+
+    // Empty slots, including the first ones so the JSON comma logic is exercised
+    for (int i = 0; i < numVehicles; i += 1000) {
+        freeVehicle(garage[i]);
+        garage[i] = NULL;
+    }
+    freeVehicle(garage[1]);
+    garage[1] = NULL;
+
+    // Display: the serial printf loop against 4 threads on a garage below the threshold
+    long serialLength = 0;
+    long parallelLength = 0;
+    char* serial = readDisplayOutput(garage, 5000, 1, &serialLength);
+    char* parallel = readDisplayOutput(garage, 5000, 4, &parallelLength);
+    int same = serial != NULL && parallel != NULL && serialLength == parallelLength &&
+               memcmp(serial, parallel, serialLength) == 0;
+    printf("displayGarage, 5000 vehicles, 4 threads: %s (%ld bytes)\n", same ? "identical" : "DIFFERENT", serialLength);
+    failures += !same;
+    free(serial);
+    free(parallel);
+
+    // Exports of the full garage: 1 thread against 4 threads, for every format
+    size_t capacity = 32 * 1024 * 1024;
+    char* expected = (char*)malloc(capacity);
+    char* actual = (char*)malloc(capacity);
+    const char* names[] = {"CSV", "JSON", "NDJSON"};
+    ExportFormat formats[] = {EXPORT_CSV, EXPORT_JSON, EXPORT_NDJSON};
+
+    for (int f = 0; f < 3; f++) {
+        long expectedLength = exportGarageToBufferParallel(garage, numVehicles, formats[f], expected, capacity, 1);
+        long actualLength = exportGarageToBufferParallel(garage, numVehicles, formats[f], actual, capacity, 4);
+        same = expectedLength > 0 && expectedLength == actualLength && memcmp(expected, actual, expectedLength) == 0;
+        printf("%s export, %d vehicles, 4 threads: %s (%ld bytes)\n", names[f], numVehicles,
+               same ? "identical" : "DIFFERENT", actualLength);
+        failures += !same;
+    }
+
+    // The file descriptor exporter goes through the same chunks
+    FILE* file = tmpfile();
+    long fileLength = -1;
+    if (file != NULL && exportGarageToFdParallel(garage, numVehicles, EXPORT_NDJSON, fileno(file), 4) == 0) {
+        fseek(file, 0, SEEK_SET);
+        fileLength = (long)fread(actual, 1, capacity, file);
+    }
+    long expectedLength = exportGarageToBufferParallel(garage, numVehicles, EXPORT_NDJSON, expected, capacity, 1);
+    same = fileLength == expectedLength && memcmp(expected, actual, expectedLength) == 0;
+    printf("NDJSON to a file, 4 threads: %s\n", same ? "identical" : "DIFFERENT");
+    failures += !same;
+    if (file != NULL) {
+        fclose(file);
+    }
+
+    // A caller buffer that is too small is still reported
+    if (exportGarageToBufferParallel(garage, numVehicles, EXPORT_CSV, actual, 4096, 4) != -1) {
+        failures++;
+    }
+
+    if (failures == 0) {
+        printf("Parallel output test passed.\n");
+    } else {
+        printf("Parallel output test FAILED.\n");
+    }
+
+    free(expected);
+    free(actual);
+    freeGarage(garage, numVehicles);
 
-    printf("\n=== All Tests Completed ===\n");
     printf("Press Enter to continue...");
     getchar();
 }
 
+typedef struct {
+    unsigned long long valueSum;
+    long visited;
+    int lastPosition;
+    int ordered;    // Stays 1 while positions arrive in the expected order
+    int direction;
+    int stopAt;     // Position at which the visitor stops the scan, -1 for never
+} ScanCheck;
+
+int checkSlot(void* context, char* vehicle, int position) {
+    ScanCheck* check = (ScanCheck*)context;
+    int expected = check->direction == GARAGE_SCAN_FORWARD ? check->lastPosition + 1 : check->lastPosition - 1;
+
+    check->ordered &= position == expected;
+    check->lastPosition = position;
+    check->visited++;
+    if (vehicle != NULL) {
+        check->valueSum += headerValue(vehicleHeader(vehicle));
+    }
+    return position == check->stopAt ? 7 : 0;
+}
+
 /*
- * Function: main
- * Purpose: Entry point for the program
+ * Function: testGarageScan
+ * Purpose: Tests the prefetching garage scan and times it against a plain loop
  */
-int main() {
-    int choice;
+void testGarageScan() {
+    printf("\n--- Garage Scan Test ---\n");
 
-    do {
-        choice = mainMenu();
+    int numVehicles = 1000000;
+    char** garage = buildSampleGarage(numVehicles);
+    int failures = 0;
 
-        switch (choice) {
-            case 0:
-                printf("Exiting program. Goodbye!\n");
-                break;
-            case 1:
-                testGarage();
-                break;
-            case 2:
-                testBitManipulation();
-                break;
-            case 3:
-                testBoundaryValues();
-                break;
-            case 4:
-                testErrorHandling();
-                break;
-            case 5:
-                testMultipleVehicles();
-                break;
-            case 6:
-                runAllTests();
+    shuffleGarage(garage, numVehicles);
+    freeVehicle(garage[3]);
+    garage[3] = NULL;
+
+    clock_t start = clock();
+    unsigned long long expected = 0;
+    for (int i = 0; i < numVehicles; i++) {
+        if (garage[i] != NULL) {
+            expected += headerValue(vehicleHeader(garage[i]));
+        }
+    }
+    printf("Plain loop:             %.1f ms\n", 1000.0 * (clock() - start) / CLOCKS_PER_SEC);
+
+    int distances[] = {0, 4, 16, 64};
+    for (int d = 0; d < 4; d++) {
+        ScanCheck check = {0, 0, -1, 1, GARAGE_SCAN_FORWARD, -1};
+        start = clock();
+        scanGarage(garage, numVehicles, GARAGE_SCAN_FORWARD, distances[d], checkSlot, &check);
+        printf("Prefetch distance %3d:  %.1f ms\n", distances[d], 1000.0 * (clock() - start) / CLOCKS_PER_SEC);
+        if (check.valueSum != expected || check.visited != numVehicles || !check.ordered) {
+            failures++;
+        }
+    }
+
+    // Reverse order, and a visitor that stops the scan early
+    ScanCheck reverse = {0, 0, numVehicles, 1, GARAGE_SCAN_REVERSE, -1};
+    scanGarage(garage, numVehicles, GARAGE_SCAN_REVERSE, GARAGE_PREFETCH_DISTANCE, checkSlot, &reverse);
+    ScanCheck stopped = {0, 0, -1, 1, GARAGE_SCAN_FORWARD, 10};
+    int result = forEachVehicle(garage, numVehicles, checkSlot, &stopped);
+    printf("Reverse scan in order: %s, early stop after %ld slots (returned %d)\n",
+           reverse.ordered && reverse.valueSum == expected ? "yes" : "no", stopped.visited, result);
+    if (!reverse.ordered || reverse.valueSum != expected || stopped.visited != 11 || result != 7) {
+        failures++;
+    }
+
+    if (failures == 0) {
+        printf("Garage scan test passed.\n");
+    } else {
+        printf("Garage scan test FAILED.\n");
+    }
+
+    freeGarage(garage, numVehicles);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+int sumSlot(void* context, char* vehicle, int position) {
+    (void)position;
+    if (vehicle != NULL) {
+        *(unsigned long long*)context += headerValue(vehicleHeader(vehicle));
+    }
+    return 0;
+}
+
+// Best of three full scans, in milliseconds
+double timeGarageScan(char** garage, int numVehicles, unsigned long long* valueSum) {
+    double best = 0;
+
+    for (int run = 0; run < 3; run++) {
+        *valueSum = 0;
+        clock_t start = clock();
+        forEachVehicle(garage, numVehicles, sumSlot, valueSum);
+        double elapsed = 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+        best = run == 0 || elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+typedef struct {
+    char** garage;
+    unsigned long long* sums;  // One per shard
+} ShardScan;
+
+// Worker i scans shard i on the CPUs of the node holding its records
+void scanShardPinned(void* context, int begin, int end, int worker) {
+    ShardScan* scan = (ShardScan*)context;
+    int pinned = pinThreadToNode(worker % numaNodeCount()) == 0;
+
+    scan->sums[worker] = 0;
+    forEachVehicle(scan->garage + begin, end - begin, sumSlot, &scan->sums[worker]);
+    if (pinned) {
+        unpinThread();
+    }
+}
+
+/*
+ * Function: testGarageMemory
+ * Purpose: Benchmarks full-garage scans under the huge page and NUMA allocation policies
+ */
+void testGarageMemory() {
+    printf("\n--- Huge Page / NUMA Garage Test ---\n");
+
+    int numVehicles = 2000000;
+    int nodes = numaNodeCount();
+    int failures = 0;
+    unsigned long long expected = 0;
+    unsigned long long valueSum = 0;
+    static const char* pageNames[] = {"normal", "transparent huge", "explicit huge"};
+
+    printf("%d NUMA node(s), %d vehicles, slots shuffled\n", nodes, numVehicles);
+
+    // Baseline: malloc records and array
+    char** garage = buildSampleGarage(numVehicles);
+    shuffleGarage(garage, numVehicles);
+    printf("%-32s%7.1f ms\n", "malloc:", timeGarageScan(garage, numVehicles, &expected));
+    freeGarage(garage, numVehicles);
+
+    GarageMemoryPolicy policies[] = {
+        {GARAGE_PAGES_DEFAULT, GARAGE_NUMA_DEFAULT, 0},
+        {GARAGE_PAGES_TRANSPARENT, GARAGE_NUMA_DEFAULT, 0},
+        {GARAGE_PAGES_EXPLICIT, GARAGE_NUMA_DEFAULT, 0},
+        {GARAGE_PAGES_TRANSPARENT, GARAGE_NUMA_INTERLEAVE, 0}
+    };
+    static const char* policyNames[] = {"arena, normal pages:", "arena, transparent huge:", "arena, explicit huge:",
+                                        "arena, huge + interleaved:"};
+
+    for (int p = 0; p < 4; p++) {
+        GarageArena* arena = createGarageArena(&policies[p]);
+        garage = createGarageArray(numVehicles, &policies[p]);
+        fillSampleGarage(garage, 0, numVehicles, garageArenaAllocator(arena));
+        shuffleGarage(garage, numVehicles);
+
+        double elapsed = timeGarageScan(garage, numVehicles, &valueSum);
+        printf("%-32s%7.1f ms  (got %s pages)\n", policyNames[p], elapsed,
+               pageNames[garageMemoryPagesUsed(arena)]);
+        failures += valueSum != expected;
+
+        freeGarageArray(garage, numVehicles);
+        destroyGarageArena(arena);
+    }
+
+    // One shard per node: records bound to the node, scanned by a worker pinned to it
+    GarageMemoryPolicy interleaved = {GARAGE_PAGES_TRANSPARENT, GARAGE_NUMA_INTERLEAVE, 0};
+    GarageArena** arenas = (GarageArena**)malloc(nodes * sizeof(GarageArena*));
+    unsigned long long* sums = (unsigned long long*)calloc(nodes, sizeof(unsigned long long));
+    garage = createGarageArray(numVehicles, &interleaved);
+
+    for (int node = 0; node < nodes; node++) {
+        GarageMemoryPolicy bound = {GARAGE_PAGES_TRANSPARENT, GARAGE_NUMA_BIND, node};
+        arenas[node] = createGarageArena(&bound);
+        // Same split as parallelFor so shard i is exactly worker i's range
+        fillSampleGarage(garage, (int)((long long)numVehicles * node / nodes),
+                         (int)((long long)numVehicles * (node + 1) / nodes), garageArenaAllocator(arenas[node]));
+    }
+
+    // Wall time: clock() would add up the CPU time of every worker
+    ShardScan scan = {garage, sums};
+    struct timespec start;
+    struct timespec finish;
+    timespec_get(&start, TIME_UTC);
+    parallelFor(numVehicles, nodes, scanShardPinned, &scan);
+    timespec_get(&finish, TIME_UTC);
+    double elapsed = (finish.tv_sec - start.tv_sec) * 1000.0 + (finish.tv_nsec - start.tv_nsec) / 1e6;
+    valueSum = 0;
+    for (int node = 0; node < nodes; node++) {
+        valueSum += sums[node];
+    }
+    printf("%-32s%7.1f ms  (slots in order)\n", "sharded per node, pinned:", elapsed);
+    failures += valueSum != expected;
+
+    freeGarageArray(garage, numVehicles);
+    for (int node = 0; node < nodes; node++) {
+        destroyGarageArena(arenas[node]);
+    }
+    free(arenas);
+    free(sums);
+
+    if (failures == 0) {
+        printf("Garage memory test passed.\n");
+    } else {
+        printf("Garage memory test FAILED.\n");
+    }
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+int compareValues(const void* a, const void* b) {
+    unsigned int left = *(const unsigned int*)a;
+    unsigned int right = *(const unsigned int*)b;
+    return (left > right) - (left < right);
+}
+
+/*
+ * Function: sketchMatchesGarage
+ * Purpose: Compares p50 / p90 / p99 of a sketch with the exact percentiles of a garage
+ * Returns: 1 if every percentile is within the sketch's error bound
+ */
+int sketchMatchesGarage(const ValueSketch* sketch, char** garage, int numVehicles, int print) {
+    static const double quantiles[] = {0.5, 0.9, 0.99};
+    unsigned int* values = (unsigned int*)malloc(numVehicles * sizeof(unsigned int));
+    int count = 0;
+    int matches = 1;
+
+    for (int i = 0; i < numVehicles; i++) {
+        if (garage[i] != NULL) {
+            values[count++] = headerValue(vehicleHeader(garage[i]));
+        }
+    }
+    qsort(values, count, sizeof(unsigned int), compareValues);
+
+    for (int q = 0; q < 3; q++) {
+        long rank = (long)(quantiles[q] * count + 0.999999);
+        unsigned int exact = values[(rank < 1 ? 1 : rank) - 1];
+        unsigned int approximate = valueSketchQuantile(sketch, quantiles[q]);
+        double error = approximate > exact ? approximate - exact : exact - approximate;
+
+        if (error > exact / (2.0 * SKETCH_SUB_BUCKETS)) {
+            matches = 0;
+        }
+        if (print) {
+            printf("p%-2d exact $%-8u sketch $%-8u error %.3f%%\n", (int)(quantiles[q] * 100 + 0.5), exact,
+                   approximate, exact == 0 ? 0.0 : 100.0 * error / exact);
+        }
+    }
+
+    free(values);
+    return matches && valueSketchCount(sketch) == count;
+}
+
+/*
+ * Function: testValueSketch
+ * Purpose: Tests percentile accuracy, parallel building, merging shards and listener updates
+ */
+void testValueSketch() {
+    printf("\n--- Value Sketch Test ---\n");
+
+    int numVehicles = 20000;
+    char** garage = buildSampleGarage(numVehicles);
+    int passed = 1;
+
+    printf("%d buckets (%zu bytes of counters) for any garage size\n", SKETCH_NUM_BUCKETS,
+           SKETCH_NUM_BUCKETS * sizeof(long));
+
+    ValueSketch* sketch = buildValueSketch(garage, numVehicles, 4);
+    passed &= sketchMatchesGarage(sketch, garage, numVehicles, 1);
+
+    // Two shards sketched separately and merged answer the same as the whole garage
+    ValueSketch* merged = buildValueSketch(garage, numVehicles / 3, 1);
+    ValueSketch* shard = buildValueSketch(garage + numVehicles / 3, numVehicles - numVehicles / 3, 2);
+    mergeValueSketch(merged, shard);
+    for (double q = 0.0; q <= 1.0; q += 0.01) {
+        passed &= valueSketchQuantile(merged, q) == valueSketchQuantile(sketch, q);
+    }
+    printf("Merged shards agree with the whole garage: %s\n", passed ? "yes" : "no");
+    freeValueSketch(merged);
+    freeValueSketch(shard);
+
+    // Follow the garage: expensive vehicles arrive, cheap ones leave
+    attachValueSketch(sketch, NULL);
+    for (int i = 0; i < 1000; i++) {
+        garage = addVehicle(garage, numVehicles++, buildVehicle(MAX_VEHICLE_VALUE - i * 500, 2024, "Supercar"));
+    }
+    for (int i = 0; i < 1500; i++) {
+        int position = (i * 7) % numVehicles;
+        garage = removeVehicle(garage, numVehicles--, position);
+    }
+    detachValueSketch(sketch, NULL);
+
+    printf("After 1000 additions and 1500 removals:\n");
+    passed &= sketchMatchesGarage(sketch, garage, numVehicles, 1);
+
+    printf("Value sketch test %s.\n", passed ? "passed" : "FAILED");
+
+    freeValueSketch(sketch);
+    freeGarage(garage, numVehicles);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+// Garage whose vehicle i is "Model <first + i % models>"
+char** buildModelGarage(int numVehicles, int first, int models) {
+    char** garage = (char**)malloc(numVehicles * sizeof(char*));
+    char description[32];
+
+    if (garage == NULL) {
+        printf("Error: Memory allocation for garage failed\n");
+        return NULL;
+    }
+
+    for (int i = 0; i < numVehicles; i++) {
+        sprintf(description, "Model %d", first + i % models);
+        garage[i] = buildVehicle((unsigned int)(i % 50000), 2000 + i % 25, description);
+    }
+    return garage;
+}
+
+// Prints an estimate against the exact count and checks it is within 3 standard errors
+int estimateIsClose(const char* label, const HyperLogLog* sketch, int exact) {
+    double estimate = hyperLogLogEstimate(sketch);
+    double error = (estimate - exact) / exact;
+    int close = error < 0 ? -error <= 3 * 1.04 / 128.0 : error <= 3 * 1.04 / 128.0;
+
+    printf("%-28s exact %6d  estimate %9.1f  error %+.2f%%  %s\n", label, exact, estimate,
+           100.0 * error, close ? "ok" : "MISMATCH");
+    return close;
+}
+
+/*
+ * Function: testDistinctModels
+ * Purpose: Tests HyperLogLog estimates, parallel building, merging garages and save / load
+ */
+void testDistinctModels() {
+    printf("\n--- Distinct Model Count Test ---\n");
+
+    int passed = 1;
+    printf("%d registers (%d bytes) for any garage size\n", HLL_REGISTERS, HLL_REGISTERS);
+
+    // Few models: linear counting is close to exact
+    char** sample = buildSampleGarage(10000);
+    HyperLogLog* sketch = buildDistinctModels(sample, 10000, 0);
+    passed &= estimateIsClose("Sample garage", sketch, 8);
+    freeHyperLogLog(sketch);
+    freeGarage(sample, 10000);
+
+    int numVehicles = 120000;
+    char** first = buildModelGarage(numVehicles, 0, 60000);
+    char** second = buildModelGarage(numVehicles, 40000, 60000);
+
+    HyperLogLog* serial = buildDistinctModels(first, numVehicles, 1);
+    HyperLogLog* parallel = buildDistinctModels(first, numVehicles, 4);
+    passed &= estimateIsClose("Serial build", serial, 60000);
+
+    // Register maxima do not depend on how the garage was split
+    int same = hyperLogLogEstimate(serial) == hyperLogLogEstimate(parallel);
+    printf("Parallel build matches serial build: %s\n", same ? "yes" : "no");
+    passed &= same;
+
+    // Models 0..59999 and 40000..99999: 100000 distinct together
+    HyperLogLog* other = buildDistinctModels(second, numVehicles, 0);
+    mergeHyperLogLog(parallel, other);
+    passed &= estimateIsClose("Merged garages", parallel, 100000);
+
+    // A saved sketch merges like the original
+    unsigned char* saved = (unsigned char*)malloc(HLL_REGISTERS);
+    hyperLogLogSave(other, saved);
+    HyperLogLog* loaded = hyperLogLogLoad(saved);
+    mergeHyperLogLog(serial, loaded);
+    same = hyperLogLogEstimate(serial) == hyperLogLogEstimate(parallel);
+    printf("Saved and loaded sketch merges the same: %s\n", same ? "yes" : "no");
+    passed &= same;
+
+    printf("Distinct model count test %s.\n", passed ? "passed" : "FAILED");
+
+    free(saved);
+    freeHyperLogLog(loaded);
+    freeHyperLogLog(other);
+    freeHyperLogLog(parallel);
+    freeHyperLogLog(serial);
+    freeGarage(first, numVehicles);
+    freeGarage(second, numVehicles);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+/*
+ * Function: testDescriptionFilter
+ * Purpose: Tests the Bloom filter in front of garage and index lookups, its false positive
+ *          rate, listener updates and rebuilding once removals make it stale
+ */
+void testDescriptionFilter() {
+    printf("\n--- Description Filter Test ---\n");
+
+    int numVehicles = 20000;
+    int numMissing = 2000;
+    char** garage = buildModelGarage(numVehicles, 0, 5000);
+    VehicleIndex* index = buildVehicleIndex(garage, numVehicles);
+    DescriptionFilter* filter = buildDescriptionFilter(garage, numVehicles);
+    char description[32];
+    int passed = 1;
+
+    // Every description in the garage passes and is found where the plain scan finds it
+    for (int i = 0; i < 5000; i++) {
+        sprintf(description, "Model %d", i);
+        int count = 0;
+        passed &= descriptionFilterMayContain(filter, description);
+        passed &= findDescription(filter, garage, numVehicles, description) == i;
+        passed &= filteredIndexLookup(filter, index, description, &count) != NULL && count == 4;
+    }
+    printf("No false negatives: %s\n", passed ? "yes" : "no");
+
+    // Absent descriptions: almost all stop at the filter
+    int falsePositives = 0;
+    for (int i = 0; i < numMissing; i++) {
+        sprintf(description, "Model %d", 100000 + i);
+        falsePositives += descriptionFilterMayContain(filter, description);
+    }
+    printf("False positives: %d of %d absent descriptions (%.2f%%)\n", falsePositives, numMissing,
+           100.0 * falsePositives / numMissing);
+    passed &= falsePositives * 100 < numMissing * 5;
+
+    clock_t start = clock();
+    int found = 0;
+    for (int i = 0; i < numMissing; i++) {
+        sprintf(description, "Model %d", 100000 + i);
+        found += findDescription(NULL, garage, numVehicles, description) >= 0;
+    }
+    double scanned = 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (int i = 0; i < numMissing; i++) {
+        sprintf(description, "Model %d", 100000 + i);
+        found += findDescription(filter, garage, numVehicles, description) >= 0;
+    }
+    double filtered = 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+    printf("%d missing lookups: %.2f ms scanning, %.2f ms with the filter\n", numMissing, scanned, filtered);
+    passed &= found == 0;
+
+    // New vehicles reach the filter through garage events
+    attachDescriptionFilter(filter, NULL);
+    garage = addVehicle(garage, numVehicles++, buildVehicle(45000, 2025, "Rivian R1T"));
+    int added = findDescription(filter, garage, numVehicles, "Rivian R1T") == numVehicles - 1;
+    printf("Added vehicle passes the filter: %s\n", added ? "yes" : "no");
+    passed &= added;
+    detachDescriptionFilter(filter, NULL);
+
+    freeDescriptionFilter(filter);
+    freeVehicleIndex(index);
+    freeGarage(garage, numVehicles);
+
+    // Remove vehicles from the end of a small garage of distinct models until the filter
+    // reports itself stale, then rebuild it
+    numVehicles = 400;
+    garage = buildModelGarage(numVehicles, 0, numVehicles);
+    filter = buildDescriptionFilter(garage, numVehicles);
+    attachDescriptionFilter(filter, NULL);
+    while (!descriptionFilterStale(filter)) {
+        garage = removeVehicle(garage, numVehicles, numVehicles - 1);
+        numVehicles--;
+    }
+    detachDescriptionFilter(filter, NULL);
+
+    int removals = 400 - numVehicles;
+    int stalePasses = 0;
+    for (int i = numVehicles; i < 400; i++) {
+        sprintf(description, "Model %d", i);
+        stalePasses += descriptionFilterMayContain(filter, description);
+    }
+
+    int rebuilt = refreshDescriptionFilter(filter, garage, numVehicles);
+    int freshPasses = 0;
+    for (int i = numVehicles; i < 400; i++) {
+        sprintf(description, "Model %d", i);
+        freshPasses += descriptionFilterMayContain(filter, description);
+    }
+    printf("Stale after %d removals; removed models passing: %d before rebuild, %d after\n",
+           removals, stalePasses, freshPasses);
+    passed &= rebuilt == 1 && !descriptionFilterStale(filter) && freshPasses * 100 < removals * 5;
+    passed &= findDescription(filter, garage, numVehicles, "Model 0") == 0;
+
+    printf("Description filter test %s.\n", passed ? "passed" : "FAILED");
+
+    freeDescriptionFilter(filter);
+    freeGarage(garage, numVehicles);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+// Elapsed wall clock time in milliseconds
+double millisecondsSince(const struct timespec* start) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Two reports list the same groups and duplicates
+int sameDedupReport(const DedupReport* first, const DedupReport* second) {
+    return first->numGroups == second->numGroups && first->numDuplicates == second->numDuplicates &&
+           memcmp(first->groups, second->groups, first->numGroups * sizeof(DuplicateGroup)) == 0 &&
+           memcmp(first->duplicates, second->duplicates, first->numDuplicates * sizeof(int)) == 0;
+}
+
+/*
+ * Function: testDedupGarage
+ * Purpose: Tests duplicate groups against known copies, serial against parallel results,
+ *          and compaction with listeners attached
+ */
+void testDedupGarage() {
+    printf("\n--- Duplicate Vehicle Test ---\n");
+
+    // Copies of the vehicles of a sample garage (which has no duplicates), some in format v2
+    int numOriginals = 30000;
+    int numVehicles = 45000;
+    char** originals = buildSampleGarage(numOriginals);
+    char** garage = (char**)malloc(numVehicles * sizeof(char*));
+    int* copies = (int*)calloc(numOriginals, sizeof(int));
+    int* firstCopy = (int*)malloc(numOriginals * sizeof(int));
+    int* originalOf = (int*)malloc(numVehicles * sizeof(int));
+    int passed = 1;
+
+    for (int i = 0; i < numVehicles; i++) {
+        int original = (int)(((unsigned long long)i * 2654435761u) % 40000);
+        original = original < numOriginals ? original : i % numOriginals;
+        garage[i] = i % 5 == 0 ? convertVehicleToV2(originals[original])
+                               : buildVehicle(headerValue(vehicleHeader(originals[original])),
+                                              headerYear(vehicleHeader(originals[original])),
+                                              vehicleDescription(originals[original]));
+        originalOf[i] = original;
+        if (copies[original]++ == 0) {
+            firstCopy[original] = i;
+        }
+    }
+
+    int expectedGroups = 0;
+    int expectedDuplicates = 0;
+    for (int i = 0; i < numOriginals; i++) {
+        expectedGroups += copies[i] > 1;
+        expectedDuplicates += copies[i] > 1 ? copies[i] - 1 : 0;
+    }
+
+    struct timespec start;
+    DedupReport serial;
+    DedupReport parallel;
+
+    timespec_get(&start, TIME_UTC);
+    dedupGarage(garage, numVehicles, 0, 1, &serial);
+    double serialTime = millisecondsSince(&start);
+
+    timespec_get(&start, TIME_UTC);
+    dedupGarage(garage, numVehicles, 0, 4, &parallel);
+    double parallelTime = millisecondsSince(&start);
+
+    printf("%d vehicles: %d groups, %d duplicates (expected %d, %d)\n", numVehicles, serial.numGroups,
+           serial.numDuplicates, expectedGroups, expectedDuplicates);
+    printf("1 thread %.2f ms, 4 threads %.2f ms\n", serialTime, parallelTime);
+    passed &= serial.numGroups == expectedGroups && serial.numDuplicates == expectedDuplicates;
+
+    for (int i = 0; i < serial.numGroups; i++) {
+        int original = originalOf[serial.groups[i].first];
+        passed &= firstCopy[original] == serial.groups[i].first && copies[original] == serial.groups[i].count;
+    }
+
+    int same = sameDedupReport(&serial, &parallel);
+    printf("Parallel report matches serial report: %s\n", same ? "yes" : "no");
+    passed &= same;
+
+    // Keep the vehicles that are not duplicates, in order, to check the compacted garage
+    char** kept = (char**)malloc((numVehicles - serial.numDuplicates) * sizeof(char*));
+    for (int i = 0, next = 0, numKept = 0; i < numVehicles; i++) {
+        if (next < serial.numDuplicates && serial.duplicates[next] == i) {
+            next++;
+        } else {
+            kept[numKept++] = garage[i];
+        }
+    }
+
+    ValueSketch* sketch = buildValueSketch(garage, numVehicles, 0);
+    attachValueSketch(sketch, NULL);
+    int remaining = dedupGarage(garage, numVehicles, 1, 0, NULL);
+    detachValueSketch(sketch, NULL);
+
+    int compacted = remaining == numVehicles - expectedDuplicates && valueSketchCount(sketch) == remaining &&
+                    memcmp(garage, kept, remaining * sizeof(char*)) == 0;
+    printf("Compacted to %d vehicles, order kept and listeners told: %s\n", remaining, compacted ? "yes" : "no");
+    passed &= compacted;
+    numVehicles = remaining;
+
+    DedupReport again;
+    dedupGarage(garage, numVehicles, 0, 0, &again);
+    printf("Duplicates left after compaction: %d\n", again.numDuplicates);
+    passed &= again.numDuplicates == 0 && again.numGroups == 0;
+
+    printf("Duplicate vehicle test %s.\n", passed ? "passed" : "FAILED");
+
+    freeDedupReport(&again);
+    freeDedupReport(&parallel);
+    freeDedupReport(&serial);
+    freeValueSketch(sketch);
+    free(kept);
+    free(originalOf);
+    free(firstCopy);
+    free(copies);
+    forEachVehicle(originals, numOriginals, freeSlot, NULL);
+    free(originals);
+    forEachVehicle(garage, numVehicles, freeSlot, NULL);
+    free(garage);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+// Value the price list test expects for a vehicle of "Model <model>"
+unsigned int expectedPrice(int model, unsigned int oldValue) {
+    if (model >= 4000) {
+        return oldValue;
+    }
+    if (model == 7) {
+        return 12345;
+    }
+    if (model == 8) {
+        return 777;
+    }
+    return model * 1000u > MAX_VEHICLE_VALUE ? MAX_VEHICLE_VALUE : model * 1000u;
+}
+
+/*
+ * Function: testRevalueGarage
+ * Purpose: Tests the price list join from both build sides, clamping, unmatched rows,
+ *          and that listening statistics follow the rewritten values
+ */
+void testRevalueGarage() {
+    printf("\n--- Price List Revaluation Test ---\n");
+
+    // Prices for models 0..3999 (values above MAX_VEHICLE_VALUE from model 2098), rows for
+    // models the garage does not have, and later rows that replace models 7 and 8
+    const char* path = "price_list_test.csv";
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Error: Cannot create %s\n", path);
+        return;
+    }
+    fprintf(file, "description,value\n");
+    for (int model = 0; model < 4000; model++) {
+        fprintf(file, "Model %d,%u\n", model, model * 1000u);
+    }
+    for (int i = 0; i < 100; i++) {
+        fprintf(file, "\"Unknown, model %d\",%d\r\n", i, i);
+    }
+    fprintf(file, "Model 7,12345\n\"Model 8\",777\n");
+    fclose(file);
+
+    PriceList* prices = loadPriceList(path);
+    remove(path);
+    int passed = prices != NULL && priceListSize(prices) == 4102 &&
+                 strcmp(priceListDescription(prices, 4000), "Unknown, model 0") == 0;
+    printf("Loaded %d price rows: %s\n", priceListSize(prices), passed ? "yes" : "no");
+
+    int numVehicles = 60000;
+    char** byPrices = buildModelGarage(numVehicles, 0, 5000);
+    char** byGarage = buildModelGarage(numVehicles, 0, 5000);
+    unsigned int* oldHeaders = (unsigned int*)malloc(numVehicles * sizeof(unsigned int));
+    for (int i = 0; i < numVehicles; i++) {
+        oldHeaders[i] = vehicleHeader(byPrices[i]);
+        if (i % 3 == 0) {
+            // Some records in format v2, whose header sits elsewhere
+            char* converted = convertVehicleToV2(byGarage[i]);
+            freeVehicle(byGarage[i]);
+            byGarage[i] = converted;
+        }
+    }
+
+    GarageYearStats* stats = buildGarageYearStats(byPrices, numVehicles);
+    ValueSketch* sketch = buildValueSketch(byPrices, numVehicles, 0);
+    GarageBitmapIndex* bitmaps = buildGarageBitmapIndex(byPrices, numVehicles);
+    attachGarageYearStats(stats, NULL);
+    attachValueSketch(sketch, NULL);
+    attachGarageBitmapIndex(bitmaps, NULL);
+
+    RevalueReport fromPrices;
+    RevalueReport fromGarage;
+    struct timespec start;
+
+    timespec_get(&start, TIME_UTC);
+    revalueGarage(byPrices, numVehicles, prices, JOIN_BUILD_AUTO, 0, &fromPrices);
+    double pricesTime = millisecondsSince(&start);
+
+    detachGarageYearStats(stats, NULL);
+    detachValueSketch(sketch, NULL);
+    detachGarageBitmapIndex(bitmaps, NULL);
+
+    timespec_get(&start, TIME_UTC);
+    revalueGarage(byGarage, numVehicles, prices, JOIN_BUILD_GARAGE, 4, &fromGarage);
+    double garageTime = millisecondsSince(&start);
+
+    printf("Table on price list: %.2f ms, table on garage: %.2f ms\n", pricesTime, garageTime);
+    printf("Matched %d, clamped %d, unmatched vehicles %d, unmatched rows %d\n", fromPrices.matchedVehicles,
+           fromPrices.clampedVehicles, fromPrices.unmatchedVehicles, fromPrices.numUnmatchedRows);
+
+    int correct = fromPrices.buildSide == JOIN_BUILD_PRICES && fromPrices.matchedVehicles == 48000 &&
+                  fromPrices.unmatchedVehicles == 12000 && fromPrices.clampedVehicles == 1902 * 12 &&
+                  fromPrices.numUnmatchedRows == 100 && fromPrices.unmatchedRows[0] == 4000;
+    for (int i = 0; i < numVehicles; i++) {
+        int model = atoi(vehicleDescription(byPrices[i]) + 6);
+        unsigned int expected = packHeader(expectedPrice(model, headerValue(oldHeaders[i])), headerYear(oldHeaders[i]));
+        correct &= vehicleHeader(byPrices[i]) == expected && vehicleHeader(byGarage[i]) == expected;
+    }
+    correct &= fromGarage.matchedVehicles == fromPrices.matchedVehicles &&
+               fromGarage.clampedVehicles == fromPrices.clampedVehicles &&
+               fromGarage.numUnmatchedRows == fromPrices.numUnmatchedRows &&
+               memcmp(fromGarage.unmatchedRows, fromPrices.unmatchedRows, fromPrices.numUnmatchedRows * sizeof(int)) == 0;
+    printf("Both build sides give the expected values and report: %s\n", correct ? "yes" : "no");
+    passed &= correct;
+
+    // Listeners saw every change as an update
+    GarageYearStats* freshStats = buildGarageYearStats(byPrices, numVehicles);
+    ValueSketch* freshSketch = buildValueSketch(byPrices, numVehicles, 0);
+    GarageBitmapIndex* freshBitmaps = buildGarageBitmapIndex(byPrices, numVehicles);
+    int inSync = 1;
+    for (unsigned int year = 2000; year < 2025; year++) {
+        YearAggregate live;
+        YearAggregate fresh;
+        readYearAggregate(stats, year, &live);
+        readYearAggregate(freshStats, year, &fresh);
+        inSync &= memcmp(&live, &fresh, sizeof(YearAggregate)) == 0;
+        inSync &= countYearValueRange(bitmaps, year, year, 0, 1000000) ==
+                  countYearValueRange(freshBitmaps, year, year, 0, 1000000);
+    }
+    for (double q = 0.0; q <= 1.0; q += 0.05) {
+        inSync &= valueSketchQuantile(sketch, q) == valueSketchQuantile(freshSketch, q);
+    }
+    printf("Statistics, sketch and bitmap index follow the updates: %s\n", inSync ? "yes" : "no");
+    passed &= inSync;
+
+    printf("Price list revaluation test %s.\n", passed ? "passed" : "FAILED");
+
+    freeGarageYearStats(freshStats);
+    freeValueSketch(freshSketch);
+    freeGarageBitmapIndex(freshBitmaps);
+    freeGarageYearStats(stats);
+    freeValueSketch(sketch);
+    freeGarageBitmapIndex(bitmaps);
+    freeRevalueReport(&fromPrices);
+    freeRevalueReport(&fromGarage);
+    freePriceList(prices);
+    free(oldHeaders);
+    forEachVehicle(byPrices, numVehicles, freeSlot, NULL);
+    free(byPrices);
+    forEachVehicle(byGarage, numVehicles, freeSlot, NULL);
+    free(byGarage);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+// One header at a time: unpack, recompute, saturate and repack
+unsigned int referenceTransform(unsigned int header, const ValueTransform* transform) {
+    unsigned int value = headerValue(header);
+    unsigned int year = headerYear(header);
+
+    if (transform->kind == TRANSFORM_ADD) {
+        long long result = (long long)value + transform->delta;
+        result = result < 0 ? 0 : result > MAX_VEHICLE_VALUE ? MAX_VEHICLE_VALUE : result;
+        return packHeader((unsigned int)result, year);
+    }
+
+    double factor = transform->factor;
+    if (transform->kind == TRANSFORM_DEPRECIATE) {
+        unsigned int age = transform->currentYear > year ? transform->currentYear - year : 0;
+        factor = 1.0;
+        for (unsigned int i = 0; i < age && i < TRANSFORM_MAX_AGE; i++) {
+            factor *= 1.0 - transform->rate;
+        }
+    }
+
+    double result = value * factor;
+    result = result < 0.0 ? 0.0 : result > MAX_VEHICLE_VALUE ? MAX_VEHICLE_VALUE : result;
+    return packHeader((unsigned int)lrint(result), year);
+}
+
+/*
+ * Function: testValueTransforms
+ * Purpose: Tests the transform kernels against a one-at-a-time reference, saturation at both
+ *          ends, and garage transforms with listeners attached
+ */
+void testValueTransforms() {
+    printf("\n--- Value Transform Test ---\n");
+
+    // An odd length so the scalar remainder runs too
+    int numHeaders = 1000003;
+    unsigned int* original = (unsigned int*)malloc(numHeaders * sizeof(unsigned int));
+    unsigned int* column = (unsigned int*)malloc(numHeaders * sizeof(unsigned int));
+    unsigned int seed = 12345;
+    int passed = 1;
+
+    for (int i = 0; i < numHeaders; i++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned int value = i % 97 == 0 ? MAX_VEHICLE_VALUE : i % 89 == 0 ? 0 : (seed >> 8) % (MAX_VEHICLE_VALUE + 1);
+        original[i] = packHeader(value, 1980 + (seed >> 3) % 50);
+    }
+
+    ValueTransform transforms[] = {
+        scaleTransform(0.85), scaleTransform(1.7), scaleTransform(-1.0), addTransform(500000),
+        addTransform(-300000), addTransform(2147483647), depreciationTransform(0.15, 2026)
+    };
+    const char* names[] = {
+        "Scale by 0.85", "Scale by 1.7", "Scale by -1", "Add 500000", "Subtract 300000", "Add INT_MAX",
+        "Depreciate 15%/year"
+    };
+
+    for (int t = 0; t < (int)(sizeof(transforms) / sizeof(transforms[0])); t++) {
+        memcpy(column, original, numHeaders * sizeof(unsigned int));
+        clock_t start = clock();
+        int changed = transformHeaders(column, numHeaders, &transforms[t]);
+        double kernelTime = 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+
+        int same = 1;
+        int expectedChanged = 0;
+        start = clock();
+        for (int i = 0; i < numHeaders; i++) {
+            unsigned int expected = referenceTransform(original[i], &transforms[t]);
+            same &= column[i] == expected;
+            expectedChanged += expected != original[i];
+        }
+        double referenceTime = 1000.0 * (clock() - start) / CLOCKS_PER_SEC;
+
+        printf("%-20s %7d changed  kernel %6.2f ms  one at a time %6.2f ms  %s\n", names[t], changed, kernelTime,
+               referenceTime, same && changed == expectedChanged ? "ok" : "MISMATCH");
+        passed &= same && changed == expectedChanged;
+    }
+
+    // A garage of both record formats with statistics listening
+    int numVehicles = 20000;
+    char** garage = buildSampleGarage(numVehicles);
+    for (int i = 0; i < numVehicles; i += 2) {
+        char* converted = convertVehicleToV2(garage[i]);
+        freeVehicle(garage[i]);
+        garage[i] = converted;
+    }
+    for (int i = 0; i < numVehicles; i++) {
+        column[i] = vehicleHeader(garage[i]);
+    }
+
+    GarageYearStats* stats = buildGarageYearStats(garage, numVehicles);
+    attachGarageYearStats(stats, NULL);
+    ValueTransform depreciation = depreciationTransform(0.08, 2026);
+    int changed = transformGarage(garage, numVehicles, &depreciation);
+    detachGarageYearStats(stats, NULL);
+
+    int expectedChanged = transformHeaders(column, numVehicles, &depreciation);
+    int garageSame = changed == expectedChanged;
+    for (int i = 0; i < numVehicles; i++) {
+        garageSame &= vehicleHeader(garage[i]) == column[i];
+    }
+
+    GarageYearStats* fresh = buildGarageYearStats(garage, numVehicles);
+    for (unsigned int year = 1990; year < 2025; year++) {
+        YearAggregate live;
+        YearAggregate rebuilt;
+        readYearAggregate(stats, year, &live);
+        readYearAggregate(fresh, year, &rebuilt);
+        garageSame &= memcmp(&live, &rebuilt, sizeof(YearAggregate)) == 0;
+    }
+    printf("Garage depreciation changed %d vehicles, matches the column and statistics: %s\n", changed,
+           garageSame ? "yes" : "no");
+    passed &= garageSame;
+
+    ValueTransform invalid = depreciationTransform(1.5, 2026);
+    passed &= transformHeaders(column, numVehicles, &invalid) == -1;
+
+    printf("Value transform test %s.\n", passed ? "passed" : "FAILED");
+
+    freeGarageYearStats(fresh);
+    freeGarageYearStats(stats);
+    forEachVehicle(garage, numVehicles, freeSlot, NULL);
+    free(garage);
+    free(column);
+    free(original);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+typedef struct {
+    const char* path;
+    int numVehicles;          // Garage size before the test adds anything
+    const VehicleQuery* query;
+    const int* expected;      // Positions the query matches
+    int numExpected;
+    int failures[8];          // Per client
+} ServerLoad;
+
+// Client 0 adds and removes vehicles the query never matches; the others run the query
+void serverClientTask(void* context, int begin, int end, int worker) {
+    ServerLoad* load = (ServerLoad*)context;
+    (void)begin;
+    (void)end;
+
+    GarageClient* client = connectGarageServer(load->path);
+    if (client == NULL) {
+        load->failures[worker]++;
+        return;
+    }
+
+    if (worker == 0) {
+        for (int i = 0; i < 200; i++) {
+            load->failures[worker] += garageClientAdd(client, 7, 1990, "Client vehicle") != load->numVehicles;
+            load->failures[worker] += garageClientRemove(client, load->numVehicles) != 0;
+        }
+    } else {
+        int* positions = (int*)malloc(load->numExpected * sizeof(int));
+        unsigned int* headers = (unsigned int*)malloc(load->numExpected * sizeof(unsigned int));
+        for (int round = 0; round < 20; round++) {
+            int matches = garageClientRange(client, load->query, positions, headers, load->numExpected);
+            int same = matches == load->numExpected;
+            for (int i = 0; same && i < matches; i++) {
+                same = positions[i] == load->expected[i] && headerYear(headers[i]) >= load->query->minYear &&
+                       headerYear(headers[i]) <= load->query->maxYear;
+            }
+            load->failures[worker] += !same;
+        }
+        free(positions);
+        free(headers);
+    }
+    closeGarageClient(client);
+}
+
+/*
+ * Function: testGarageServer
+ * Purpose: Tests the garage server over a local socket: every request type, pipelining,
+ *          malformed requests, concurrent clients and both ways of stopping it
+ */
+void testGarageServer() {
+    printf("\n--- Garage Server Test ---\n");
+
+    const char* path = "garage_server_test.sock";
+    int numVehicles = 20000;
+    char** garage = buildModelGarage(numVehicles, 0, 500);
+
+    // Answers worked out locally before the server takes the garage
+    VehicleQuery query;
+    initVehicleQuery(&query);
+    query.minYear = 2003;
+    query.maxYear = 2006;
+    query.minValue = 1000;
+    query.maxValue = 30000;
+    query.descriptionPrefix = "Model 1";
+    int* expected = (int*)malloc(numVehicles * sizeof(int));
+    int numExpected = queryGarage(garage, numVehicles, &query, expected);
+    GarageYearStats* localStats = buildGarageYearStats(garage, numVehicles);
+    YearAggregate expectedYear;
+    readYearAggregate(localStats, 2003, &expectedYear);
+    freeGarageYearStats(localStats);
+
+    GarageServer* server = startGarageServer(path, garage, numVehicles, 4);
+    GarageClient* client = server != NULL ? connectGarageServer(path) : NULL;
+    if (client == NULL) {
+        printf("Garage server test FAILED (server did not start).\n");
+        if (server != NULL) {
+            garage = stopGarageServer(server, &numVehicles);
+        }
+        forEachVehicle(garage, numVehicles, freeSlot, NULL);
+        free(garage);
+        free(expected);
+        printf("Press Enter to continue...");
+        getchar();
+        return;
+    }
+
+    // One request of each kind
+    unsigned int headers[64];
+    YearAggregate year;
+    int* positions = (int*)malloc(numVehicles * sizeof(int));
+    int passed = garageClientCount(client) == numVehicles;
+    passed &= garageClientLookup(client, "Model 7", headers, 64) == 40 && headerYear(headers[0]) == 2007;
+    passed &= garageClientLookup(client, "Nothing", headers, 64) == 0;
+    passed &= garageClientStats(client, 2003, &year) == 0 && memcmp(&year, &expectedYear, sizeof(YearAggregate)) == 0;
+    int matches = garageClientRange(client, &query, positions, NULL, numVehicles);
+    passed &= matches == numExpected && memcmp(positions, expected, numExpected * sizeof(int)) == 0;
+    printf("Count, lookup, stats and range agree with the local garage: %s\n", passed ? "yes" : "no");
+
+    // Pipelined: every add is sent before the first response is read
+    int batch = 1000;
+    char description[32];
+    unsigned char payload[64];
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    for (int i = 0; i < batch; i++) {
+        int length = sprintf(description, "Pipelined %d", i);
+        unsigned int fields[2] = {(unsigned int)i, 2010};
+        for (int b = 0; b < 4; b++) {
+            payload[b] = (unsigned char)(fields[0] >> (8 * b));
+            payload[4 + b] = (unsigned char)(fields[1] >> (8 * b));
+        }
+        payload[8] = (unsigned char)length;
+        payload[9] = 0;
+        memcpy(payload + 10, description, length);
+        sendGarageRequest(client, 1000 + i, SERVER_OP_ADD, payload, 10 + length);
+    }
+    int inOrder = 1;
+    for (int i = 0; i < batch; i++) {
+        GarageResponse response;
+        inOrder &= receiveGarageResponse(client, &response) == 0 && response.id == 1000u + i &&
+                   response.status == SERVER_STATUS_OK && response.length == 4 &&
+                   response.payload[0] + 256 * response.payload[1] + 65536 * response.payload[2] == numVehicles + i;
+    }
+    double pipelinedTime = millisecondsSince(&start);
+
+    timespec_get(&start, TIME_UTC);
+    for (int i = 0; i < batch; i++) {
+        sprintf(description, "One by one %d", i);
+        inOrder &= garageClientAdd(client, i, 2011, description) == numVehicles + batch + i;
+    }
+    double sequentialTime = millisecondsSince(&start);
+    printf("%d adds pipelined: %.2f ms, one at a time: %.2f ms\n", batch, pipelinedTime, sequentialTime);
+
+    inOrder &= garageClientLookup(client, "Pipelined 999", headers, 64) == 1 && headers[0] == packHeader(999, 2010);
+    for (int i = 0; i < 2 * batch; i++) {
+        inOrder &= garageClientRemove(client, numVehicles) == 0;
+    }
+    inOrder &= garageClientCount(client) == numVehicles && garageClientLookup(client, "Pipelined 999", headers, 64) == 0;
+    printf("Pipelined responses arrive in order with the right positions: %s\n", inOrder ? "yes" : "no");
+    passed &= inOrder;
+
+    // Bad requests are answered; a malformed frame only loses its own connection
+    GarageResponse response;
+    int rejected = garageClientRemove(client, numVehicles) == -1;
+    rejected &= garageClientAdd(client, 1, 5000, "Bad year") == -1;
+    rejected &= sendGarageRequest(client, 77, 99, NULL, 0) == 0 && receiveGarageResponse(client, &response) == 0 &&
+                response.id == 77 && response.status == SERVER_STATUS_BAD_REQUEST;
+    // A frame length of 2 cannot even hold an id and an op
+    unsigned char malformed[4] = {2, 0, 0, 0};
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    int raw = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (raw >= 0 && connect(raw, (struct sockaddr*)&address, sizeof(address)) == 0 &&
+        write(raw, malformed, sizeof(malformed)) == (ssize_t)sizeof(malformed)) {
+        rejected &= read(raw, malformed, sizeof(malformed)) == 0;
+    } else {
+        rejected = 0;
+    }
+    if (raw >= 0) {
+        close(raw);
+    }
+    rejected &= garageClientCount(client) == numVehicles;
+    printf("Bad requests are refused and the server keeps serving: %s\n", rejected ? "yes" : "no");
+    passed &= rejected;
+
+    // Range queries on several connections while another client adds and removes
+    ServerLoad load;
+    memset(&load, 0, sizeof(load));
+    load.path = path;
+    load.numVehicles = numVehicles;
+    load.query = &query;
+    load.expected = expected;
+    load.numExpected = numExpected;
+    timespec_get(&start, TIME_UTC);
+    parallelFor(5, 5, serverClientTask, &load);
+    int failures = 0;
+    for (int i = 0; i < 5; i++) {
+        failures += load.failures[i];
+    }
+    printf("4 clients x 20 range queries during 400 updates: %.2f ms, %d failures\n", millisecondsSince(&start), failures);
+    passed &= failures == 0;
+
+    // Stopped from this process, then stopped by a client
+    closeGarageClient(client);
+    garage = stopGarageServer(server, &numVehicles);
+    int intact = numVehicles == 20000;
+    for (int i = 0; intact && i < numVehicles; i++) {
+        sprintf(description, "Model %d", i % 500);
+        intact = strcmp(vehicleDescription(garage[i]), description) == 0;
+    }
+
+    server = startGarageServer(path, garage, numVehicles, 1);
+    client = server != NULL ? connectGarageServer(path) : NULL;
+    intact &= client != NULL && garageClientShutdown(client) == 0;
+    closeGarageClient(client);
+    if (server != NULL) {
+        garage = stopGarageServer(server, &numVehicles);
+    }
+    intact &= numVehicles == 20000 && access(path, F_OK) != 0;
+    printf("Garage handed back intact and socket removed after stop and shutdown: %s\n", intact ? "yes" : "no");
+    passed &= intact;
+
+    printf("Garage server test %s.\n", passed ? "passed" : "FAILED");
+
+    forEachVehicle(garage, numVehicles, freeSlot, NULL);
+    free(garage);
+    free(positions);
+    free(expected);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+// Checks a shared view against the first numVehicles vehicles of a garage
+int sharedViewMatches(char** shared, const unsigned int* headers, int numShared, char** garage, int numVehicles) {
+    if (numShared != numVehicles) {
+        return 0;
+    }
+    for (int i = 0; i < numVehicles; i++) {
+        if (vehicleHeader(shared[i]) != vehicleHeader(garage[i]) || headers[i] != vehicleHeader(garage[i]) ||
+            strcmp(vehicleDescription(shared[i]), vehicleDescription(garage[i])) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+typedef struct {
+    const char* name;
+    SharedGarageWriter* writer;
+    char** garage;
+    int sizes[2];      // Generations alternate between these garage sizes
+    int generations;
+    int views;         // Views the reader checked
+    int mismatches;
+} SharedSwapTest;
+
+// Worker 0 keeps publishing, worker 1 keeps refreshing and checking what it sees
+void sharedSwapTask(void* context, int begin, int end, int worker) {
+    SharedSwapTest* test = (SharedSwapTest*)context;
+    (void)begin;
+    (void)end;
+
+    if (worker == 0) {
+        for (int i = 0; i < test->generations; i++) {
+            publishSharedGarage(test->writer, test->garage, test->sizes[i % 2]);
+        }
+        return;
+    }
+
+    SharedGarageReader* reader = openSharedGarage(test->name);
+    if (reader == NULL) {
+        test->mismatches++;
+        return;
+    }
+    // Generation 2 comes from the test itself, the later ones from the publisher
+    long final = test->generations + 2;
+    for (int round = 0; round < 1000000 && sharedGarageGeneration(reader) < final; round++) {
+        int numShared;
+        char** shared = sharedGarageVehicles(reader, &numShared);
+        long generation = sharedGarageGeneration(reader);
+        int expected = generation == 2 ? test->sizes[1] : test->sizes[(generation - 3) % 2];
+        test->mismatches += !sharedViewMatches(shared, sharedGarageHeaders(reader), numShared, test->garage, expected);
+        test->views++;
+        if (refreshSharedGarage(reader) < 0) {
+            test->mismatches++;
+            break;
+        }
+    }
+    closeSharedGarage(reader);
+}
+
+/*
+ * Function: testSharedGarage
+ * Purpose: Tests publishing a garage to shared memory, reading it from this and another
+ *          process with the normal garage code, and generation swaps under a live reader
+ */
+void testSharedGarage() {
+    printf("\n--- Shared Memory Garage Test ---\n");
+
+    const char* name = "cosc292_shared_garage_test";
+    int numVehicles = 100000;
+    char** garage = buildModelGarage(numVehicles, 0, 1000);
+    for (int i = 0; i < numVehicles; i += 7) {
+        // Some records in format v2; the shared copy is always v1
+        char* converted = convertVehicleToV2(garage[i]);
+        freeVehicle(garage[i]);
+        garage[i] = converted;
+    }
+
+    SharedGarageWriter* writer = createSharedGarageWriter(name);
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    long generation = publishSharedGarage(writer, garage, numVehicles);
+    printf("Published %d vehicles as generation %ld in %.2f ms\n", numVehicles, generation, millisecondsSince(&start));
+
+    SharedGarageReader* reader = openSharedGarage(name);
+    if (writer == NULL || generation != 1 || reader == NULL) {
+        printf("Shared memory garage test FAILED (cannot publish or open).\n");
+        closeSharedGarage(reader);
+        closeSharedGarageWriter(writer);
+        forEachVehicle(garage, numVehicles, freeSlot, NULL);
+        free(garage);
+        printf("Press Enter to continue...");
+        getchar();
+        return;
+    }
+
+    // The mapped garage works with the ordinary garage code
+    int numShared;
+    char** shared = sharedGarageVehicles(reader, &numShared);
+    int passed = sharedViewMatches(shared, sharedGarageHeaders(reader), numShared, garage, numVehicles);
+    VehicleQuery query;
+    initVehicleQuery(&query);
+    query.minYear = 2010;
+    query.maxYear = 2014;
+    query.descriptionPrefix = "Model 12";
+    int* expected = (int*)malloc(numVehicles * sizeof(int));
+    int* positions = (int*)malloc(numVehicles * sizeof(int));
+    int numExpected = queryGarage(garage, numVehicles, &query, expected);
+    passed &= queryGarage(shared, numShared, &query, positions) == numExpected &&
+              memcmp(positions, expected, numExpected * sizeof(int)) == 0;
+    printf("First shared vehicle: ");
+    displayVehicle(shared[0]);
+    printf("Reader sees the same vehicles and query results: %s\n", passed ? "yes" : "no");
+
+    // Another process maps the same generation
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+        SharedGarageReader* other = openSharedGarage(name);
+        int numOther = 0;
+        char** otherGarage = other != NULL ? sharedGarageVehicles(other, &numOther) : NULL;
+        int ok = otherGarage != NULL && numOther == numVehicles &&
+                 queryGarage(otherGarage, numOther, &query, positions) == numExpected;
+        _exit(ok ? 0 : 1);
+    }
+    int childStatus = 1;
+    int otherProcess = child > 0 && waitpid(child, &childStatus, 0) == child &&
+                       WIFEXITED(childStatus) && WEXITSTATUS(childStatus) == 0;
+    printf("A second process reads the published garage: %s\n", otherProcess ? "yes" : "no");
+    passed &= otherProcess;
+
+    // A new generation does not disturb a reader until it refreshes
+    for (int i = 0; i < 1000; i++) {
+        freeVehicle(garage[i]);
+    }
+    numVehicles -= 1000;
+    memmove(garage, garage + 1000, numVehicles * sizeof(char*));
+    generation = publishSharedGarage(writer, garage, numVehicles);
+    int swapped = generation == 2 && sharedGarageGeneration(reader) == 1;
+    swapped &= sharedViewMatches(shared + 1000, sharedGarageHeaders(reader) + 1000, numShared - 1000, garage, numVehicles);
+    swapped &= refreshSharedGarage(reader) == 1 && refreshSharedGarage(reader) == 0;
+    shared = sharedGarageVehicles(reader, &numShared);
+    swapped &= sharedGarageGeneration(reader) == 2 &&
+               sharedViewMatches(shared, sharedGarageHeaders(reader), numShared, garage, numVehicles);
+    printf("Old generation stays readable until refresh, then the new one is seen: %s\n", swapped ? "yes" : "no");
+    passed &= swapped;
+    closeSharedGarage(reader);
+
+    // Publishing continuously while another thread refreshes and checks every view
+    SharedSwapTest swap;
+    swap.name = name;
+    swap.writer = writer;
+    swap.garage = garage;
+    swap.sizes[0] = 20000;
+    swap.sizes[1] = numVehicles;
+    swap.generations = 40;
+    swap.views = 0;
+    swap.mismatches = 0;
+    parallelFor(2, 2, sharedSwapTask, &swap);
+    printf("%d generations published under a live reader: %d views checked, %d mismatches\n",
+           swap.generations, swap.views, swap.mismatches);
+    passed &= swap.mismatches == 0;
+
+    closeSharedGarageWriter(writer);
+    passed &= openSharedGarage(name) == NULL;
+
+    printf("Shared memory garage test %s.\n", passed ? "passed" : "FAILED");
+
+    forEachVehicle(garage, numVehicles, freeSlot, NULL);
+    free(garage);
+    free(expected);
+    free(positions);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+typedef struct {
+    char** expected;  // What every position must hold
+    int mismatches;
+} SnapshotCheck;
+
+int checkSnapshotSlot(void* context, char* vehicle, int position) {
+    SnapshotCheck* check = (SnapshotCheck*)context;
+    check->mismatches += vehicle != check->expected[position];
+    return 0;
+}
+
+// Records the vehicles and headers of a snapshot, or compares against a recording
+typedef struct {
+    char** vehicles;
+    unsigned int* headers;
+    int compare;
+    int mismatches;
+    long yearMatches;
+} SnapshotRecording;
+
+int recordSnapshotChunk(void* context, char** vehicles, int count, int first) {
+    SnapshotRecording* recording = (SnapshotRecording*)context;
+    for (int i = 0; i < count; i++) {
+        if (recording->compare) {
+            recording->mismatches += recording->vehicles[first + i] != vehicles[i] ||
+                                     recording->headers[first + i] != vehicleHeader(vehicles[i]);
+        } else {
+            recording->vehicles[first + i] = vehicles[i];
+            recording->headers[first + i] = vehicleHeader(vehicles[i]);
+        }
+    }
+
+    // A chunk is an ordinary garage, so the query code runs on it in place
+    VehicleQuery query;
+    int positions[SNAPSHOT_NODE_SIZE];
+    initVehicleQuery(&query);
+    query.minYear = 2010;
+    query.maxYear = 2010;
+    recording->yearMatches += queryGarage(vehicles, count, &query, positions);
+    return 0;
+}
+
+typedef struct {
+    VersionedGarage* garage;
+    int changes;
+    int snapshots;
+    int mismatches;
+} SnapshotStress;
+
+// Worker 0 keeps changing the garage, worker 1 walks snapshots twice and compares the walks
+void snapshotStressTask(void* context, int begin, int end, int worker) {
+    SnapshotStress* stress = (SnapshotStress*)context;
+    (void)begin;
+    (void)end;
+
+    if (worker == 0) {
+        unsigned int seed = 12345;
+        for (int i = 0; i < stress->changes; i++) {
+            seed = seed * 1103515245u + 12345u;
+            int size = versionedGarageSize(stress->garage);
+            int position = (int)((seed >> 8) % (unsigned int)size);
+            switch (i % 3) {
+                case 0:
+                    versionedGarageInsert(stress->garage, position, buildVehicle(i % 1000, 2010, "Ingested"));
+                    break;
+                case 1:
+                    versionedGarageRemove(stress->garage, position);
+                    break;
+                default:
+                    versionedGarageReplace(stress->garage, position, buildVehicle(i % 1000, 2011, "Replaced"));
+                    break;
+            }
+        }
+        return;
+    }
+
+    for (int round = 0; round < stress->snapshots; round++) {
+        GarageSnapshot* snapshot = takeGarageSnapshot(stress->garage);
+        int size = snapshotSize(snapshot);
+        SnapshotRecording recording = {(char**)malloc(size * sizeof(char*)),
+                                       (unsigned int*)malloc(size * sizeof(unsigned int)), 0, 0, 0};
+        forEachSnapshotChunk(snapshot, recordSnapshotChunk, &recording);
+        long firstMatches = recording.yearMatches;
+        recording.compare = 1;
+        recording.yearMatches = 0;
+        forEachSnapshotChunk(snapshot, recordSnapshotChunk, &recording);
+        stress->mismatches += recording.mismatches + (recording.yearMatches != firstMatches);
+        free(recording.vehicles);
+        free(recording.headers);
+        releaseGarageSnapshot(snapshot);
+    }
+}
+
+/*
+ * Function: testGarageSnapshots
+ * Purpose: Tests copy-on-write snapshots: O(1) creation, frozen contents while the garage
+ *          changes, memory in proportion to the changes, and snapshots read on another thread
+ */
+void testGarageSnapshots() {
+    printf("\n--- Garage Snapshot Test ---\n");
+
+    int numVehicles = 200000;
+    char** garage = buildModelGarage(numVehicles, 0, 1000);
+    char** frozen = (char**)malloc(numVehicles * sizeof(char*));
+    memcpy(frozen, garage, numVehicles * sizeof(char*));
+    VersionedGarage* versioned = createVersionedGarage(garage, numVehicles);
+    free(garage);
+
+    VersionedGarageUsage before;
+    VersionedGarageUsage after;
+    versionedGarageUsage(versioned, &before);
+
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    GarageSnapshot* snapshot = takeGarageSnapshot(versioned);
+    double snapshotTime = millisecondsSince(&start);
+    timespec_get(&start, TIME_UTC);
+    char** copy = (char**)malloc((numVehicles + 100) * sizeof(char*));  // Room for the inserts below
+    memcpy(copy, frozen, numVehicles * sizeof(char*));
+    double copyTime = millisecondsSince(&start);
+    printf("Snapshot of %d vehicles: %.4f ms (copying the pointer array: %.4f ms)\n", numVehicles, snapshotTime, copyTime);
+
+    // 300 changes; the live garage is mirrored in an ordinary array
+    int live = numVehicles;
+    int passed = 1;
+    for (int i = 0; i < 300; i++) {
+        int position = (int)((i * 7919u) % (unsigned int)live);
+        if (i % 3 == 0) {
+            char* vehicle = buildVehicle(1, 2020, "Inserted");
+            passed &= versionedGarageInsert(versioned, position, vehicle) == 0;
+            memmove(copy + position + 1, copy + position, (live - position) * sizeof(char*));
+            copy[position] = vehicle;
+            live++;
+        } else if (i % 3 == 1) {
+            passed &= versionedGarageRemove(versioned, position) == 0;
+            memmove(copy + position, copy + position + 1, (live - position - 1) * sizeof(char*));
+            live--;
+        } else {
+            char* vehicle = buildVehicle(2, 2021, "Replacement");
+            passed &= versionedGarageReplace(versioned, position, vehicle) == 0;
+            copy[position] = vehicle;
+        }
+    }
+    versionedGarageUsage(versioned, &after);
+    printf("300 changes copied %ld of %ld nodes; %ld removed vehicles kept for the snapshot\n",
+           after.nodes - before.nodes, before.nodes, after.retiredVehicles);
+    passed &= after.nodes - before.nodes <= 300 * 4 && after.retiredVehicles == 200;
+
+    // The snapshot still holds exactly the original vehicles; the live garage has the changes
+    SnapshotCheck check = {frozen, 0};
+    forEachSnapshotVehicle(snapshot, checkSnapshotSlot, &check);
+    int frozenOk = snapshotSize(snapshot) == numVehicles && check.mismatches == 0;
+    for (int i = 0; frozenOk && i < numVehicles; i += 997) {
+        frozenOk = headerValue(vehicleHeader(snapshotVehicle(snapshot, i))) == (unsigned int)(i % 50000);
+    }
+    GarageSnapshot* current = takeGarageSnapshot(versioned);
+    check.expected = copy;
+    check.mismatches = 0;
+    forEachSnapshotVehicle(current, checkSnapshotSlot, &check);
+    int liveOk = snapshotSize(current) == live && versionedGarageSize(versioned) == live && check.mismatches == 0 &&
+                 versionedGarageVehicle(versioned, live - 1) == copy[live - 1];
+    releaseGarageSnapshot(current);
+    printf("Snapshot unchanged: %s, current version matches the changes: %s\n", frozenOk ? "yes" : "no", liveOk ? "yes" : "no");
+    passed &= frozenOk && liveOk;
+
+    long withSnapshot = after.nodes;
+    releaseGarageSnapshot(snapshot);
+    versionedGarageUsage(versioned, &after);
+    printf("Releasing the snapshot freed %ld nodes and the %d removed vehicles\n", withSnapshot - after.nodes, 200);
+    // What remains is the original tree plus the splits of 100 inserts into full chunks
+    passed &= after.retiredVehicles == 0 && after.openSnapshots == 0 && after.nodes <= before.nodes + 200;
+
+    // Out of range changes are refused
+    passed &= versionedGarageRemove(versioned, live) == -1 && versionedGarageInsert(versioned, -1, frozen[0]) == -1;
+
+    // Reports on one thread while another thread changes the garage
+    SnapshotStress stress = {versioned, 30000, 20, 0};
+    timespec_get(&start, TIME_UTC);
+    parallelFor(2, 2, snapshotStressTask, &stress);
+    versionedGarageUsage(versioned, &after);
+    printf("%d changes during %d snapshot reports: %.2f ms, %d mismatches\n", stress.changes, stress.snapshots,
+           millisecondsSince(&start), stress.mismatches);
+    passed &= stress.mismatches == 0 && after.retiredVehicles == 0;
+
+    // Statistics attached to this garage hear its changes and nothing from plain garages
+    GarageYearStats* stats = buildGarageYearStats(NULL, 0);
+    YearAggregate aggregate = {0};
+    attachGarageYearStats(stats, versionedGarageListeners(versioned));
+    versionedGarageAppend(versioned, buildVehicle(7000, 1999, "Listener Test"));
+    char** plain = addVehicle(NULL, 0, buildVehicle(9000, 1999, "Plain Garage"));
+    freeGarage(plain, 1);
+    readYearAggregate(stats, 1999, &aggregate);
+    detachGarageYearStats(stats, versionedGarageListeners(versioned));
+    freeGarageYearStats(stats);
+    int scopedOk = aggregate.count == 1 && aggregate.sum == 7000;
+    printf("Listeners only hear about their own garage: %s\n", scopedOk ? "yes" : "no");
+    passed &= scopedOk;
+
+    printf("Garage snapshot test %s.\n", passed ? "passed" : "FAILED");
+
+    freeVersionedGarage(versioned);
+    free(frozen);
+    free(copy);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+// Checks that a loaded garage holds the vehicles of the given years in garage order
+static int segmentGarageMatches(char** loaded, int numLoaded, char** garage, int numVehicles,
+                                unsigned int firstYear, unsigned int lastYear, int yearsPerSegment) {
+    int next = 0;
+    for (unsigned int partition = firstYear; partition <= lastYear; partition += (unsigned int)yearsPerSegment) {
+        for (int i = 0; i < numVehicles; i++) {
+            unsigned int year = headerYear(vehicleHeader(garage[i]));
+            if (year < partition || year >= partition + (unsigned int)yearsPerSegment) {
+                continue;
+            }
+            if (next >= numLoaded || vehicleHeader(loaded[next]) != vehicleHeader(garage[i]) ||
+                strcmp(vehicleDescription(loaded[next]), vehicleDescription(garage[i])) != 0) {
+                return 0;
+            }
+            next++;
+        }
+    }
+    return next == numLoaded;
+}
+
+/*
+ * Function: testGarageSegments
+ * Purpose: Tests year partitioned segment files: footer statistics, pruning, loading by
+ *          reading and by mapping, rewriting with another partitioning and damaged files
+ */
+void testGarageSegments() {
+    printf("\n--- Garage Segment Test ---\n");
+
+    const char* directory = "garage_segments_test";
+    int numVehicles = 300000;
+    char** garage = buildModelGarage(numVehicles, 0, 1000);  // Model years 2000 to 2024
+    int passed = 1;
+
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    int written = writeGarageSegments(directory, garage, numVehicles, 5, 0);
+    printf("Wrote %d segments of 5 model years in %.2f ms\n", written, millisecondsSince(&start));
+    passed &= written == 5;
+
+    // The footers alone describe every segment
+    SegmentCatalog* catalog = openSegmentCatalog(directory);
+    int footersOk = catalog != NULL && segmentCatalogSize(catalog) == 5;
+    for (int s = 0; footersOk && s < 5; s++) {
+        const SegmentInfo* info = segmentCatalogInfo(catalog, s);
+        unsigned int minValue = MAX_VEHICLE_VALUE, maxValue = 0;
+        int count = 0;
+        for (int i = 0; i < numVehicles; i++) {
+            unsigned int header = vehicleHeader(garage[i]);
+            if (headerYear(header) >= info->firstYear && headerYear(header) <= info->lastYear) {
+                minValue = headerValue(header) < minValue ? headerValue(header) : minValue;
+                maxValue = headerValue(header) > maxValue ? headerValue(header) : maxValue;
+                count++;
+            }
+        }
+        footersOk = info->firstYear == 2000u + 5u * (unsigned int)s && info->lastYear == info->firstYear + 4 &&
+                    info->minYear == info->firstYear && info->maxYear == info->lastYear &&
+                    info->minValue == minValue && info->maxValue == maxValue && info->numVehicles == count;
+    }
+    printf("Footers match the garage: %s\n", footersOk ? "yes" : "no");
+    passed &= footersOk;
+
+    // Every segment, read and mapped
+    SegmentLoadReport report;
+    timespec_get(&start, TIME_UTC);
+    SegmentGarage* all = loadGarageSegments(catalog, NULL, SEGMENT_LOAD_READ, 0, &report);
+    double allTime = millisecondsSince(&start);
+    int numLoaded = 0;
+    char** loaded = segmentGarageVehicles(all, &numLoaded);
+    int allOk = all != NULL && report.segmentsLoaded == 5 &&
+                segmentGarageMatches(loaded, numLoaded, garage, numVehicles, 2000, 2024, 5);
+    printf("Loading all %d segments (%lld bytes): %.2f ms, contents match: %s\n", report.segmentsLoaded,
+           report.bytesLoaded, allTime, allOk ? "yes" : "no");
+    passed &= allOk;
+    freeSegmentGarage(all);
+
+    // A two year window loads one segment; the query then runs on it as on any garage
+    VehicleQuery query;
+    initVehicleQuery(&query);
+    query.minYear = 2011;
+    query.maxYear = 2012;
+    query.minValue = 1000;
+    query.maxValue = 20000;
+    int* expected = (int*)malloc(numVehicles * sizeof(int));
+    int* matches = (int*)malloc(numVehicles * sizeof(int));
+    int numExpected = queryGarage(garage, numVehicles, &query, expected);
+    for (int mode = SEGMENT_LOAD_READ; mode <= SEGMENT_LOAD_MMAP; mode++) {
+        timespec_get(&start, TIME_UTC);
+        SegmentGarage* window = loadGarageSegments(catalog, &query, (SegmentLoadMode)mode, 0, &report);
+        loaded = segmentGarageVehicles(window, &numLoaded);
+        int numMatches = window != NULL ? queryGarage(loaded, numLoaded, &query, matches) : -1;
+        double windowTime = millisecondsSince(&start);
+        int windowOk = window != NULL && report.segmentsPruned == 4 && report.segmentsLoaded == 1 &&
+                       numMatches == numExpected;
+        for (int i = 0; windowOk && i < numMatches; i++) {
+            windowOk = vehicleHeader(loaded[matches[i]]) == vehicleHeader(garage[expected[i]]) &&
+                       strcmp(vehicleDescription(loaded[matches[i]]), vehicleDescription(garage[expected[i]])) == 0;
+        }
+        printf("Years 2011-2012 (%s): %d segments pruned, %d loaded, %d matches in %.2f ms: %s\n",
+               mode == SEGMENT_LOAD_READ ? "read" : "mapped", report.segmentsPruned, report.segmentsLoaded,
+               numMatches, windowTime, windowOk ? "correct" : "WRONG");
+        passed &= windowOk;
+        freeSegmentGarage(window);
+    }
+
+    // No footer holds a value this high, so nothing is loaded
+    initVehicleQuery(&query);
+    query.minValue = 60000;
+    SegmentGarage* none = loadGarageSegments(catalog, &query, SEGMENT_LOAD_MMAP, 0, &report);
+    segmentGarageVehicles(none, &numLoaded);
+    printf("Values from 60000: %d segments pruned, %d vehicles loaded\n", report.segmentsPruned, numLoaded);
+    passed &= none != NULL && report.segmentsPruned == 5 && numLoaded == 0;
+    freeSegmentGarage(none);
+    closeSegmentCatalog(catalog);
+
+    // Rewriting with wider partitions replaces the old segments
+    written = writeGarageSegments(directory, garage, numVehicles, 10, 0);
+    catalog = openSegmentCatalog(directory);
+    int rewriteOk = written == 3 && catalog != NULL && segmentCatalogSize(catalog) == 3 &&
+                    segmentCatalogInfo(catalog, 2)->firstYear == 2020 && segmentCatalogInfo(catalog, 2)->lastYear == 2029;
+    printf("Rewritten as %d segments of 10 years, %d in the directory: %s\n", written, segmentCatalogSize(catalog),
+           rewriteOk ? "correct" : "WRONG");
+    passed &= rewriteOk;
+
+    // A damaged segment fails its checksum, but queries that prune it still work
+    int damageOk = 0;
+    if (catalog != NULL) {
+        FILE* file = fopen(segmentCatalogInfo(catalog, 0)->path, "r+b");
+        if (file != NULL) {
+            fseek(file, 1000, SEEK_SET);
+            fputc('#', file);
+            fclose(file);
+        }
+        printf("Loading every segment after damaging the first (expect an error):\n");
+        SegmentGarage* damaged = loadGarageSegments(catalog, NULL, SEGMENT_LOAD_READ, 0, NULL);
+        initVehicleQuery(&query);
+        query.minYear = 2015;
+        SegmentGarage* recent = loadGarageSegments(catalog, &query, SEGMENT_LOAD_MMAP, 0, &report);
+        segmentGarageVehicles(recent, &numLoaded);
+        damageOk = file != NULL && damaged == NULL && recent != NULL && report.segmentsPruned == 1 &&
+                   numLoaded == numVehicles / 25 * 15;
+        freeSegmentGarage(recent);
+    }
+    printf("Damaged segment refused, the others still load: %s\n", damageOk ? "yes" : "no");
+    passed &= damageOk;
+    closeSegmentCatalog(catalog);
+
+    int removed = removeGarageSegments(directory);
+#ifndef _MSC_VER
+    rmdir(directory);
+#endif
+    passed &= removed == 3;
+
+    printf("Garage segment test %s.\n", passed ? "passed" : "FAILED");
+
+    free(expected);
+    free(matches);
+    freeGarage(garage, numVehicles);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+typedef struct {
+    unsigned long long* hashes;  // Per file
+    long long* sizes;
+    int rejectFile;              // Handler refuses this file (-1 for none)
+} LoaderCheck;
+
+// Loaded file handler that remembers a hash of each file
+static int hashLoadedFile(void* context, int file, char* data, size_t size) {
+    LoaderCheck* check = (LoaderCheck*)context;
+    check->hashes[file] = hashBytes(data, size, 0);
+    check->sizes[file] = (long long)size;
+    free(data);
+    return file == check->rejectFile ? -1 : 0;
+}
+
+/*
+ * Function: testGarageLoader
+ * Purpose: Tests the garage file loader on hundreds of segment files: io_uring against the
+ *          pread threads, segments loaded through it, and missing or refused files
+ */
+void testGarageLoader() {
+    printf("\n--- Garage File Loader Test ---\n");
+
+    const char* directory = "garage_loader_test";
+    const char* wholeDirectory = "garage_loader_test_whole";
+    int numVehicles = 400000;
+    char** garage = (char**)malloc(numVehicles * sizeof(char*));
+    char description[32];
+    for (int i = 0; i < numVehicles; i++) {
+        sprintf(description, "Model %d", i % 1000);
+        garage[i] = buildVehicle((unsigned int)(i % 50000), 1800 + i % 248, description);
+    }
+    int passed = 1;
+
+    // One file per model year, plus the whole garage as one file of many chunks
+    int written = writeGarageSegments(directory, garage, numVehicles, 1, 0);
+    int wholeWritten = writeGarageSegments(wholeDirectory, garage, numVehicles, 4096, 0);
+    SegmentCatalog* catalog = openSegmentCatalog(directory);
+    SegmentCatalog* whole = openSegmentCatalog(wholeDirectory);
+    int numFiles = segmentCatalogSize(catalog) + segmentCatalogSize(whole);
+    passed &= written == 248 && wholeWritten == 1 && numFiles == 249;
+
+    const char** paths = (const char**)malloc((numFiles + 1) * sizeof(char*));
+    for (int i = 0; i < segmentCatalogSize(catalog); i++) {
+        paths[i] = segmentCatalogInfo(catalog, i)->path;
+    }
+    paths[numFiles - 1] = segmentCatalogInfo(whole, 0)->path;
+    long long totalBytes = 0;
+    for (int i = 0; i < numFiles; i++) {
+        totalBytes += i < numFiles - 1 ? segmentCatalogInfo(catalog, i)->fileSize : segmentCatalogInfo(whole, 0)->fileSize;
+    }
+    printf("%d files, %lld bytes (the largest takes %lld reads of %d bytes)\n", numFiles, totalBytes,
+           (segmentCatalogInfo(whole, 0)->fileSize + LOADER_CHUNK_SIZE - 1) / LOADER_CHUNK_SIZE, LOADER_CHUNK_SIZE);
+
+    unsigned long long* expected = (unsigned long long*)calloc(numFiles, sizeof(unsigned long long));
+    unsigned long long* hashes = (unsigned long long*)calloc(numFiles, sizeof(unsigned long long));
+    long long* sizes = (long long*)calloc(numFiles, sizeof(long long));
+    LoaderCheck check = {expected, sizes, -1};
+    LoaderReport report;
+
+    // The pread threads set the expected contents; io_uring (when the kernel allows it) must agree
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    int result = loadGarageFiles(paths, numFiles, LOADER_PREAD, 0, hashLoadedFile, &check, &report);
+    double time = millisecondsSince(&start);
+    printf("pread: %d files, %lld bytes in %lld reads, %.2f ms (%.0f MB/s)\n", report.filesLoaded, report.bytesRead,
+           report.readsIssued, time, report.bytesRead / 1048576.0 / (time > 0 ? time / 1000.0 : 1e-9));
+    passed &= result == 0 && report.backend == LOADER_PREAD && report.filesLoaded == numFiles && report.bytesRead == totalBytes;
+
+    check.hashes = hashes;
+    timespec_get(&start, TIME_UTC);
+    result = loadGarageFiles(paths, numFiles, LOADER_AUTO, 0, hashLoadedFile, &check, &report);
+    time = millisecondsSince(&start);
+    int same = result == 0 && report.filesLoaded == numFiles && memcmp(hashes, expected, numFiles * sizeof(unsigned long long)) == 0;
+    printf("%s: %d files, %lld bytes in %lld reads, %.2f ms (%.0f MB/s), contents match: %s\n",
+           loaderBackendName(report.backend), report.filesLoaded, report.bytesRead, report.readsIssued, time,
+           report.bytesRead / 1048576.0 / (time > 0 ? time / 1000.0 : 1e-9), same ? "yes" : "no");
+    if (report.backend != LOADER_IO_URING) {
+        printf("io_uring is not available here, so the loader fell back to pread\n");
+    }
+    passed &= same;
+
+    // With a single thread the submitting thread also copies the chunks
+    memset(hashes, 0, numFiles * sizeof(unsigned long long));
+    result = loadGarageFiles(paths, numFiles, LOADER_AUTO, 1, hashLoadedFile, &check, &report);
+    same = result == 0 && memcmp(hashes, expected, numFiles * sizeof(unsigned long long)) == 0;
+    printf("One thread (%s): contents match: %s\n", loaderBackendName(report.backend), same ? "yes" : "no");
+    passed &= same;
+
+    // A missing file and a refused file fail the load; every other file still arrives
+    paths[numFiles] = "garage_loader_test_missing.gseg";
+    check.rejectFile = 3;
+    printf("Loading with a missing file and a refused file (expect an error):\n");
+    result = loadGarageFiles(paths, numFiles + 1, LOADER_AUTO, 0, hashLoadedFile, &check, &report);
+    printf("Result %d, %d of %d files accepted\n", result, report.filesLoaded, numFiles + 1);
+    passed &= result == -1 && report.filesLoaded == numFiles - 1;
+    check.rejectFile = -1;
+
+    // Segments loaded through the loader equal segments read directly
+    SegmentGarage* direct = loadGarageSegments(catalog, NULL, SEGMENT_LOAD_READ, 0, NULL);
+    timespec_get(&start, TIME_UTC);
+    SegmentGarage* queued = loadGarageSegments(catalog, NULL, SEGMENT_LOAD_QUEUED, 0, NULL);
+    time = millisecondsSince(&start);
+    int numDirect = 0;
+    int numQueued = 0;
+    char** directVehicles = segmentGarageVehicles(direct, &numDirect);
+    char** queuedVehicles = segmentGarageVehicles(queued, &numQueued);
+    int segmentsOk = direct != NULL && queued != NULL && numDirect == numVehicles && numQueued == numVehicles;
+    for (int i = 0; segmentsOk && i < numQueued; i++) {
+        segmentsOk = vehicleHeader(queuedVehicles[i]) == vehicleHeader(directVehicles[i]) &&
+                     strcmp(vehicleDescription(queuedVehicles[i]), vehicleDescription(directVehicles[i])) == 0;
+    }
+    printf("All 248 segments through the loader: %d vehicles in %.2f ms, same as reading directly: %s\n",
+           numQueued, time, segmentsOk ? "yes" : "no");
+    passed &= segmentsOk;
+    freeSegmentGarage(direct);
+    freeSegmentGarage(queued);
+
+    // An explicit io_uring request either runs on io_uring or fails cleanly
+    result = loadGarageFiles(paths, 1, LOADER_IO_URING, 2, hashLoadedFile, &check, &report);
+    passed &= result == -1 || report.backend == LOADER_IO_URING;
+
+    closeSegmentCatalog(catalog);
+    closeSegmentCatalog(whole);
+    passed &= removeGarageSegments(directory) == 248 && removeGarageSegments(wholeDirectory) == 1;
+#ifndef _MSC_VER
+    rmdir(directory);
+    rmdir(wholeDirectory);
+#endif
+
+    printf("Garage file loader test %s.\n", passed ? "passed" : "FAILED");
+
+    free(paths);
+    free(expected);
+    free(hashes);
+    free(sizes);
+    freeGarage(garage, numVehicles);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+typedef struct {
+    unsigned int header;
+    int position;
+} SortedSlot;
+
+static int compareSortedSlots(const void* a, const void* b) {
+    const SortedSlot* left = (const SortedSlot*)a;
+    const SortedSlot* right = (const SortedSlot*)b;
+    if (left->header != right->header) {
+        return left->header < right->header ? -1 : 1;
+    }
+    return left->position - right->position;
+}
+
+// Checks a vehicle against the one expected, freeing it
+static int sameVehicle(char* vehicle, const char* expected) {
+    int same = vehicle != NULL && vehicleHeader(vehicle) == vehicleHeader(expected) &&
+               strcmp(vehicleDescription(vehicle), vehicleDescription(expected)) == 0;
+    freeVehicle(vehicle);
+    return same;
+}
+
+/*
+ * Function: testGarageArchive
+ * Purpose: Tests block-compressed garage archives: the LZ codec, compression ratio, point
+ *          lookups that read one block, parallel full loads and damaged blocks
+ */
+void testGarageArchive() {
+    printf("\n--- Garage Archive Test ---\n");
+
+    int passed = 1;
+
+    // The codec on its own: repetitive, overlapping, incompressible and malformed input
+    char plain[10000];
+    char packed[10100];
+    char unpacked[10000];
+    int codecOk = 1;
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < (int)sizeof(plain); i++) {
+            plain[i] = round == 0 ? (char)('a' + i % 7) : round == 1 ? 'z' : (char)(rand() & 0xFF);
+        }
+        size_t size = lzCompress(plain, sizeof(plain), packed, sizeof(packed));
+        long restored = lzDecompress(packed, size, unpacked, sizeof(unpacked));
+        codecOk &= size > 0 && size <= lzCompressBound(sizeof(plain)) && restored == (long)sizeof(plain) &&
+                   memcmp(plain, unpacked, sizeof(plain)) == 0;
+        if (round == 0) {
+            codecOk &= lzDecompress(packed, size - 1, unpacked, sizeof(unpacked)) == -1 &&
+                       lzDecompress(packed, size, unpacked, sizeof(unpacked) - 1) == -1;
+        }
+    }
+    const char farMatch[] = {0x10, 'a', 0x05, 0x00, 0x00};  // Match reaching before the output
+    codecOk &= lzDecompress(farMatch, sizeof(farMatch), unpacked, sizeof(unpacked)) == -1 &&
+               lzDecompress(packed, 0, unpacked, sizeof(unpacked)) == -1;
+    printf("LZ codec round trips and rejects bad input: %s\n", codecOk ? "yes" : "no");
+    passed &= codecOk;
+
+    const char* path = "garage_archive_test.garc";
+    int numVehicles = 300000;
+    char** garage = buildModelGarage(numVehicles, 0, 1000);
+    long long rawBytes = 0;
+    for (int i = 0; i < numVehicles; i++) {
+        rawBytes += 4 + vehicleDescriptionLength(garage[i]) + 1;
+    }
+
+    // What the archive should hold: the garage sorted by header, ties in garage order
+    SortedSlot* sorted = (SortedSlot*)malloc(numVehicles * sizeof(SortedSlot));
+    for (int i = 0; i < numVehicles; i++) {
+        sorted[i].header = vehicleHeader(garage[i]);
+        sorted[i].position = i;
+    }
+    qsort(sorted, numVehicles, sizeof(SortedSlot), compareSortedSlots);
+
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    int numBlocks = writeGarageArchive(path, garage, numVehicles, 0);
+    double writeTime = millisecondsSince(&start);
+    GarageArchive* archive = openGarageArchive(path);
+    FILE* file = fopen(path, "rb");
+    long fileSize = 0;
+    if (file != NULL) {
+        fseek(file, 0, SEEK_END);
+        fileSize = ftell(file);
+        fclose(file);
+    }
+    printf("%d vehicles (%lld record bytes) in %d blocks: %ld bytes on disk (%.1fx), written in %.2f ms\n",
+           numVehicles, rawBytes, numBlocks, fileSize, fileSize > 0 ? (double)rawBytes / fileSize : 0.0, writeTime);
+    passed &= numBlocks > 1 && archive != NULL && garageArchiveCount(archive) == numVehicles &&
+              garageArchiveBlocks(archive) == numBlocks && fileSize > 0 && fileSize < rawBytes / 2;
+
+    // Full loads, serial and parallel
+    for (int threads = 1; archive != NULL && threads >= 0; threads--) {
+        int numLoaded = 0;
+        timespec_get(&start, TIME_UTC);
+        char** loaded = loadGarageArchive(archive, threads, &numLoaded);
+        double loadTime = millisecondsSince(&start);
+        int loadOk = loaded != NULL && numLoaded == numVehicles;
+        for (int i = 0; loadOk && i < numLoaded; i++) {
+            const char* expected = garage[sorted[i].position];
+            loadOk = vehicleHeader(loaded[i]) == vehicleHeader(expected) &&
+                     strcmp(vehicleDescription(loaded[i]), vehicleDescription(expected)) == 0;
+        }
+        printf("Full load (%s): %.2f ms, in header order: %s\n", threads == 1 ? "1 thread" : "all processors",
+               loadTime, loadOk ? "yes" : "no");
+        passed &= loadOk;
+        freeGarage(loaded, numLoaded);
+    }
+
+    // Point lookups decompress exactly one block each
+    int lookupsOk = archive != NULL;
+    long long before = garageArchiveBlocksRead(archive);
+    timespec_get(&start, TIME_UTC);
+    for (int i = 0; lookupsOk && i < 1000; i++) {
+        unsigned int header = vehicleHeader(garage[(int)((i * 7919u) % (unsigned int)numVehicles)]);
+        int low = 0;
+        int high = numVehicles;
+        while (low < high) {
+            int middle = low + (high - low) / 2;
+            if (sorted[middle].header < header) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        lookupsOk = sameVehicle(archiveFindVehicle(archive, header), garage[sorted[low].position]);
+    }
+    double lookupTime = millisecondsSince(&start);
+    long long blocksRead = garageArchiveBlocksRead(archive) - before;
+    printf("1000 lookups by header: %.2f ms, %lld blocks decompressed, correct: %s\n", lookupTime, blocksRead,
+           lookupsOk ? "yes" : "no");
+    passed &= lookupsOk && blocksRead == 1000;
+
+    // Value 1 only exists with model year 2001; value 60000 lies past every block
+    before = garageArchiveBlocksRead(archive);
+    int missingOk = archiveFindVehicle(archive, packHeader(1, 2024)) == NULL &&
+                    garageArchiveBlocksRead(archive) - before == 1 &&
+                    archiveFindVehicle(archive, packHeader(60000, 2000)) == NULL &&
+                    garageArchiveBlocksRead(archive) - before == 1;
+    for (int position = 0; missingOk && position < numVehicles; position += 29989) {
+        missingOk = sameVehicle(archiveVehicleAt(archive, position), garage[sorted[position].position]);
+    }
+    printf("Missing headers and lookups by position: %s\n", missingOk ? "correct" : "WRONG");
+    passed &= missingOk;
+
+    // A damaged block fails the full load but not lookups in other blocks
+    int damageOk = 0;
+    if (archive != NULL) {
+        file = fopen(path, "r+b");
+        if (file != NULL) {
+            fseek(file, 100, SEEK_SET);
+            int byte = fgetc(file);
+            fseek(file, 100, SEEK_SET);
+            fputc(byte ^ 0x5A, file);
+            fclose(file);
+        }
+        printf("Loading after damaging the first block (expect an error):\n");
+        int numLoaded = 0;
+        char** damaged = loadGarageArchive(archive, 0, &numLoaded);
+        damageOk = file != NULL && damaged == NULL &&
+                   sameVehicle(archiveVehicleAt(archive, numVehicles - 1), garage[sorted[numVehicles - 1].position]);
+        freeGarage(damaged, numLoaded);
+    }
+    printf("Damaged block refused, other blocks still readable: %s\n", damageOk ? "yes" : "no");
+    passed &= damageOk;
+
+    closeGarageArchive(archive);
+    remove(path);
+
+    printf("Garage archive test %s.\n", passed ? "passed" : "FAILED");
+
+    free(sorted);
+    freeGarage(garage, numVehicles);
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+/*
+ * Function: testHeaderLayout
+ * Purpose: Tests the packed header layout: every value at the lowest and highest year, every
+ *          year at the lowest and highest value, and the model year range check
+ */
+void testHeaderLayout() {
+    printf("\n=== Header Layout Test ===\n");
+    printf("Layout: %d value bits, %d year bits, years %u to %u, values up to $%u\n",
+           VEHICLE_VALUE_BITS, VEHICLE_YEAR_BITS, MIN_MODEL_YEAR, MAX_MODEL_YEAR, MAX_VEHICLE_VALUE);
+
+    unsigned long checked = 0;
+    unsigned long failures = 0;
+    unsigned int boundaryYears[] = {MIN_MODEL_YEAR, MAX_MODEL_YEAR};
+    unsigned int boundaryValues[] = {0, MAX_VEHICLE_VALUE};
+
+    for (int b = 0; b < 2; b++) {
+        for (unsigned int v = 0; v <= MAX_VEHICLE_VALUE; v++) {
+            unsigned int packedData = packHeader(v, boundaryYears[b]);
+            failures += headerValue(packedData) != v || headerYear(packedData) != boundaryYears[b];
+            checked++;
+        }
+        for (unsigned int y = MIN_MODEL_YEAR; y <= MAX_MODEL_YEAR; y++) {
+            unsigned int packedData = packHeader(boundaryValues[b], y);
+            failures += headerValue(packedData) != boundaryValues[b] || headerYear(packedData) != y;
+            checked++;
+        }
+    }
+    printf("%lu boundary combinations checked, %lu failures\n", checked, failures);
+
+    // Value bits just above the year field were lost by the old fixed mask
+    unsigned int middleValue = 5050;
+    int middleOk = headerValue(packHeader(middleValue, MIN_MODEL_YEAR)) == middleValue;
+    printf("$%u round trips: %s\n", middleValue, middleOk ? "yes" : "no");
+
+    int rangeOk = isModelYear(MIN_MODEL_YEAR) && isModelYear(MAX_MODEL_YEAR) && !isModelYear(MAX_MODEL_YEAR + 1);
+#if VEHICLE_YEAR_BASE > 0
+    rangeOk &= !isModelYear(MIN_MODEL_YEAR - 1);
+#endif
+    printf("Model year range check: %s\n", rangeOk ? "yes" : "no");
+
+    int builtOk = 1;
+    char* vehicle = buildVehicle(MAX_VEHICLE_VALUE, MAX_MODEL_YEAR, "Layout Test");
+    builtOk &= vehicle != NULL && vehicleHeader(vehicle) == packHeader(MAX_VEHICLE_VALUE, MAX_MODEL_YEAR);
+    freeVehicle(vehicle);
+    builtOk &= buildVehicle(MAX_VEHICLE_VALUE + 1, MAX_MODEL_YEAR, "Too Valuable") == NULL;
+    builtOk &= buildVehicle(0, MAX_MODEL_YEAR + 1, "Too New") == NULL;
+    printf("buildVehicle keeps to the layout (expect two errors above): %s\n", builtOk ? "yes" : "no");
+
+    int passed = failures == 0 && middleOk && rangeOk && builtOk;
+    printf("Header layout test %s.\n", passed ? "passed" : "FAILED");
+
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+/*
+ * Function: runAllTests
+ * Purpose: Runs all test functions
+ */
+void runAllTests() {
+    printf("\n=== Running All Tests ===\n");
+
+    testGarage();
+    testBitManipulation();
+    testBoundaryValues();
+    testErrorHandling();
+    testMultipleVehicles();
+    testCompressedGarage();
+    testExport();
+    testVehicleIndex();
+    testTopK();
+    testQuery();
+    testBitmapIndex();
+    testYearStats();
+    testVehiclePool();
+    testRecordFormatV2();
+    testParallelOutput();
+    testGarageScan();
+    testGarageMemory();
+    testValueSketch();
+    testDistinctModels();
+    testDescriptionFilter();
+    testDedupGarage();
+    testRevalueGarage();
+    testValueTransforms();
+    testGarageServer();
+    testSharedGarage();
+    testGarageSnapshots();
+    testGarageSegments();
+    testGarageLoader();
+    testGarageArchive();
+    testHeaderLayout();
+
+    printf("\n=== All Tests Completed ===\n");
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+/*
+ * Function: main
+ * Purpose: Entry point for the program. With --serve <socket path> [worker threads] it runs
+ *          as a garage server instead of showing the test menu.
+ */
+int main(int argc, char* argv[]) {
+    int choice;
+
+    if (argc >= 3 && strcmp(argv[1], "--serve") == 0) {
+        int numVehicles = 0;
+        char** garage = runGarageServer(argv[2], NULL, &numVehicles, argc >= 4 ? atoi(argv[3]) : 0);
+        if (garage == NULL) {
+            return 1;
+        }
+        freeGarage(garage, numVehicles);
+        return 0;
+    }
+
+    do {
+        choice = mainMenu();
+
+        switch (choice) {
+            case 0:
+                printf("Exiting program. Goodbye!\n");
+                break;
+            case 1:
+                testGarage();
+                break;
+            case 2:
+                testBitManipulation();
+                break;
+            case 3:
+                testBoundaryValues();
+                break;
+            case 4:
+                testErrorHandling();
+                break;
+            case 5:
+                testMultipleVehicles();
+                break;
+            case 6:
+                runAllTests();
+                break;
+            case 7:
+                testCompressedGarage();
+                break;
+            case 8:
+                testExport();
+                break;
+            case 9:
+                testVehicleIndex();
+                break;
+            case 10:
+                testTopK();
+                break;
+            case 11:
+                testQuery();
+                break;
+            case 12:
+                testBitmapIndex();
+                break;
+            case 13:
+                testYearStats();
+                break;
+            case 14:
+                testVehiclePool();
+                break;
+            case 15:
+                testRecordFormatV2();
+                break;
+            case 16:
+                testParallelOutput();
+                break;
+            case 17:
+                testGarageScan();
+                break;
+            case 18:
+                testGarageMemory();
+                break;
+            case 19:
+                testValueSketch();
+                break;
+            case 20:
+                testDistinctModels();
+                break;
+            case 21:
+                testDescriptionFilter();
+                break;
+            case 22:
+                testDedupGarage();
+                break;
+            case 23:
+                testRevalueGarage();
+                break;
+            case 24:
+                testValueTransforms();
+                break;
+            case 25:
+                testGarageServer();
+                break;
+            case 26:
+                testSharedGarage();
+                break;
+            case 27:
+                testGarageSnapshots();
+                break;
+            case 28:
+                testGarageSegments();
+                break;
+            case 29:
+                testGarageLoader();
+                break;
+            case 30:
+                testGarageArchive();
+                break;
+            case 31:
+                testHeaderLayout();
                 break;
             default:
                 printf("Invalid choice. Please try again.\n");
@@ -0,0 +1,221 @@
+/*
+ * Parallel
+ * Fork/join over contiguous ranges with POSIX threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include "parallel.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+typedef struct {
+    ParallelTask task;
+    void* context;
+    int begin;
+    int end;
+    int worker;
+} ParallelRange;
+
+int defaultThreadCount() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return processors > 0 ? (int)processors : 1;
+#endif
+}
+
+// First item of range i when [0, count) is split into numRanges ranges
+static int rangeBegin(int count, int i, int numRanges) {
+    return (int)((long long)count * i / numRanges);
+}
+
+#ifndef _WIN32
+static void* runRange(void* argument) {
+    ParallelRange* range = (ParallelRange*)argument;
+    range->task(range->context, range->begin, range->end, range->worker);
+    return NULL;
+}
+#endif
+
+int parallelFor(int count, int numThreads, ParallelTask task, void* context) {
+    if (numThreads <= 0) {
+        numThreads = defaultThreadCount();
+    }
+    if (numThreads > count) {
+        numThreads = count > 0 ? count : 1;
+    }
+
+    ParallelRange* ranges = (ParallelRange*)malloc(numThreads * sizeof(ParallelRange));
+    if (ranges == NULL) {
+        // Still do the work on this thread, keeping the same range for every worker
+        for (int i = 0; i < numThreads; i++) {
+            task(context, rangeBegin(count, i, numThreads), rangeBegin(count, i + 1, numThreads), i);
+        }
+        return numThreads;
+    }
+
+    for (int i = 0; i < numThreads; i++) {
+        ranges[i].task = task;
+        ranges[i].context = context;
+        ranges[i].begin = rangeBegin(count, i, numThreads);
+        ranges[i].end = rangeBegin(count, i + 1, numThreads);
+        ranges[i].worker = i;
+    }
+
+#ifdef _WIN32
+    for (int i = 0; i < numThreads; i++) {
+        task(context, ranges[i].begin, ranges[i].end, i);
+    }
+#else
+    pthread_t* threads = (pthread_t*)malloc(numThreads * sizeof(pthread_t));
+    int* started = (int*)calloc(numThreads, sizeof(int));
+
+    // Worker 0 runs on the calling thread
+    for (int i = 1; i < numThreads; i++) {
+        if (threads != NULL && started != NULL &&
+            pthread_create(&threads[i], NULL, runRange, &ranges[i]) == 0) {
+            started[i] = 1;
+        }
+    }
+    runRange(&ranges[0]);
+
+    for (int i = 1; i < numThreads; i++) {
+        if (started != NULL && started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            // Thread could not be started, so run its range here
+            runRange(&ranges[i]);
+        }
+    }
+
+    free(threads);
+    free(started);
+#endif
+
+    free(ranges);
+    return numThreads;
+}
+
+static int reserveOutput(OutputBuffer* out, size_t extra) {
+    if (out->error) {
+        return -1;
+    }
+    if (out->used + extra <= out->capacity) {
+        return 0;
+    }
+
+    size_t capacity = out->capacity == 0 ? 4096 : out->capacity;
+    while (capacity < out->used + extra) {
+        capacity *= 2;
+    }
+
+    char* data = (char*)realloc(out->data, capacity);
+    if (data == NULL) {
+        out->error = 1;
+        return -1;
+    }
+    out->data = data;
+    out->capacity = capacity;
+    return 0;
+}
+
+int outputAppend(OutputBuffer* out, const char* bytes, size_t length) {
+    if (reserveOutput(out, length) != 0) {
+        return -1;
+    }
+    memcpy(out->data + out->used, bytes, length);
+    out->used += length;
+    return 0;
+}
+
+int outputPrintf(OutputBuffer* out, const char* format, ...) {
+    va_list arguments;
+
+    // Usually fits in the room left; otherwise grow to the exact size and format again
+    va_start(arguments, format);
+    int length = vsnprintf(out->data == NULL ? NULL : out->data + out->used,
+                           out->capacity - out->used, format, arguments);
+    va_end(arguments);
+
+    if (length < 0) {
+        out->error = 1;
+        return -1;
+    }
+    if (out->used + (size_t)length < out->capacity) {
+        out->used += (size_t)length;
+        return 0;
+    }
+
+    if (reserveOutput(out, (size_t)length + 1) != 0) {
+        return -1;
+    }
+    va_start(arguments, format);
+    vsnprintf(out->data + out->used, out->capacity - out->used, format, arguments);
+    va_end(arguments);
+    out->used += (size_t)length;
+    return 0;
+}
+
+typedef struct {
+    ChunkFormatter format;
+    void* context;
+    OutputBuffer* buffers;
+    int start;  // First item of the current round
+} OutputRound;
+
+static void formatRange(void* argument, int begin, int end, int worker) {
+    OutputRound* round = (OutputRound*)argument;
+    round->format(round->context, round->start + begin, round->start + end, &round->buffers[worker]);
+}
+
+int parallelOrderedOutput(int count, int numThreads, ChunkFormatter format, ChunkWriter write, void* context) {
+    if (numThreads <= 0) {
+        numThreads = defaultThreadCount();
+    }
+
+    OutputBuffer* buffers = (OutputBuffer*)calloc(numThreads, sizeof(OutputBuffer));
+    if (buffers == NULL) {
+        printf("Error: Memory allocation for output buffers failed\n");
+        return -1;
+    }
+
+    OutputRound round = {format, context, buffers, 0};
+    int result = 0;
+    int roundSize = numThreads * PARALLEL_OUTPUT_CHUNK;
+
+    for (round.start = 0; round.start < count && result == 0; round.start += roundSize) {
+        int items = count - round.start < roundSize ? count - round.start : roundSize;
+
+        for (int i = 0; i < numThreads; i++) {
+            buffers[i].used = 0;
+        }
+        parallelFor(items, numThreads, formatRange, &round);
+
+        // Worker i formatted the i-th range, so writing 0, 1, 2 ... keeps the order
+        for (int i = 0; i < numThreads && result == 0; i++) {
+            if (buffers[i].error) {
+                printf("Error: Memory allocation for output buffers failed\n");
+                result = -1;
+            } else if (buffers[i].used > 0) {
+                result = write(context, buffers[i].data, buffers[i].used);
+            }
+        }
+    }
+
+    for (int i = 0; i < numThreads; i++) {
+        free(buffers[i].data);
+    }
+    free(buffers);
+    return result;
+}
@@ -0,0 +1,83 @@
+/*
+ * Parallel Header File
+ * Minimal fork/join helper used by the parallel garage operations.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+
+/*
+ * Work done by one thread: process items [begin, end). worker is 0 .. numThreads - 1.
+ */
+typedef void (*ParallelTask)(void* context, int begin, int end, int worker);
+
+/*
+ * Function: defaultThreadCount
+ * Purpose: Number of threads to use when the caller does not choose (online processors).
+ */
+int defaultThreadCount();
+
+/*
+ * Function: parallelFor
+ * Purpose: Splits [0, count) into numThreads contiguous ranges and runs task on each range
+ *          in its own thread, then waits for all of them. Range i always goes to worker i,
+ *          even when threads cannot be started and the ranges run on the calling thread, so
+ *          per-worker results can be merged in order and passes over the same count line up.
+ * Parameters: int - number of items
+ *             int - number of threads (0 or less means defaultThreadCount)
+ *             ParallelTask - the work for one range
+ *             void* - context passed to every task
+ * Returns: the number of workers used
+ */
+int parallelFor(int, int, ParallelTask, void*);
+
+/*
+ * Ordered output
+ * Items are formatted on worker threads into per-worker buffers and the buffers are then
+ * written in item order, so the result is byte for byte what a serial loop would produce.
+ * Work is done in rounds of PARALLEL_OUTPUT_CHUNK items per worker to bound memory use.
+ */
+#define PARALLEL_OUTPUT_CHUNK 65536       // Items one worker formats per round
+#define PARALLEL_OUTPUT_THRESHOLD 100000  // Below this many items callers stay serial
+
+typedef struct {
+    char* data;
+    size_t used;
+    size_t capacity;
+    int error;  // Set once growing the buffer failed
+} OutputBuffer;
+
+/*
+ * Functions: outputAppend, outputPrintf
+ * Purpose: Add bytes / printf style text to an output buffer, growing it as needed.
+ * Returns: 0 on success, -1 if allocation failed
+ */
+int outputAppend(OutputBuffer*, const char*, size_t);
+int outputPrintf(OutputBuffer*, const char*, ...);
+
+/*
+ * Formats items [begin, end) into out. Runs on a worker thread.
+ */
+typedef void (*ChunkFormatter)(void* context, int begin, int end, OutputBuffer* out);
+
+/*
+ * Writes formatted bytes to the destination. Always called on the calling thread, in order.
+ * Returns 0 on success, -1 to stop the output.
+ */
+typedef int (*ChunkWriter)(void* context, const char* data, size_t length);
+
+/*
+ * Function: parallelOrderedOutput
+ * Purpose: Formats [0, count) in parallel and writes the result in order.
+ * Parameters: int - number of items
+ *             int - number of threads (0 or less means defaultThreadCount)
+ *             ChunkFormatter - formats a range of items
+ *             ChunkWriter - receives the formatted bytes in order
+ *             void* - context passed to both
+ * Returns: 0 on success, -1 if allocation or a write failed
+ */
+int parallelOrderedOutput(int, int, ChunkFormatter, ChunkWriter, void*);
+
+#endif /* PARALLEL_H */
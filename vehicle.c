@@ -6,28 +6,52 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
 #include "vehicle.h"
+#include "hash.h"
+#include "parallel.h"
+#include "garage_scan.h"
 
 // To make the code compatible for both microsoft and mac users, Add compatibility for non-Microsoft compilers
 #ifndef _MSC_VER
     #define scanf_s scanf
 #endif
 
-// Constants for bit operations
-#define VALUE_MASK 0xFFFFE000  // Mask for the upper 21 bits (vehicle value)
-#define YEAR_MASK 0x000007FF   // Mask for the lower 11 bits (model year)
-#define VALUE_SHIFT 11         // Number of bits to shift for value
 #define MAX_DESCRIPTION 100    // Maximum buffer size for description input
 
+struct GarageListeners {
+    pthread_mutex_t lock;  // Held while registering and while reporting an event
+    struct {
+        GarageListener callback;
+        void* context;
+    } entries[MAX_GARAGE_LISTENERS];
+    atomic_int count;      // Read without the lock to skip empty lists
+};
+
+// Listeners of the plain char** garages, which have no handle to own a list
+static GarageListeners plainGarageListeners = {PTHREAD_MUTEX_INITIALIZER, {{NULL, NULL}}, 0};
+
+static char* allocateRecord(const VehicleAllocator* allocator, size_t size) {
+    return allocator != NULL ? allocator->allocate(allocator->context, size) : (char*)malloc(size);
+}
+
+static char* buildRecord(const VehicleAllocator*, unsigned int, const char*, int);
+static char* buildRecordV2(const VehicleAllocator*, unsigned int, const char*, unsigned int);
+
 /*
  * Function to: createVehicle
  * Purpose: This meant to dynamically allocate a string to store a vehicle's information.
- *          Value and model year are stored in the first 4 bytes.
- *          The remaining memory is for the description of the vehicle.
+ *          The record is in format v2: value and model year, the description length and
+ *          the description hash are stored ahead of the description of the vehicle.
  * Returns: a dynamically allocated block of memory containing the vehicle's information
  * By: Anyaso
  */
 char* createVehicle() {
+    return createVehicleWith(NULL);
+}
+
+char* createVehicleWith(const VehicleAllocator* allocator) {
     char descriptionBuffer[MAX_DESCRIPTION];
     unsigned int value, year;
     unsigned int packedData;
@@ -35,24 +59,24 @@ char* createVehicle() {
     int descriptionLength;
 
     // Get vehicle value from user
-    printf("Input vehicle value (up to $2,097,151): $");
+    printf("Input vehicle value (up to $%u): $", MAX_VEHICLE_VALUE);
     scanf_s("%u", &value);
 
     // Validate vehicle value
-    if (value > 2097151) { // 2^21 - 1
-        printf("Error: Vehicle value exceeds required maximum value ($2,097,151)\n");
+    if (value > MAX_VEHICLE_VALUE) {
+        printf("Error: Vehicle value exceeds required maximum value ($%u)\n", MAX_VEHICLE_VALUE);
         // Clear input buffer
         while (getchar() != '\n');
         return NULL;
     }
 
     // Accept vehicle year from user
-    printf("Input vehicle model year (up to 2047): ");
+    printf("Input vehicle model year (%u to %u): ", MIN_MODEL_YEAR, MAX_MODEL_YEAR);
     scanf_s("%u", &year);
 
     // Validate model year
-    if (year > 2047) { // 2^11 - 1
-        printf("Error: Model year exceeds required maximum model (2047)\n");
+    if (!isModelYear(year)) {
+        printf("Error: Model year is outside the supported range (%u to %u)\n", MIN_MODEL_YEAR, MAX_MODEL_YEAR);
         // Clear input buffer
         while (getchar() != '\n');
         return NULL;
@@ -72,32 +96,255 @@ char* createVehicle() {
         descriptionLength--;
     }
 
+    // Would make a v1 record look like a v2 tag
+    if (descriptionBuffer[0] == VEHICLE_V2_TAG[4]) {
+        printf("Error: Vehicle description cannot start with a control character\n");
+        return NULL;
+    }
+
+    // Pack value and year into one integer using bit operations
+    packedData = packHeader(value, year);
+
+    // In format v2, so the description hash is computed once, here
+    vehicle = buildRecordV2(allocator, packedData, descriptionBuffer, (unsigned int)descriptionLength);
+
+    return vehicle;
+}
+
+/*
+ * Function: buildVehicleRecord
+ * Purpose: Allocates a vehicle and stores the packed header followed by the description.
+ */
+char* buildVehicleRecord(unsigned int packedData, const char* description, int descriptionLength) {
+    return buildRecord(NULL, packedData, description, descriptionLength);
+}
+
+static char* buildRecord(const VehicleAllocator* allocator, unsigned int packedData, const char* description,
+                         int descriptionLength) {
+    // Checked whatever the header: a later rewrite to 0 would turn the record into a v2 tag
+    if (descriptionLength > 0 && description[0] == VEHICLE_V2_TAG[4]) {
+        printf("Error: Record would read as a v2 vehicle\n");
+        return NULL;
+    }
+
     // Allocate memory for the vehicle
     // 4 bytes for value/year + length of description + 1 for null terminator
-    vehicle = (char*)malloc(4 + descriptionLength + 1);
+    size_t size = 4 + descriptionLength + 1;
+    char* vehicle = allocateRecord(allocator, size);
 
     if (vehicle == NULL) {
         printf("Error: Memory allocation failed\n");
         return NULL;
     }
 
-    // Pack value and year into one integer using bit operations
-    packedData = (value << VALUE_SHIFT) | year;
+    encodeVehicleRecord(vehicle, packedData, description, (unsigned int)descriptionLength);
+    return vehicle;
+}
+
+/*
+ * Function: encodeVehicleRecord
+ * Purpose: Writes the packed header in the first 4 bytes, then the description and its terminator.
+ */
+size_t encodeVehicleRecord(char* record, unsigned int packedData, const char* description, unsigned int descriptionLength) {
+    record[0] = (char)(packedData >> 24);
+    record[1] = (char)(packedData >> 16);
+    record[2] = (char)(packedData >> 8);
+    record[3] = (char)packedData;
+
+    memcpy(record + 4, description, descriptionLength);
+    record[4 + descriptionLength] = '\0';
+    return 4 + (size_t)descriptionLength + 1;
+}
+
+/*
+ * Function: buildVehicleRecordV2
+ * Purpose: Allocates a v2 vehicle: tag, native header, length, then the description.
+ */
+char* buildVehicleRecordV2(unsigned int packedData, const char* description, unsigned int descriptionLength) {
+    return buildRecordV2(NULL, packedData, description, descriptionLength);
+}
+
+static char* buildRecordV2(const VehicleAllocator* allocator, unsigned int packedData, const char* description,
+                           unsigned int descriptionLength) {
+    // Refused as in v1, so the vehicle can still be written out in format v1
+    if (descriptionLength > 0 && description[0] == VEHICLE_V2_TAG[4]) {
+        printf("Error: Record would read as a v2 vehicle\n");
+        return NULL;
+    }
 
-    // Save the packed data in the first 4 bytes
-    vehicle[0] = (packedData >> 24) & 0xFF;
-    vehicle[1] = (packedData >> 16) & 0xFF;
-    vehicle[2] = (packedData >> 8) & 0xFF;
-    vehicle[3] = packedData & 0xFF;
+    size_t size = VEHICLE_V2_DESCRIPTION_OFFSET + (size_t)descriptionLength + 1;
+    char* vehicle = allocateRecord(allocator, size);
 
-    // Copy the description to the rest of the allocated memory, this will be done manually
-    for (int i = 0; i <= descriptionLength; i++) {
-        vehicle[4 + i] = descriptionBuffer[i];
+    if (vehicle == NULL) {
+        printf("Error: Memory allocation failed\n");
+        return NULL;
     }
 
+    memcpy(vehicle, VEHICLE_V2_TAG, VEHICLE_V2_HEADER_OFFSET);
+    memcpy(vehicle + VEHICLE_V2_HEADER_OFFSET, &packedData, sizeof(unsigned int));
+    memcpy(vehicle + VEHICLE_V2_LENGTH_OFFSET, &descriptionLength, sizeof(unsigned int));
+    unsigned long long hash = hashDescriptionBytes(description, descriptionLength);
+    memcpy(vehicle + VEHICLE_V2_HASH_OFFSET, &hash, sizeof(hash));
+    memcpy(vehicle + VEHICLE_V2_DESCRIPTION_OFFSET, description, descriptionLength);
+    vehicle[VEHICLE_V2_DESCRIPTION_OFFSET + descriptionLength] = '\0';
+
     return vehicle;
 }
 
+// Checks the value, year and description shared by buildVehicle and buildVehicleV2
+static int validateVehicle(unsigned int value, unsigned int year, const char* description) {
+    if (description == NULL) {
+        printf("Error: Vehicle description is NULL\n");
+        return -1;
+    }
+
+    // Would make a v1 record look like a v2 tag
+    if (description[0] == VEHICLE_V2_TAG[4]) {
+        printf("Error: Vehicle description cannot start with a control character\n");
+        return -1;
+    }
+
+    if (value > MAX_VEHICLE_VALUE) {
+        printf("Error: Vehicle value exceeds required maximum value ($%u)\n", MAX_VEHICLE_VALUE);
+        return -1;
+    }
+
+    if (!isModelYear(year)) {
+        printf("Error: Model year is outside the supported range (%u to %u)\n", MIN_MODEL_YEAR, MAX_MODEL_YEAR);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Function: buildVehicle
+ * Purpose: Validates a value/year pair and builds a vehicle without asking the user.
+ */
+char* buildVehicle(unsigned int value, unsigned int year, const char* description) {
+    return buildVehicleWith(NULL, value, year, description);
+}
+
+char* buildVehicleWith(const VehicleAllocator* allocator, unsigned int value, unsigned int year, const char* description) {
+    if (validateVehicle(value, year, description) != 0) {
+        return NULL;
+    }
+
+    return buildRecord(allocator, packHeader(value, year), description, (int)strlen(description));
+}
+
+char* buildVehicleV2(unsigned int value, unsigned int year, const char* description) {
+    if (validateVehicle(value, year, description) != 0) {
+        return NULL;
+    }
+
+    return buildVehicleRecordV2(packHeader(value, year), description, (unsigned int)strlen(description));
+}
+
+char* convertVehicleToV2(const char* vehicle) {
+    if (vehicle == NULL) {
+        printf("Error: Vehicle pointer is NULL\n");
+        return NULL;
+    }
+
+    return buildVehicleRecordV2(vehicleHeader(vehicle), vehicleDescription(vehicle), vehicleDescriptionLength(vehicle));
+}
+
+int isReservedVehicleRecord(const char* record) {
+    return record[4] == VEHICLE_V2_TAG[4];
+}
+
+int isVehicleV2(const char* vehicle) {
+    // Byte by byte so a short v1 record is never read past its terminator
+    return vehicle[4] == VEHICLE_V2_TAG[4] && vehicle[5] == VEHICLE_V2_TAG[5] &&
+           vehicle[6] == VEHICLE_V2_TAG[6] && vehicle[7] == '\0' &&
+           vehicle[0] == 0 && vehicle[1] == 0 && vehicle[2] == 0 && vehicle[3] == 0;
+}
+
+void freeVehicle(char* vehicle) {
+    freeVehicleWith(NULL, vehicle);
+}
+
+void freeVehicleWith(const VehicleAllocator* allocator, char* vehicle) {
+    if (vehicle == NULL) {
+        return;
+    }
+
+    if (allocator != NULL) {
+        allocator->release(allocator->context, vehicle, vehicleRecordSize(vehicle));
+    } else {
+        free(vehicle);
+    }
+}
+
+size_t vehicleRecordSize(const char* vehicle) {
+    if (isVehicleV2(vehicle)) {
+        return VEHICLE_V2_DESCRIPTION_OFFSET + (size_t)vehicleDescriptionLength(vehicle) + 1;
+    }
+    return 4 + strlen(vehicle + 4) + 1;
+}
+
+unsigned int vehicleDescriptionLength(const char* vehicle) {
+    if (isVehicleV2(vehicle)) {
+        unsigned int length;
+        memcpy(&length, vehicle + VEHICLE_V2_LENGTH_OFFSET, sizeof(unsigned int));
+        return length;
+    }
+    return (unsigned int)strlen(vehicle + 4);
+}
+
+unsigned long long vehicleDescriptionHash(const char* vehicle) {
+    if (isVehicleV2(vehicle)) {
+        unsigned long long hash;
+        memcpy(&hash, vehicle + VEHICLE_V2_HASH_OFFSET, sizeof(hash));
+        return hash;
+    }
+    return hashDescriptionBytes(vehicle + 4, strlen(vehicle + 4));
+}
+
+unsigned int vehicleHeader(const char* vehicle) {
+    if (isVehicleV2(vehicle)) {
+        // Aligned native load; memcpy keeps it free of aliasing problems
+        unsigned int packedData;
+        memcpy(&packedData, vehicle + VEHICLE_V2_HEADER_OFFSET, sizeof(unsigned int));
+        return packedData;
+    }
+    return ((unsigned int)(unsigned char)vehicle[0] << 24) |
+           ((unsigned int)(unsigned char)vehicle[1] << 16) |
+           ((unsigned int)(unsigned char)vehicle[2] << 8) |
+           ((unsigned int)(unsigned char)vehicle[3]);
+}
+
+void setVehicleHeader(char* vehicle, unsigned int packedData) {
+    if (isVehicleV2(vehicle)) {
+        memcpy(vehicle + VEHICLE_V2_HEADER_OFFSET, &packedData, sizeof(unsigned int));
+        return;
+    }
+    vehicle[0] = (char)(packedData >> 24);
+    vehicle[1] = (char)(packedData >> 16);
+    vehicle[2] = (char)(packedData >> 8);
+    vehicle[3] = (char)packedData;
+}
+
+const char* vehicleDescription(const char* vehicle) {
+    if (isVehicleV2(vehicle)) {
+        return vehicle + VEHICLE_V2_DESCRIPTION_OFFSET;
+    }
+    // The description starts at the 5th byte
+    return vehicle + 4;
+}
+
+static int displaySlot(void* context, char* vehicle, int position) {
+    (void)context;
+    printf("Vehicle %d: ", position + 1);
+    if (vehicle == NULL) {
+        printf("Empty\n");
+    } else {
+        displayVehicle(vehicle);
+    }
+    return 0;
+}
+
 /*
  * Function to: displayGarage
  * Purpose: This will display all the information stored for each vehicle in the garage.
@@ -112,15 +359,54 @@ void displayGarage(char** garage, int numVehicles) {
         return;
     }
 
+    if (numVehicles >= PARALLEL_OUTPUT_THRESHOLD) {
+        displayGarageParallel(garage, numVehicles, 0);
+        return;
+    }
+
     printf("\n--- Garage Contents (%d vehicles) ---\n", numVehicles);
-    for (int i = 0; i < numVehicles; i++) {
-        printf("Vehicle %d: ", i + 1);
-        if (garage[i] == NULL) {
-            printf("Empty\n");
-        } else {
-            displayVehicle(garage[i]);
-        }
+    forEachVehicle(garage, numVehicles, displaySlot, NULL);
+    printf("--- End of Garage ---\n");
+}
+
+typedef struct {
+    OutputBuffer* out;
+    int base;  // Garage position of the first slot being formatted
+} GarageLines;
+
+static int formatGarageLine(void* context, char* vehicle, int position) {
+    GarageLines* lines = (GarageLines*)context;
+    int number = lines->base + position + 1;
+
+    if (vehicle == NULL) {
+        outputPrintf(lines->out, "Vehicle %d: Empty\n", number);
+    } else {
+        unsigned int packedData = vehicleHeader(vehicle);
+        outputPrintf(lines->out, "Vehicle %d: Vehicle: %s, Year: %u, Value: $%u\n", number,
+                     vehicleDescription(vehicle), headerYear(packedData), headerValue(packedData));
+    }
+    return 0;
+}
+
+// Formats the displayGarage lines of vehicles [begin, end)
+static void formatGarageLines(void* context, int begin, int end, OutputBuffer* out) {
+    GarageLines lines = {out, begin};
+    forEachVehicle((char**)context + begin, end - begin, formatGarageLine, &lines);
+}
+
+static int writeToStdout(void* context, const char* data, size_t length) {
+    (void)context;
+    return fwrite(data, 1, length, stdout) == length ? 0 : -1;
+}
+
+void displayGarageParallel(char** garage, int numVehicles, int numThreads) {
+    if (garage == NULL) {
+        printf("Error: Garage pointer is NULL\n");
+        return;
     }
+
+    printf("\n--- Garage Contents (%d vehicles) ---\n", numVehicles);
+    parallelOrderedOutput(numVehicles, numThreads, formatGarageLines, writeToStdout, garage);
     printf("--- End of Garage ---\n");
 }
 
@@ -136,20 +422,16 @@ void displayVehicle(char* vehicle) {
     }
 
     // Extract the packed data from the first 4 bytes
-    unsigned int packedData =
-        ((unsigned int)(unsigned char)vehicle[0] << 24) |
-        ((unsigned int)(unsigned char)vehicle[1] << 16) |
-        ((unsigned int)(unsigned char)vehicle[2] << 8) |
-        ((unsigned int)(unsigned char)vehicle[3]);
+    unsigned int packedData = vehicleHeader(vehicle);
 
     // Extract the value (upper 21 bits)
-    unsigned int value = (packedData & VALUE_MASK) >> VALUE_SHIFT;
+    unsigned int value = headerValue(packedData);
 
     // Extract the year (lower 11 bits)
-    unsigned int year = packedData & YEAR_MASK;
+    unsigned int year = headerYear(packedData);
 
     // The description starts at the 5th byte
-    char* description = vehicle + 4;
+    const char* description = vehicleDescription(vehicle);
 
     printf("Vehicle: %s, Year: %u, Value: $%u\n", description, year, value);
 }
@@ -182,6 +464,8 @@ char** createGarage(int numVehicles) {
             printf("\nPlease try again for vehicle %d:\n", i + 1);
             garage[i] = createVehicle();
         }
+
+        notifyGarageListeners(NULL, GARAGE_EVENT_INSERT, garage[i], i);
     }
 
     return garage;
@@ -189,6 +473,10 @@ char** createGarage(int numVehicles) {
 
 //removeVehicle
 char** removeVehicle(char** garage, int numVehicles, int index) {
+    return removeVehicleWith(garage, numVehicles, index, NULL);
+}
+
+char** removeVehicleWith(char** garage, int numVehicles, int index, const VehicleAllocator* allocator) {
     printf("removeVehicle(%p, %d, %d)\n",
            (void*)garage, numVehicles, index);
 
@@ -215,7 +503,8 @@ char** removeVehicle(char** garage, int numVehicles, int index) {
     for (int i = 0; i < numVehicles; i++) {
         if (i == index) {
             // Free the vehicle being removed
-            free(garage[i]);
+            notifyGarageListeners(NULL, GARAGE_EVENT_REMOVE, garage[i], i);
+            freeVehicleWith(allocator, garage[i]);
         } else {
             // Copy the vehicle pointer to the new garage
             newGarage[newIndex++] = garage[i];
@@ -228,4 +517,130 @@ char** removeVehicle(char** garage, int numVehicles, int index) {
     printf("Vehicle at position %d has been removed.\n", index + 1);
 
     return newGarage;
-}
\ No newline at end of file
+}
+
+static GarageListeners* listenersOf(GarageListeners* listeners) {
+    return listeners != NULL ? listeners : &plainGarageListeners;
+}
+
+GarageListeners* createGarageListeners() {
+    GarageListeners* listeners = (GarageListeners*)calloc(1, sizeof(GarageListeners));
+    if (listeners == NULL) {
+        printf("Error: Memory allocation for garage listeners failed\n");
+        return NULL;
+    }
+    pthread_mutex_init(&listeners->lock, NULL);
+    return listeners;
+}
+
+void freeGarageListeners(GarageListeners* listeners) {
+    if (listeners == NULL || listeners == &plainGarageListeners) {
+        return;
+    }
+    pthread_mutex_destroy(&listeners->lock);
+    free(listeners);
+}
+
+int addGarageListener(GarageListeners* listeners, GarageListener callback, void* context) {
+    listeners = listenersOf(listeners);
+    pthread_mutex_lock(&listeners->lock);
+    int count = atomic_load_explicit(&listeners->count, memory_order_relaxed);
+    if (callback == NULL || count == MAX_GARAGE_LISTENERS) {
+        pthread_mutex_unlock(&listeners->lock);
+        printf("Error: Cannot register garage listener\n");
+        return -1;
+    }
+
+    listeners->entries[count].callback = callback;
+    listeners->entries[count].context = context;
+    atomic_store_explicit(&listeners->count, count + 1, memory_order_release);
+    pthread_mutex_unlock(&listeners->lock);
+    return 0;
+}
+
+void removeGarageListener(GarageListeners* listeners, GarageListener callback, void* context) {
+    listeners = listenersOf(listeners);
+    pthread_mutex_lock(&listeners->lock);
+    int count = atomic_load_explicit(&listeners->count, memory_order_relaxed);
+    for (int i = 0; i < count; i++) {
+        if (listeners->entries[i].callback == callback && listeners->entries[i].context == context) {
+            // Keep registration order for the remaining listeners
+            for (int j = i + 1; j < count; j++) {
+                listeners->entries[j - 1] = listeners->entries[j];
+            }
+            atomic_store_explicit(&listeners->count, count - 1, memory_order_release);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&listeners->lock);
+}
+
+static void reportEvent(GarageListeners* listeners, const GarageEvent* event) {
+    listeners = listenersOf(listeners);
+    if (atomic_load_explicit(&listeners->count, memory_order_acquire) == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&listeners->lock);
+    int count = atomic_load_explicit(&listeners->count, memory_order_relaxed);
+    for (int i = 0; i < count; i++) {
+        listeners->entries[i].callback(listeners->entries[i].context, event);
+    }
+    pthread_mutex_unlock(&listeners->lock);
+}
+
+void notifyGarageListeners(GarageListeners* listeners, int type, const char* vehicle, int position) {
+    GarageEvent event = {type, vehicle, position, 0};
+    reportEvent(listeners, &event);
+}
+
+void notifyVehicleUpdated(GarageListeners* listeners, const char* vehicle, int position, unsigned int previousHeader) {
+    GarageEvent event = {GARAGE_EVENT_UPDATE, vehicle, position, previousHeader};
+    reportEvent(listeners, &event);
+}
+
+int hasGarageListeners(GarageListeners* listeners) {
+    return atomic_load_explicit(&listenersOf(listeners)->count, memory_order_acquire) > 0;
+}
+
+//addVehicle
+char** addVehicle(char** garage, int numVehicles, char* vehicle) {
+    if (vehicle == NULL) {
+        printf("Error: Vehicle pointer is NULL\n");
+        return garage;
+    }
+
+    char** newGarage = (char**)realloc(garage, (numVehicles + 1) * sizeof(char*));
+    if (newGarage == NULL) {
+        printf("Error: Memory allocation for new garage failed\n");
+        return garage; // Return the original garage unchanged
+    }
+
+    newGarage[numVehicles] = vehicle;
+    notifyGarageListeners(NULL, GARAGE_EVENT_INSERT, vehicle, numVehicles);
+
+    return newGarage;
+}
+
+static int releaseSlot(void* context, char* vehicle, int position) {
+    if (vehicle != NULL) {
+        notifyGarageListeners(NULL, GARAGE_EVENT_REMOVE, vehicle, position);
+        freeVehicleWith((const VehicleAllocator*)context, vehicle);
+    }
+    return 0;
+}
+
+//freeGarage
+void freeGarage(char** garage, int numVehicles) {
+    freeGarageWith(garage, numVehicles, NULL);
+}
+
+void freeGarageWith(char** garage, int numVehicles, const VehicleAllocator* allocator) {
+    if (garage == NULL) {
+        return;
+    }
+
+    // Remove from the end so no listener has to shift positions
+    scanGarage(garage, numVehicles, GARAGE_SCAN_REVERSE, GARAGE_PREFETCH_DISTANCE, releaseSlot, (void*)allocator);
+    free(garage);
+}
@@ -6,17 +6,189 @@
 #ifndef VEHICLE_H
 #define VEHICLE_H
 
+#include <stddef.h>
+#include "vehicle_layout.h"
+
 /*
  * Function: createVehicle
  * Purpose: Dynamically allocates a string to store a vehicle's information.
- *          Value and model year are stored in the first 4 bytes.
- *          The remaining memory is for the description of the vehicle.
+ *          The record is in format v2: value and model year, the description length and
+ *          the description hash are stored ahead of the description of the vehicle.
  * Parameters: None
  * Returns: a dynamically allocated block of memory containing the vehicle's information
  * By: Anyaso
  */
 char* createVehicle();
 
+/*
+ * Function: buildVehicle
+ * Purpose: Builds a vehicle from values already in memory instead of reading them from the user.
+ *          Uses the same layout as createVehicle.
+ * Parameters: unsigned int - vehicle value (up to MAX_VEHICLE_VALUE)
+ *             unsigned int - model year (MIN_MODEL_YEAR to MAX_MODEL_YEAR)
+ *             const char* - description of the vehicle
+ * Returns: a dynamically allocated vehicle, or NULL if a value is out of range or allocation failed
+ */
+char* buildVehicle(unsigned int, unsigned int, const char*);
+
+/*
+ * Function: buildVehicleRecord
+ * Purpose: Allocates a vehicle from an already packed header and a description of known length.
+ * Parameters: unsigned int - packed value/year header
+ *             const char* - description (does not need to be null terminated)
+ *             int - length of the description
+ * Returns: a dynamically allocated vehicle, or NULL if allocation failed or the description
+ *          starts with 0x01 (the v2 tag, see below)
+ */
+char* buildVehicleRecord(unsigned int, const char*, int);
+
+/*
+ * Function: encodeVehicleRecord
+ * Purpose: Writes a v1 record (big-endian header, description, '\0') into a caller's buffer,
+ *          such as a file being built. Does not check for the reserved v2 prefix.
+ * Parameters: char* - destination, at least 4 + length + 1 bytes, any alignment
+ *             unsigned int - packed value/year header
+ *             const char* - description (does not need to be null terminated)
+ *             unsigned int - length of the description
+ * Returns: the number of bytes written
+ */
+size_t encodeVehicleRecord(char*, unsigned int, const char*, unsigned int);
+
+/*
+ * Version 2 records
+ * A v1 record is the big-endian 4-byte header followed by a null terminated description.
+ * A v2 record starts with an 8-byte tag, then the header in native byte order and the
+ * description length as 4-byte aligned words, the description hash, computed once when the
+ * record is built, and the description (still null terminated):
+ *
+ *   bytes 0-7    VEHICLE_V2_TAG
+ *   bytes 8-11   packed value/year header
+ *   bytes 12-15  description length
+ *   bytes 16-23  hashDescriptionBytes of the description, native byte order
+ *   bytes 24-    description + '\0'
+ *
+ * The tag reads as a v1 record with a zero header and the description "\x01V2". No record
+ * may have a description starting with 0x01, whatever its header, so that rewriting a
+ * header to 0 in place can never produce the tag: every builder refuses such descriptions
+ * and loaders treat a stored v1 record that has one as damaged (see isReservedVehicleRecord).
+ * So both formats can be mixed in one garage.
+ */
+#define VEHICLE_V2_TAG "\0\0\0\0\x01V2"      // 8 bytes including the terminator
+#define VEHICLE_V2_HEADER_OFFSET 8
+#define VEHICLE_V2_LENGTH_OFFSET 12
+#define VEHICLE_V2_HASH_OFFSET 16
+#define VEHICLE_V2_DESCRIPTION_OFFSET 24
+
+/*
+ * Function: buildVehicleV2
+ * Purpose: Same as buildVehicle but creates a v2 record.
+ * Returns: a dynamically allocated v2 vehicle, or NULL if a value is out of range or allocation failed
+ */
+char* buildVehicleV2(unsigned int, unsigned int, const char*);
+
+/*
+ * Function: buildVehicleRecordV2
+ * Purpose: Allocates a v2 vehicle from a packed header and a description of known length.
+ * Returns: the new vehicle, or NULL if allocation failed or the description starts with 0x01
+ */
+char* buildVehicleRecordV2(unsigned int, const char*, unsigned int);
+
+/*
+ * Function: convertVehicleToV2
+ * Purpose: Creates a v2 copy of a vehicle in either format. The original is not freed.
+ * Returns: the new vehicle, or NULL if allocation failed
+ */
+char* convertVehicleToV2(const char*);
+
+/*
+ * Function: isReservedVehicleRecord
+ * Purpose: Checks a record stored as v1 for a description starting with the tag's 0x01 byte,
+ *          which isVehicleV2 could misread once the header is 0. Reads only the 5th byte.
+ * Returns: 1 if the record is reserved (and so damaged), 0 otherwise
+ */
+int isReservedVehicleRecord(const char*);
+
+/*
+ * Function: isVehicleV2
+ * Purpose: Tells the two record formats apart.
+ * Returns: 1 for a v2 record, 0 for a v1 record
+ */
+int isVehicleV2(const char*);
+
+/*
+ * Vehicle memory
+ * Vehicle records come from malloc/free. A garage that keeps its records somewhere else
+ * (a VehiclePool or a GarageArena) owns that allocator and passes it to the ...With
+ * functions below for every vehicle it creates and removes: a vehicle must be freed by the
+ * allocator that created it. A NULL allocator means malloc/free, so createVehicle is
+ * createVehicleWith(NULL) and so on.
+ */
+typedef char* (*VehicleAllocFunction)(void* context, size_t size);
+typedef void (*VehicleFreeFunction)(void* context, char* vehicle, size_t size);
+
+typedef struct {
+    VehicleAllocFunction allocate;
+    VehicleFreeFunction release;
+    void* context;
+} VehicleAllocator;
+
+/*
+ * Functions: createVehicleWith, buildVehicleWith
+ * Purpose: createVehicle and buildVehicle with the record taken from an allocator.
+ */
+char* createVehicleWith(const VehicleAllocator*);
+char* buildVehicleWith(const VehicleAllocator*, unsigned int, unsigned int, const char*);
+
+/*
+ * Functions: freeVehicle, freeVehicleWith
+ * Purpose: Frees one vehicle record with free() / through the allocator that created it.
+ */
+void freeVehicle(char*);
+void freeVehicleWith(const VehicleAllocator*, char*);
+
+/*
+ * Function: vehicleRecordSize
+ * Purpose: Number of bytes a vehicle record occupies (header + description length + 1).
+ */
+size_t vehicleRecordSize(const char*);
+
+/*
+ * Function: vehicleDescriptionLength
+ * Purpose: Length of the description. Stored in v2 records, counted with strlen for v1.
+ */
+unsigned int vehicleDescriptionLength(const char*);
+
+/*
+ * Function: vehicleDescriptionHash
+ * Purpose: hashDescriptionBytes of the description. Stored in v2 records, computed for v1.
+ */
+unsigned long long vehicleDescriptionHash(const char*);
+
+/*
+ * Function: vehicleHeader
+ * Purpose: Reads the packed value/year header of a vehicle in either format.
+ * Parameters: const char* - the vehicle
+ * Returns: the packed header as a 32-bit unsigned integer
+ */
+unsigned int vehicleHeader(const char*);
+
+/*
+ * Function: setVehicleHeader
+ * Purpose: Overwrites the packed value/year header of a vehicle in place (either format).
+ *          Garage listeners are not told; see notifyVehicleUpdated.
+ * Parameters: char* - the vehicle
+ *             unsigned int - the new packed header
+ */
+void setVehicleHeader(char*, unsigned int);
+
+/*
+ * Function: vehicleDescription
+ * Purpose: Returns the description stored after the packed header (either format).
+ * Parameters: const char* - the vehicle
+ * Returns: pointer to the null terminated description inside the vehicle
+ */
+const char* vehicleDescription(const char*);
+
 /*
  * Function: displayVehicle
  * Purpose: Display the information stored in a vehicle
@@ -47,6 +219,17 @@ char** createGarage(int);
  */
 void displayGarage(char**, int);
 
+/*
+ * Function: displayGarageParallel
+ * Purpose: Same output as displayGarage, but the lines are formatted on worker threads and
+ *          written in order. displayGarage switches to this for PARALLEL_OUTPUT_THRESHOLD
+ *          or more vehicles.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ *             int - number of threads (0 or less means one per processor)
+ */
+void displayGarageParallel(char**, int, int);
+
 /*
  * Function: removeVehicle
  * Purpose: Remove a vehicle from the garage. Returns a new dynamically allocated garage with remaining cars.
@@ -59,6 +242,119 @@ void displayGarage(char**, int);
  */
 char** removeVehicle(char**, int, int);
 
+/*
+ * Function: removeVehicleWith
+ * Purpose: removeVehicle for a garage whose records come from an allocator (see Vehicle memory).
+ */
+char** removeVehicleWith(char**, int, int, const VehicleAllocator*);
+
+/*
+ * Garage events
+ * Indexes and statistics that must stay in sync with a garage register a listener on the
+ * garage's listener list. createGarage and addVehicle report inserts, removeVehicle and
+ * freeGarage report removals (before the vehicle is freed), and code that rewrites a header
+ * in place reports an update with the header it replaced. Positions are 0 based and refer
+ * to the garage at the time of the event: after a removal every later vehicle moves down by one.
+ *
+ * A garage behind a handle (such as a VersionedGarage) owns its own list, so its listeners
+ * only hear about that garage. Plain char** garages have no handle and share the default
+ * list, which every function below uses when passed NULL; attach listeners to one plain
+ * garage at a time. Each list has a lock, so listeners may be added and removed while
+ * another thread reports events. Callbacks run under that lock and must not add or remove
+ * listeners themselves.
+ */
+#define MAX_GARAGE_LISTENERS 8
+#define GARAGE_EVENT_INSERT 0
+#define GARAGE_EVENT_REMOVE 1
+#define GARAGE_EVENT_UPDATE 2
+
+typedef struct {
+    int type;                     // GARAGE_EVENT_INSERT, GARAGE_EVENT_REMOVE or GARAGE_EVENT_UPDATE
+    const char* vehicle;          // The vehicle inserted, about to be removed, or updated
+    int position;                 // Position of the vehicle in the garage
+    unsigned int previousHeader;  // GARAGE_EVENT_UPDATE only: the header before the change
+} GarageEvent;
+
+typedef void (*GarageListener)(void* context, const GarageEvent* event);
+
+typedef struct GarageListeners GarageListeners;
+
+/*
+ * Functions: createGarageListeners, freeGarageListeners
+ * Purpose: Create / free the listener list of a garage with a handle.
+ * Returns: createGarageListeners - the empty list, or NULL if allocation failed
+ */
+GarageListeners* createGarageListeners();
+void freeGarageListeners(GarageListeners*);
+
+/*
+ * Function: addGarageListener
+ * Purpose: Registers a callback that receives every event of one garage.
+ * Parameters: GarageListeners* - the garage's list (NULL for plain garages)
+ *             GarageListener - the callback
+ *             void* - context passed back to the callback
+ * Returns: 0 on success, -1 if MAX_GARAGE_LISTENERS are already registered
+ */
+int addGarageListener(GarageListeners*, GarageListener, void*);
+
+/*
+ * Function: removeGarageListener
+ * Purpose: Unregisters a callback previously added to the same list with the same context.
+ *          Once it returns the callback is not running and will not be called again.
+ */
+void removeGarageListener(GarageListeners*, GarageListener, void*);
+
+/*
+ * Function: notifyGarageListeners
+ * Purpose: Reports an event to the listeners of a garage. Used by code that edits a garage directly.
+ * Parameters: GarageListeners* - the garage's list (NULL for plain garages)
+ *             int - event type
+ *             const char* - the vehicle
+ *             int - position of the vehicle
+ */
+void notifyGarageListeners(GarageListeners*, int, const char*, int);
+
+/*
+ * Function: notifyVehicleUpdated
+ * Purpose: Reports a GARAGE_EVENT_UPDATE after a vehicle's header was rewritten in place.
+ * Parameters: GarageListeners* - the garage's list (NULL for plain garages)
+ *             const char* - the vehicle, already holding its new header
+ *             int - position of the vehicle
+ *             unsigned int - the header it had before
+ */
+void notifyVehicleUpdated(GarageListeners*, const char*, int, unsigned int);
+
+/*
+ * Function: hasGarageListeners
+ * Purpose: Nonzero if any listener is registered on a list (NULL for plain garages), so bulk
+ *          updates can skip recording events.
+ */
+int hasGarageListeners(GarageListeners*);
+
+/*
+ * Function: addVehicle
+ * Purpose: Appends a vehicle to the end of the garage, growing the garage by one.
+ * Parameters: char** - pointer to current garage (may be NULL when empty)
+ *             int - number of vehicles in current garage
+ *             char* - vehicle to add; the garage takes ownership
+ * Returns: a reference to the resized garage, or the original garage if allocation failed
+ */
+char** addVehicle(char**, int, char*);
+
+/*
+ * Function: freeGarage
+ * Purpose: Frees every vehicle in the garage and the garage itself.
+ * Parameters: char** - pointer to the garage
+ *             int - number of vehicles in the garage
+ */
+void freeGarage(char**, int);
+
+/*
+ * Function: freeGarageWith
+ * Purpose: freeGarage for a garage whose records come from an allocator.
+ */
+void freeGarageWith(char**, int, const VehicleAllocator*);
+
 /*
  * Function: testGarage
  * Purpose: Test the vehicle management functions
@@ -70,5 +366,30 @@ void testBoundaryValues();
 void testErrorHandling();
 void testMultipleVehicles();
 void runAllTests();
+void testCompressedGarage();
+void testExport();
+void testVehicleIndex();
+void testTopK();
+void testQuery();
+void testBitmapIndex();
+void testYearStats();
+void testVehiclePool();
+void testRecordFormatV2();
+void testParallelOutput();
+void testGarageScan();
+void testGarageMemory();
+void testValueSketch();
+void testDistinctModels();
+void testDescriptionFilter();
+void testDedupGarage();
+void testRevalueGarage();
+void testValueTransforms();
+void testGarageServer();
+void testSharedGarage();
+void testGarageSnapshots();
+void testGarageSegments();
+void testGarageLoader();
+void testGarageArchive();
+void testHeaderLayout();
 
 #endif /* VEHICLE_H */
\ No newline at end of file
@@ -0,0 +1,88 @@
+/*
+ * Vehicle Layout Header File
+ * Single compile-time description of the 4-byte packed value/year header.
+ *
+ * The value occupies the upper VEHICLE_VALUE_BITS bits and the model year the lower
+ * VEHICLE_YEAR_BITS bits, stored as an offset from VEHICLE_YEAR_BASE. The default is
+ * 21 value bits, 11 year bits and base 0. Other splits are chosen at build time, for
+ * example -DVEHICLE_VALUE_BITS=24 -DVEHICLE_YEAR_BASE=1900 for values up to $16,777,215
+ * and years 1900 - 2155. Everything below is derived from these three numbers, and
+ * pack/unpack are inline, so a different layout costs nothing at run time.
+ */
+
+#ifndef VEHICLE_LAYOUT_H
+#define VEHICLE_LAYOUT_H
+
+#ifndef VEHICLE_VALUE_BITS
+    #define VEHICLE_VALUE_BITS 21
+#endif
+
+#define VEHICLE_YEAR_BITS (32 - VEHICLE_VALUE_BITS)
+
+#ifndef VEHICLE_YEAR_BASE
+    #define VEHICLE_YEAR_BASE 0
+#endif
+
+_Static_assert(VEHICLE_VALUE_BITS >= 1 && VEHICLE_VALUE_BITS <= 31, "value field must be 1 to 31 bits");
+_Static_assert(VEHICLE_YEAR_BASE >= 0, "year base cannot be negative");
+
+// Constants for bit operations
+#define VALUE_SHIFT VEHICLE_YEAR_BITS                        // Number of bits to shift for value
+#define YEAR_MASK ((1u << VEHICLE_YEAR_BITS) - 1u)           // Mask for the year bits (0x000007FF)
+#define VALUE_MASK (~YEAR_MASK)                              // Mask for the value bits (0xFFFFF800)
+#define MAX_VEHICLE_VALUE ((1u << VEHICLE_VALUE_BITS) - 1u)  // 2^21 - 1 by default
+#define MIN_MODEL_YEAR ((unsigned int)VEHICLE_YEAR_BASE)
+#define MAX_MODEL_YEAR (MIN_MODEL_YEAR + YEAR_MASK)          // 2047 by default
+
+/*
+ * Macro: PACK_HEADER_CONSTANT
+ * Purpose: Packs a value/year pair known at compile time. Out of range constants fail to
+ *          compile (negative array size) instead of silently overflowing into the other field.
+ */
+#define PACK_HEADER_CONSTANT(value, year)                                                       \
+    ((unsigned int)(sizeof(char[((value) <= MAX_VEHICLE_VALUE && (year) >= MIN_MODEL_YEAR &&    \
+                                 (year) <= MAX_MODEL_YEAR) ? 1 : -1]) * 0) |                    \
+     ((unsigned int)(value) << VALUE_SHIFT) | ((unsigned int)(year) - MIN_MODEL_YEAR))
+
+// The fields must tile the word exactly, with nothing lost at either end
+_Static_assert((VALUE_MASK & YEAR_MASK) == 0u, "value and year fields overlap");
+_Static_assert((VALUE_MASK | YEAR_MASK) == 0xFFFFFFFFu, "value and year fields leave gaps");
+_Static_assert(PACK_HEADER_CONSTANT(MAX_VEHICLE_VALUE, MAX_MODEL_YEAR) == 0xFFFFFFFFu, "maximum does not fill the header");
+_Static_assert(PACK_HEADER_CONSTANT(0, MIN_MODEL_YEAR) == 0u, "minimum is not zero");
+_Static_assert((PACK_HEADER_CONSTANT(MAX_VEHICLE_VALUE, MIN_MODEL_YEAR) & VALUE_MASK) >> VALUE_SHIFT == MAX_VEHICLE_VALUE,
+               "maximum value does not round trip");
+_Static_assert((PACK_HEADER_CONSTANT(1, MIN_MODEL_YEAR) & VALUE_MASK) >> VALUE_SHIFT == 1u,
+               "lowest value bit does not round trip");
+
+/*
+ * Functions: packHeader, headerValue, headerYear
+ * Purpose: Convert between a value/year pair and the packed 32-bit header.
+ *          packHeader expects values already checked against the limits above.
+ */
+static inline unsigned int packHeader(unsigned int value, unsigned int year) {
+    return (value << VALUE_SHIFT) | ((year - MIN_MODEL_YEAR) & YEAR_MASK);
+}
+
+static inline unsigned int headerValue(unsigned int packedData) {
+    return (packedData & VALUE_MASK) >> VALUE_SHIFT;
+}
+
+static inline unsigned int headerYear(unsigned int packedData) {
+    return (packedData & YEAR_MASK) + MIN_MODEL_YEAR;
+}
+
+/*
+ * Function: isModelYear
+ * Purpose: Checks a year against MIN_MODEL_YEAR and MAX_MODEL_YEAR. The lower bound is only
+ *          compared when the base is above 0, where an unsigned year could fall below it.
+ */
+static inline int isModelYear(unsigned int year) {
+#if VEHICLE_YEAR_BASE > 0
+    if (year < MIN_MODEL_YEAR) {
+        return 0;
+    }
+#endif
+    return year <= MAX_MODEL_YEAR;
+}
+
+#endif /* VEHICLE_LAYOUT_H */
@@ -0,0 +1,395 @@
+/*
+ * Vehicle Pool
+ * Slab backed size classes with per-thread caches.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "vehicle.h"
+#include "vehicle_pool.h"
+#include "garage_scan.h"
+
+typedef struct FreeRecord {
+    struct FreeRecord* next;
+} FreeRecord;
+
+typedef struct {
+    pthread_mutex_t lock;
+    FreeRecord* head;
+} SizeClass;
+
+struct VehiclePool {
+    unsigned long id;  // Lets thread caches notice they belong to another pool
+    struct VehiclePool* nextLive;
+    VehicleAllocator allocator;  // This pool, for the ...With vehicle functions
+    SizeClass classes[VEHICLE_POOL_NUM_CLASSES];
+
+    pthread_mutex_t slabLock;
+    void** slabs;
+    long numSlabs;
+    long slabCapacity;
+
+    atomic_long systemAllocations;
+    atomic_long recordsInUse;
+};
+
+typedef struct {
+    FreeRecord* head;
+    int count;
+} CacheList;
+
+typedef struct {
+    unsigned long poolId;
+    CacheList lists[VEHICLE_POOL_NUM_CLASSES];
+} ThreadCache;
+
+static _Thread_local ThreadCache threadCache;
+static atomic_ulong nextPoolId = 1;
+
+// Pools not yet destroyed, so a thread cache can find the pool its records belong to
+static pthread_mutex_t livePoolsLock = PTHREAD_MUTEX_INITIALIZER;
+static VehiclePool* livePools = NULL;
+
+// Its destructor returns a thread's cached records when the thread exits
+static pthread_key_t cacheKey;
+static pthread_once_t cacheKeyOnce = PTHREAD_ONCE_INIT;
+
+// Size class of a record, or -1 if it is too large for the pool
+static int sizeClass(size_t size) {
+    int index = (int)((size + VEHICLE_POOL_CLASS_STEP - 1) / VEHICLE_POOL_CLASS_STEP) - 1;
+    return index < VEHICLE_POOL_NUM_CLASSES ? index : -1;
+}
+
+static size_t classSize(int index) {
+    return (size_t)(index + 1) * VEHICLE_POOL_CLASS_STEP;
+}
+
+// Splices a chain of count records onto a shared size class list
+static void returnChain(VehiclePool* pool, int index, FreeRecord* head, FreeRecord* tail) {
+    SizeClass* sizeClass = &pool->classes[index];
+
+    pthread_mutex_lock(&sizeClass->lock);
+    tail->next = sizeClass->head;
+    sizeClass->head = head;
+    pthread_mutex_unlock(&sizeClass->lock);
+}
+
+// Moves every record of a cache to its pool's shared lists and empties the cache
+static void flushCache(VehiclePool* pool, ThreadCache* cache) {
+    for (int i = 0; i < VEHICLE_POOL_NUM_CLASSES; i++) {
+        CacheList* list = &cache->lists[i];
+        if (list->head == NULL) {
+            continue;
+        }
+
+        FreeRecord* tail = list->head;
+        while (tail->next != NULL) {
+            tail = tail->next;
+        }
+        returnChain(pool, i, list->head, tail);
+        list->head = NULL;
+        list->count = 0;
+    }
+}
+
+// Returns a cache to the pool it belongs to. Records of a destroyed pool went with its slabs.
+static void releaseCache(ThreadCache* cache) {
+    pthread_mutex_lock(&livePoolsLock);
+    for (VehiclePool* pool = livePools; pool != NULL; pool = pool->nextLive) {
+        if (pool->id == cache->poolId) {
+            flushCache(pool, cache);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&livePoolsLock);
+
+    for (int i = 0; i < VEHICLE_POOL_NUM_CLASSES; i++) {
+        cache->lists[i].head = NULL;
+        cache->lists[i].count = 0;
+    }
+    cache->poolId = 0;
+}
+
+static void releaseCacheAtExit(void* cache) {
+    releaseCache((ThreadCache*)cache);
+}
+
+static void createCacheKey() {
+    pthread_key_create(&cacheKey, releaseCacheAtExit);
+}
+
+static ThreadCache* cacheFor(VehiclePool* pool) {
+    if (threadCache.poolId != pool->id) {
+        if (threadCache.poolId != 0) {
+            releaseCache(&threadCache);
+        }
+        threadCache.poolId = pool->id;
+        pthread_once(&cacheKeyOnce, createCacheKey);
+        pthread_setspecific(cacheKey, &threadCache);
+    }
+    return &threadCache;
+}
+
+// Carves a new slab into records of one class. Called with the class lock held.
+static int carveSlab(VehiclePool* pool, int index) {
+    char* slab = (char*)malloc(VEHICLE_POOL_SLAB_SIZE);
+    if (slab == NULL) {
+        printf("Error: Memory allocation for vehicle pool failed\n");
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool->slabLock);
+    if (pool->numSlabs == pool->slabCapacity) {
+        long capacity = pool->slabCapacity == 0 ? 16 : pool->slabCapacity * 2;
+        void** slabs = (void**)realloc(pool->slabs, capacity * sizeof(void*));
+        if (slabs == NULL) {
+            pthread_mutex_unlock(&pool->slabLock);
+            free(slab);
+            printf("Error: Memory allocation for vehicle pool failed\n");
+            return -1;
+        }
+        pool->slabs = slabs;
+        pool->slabCapacity = capacity;
+    }
+    pool->slabs[pool->numSlabs++] = slab;
+    pthread_mutex_unlock(&pool->slabLock);
+
+    atomic_fetch_add(&pool->systemAllocations, 1);
+
+    size_t size = classSize(index);
+    SizeClass* sizeClass = &pool->classes[index];
+    for (size_t offset = 0; offset + size <= VEHICLE_POOL_SLAB_SIZE; offset += size) {
+        FreeRecord* record = (FreeRecord*)(slab + offset);
+        record->next = sizeClass->head;
+        sizeClass->head = record;
+    }
+    return 0;
+}
+
+// Moves up to VEHICLE_POOL_BATCH records from the shared list into the thread cache
+static void refill(VehiclePool* pool, int index, CacheList* list) {
+    SizeClass* sizeClass = &pool->classes[index];
+
+    pthread_mutex_lock(&sizeClass->lock);
+    if (sizeClass->head == NULL && carveSlab(pool, index) != 0) {
+        pthread_mutex_unlock(&sizeClass->lock);
+        return;
+    }
+
+    while (sizeClass->head != NULL && list->count < VEHICLE_POOL_BATCH) {
+        FreeRecord* record = sizeClass->head;
+        sizeClass->head = record->next;
+        record->next = list->head;
+        list->head = record;
+        list->count++;
+    }
+    pthread_mutex_unlock(&sizeClass->lock);
+}
+
+static char* allocateFromPool(void* context, size_t size) {
+    return vehiclePoolAllocate((VehiclePool*)context, size);
+}
+
+static void freeToPool(void* context, char* vehicle, size_t size) {
+    vehiclePoolFree((VehiclePool*)context, vehicle, size);
+}
+
+VehiclePool* createVehiclePool() {
+    VehiclePool* pool = (VehiclePool*)calloc(1, sizeof(VehiclePool));
+    if (pool == NULL) {
+        printf("Error: Memory allocation for vehicle pool failed\n");
+        return NULL;
+    }
+
+    pool->id = atomic_fetch_add(&nextPoolId, 1);
+    pool->allocator.allocate = allocateFromPool;
+    pool->allocator.release = freeToPool;
+    pool->allocator.context = pool;
+    for (int i = 0; i < VEHICLE_POOL_NUM_CLASSES; i++) {
+        pthread_mutex_init(&pool->classes[i].lock, NULL);
+    }
+    pthread_mutex_init(&pool->slabLock, NULL);
+    atomic_init(&pool->systemAllocations, 0);
+    atomic_init(&pool->recordsInUse, 0);
+
+    pthread_mutex_lock(&livePoolsLock);
+    pool->nextLive = livePools;
+    livePools = pool;
+    pthread_mutex_unlock(&livePoolsLock);
+
+    return pool;
+}
+
+void destroyVehiclePool(VehiclePool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    // Once unlisted no thread cache returns records to the pool any more
+    pthread_mutex_lock(&livePoolsLock);
+    VehiclePool** link = &livePools;
+    while (*link != pool) {
+        link = &(*link)->nextLive;
+    }
+    *link = pool->nextLive;
+    pthread_mutex_unlock(&livePoolsLock);
+
+    if (threadCache.poolId == pool->id) {
+        for (int i = 0; i < VEHICLE_POOL_NUM_CLASSES; i++) {
+            threadCache.lists[i].head = NULL;
+            threadCache.lists[i].count = 0;
+        }
+        threadCache.poolId = 0;
+    }
+
+    for (long i = 0; i < pool->numSlabs; i++) {
+        free(pool->slabs[i]);
+    }
+    for (int i = 0; i < VEHICLE_POOL_NUM_CLASSES; i++) {
+        pthread_mutex_destroy(&pool->classes[i].lock);
+    }
+    pthread_mutex_destroy(&pool->slabLock);
+    free(pool->slabs);
+    free(pool);
+}
+
+char* vehiclePoolAllocate(VehiclePool* pool, size_t size) {
+    int index = sizeClass(size);
+
+    if (index < 0) {
+        atomic_fetch_add(&pool->systemAllocations, 1);
+        atomic_fetch_add(&pool->recordsInUse, 1);
+        return (char*)malloc(size);
+    }
+
+    CacheList* list = &cacheFor(pool)->lists[index];
+    if (list->head == NULL) {
+        refill(pool, index, list);
+        if (list->head == NULL) {
+            return NULL;
+        }
+    }
+
+    FreeRecord* record = list->head;
+    list->head = record->next;
+    list->count--;
+
+    atomic_fetch_add(&pool->recordsInUse, 1);
+    return (char*)record;
+}
+
+void vehiclePoolFree(VehiclePool* pool, char* vehicle, size_t size) {
+    if (vehicle == NULL) {
+        return;
+    }
+
+    atomic_fetch_sub(&pool->recordsInUse, 1);
+
+    int index = sizeClass(size);
+    if (index < 0) {
+        free(vehicle);
+        return;
+    }
+
+    CacheList* list = &cacheFor(pool)->lists[index];
+    FreeRecord* record = (FreeRecord*)vehicle;
+    record->next = list->head;
+    list->head = record;
+    list->count++;
+
+    // Too many cached: hand one batch back to the shared list in one step
+    if (list->count >= 2 * VEHICLE_POOL_BATCH) {
+        FreeRecord* head = list->head;
+        FreeRecord* tail = head;
+        for (int i = 1; i < VEHICLE_POOL_BATCH; i++) {
+            tail = tail->next;
+        }
+        list->head = tail->next;
+        list->count -= VEHICLE_POOL_BATCH;
+        returnChain(pool, index, head, tail);
+    }
+}
+
+typedef struct {
+    FreeRecord* heads[VEHICLE_POOL_NUM_CLASSES];
+    FreeRecord* tails[VEHICLE_POOL_NUM_CLASSES];
+    long returned;
+} ChainScan;
+
+static int chainSlot(void* context, char* vehicle, int position) {
+    ChainScan* chains = (ChainScan*)context;
+    (void)position;
+
+    if (vehicle == NULL) {
+        return 0;
+    }
+
+    chains->returned++;
+    int index = sizeClass(vehicleRecordSize(vehicle));
+    if (index < 0) {
+        free(vehicle);
+        return 0;
+    }
+
+    FreeRecord* record = (FreeRecord*)vehicle;
+    record->next = chains->heads[index];
+    chains->heads[index] = record;
+    if (chains->tails[index] == NULL) {
+        chains->tails[index] = record;
+    }
+    return 0;
+}
+
+void vehiclePoolFreeGarage(VehiclePool* pool, char** garage, int numVehicles) {
+    if (pool == NULL || garage == NULL) {
+        return;
+    }
+
+    // Chain the records per size class without taking any lock
+    ChainScan chains = {{NULL}, {NULL}, 0};
+    forEachVehicle(garage, numVehicles, chainSlot, &chains);
+
+    for (int i = 0; i < VEHICLE_POOL_NUM_CLASSES; i++) {
+        if (chains.heads[i] != NULL) {
+            returnChain(pool, i, chains.heads[i], chains.tails[i]);
+        }
+    }
+
+    atomic_fetch_sub(&pool->recordsInUse, chains.returned);
+    free(garage);
+}
+
+void vehiclePoolFlushThreadCache(VehiclePool* pool) {
+    if (pool == NULL || threadCache.poolId != pool->id) {
+        return;
+    }
+    flushCache(pool, &threadCache);
+}
+
+const VehicleAllocator* vehiclePoolAllocator(VehiclePool* pool) {
+    return pool != NULL ? &pool->allocator : NULL;
+}
+
+void vehiclePoolGetStats(VehiclePool* pool, VehiclePoolStats* stats) {
+    if (pool == NULL || stats == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->slabLock);
+    stats->slabs = pool->numSlabs;
+    pthread_mutex_unlock(&pool->slabLock);
+
+    stats->systemAllocations = atomic_load(&pool->systemAllocations);
+    stats->recordsInUse = atomic_load(&pool->recordsInUse);
+
+    stats->sharedRecords = 0;
+    for (int i = 0; i < VEHICLE_POOL_NUM_CLASSES; i++) {
+        pthread_mutex_lock(&pool->classes[i].lock);
+        for (FreeRecord* record = pool->classes[i].head; record != NULL; record = record->next) {
+            stats->sharedRecords++;
+        }
+        pthread_mutex_unlock(&pool->classes[i].lock);
+    }
+}
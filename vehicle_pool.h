@@ -0,0 +1,77 @@
+/*
+ * Vehicle Pool Header File
+ * Size-class pool allocator that recycles vehicle records.
+ *
+ * Records are carved out of VEHICLE_POOL_SLAB_SIZE slabs into size classes that are
+ * VEHICLE_POOL_CLASS_STEP bytes apart, matching 4 + length + 1 record sizes. Freed
+ * records go back on a free list and are handed out again, so a garage that keeps
+ * removing and creating vehicles stops calling malloc/free once it reaches steady state.
+ *
+ * Every thread keeps a small cache of free records per size class and moves them to and
+ * from the shared lists in batches of VEHICLE_POOL_BATCH, so the lock is rarely touched.
+ * A thread caches records of one pool at a time. Its cached records go back to their own
+ * pool when the thread moves on to another pool and when the thread exits, so they are
+ * never lost while the pool lives.
+ */
+
+#ifndef VEHICLE_POOL_H
+#define VEHICLE_POOL_H
+
+#include <stddef.h>
+#include "vehicle.h"
+
+#define VEHICLE_POOL_CLASS_STEP 8      // Bytes between size classes
+#define VEHICLE_POOL_NUM_CLASSES 16    // Classes of 8 .. 128 bytes; larger records use malloc
+#define VEHICLE_POOL_SLAB_SIZE 65536   // Bytes requested from the system at a time
+#define VEHICLE_POOL_BATCH 32          // Records moved between a thread cache and the pool at once
+
+typedef struct VehiclePool VehiclePool;
+
+typedef struct {
+    long systemAllocations;  // Slabs plus oversized records obtained from malloc
+    long slabs;              // Slabs currently owned by the pool
+    long recordsInUse;       // Records handed out and not yet returned
+    long sharedRecords;      // Free records on the shared lists, not in any thread cache
+} VehiclePoolStats;
+
+/*
+ * Functions: createVehiclePool, destroyVehiclePool
+ * Purpose: Create an empty pool / free every slab of a pool. Records from the pool must
+ *          not be used after it is destroyed.
+ */
+VehiclePool* createVehiclePool();
+void destroyVehiclePool(VehiclePool*);
+
+/*
+ * Functions: vehiclePoolAllocate, vehiclePoolFree
+ * Purpose: Allocate a record of the given size / return a record of the given size.
+ */
+char* vehiclePoolAllocate(VehiclePool*, size_t);
+void vehiclePoolFree(VehiclePool*, char*, size_t);
+
+/*
+ * Function: vehiclePoolFreeGarage
+ * Purpose: Bulk return: gives every vehicle of a garage back to the pool, taking each
+ *          size class lock once, and frees the garage array. Sends no garage events.
+ */
+void vehiclePoolFreeGarage(VehiclePool*, char**, int);
+
+/*
+ * Function: vehiclePoolFlushThreadCache
+ * Purpose: Moves the calling thread's cached records back to the shared lists now, for
+ *          example before reading vehiclePoolGetStats. Threads do this on exit anyway.
+ */
+void vehiclePoolFlushThreadCache(VehiclePool*);
+
+/*
+ * Function: vehiclePoolAllocator
+ * Purpose: The pool as a vehicle allocator. The garage that owns the pool passes it to
+ *          createVehicleWith, buildVehicleWith, removeVehicleWith and the other ...With
+ *          functions, so every record goes back to the pool that made it.
+ * Returns: the allocator, valid until the pool is destroyed (NULL for a NULL pool)
+ */
+const VehicleAllocator* vehiclePoolAllocator(VehiclePool*);
+
+void vehiclePoolGetStats(VehiclePool*, VehiclePoolStats*);
+
+#endif /* VEHICLE_POOL_H */